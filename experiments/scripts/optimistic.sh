@@ -0,0 +1,118 @@
+#!/bin/bash
+# Compares pessimistic (default) and optimistic (--rocksdb_optimistic) write
+# transactions using the vote and lobsters harnesses.
+K9DB_DIR="$(pwd)"
+LOG_OUT="${K9DB_DIR}/experiments/scripts/logs/optimistic/"
+
+mkdir -p "$LOG_OUT"
+mkdir -p /mnt/disks/my-ssd/k9db
+
+echo "Writing logs and measurements to $LOG_OUT"
+
+# The database IP is either 127.0.0.1 or LOCAL_IP if running on gcloud.
+DB_IP=$LOCAL_IP
+if [[ $LOCAL_IP == "" ]]; then
+  DB_IP="127.0.0.1"
+fi
+
+# Vote parameters (same as votes.sh).
+articles=10000
+distribution="skewed"
+target=10000
+write=19
+runtime=60
+prime=30
+
+# Lobsters parameters (same as lobsters-endpoints-load.sh).
+RT=120
+DS=2.59
+RS=1000
+
+#
+# Build K9db and harnesses.
+#
+cd "${K9DB_DIR}"
+bazel build //:k9db --config=opt
+cd "${K9DB_DIR}/experiments/vote"
+bazel build :vote-benchmark -c opt
+cd "${K9DB_DIR}/experiments/lobsters"
+bazel build -c opt //:lobsters-harness
+
+# Starts a fresh K9db server in the background with the given mode.
+start_k9db() {
+  cd "${K9DB_DIR}"
+  rm -rf /mnt/disks/my-ssd/k9db/k9db
+  bazel run //:k9db --config=opt -- --hostname="$DB_IP:10001" \
+    --db_path="/mnt/disks/my-ssd/k9db/" --rocksdb_optimistic=$1 \
+    > "$LOG_OUT/k9db-server-$2.out" 2>&1 &
+  sleep 10
+}
+
+stop_k9db() {
+  mariadb -P10001 --host=$DB_IP -e "STOP" > /dev/null 2>&1;
+  sleep 20
+}
+
+for MODE in "pessimistic" "optimistic"
+do
+  OPTIMISTIC="false"
+  if [[ $MODE == "optimistic" ]]; then
+    OPTIMISTIC="true"
+  fi
+
+  #
+  # Vote.
+  #
+  echo "Running vote against K9db ($MODE)..."
+  start_k9db $OPTIMISTIC "vote-$MODE"
+
+  cd "${K9DB_DIR}/experiments/vote"
+  echo "  Priming..."
+  bazel run :vote-benchmark -c opt -- \
+    --articles $articles \
+    -d $distribution \
+    --target $target \
+    --write-every 1 \
+    --runtime $prime \
+    pelton > "$LOG_OUT/vote-$MODE-prime.out" 2>&1
+
+  echo "  Running load..."
+  bazel run :vote-benchmark -c opt -- \
+    --articles $articles \
+    -d $distribution \
+    --target $target \
+    --write-every $write \
+    --runtime $runtime \
+    --no-prime \
+    pelton > "$LOG_OUT/vote-$MODE.out" 2>&1
+
+  stop_k9db
+
+  #
+  # Lobsters.
+  #
+  echo "Running lobsters against K9db ($MODE)..."
+  start_k9db $OPTIMISTIC "lobsters-$MODE"
+
+  cd "${K9DB_DIR}/experiments/lobsters"
+  echo "  Priming..."
+  bazel run -c opt //:lobsters-harness -- \
+    --runtime 0 --datascale $DS --reqscale $RS --queries pelton \
+    --backend pelton --prime \
+    "mysql://root:password@$DB_IP:10001/lobsters" \
+    > "$LOG_OUT/lobsters-$MODE-prime.out" 2>&1
+
+  echo "  Running load..."
+  bazel run -c opt //:lobsters-harness -- \
+    --runtime $RT --datascale $DS --reqscale $RS --queries pelton \
+    --backend pelton \
+    "mysql://root:password@$DB_IP:10001/lobsters" \
+    > "$LOG_OUT/lobsters-$MODE.out" 2>&1
+
+  stop_k9db
+done
+
+echo "Experiment ran. Results are in $LOG_OUT:"
+echo "  vote-pessimistic.out vs vote-optimistic.out"
+echo "  lobsters-pessimistic.out vs lobsters-optimistic.out"
+echo "Success"
@@ -11,7 +11,8 @@
 namespace k9db {
 
 // Constructor.
-State::State(size_t w, bool c) : sstate_(), dstate_(w, c) {}
+State::State(size_t w, bool c, bool a, bool p)
+    : sstate_(), dstate_(w, c, a, p) {}
 State::~State() {
   this->dstate_.Shutdown();
   this->database_ = nullptr;
@@ -23,7 +24,7 @@ std::vector<std::string> State::Initialize(const std::string &db_name,
   auto lock = this->WriterLock();
   if (this->database_ == nullptr) {
     this->database_ = sql::MakeConnection();
-    return this->database_->Open(db_name, db_path);
+    return this->database_->Open(db_name, db_path, this->dstate_.checkpoints());
   }
   return {};
 }
@@ -99,6 +100,25 @@ sql::SqlResult State::ListIndices() const {
   // Return result.
   return sql::SqlResult(sql::SqlResultSet("#INDICES", schema, std::move(records)));
 }
+sql::SqlResult State::StorageSettings() const {
+  util::SharedLock reader_lock = this->ReaderLock();
+  dataflow::SchemaRef schema = dataflow::SchemaFactory::STORAGE_SETTINGS_SCHEMA;
+  std::vector<dataflow::Record> records;
+  for (auto &[name, value] : this->database_->GetSettings()) {
+    records.emplace_back(schema, true,
+                         std::make_unique<std::string>(std::move(name)),
+                         std::make_unique<std::string>(std::move(value)));
+  }
+  return sql::SqlResult(
+      sql::SqlResultSet("#STORAGE", schema, std::move(records)));
+}
+
+sql::SqlResult State::SchedulerStats() const {
+  return this->dstate_.SchedulerStats();
+}
+sql::SqlResult State::VisibilityStats() const {
+  return this->dstate_.VisibilityStats();
+}
 
 // Locks.
 util::UniqueLock State::WriterLock() { return util::UniqueLock(&this->mtx_); }
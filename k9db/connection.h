@@ -2,6 +2,7 @@
 #define K9DB_CONNECTION_H_
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 // NOLINTNEXTLINE
 #include <mutex>
@@ -23,7 +24,8 @@ namespace k9db {
 
 class State {
  public:
-  State(size_t workers, bool consistent);
+  State(size_t workers, bool consistent, bool async_writes = false,
+        bool checkpoints = false);
   ~State();
 
   // Not copyable or movable.
@@ -62,6 +64,9 @@ class State {
   sql::SqlResult NumShards() const;
   sql::SqlResult PreparedDebug() const;
   sql::SqlResult ListIndices() const;
+  sql::SqlResult StorageSettings() const;
+  sql::SqlResult SchedulerStats() const;
+  sql::SqlResult VisibilityStats() const;
 
   // Locks.
   util::UniqueLock WriterLock();
@@ -89,6 +94,9 @@ struct Connection {
   // Prepared statements created by this connection.
   std::vector<prepared::PreparedStatementDescriptor> stmts;
   std::unique_ptr<sql::Session> session;
+  // The last write made by this connection that may not be visible in views
+  // yet (with async writes), reads by this connection wait for it.
+  uint64_t last_write = 0;
   std::unique_ptr<ComplianceTransaction> ctx;  // Destruct this first.
 };
 
@@ -0,0 +1,140 @@
+#include "k9db/dataflow/batcher.h"
+
+#include <chrono>
+// NOLINTNEXTLINE
+#include <thread>
+#include <utility>
+
+// A batch is flushed once it has this many records.
+#define BATCH_MAX_RECORDS 512
+// The leader of a batch flushes it at most this long after it started it.
+#define BATCH_WINDOW_US 50
+// The leader of a batch flushes it once it did not grow for this many checks
+// (yielding in between) and the partition has nothing queued.
+#define BATCH_IDLE_SPINS 8
+
+namespace k9db {
+namespace dataflow {
+
+Batcher::Batcher(const std::vector<Channel *> &channels, bool consistent)
+    : channels_(channels),
+      batches_(),
+      consistent_(consistent),
+      writers_(0),
+      writes_(0),
+      flushes_(0),
+      messages_(0) {
+  for (size_t i = 0; i < channels.size(); i++) {
+    this->batches_.push_back(std::make_unique<Batch>());
+  }
+}
+
+void Batcher::Write(PartitionIndex partition, Channel::Message &&msg) {
+  using Clock = std::chrono::steady_clock;
+  Batch &batch = *this->batches_.at(partition);
+  this->writers_.fetch_add(1);
+  this->writes_.fetch_add(1, std::memory_order_relaxed);
+
+  // Add the message to the batch.
+  std::unique_lock<std::mutex> lock(batch.mtx);
+  batch.records += msg.records.size();
+  batch.promises.push_back(std::move(msg.promise));
+  if (batch.messages.size() > 0 &&
+      batch.messages.back().flow == msg.flow &&
+      batch.messages.back().source == msg.source &&
+      batch.messages.back().target == msg.target) {
+    std::vector<Record> &records = batch.messages.back().records;
+    for (Record &record : msg.records) {
+      records.push_back(std::move(record));
+    }
+  } else {
+    batch.messages.push_back({msg.flow, std::move(msg.records), msg.source,
+                              msg.target, Promise::None.Derive()});
+  }
+
+  // Full batches are flushed right away, by whoever fills them.
+  if (batch.records >= BATCH_MAX_RECORDS) {
+    this->Flush(partition, &batch);
+    this->writers_.fetch_sub(1);
+    return;
+  }
+  // Some other write leads this batch.
+  if (batch.led) {
+    this->writers_.fetch_sub(1);
+    return;
+  }
+
+  // Lead this batch: wait for it to grow while other writers are around or
+  // the partition is busy anyway.
+  batch.led = true;
+  Channel *chan = this->channels_.at(partition);
+  if (this->writers_.load() > 1 || chan->Depth() > 0) {
+    uint64_t epoch = batch.epoch;
+    size_t size = batch.promises.size();
+    size_t idle = 0;
+    Clock::time_point deadline =
+        Clock::now() + std::chrono::microseconds(BATCH_WINDOW_US);
+    while (Clock::now() < deadline) {
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+      if (batch.epoch != epoch) {
+        // Already flushed for being full.
+        this->writers_.fetch_sub(1);
+        return;
+      }
+      if (batch.promises.size() > size) {
+        size = batch.promises.size();
+        idle = 0;
+      } else if (++idle >= BATCH_IDLE_SPINS && chan->Depth() == 0) {
+        break;
+      }
+    }
+  }
+  this->Flush(partition, &batch);
+  this->writers_.fetch_sub(1);
+}
+
+void Batcher::Flush(PartitionIndex partition, Batch *batch) {
+  // The messages of the batch resolve one future, which then resolves the
+  // promises of all the writes in the batch.
+  if (this->consistent_) {
+    Future *future = new Future(true);
+    for (Channel::Message &msg : batch->messages) {
+      msg.promise = future->GetPromise();
+    }
+    auto promises =
+        std::make_shared<std::vector<Promise>>(std::move(batch->promises));
+    future->Then([promises]() {
+      for (Promise &promise : *promises) {
+        promise.Resolve();
+      }
+    });
+  } else {
+    for (Promise &promise : batch->promises) {
+      promise.Resolve();
+    }
+  }
+
+  // Write to the channel in order.
+  Channel *chan = this->channels_.at(partition);
+  this->flushes_.fetch_add(1, std::memory_order_relaxed);
+  this->messages_.fetch_add(batch->messages.size(), std::memory_order_relaxed);
+  for (Channel::Message &msg : batch->messages) {
+    chan->WriteInput(std::move(msg));
+  }
+
+  // Reset the batch.
+  batch->messages.clear();
+  batch->promises.clear();
+  batch->records = 0;
+  batch->epoch++;
+  batch->led = false;
+}
+
+Batcher::Stats Batcher::GetStats() const {
+  return {this->writes_.load(), this->flushes_.load(), this->messages_.load()};
+}
+
+}  // namespace dataflow
+}  // namespace k9db
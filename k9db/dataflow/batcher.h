@@ -0,0 +1,87 @@
+// Coalesces the input messages of concurrent client writes into larger
+// per-partition batches before they are written to the partition's channel.
+//
+// Every INSERT/UPDATE/DELETE typically produces a message with one or two
+// records per affected flow and partition, so channel and promise overheads
+// dominate. Instead, messages accumulate in a batch per partition for a short
+// window, consecutive messages to the same flow and node are merged, and the
+// batch is flushed as a whole. The promise of every write is resolved once
+// the batch it was part of is processed.
+//
+// The first write into an empty batch leads it: it waits while the batch can
+// still grow (other writers are around, or the partition is busy anyway), and
+// then flushes it. A write that is alone with an idle partition is flushed
+// immediately, so batching never adds latency to an otherwise idle system.
+#ifndef K9DB_DATAFLOW_BATCHER_H_
+#define K9DB_DATAFLOW_BATCHER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+// NOLINTNEXTLINE
+#include <mutex>
+#include <vector>
+
+#include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/future.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+class Batcher {
+ public:
+  struct Stats {
+    // Writes (i.e. input messages) batched, the batches they were flushed as,
+    // and the messages written to channels for these batches.
+    uint64_t writes;
+    uint64_t batches;
+    uint64_t messages;
+  };
+
+  Batcher(const std::vector<Channel *> &channels, bool consistent);
+
+  // Not copyable or movable.
+  Batcher(const Batcher &) = delete;
+  Batcher &operator=(const Batcher &) = delete;
+
+  // Write the message to the channel of partition, possibly batched with
+  // other messages. Messages to a partition are kept in order.
+  void Write(PartitionIndex partition, Channel::Message &&msg);
+
+  Stats GetStats() const;
+
+ private:
+  struct Batch {
+    Batch() : messages(), promises(), records(0), epoch(0), led(false) {}
+    std::mutex mtx;
+    // Merged messages, in order.
+    std::vector<Channel::Message> messages;
+    // The promises of the writes in this batch.
+    std::vector<Promise> promises;
+    size_t records;
+    // Incremented every time the batch is flushed.
+    uint64_t epoch;
+    // Whether some write is leading the batch (and will flush it).
+    bool led;
+  };
+
+  // Write the batch to the channel of partition and reset it (batch.mtx must
+  // be held).
+  void Flush(PartitionIndex partition, Batch *batch);
+
+  std::vector<Channel *> channels_;
+  std::vector<std::unique_ptr<Batch>> batches_;
+  bool consistent_;
+  // Number of threads currently writing.
+  std::atomic<size_t> writers_;
+  // Statistics.
+  std::atomic<uint64_t> writes_;
+  std::atomic<uint64_t> flushes_;
+  std::atomic<uint64_t> messages_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_BATCHER_H_
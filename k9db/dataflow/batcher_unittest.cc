@@ -0,0 +1,115 @@
+#include "k9db/dataflow/batcher.h"
+
+#include <atomic>
+#include <memory>
+// NOLINTNEXTLINE
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/future.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+#include "k9db/sqlast/ast.h"
+#include "k9db/util/ints.h"
+
+namespace k9db {
+namespace dataflow {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+namespace {
+
+SchemaRef MakeSchema() {
+  return SchemaFactory::Create({"writer", "seq"}, {CType::UINT, CType::UINT},
+                               {0});
+}
+
+Channel::Message MakeMessage(SchemaRef schema, uint64_t writer, uint64_t seq,
+                             Promise &&promise) {
+  std::vector<Record> records;
+  records.emplace_back(schema, true, writer, seq);
+  return {0, std::move(records), UNDEFINED_NODE_INDEX, 0, std::move(promise)};
+}
+
+}  // namespace
+
+// A lone write is written to the channel as is.
+TEST(BatcherTest, LoneWrite) {
+  SchemaRef schema = MakeSchema();
+  Channel channel(1);
+  Batcher batcher({&channel}, true);
+
+  Future future(true);
+  batcher.Write(0, MakeMessage(schema, 0_u, 0_u, future.GetPromise()));
+  std::vector<Channel::Message> messages;
+  ASSERT_TRUE(channel.TryRead(&messages));
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages.at(0).records.size(), 1u);
+  messages.at(0).promise.Resolve();
+  future.Wait();
+
+  Batcher::Stats stats = batcher.GetStats();
+  EXPECT_EQ(stats.writes, 1u);
+  EXPECT_EQ(stats.batches, 1u);
+  EXPECT_EQ(stats.messages, 1u);
+}
+
+// Concurrent writes are merged, but the writes of every writer stay in order
+// and every writer's promise is resolved once its records are processed.
+TEST(BatcherTest, ConcurrentWrites) {
+  constexpr size_t kWriters = 8;
+  constexpr size_t kWrites = 500;
+  SchemaRef schema = MakeSchema();
+  Channel channel(1);
+  Batcher batcher({&channel}, true);
+
+  std::atomic<bool> stop = false;
+  std::atomic<size_t> records = 0;
+  std::vector<uint64_t> next(kWriters, 0);
+  std::thread consumer([&]() {
+    while (!stop.load()) {
+      std::vector<Channel::Message> messages;
+      if (!channel.TryRead(&messages)) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (Channel::Message &msg : messages) {
+        for (const Record &record : msg.records) {
+          uint64_t writer = record.GetUInt(0);
+          EXPECT_EQ(record.GetUInt(1), next.at(writer)++);
+        }
+        records += msg.records.size();
+        msg.promise.Resolve();
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (size_t w = 0; w < kWriters; w++) {
+    writers.emplace_back([&, w]() {
+      for (size_t i = 0; i < kWrites; i++) {
+        Future future(true);
+        batcher.Write(0, MakeMessage(schema, w, i, future.GetPromise()));
+        future.Wait();
+      }
+    });
+  }
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  stop.store(true);
+  consumer.join();
+
+  EXPECT_EQ(records.load(), kWriters * kWrites);
+  Batcher::Stats stats = batcher.GetStats();
+  EXPECT_EQ(stats.writes, kWriters * kWrites);
+  EXPECT_LE(stats.batches, stats.writes);
+  EXPECT_LE(stats.messages, stats.writes);
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -1,64 +1,81 @@
 #include "k9db/dataflow/channel.h"
 
+// NOLINTNEXTLINE
+#include <thread>
 #include <utility>
 
+// Messages each worker producer (and all clients together) can have in
+// flight before spilling (or blocking for clients).
+#define RING_CAPACITY 256
+
 namespace k9db {
 namespace dataflow {
 
 // Channel constructor.
-Channel::Channel(size_t workers) : queues_(workers), semaphore_(0) {}
+Channel::Channel(size_t workers)
+    : queues_(),
+      input_ring_(RING_CAPACITY),
+      depth_(0),
+      wake_() {
+  for (size_t i = 0; i < workers; i++) {
+    this->queues_.push_back(std::make_unique<WorkerQueue>(RING_CAPACITY));
+  }
+}
 
 // Called by consumer.
-std::vector<Channel::Message> Channel::Read() {
-  // Block until producer notify.
-  this->semaphore_.acquire();
-  // Consumer work up. Lock all the queues (and the semaphore).
-  std::unique_lock<std::shared_mutex> lock(this->mtx_);
-  // All producers are locked out from all members here.
-  // Step 1: Consume all notifications because we will read all the queues.
-  while (this->semaphore_.try_acquire()) {
-  }
-  // Step 2: Read all the queues.
-  std::vector<Channel::Message> result;
-  for (std::deque<Channel::Message> &queue : this->queues_) {
-    while (!queue.empty()) {
-      Channel::Message &m = queue.front();
-      result.emplace_back(std::move(m));
-      queue.pop_front();
+bool Channel::TryRead(std::vector<Channel::Message> *result) {
+  size_t count = 0;
+  for (std::unique_ptr<WorkerQueue> &queue : this->queues_) {
+    // Anything in the ring was written before anything in overflow.
+    count += queue->ring.PopInto(result, queue->ring.capacity());
+    if (queue->overflowing.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(queue->mtx);
+      while (!queue->overflow.empty()) {
+        result->push_back(std::move(queue->overflow.front()));
+        queue->overflow.pop_front();
+        count++;
+      }
+      queue->overflowing.store(false, std::memory_order_release);
     }
   }
-  while (!this->input_queue_.empty()) {
-    Channel::Message &m = this->input_queue_.front();
-    result.emplace_back(std::move(m));
-    this->input_queue_.pop_front();
+  count += this->input_ring_.PopInto(result, this->input_ring_.capacity());
+  if (count > 0) {
+    this->depth_.fetch_sub(count, std::memory_order_relaxed);
+  }
+  return count > 0;
+}
+
+void Channel::Notify() {
+  if (this->wake_) {
+    this->wake_();
   }
-  return result;
 }
 
 // Called by (worker) producers.
 void Channel::Write(PartitionIndex producer, Channel::Message &&msg) {
-  std::shared_lock<std::shared_mutex> produer_lock(this->mtx_);
-  // Other producers might be here, but not the consumer.
   // Only one producer with this index can be active, since the index
-  // is tied to the worker thread.
-  std::deque<Channel::Message> &queue = this->queues_.at(producer);
-  queue.push_back(std::move(msg));
-  this->semaphore_.release();
+  // is tied to a partition, which only one worker processes at a time.
+  WorkerQueue &queue = *this->queues_.at(producer);
+  this->depth_.fetch_add(1, std::memory_order_relaxed);
+  if (queue.overflowing.load(std::memory_order_acquire) ||
+      !queue.ring.TryPush(std::move(msg))) {
+    std::unique_lock<std::mutex> lock(queue.mtx);
+    queue.overflow.push_back(std::move(msg));
+    queue.overflowing.store(true, std::memory_order_release);
+  }
+  this->Notify();
 }
 
 // Called by (client) producers.
 void Channel::WriteInput(Channel::Message &&msg) {
-  std::shared_lock<std::shared_mutex> produer_lock(this->mtx_);
-  // Many producers might be here, but not the consumer.
-  std::unique_lock<std::mutex> input_lock(this->input_mtx_);
-  // Only one input producer, input_queue_ is safe!
-  this->input_queue_.push_back(std::move(msg));
-  this->semaphore_.release();
-}
-
-void Channel::Shutdown() {
-  std::shared_lock<std::shared_mutex> produer_lock(this->mtx_);
-  this->semaphore_.release();
+  // Many producers might be here, the ring orders them.
+  this->depth_.fetch_add(1, std::memory_order_relaxed);
+  while (!this->input_ring_.TryPush(std::move(msg))) {
+    // Backpressure: wait for the consumer to catch up.
+    this->Notify();
+    std::this_thread::yield();
+  }
+  this->Notify();
 }
 
 }  // namespace dataflow
@@ -1,18 +1,18 @@
 #ifndef K9DB_DATAFLOW_CHANNEL_H_
 #define K9DB_DATAFLOW_CHANNEL_H_
 
+#include <atomic>
 #include <deque>
+#include <functional>
+#include <memory>
 // NOLINTNEXTLINE
 #include <mutex>
-// NOLINTNEXTLINE
-#include <semaphore>
-// NOLINTNEXTLINE
-#include <shared_mutex>
 #include <string>
 #include <vector>
 
 #include "k9db/dataflow/future.h"
 #include "k9db/dataflow/record.h"
+#include "k9db/dataflow/ring_buffer.h"
 #include "k9db/dataflow/types.h"
 
 namespace k9db {
@@ -20,9 +20,11 @@ namespace dataflow {
 
 class Channel {
  public:
-  // A batch of records with source and target operators.
+  // A batch of records with source and target operators. Flows are identified
+  // by index rather than name, so that workers need not look them up by name
+  // (see FlowTable).
   struct Message {
-    std::string flow_name;
+    FlowIndex flow;
     std::vector<Record> records;
     NodeIndex source;
     NodeIndex target;
@@ -32,8 +34,19 @@ class Channel {
   // Constructor.
   explicit Channel(size_t workers);
 
-  // Called by consumer.
-  std::vector<Message> Read();
+  // Called by consumer. Never blocks, returns false if there is nothing to
+  // read. Consumers may change over time (see Scheduler) but must never read
+  // concurrently.
+  bool TryRead(std::vector<Message> *result);
+
+  // Messages written but not read yet (approximate).
+  size_t Depth() const { return this->depth_.load(std::memory_order_relaxed); }
+
+  // Call wake after every write, so that a pool of workers can find the
+  // channel to consume.
+  void SetWakeUp(std::function<void()> &&wake) {
+    this->wake_ = std::move(wake);
+  }
 
   // Called by (worker) producers.
   void Write(PartitionIndex producer, Message &&msg);
@@ -41,20 +54,30 @@ class Channel {
   // Called by (client) producers.
   void WriteInput(Message &&msg);
 
-  void Shutdown();
-
  private:
-  // A queue for each producer (e.g. partition).
-  std::vector<std::deque<Message>> queues_;
-  std::deque<Message> input_queue_;
-  // Synchronizes the many producers (shared) with the consumer (unique).
-  // When a consumer is reading data from queue, this is acquired uniquely
-  // and no produced can operate.
-  std::shared_mutex mtx_;
-  std::mutex input_mtx_;  // input_queue_ is shared between many producers.
-  // A better notification variable that is lightweight and guarantees
-  // notifications will never be lost in our design.
-  std::binary_semaphore semaphore_;
+  // The messages of one worker producer.
+  struct WorkerQueue {
+    explicit WorkerQueue(size_t capacity)
+        : ring(capacity), overflow(), overflowing(false) {}
+    RingBuffer<Message> ring;
+    // Workers are consumers of their own channel, so they cannot block on a
+    // full ring (two workers writing to each other's full rings would
+    // deadlock). Instead, messages spill into overflow until the consumer
+    // drains it. Once spilling, all messages go to overflow to keep order.
+    std::mutex mtx;
+    std::deque<Message> overflow;
+    std::atomic<bool> overflowing;
+  };
+
+  // Tell the consumers about new messages (producers).
+  void Notify();
+
+  // A ring for each worker producer (e.g. partition).
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  // Clients block (spin) when the input ring is full (backpressure).
+  RingBuffer<Message> input_ring_;
+  std::atomic<size_t> depth_;
+  std::function<void()> wake_;
 };
 
 }  // namespace dataflow
@@ -0,0 +1,99 @@
+#include "k9db/dataflow/channel.h"
+
+#include <atomic>
+#include <string>
+// NOLINTNEXTLINE
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/future.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+namespace {
+
+Channel::Message MakeMessage(NodeIndex source, NodeIndex target) {
+  return {0, {}, source, target, Promise::None.Derive()};
+}
+
+}  // namespace
+
+// Messages of every producer arrive in order, including when rings are full
+// and messages spill over.
+TEST(ChannelTest, ProducerOrder) {
+  constexpr size_t kProducers = 4;
+  constexpr size_t kMessages = 2000;
+  Channel channel(kProducers);
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kProducers; p++) {
+    producers.emplace_back([&channel, p]() {
+      for (size_t i = 0; i < kMessages; i++) {
+        channel.Write(p, MakeMessage(p, i));
+      }
+    });
+  }
+  std::thread client([&channel]() {
+    for (size_t i = 0; i < kMessages; i++) {
+      channel.WriteInput(MakeMessage(UNDEFINED_NODE_INDEX, i));
+    }
+  });
+
+  std::vector<size_t> next(kProducers, 0);
+  size_t next_input = 0;
+  size_t total = 0;
+  std::vector<Channel::Message> messages;
+  while (total < (kProducers + 1) * kMessages) {
+    messages.clear();
+    if (!channel.TryRead(&messages)) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (Channel::Message &msg : messages) {
+      if (msg.source == UNDEFINED_NODE_INDEX) {
+        EXPECT_EQ(msg.target, next_input++);
+      } else {
+        EXPECT_EQ(msg.target, next.at(msg.source)++);
+      }
+      total++;
+    }
+  }
+
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+  client.join();
+  EXPECT_EQ(next_input, kMessages);
+  for (size_t p = 0; p < kProducers; p++) {
+    EXPECT_EQ(next.at(p), kMessages);
+  }
+}
+
+// Every write calls the wake up function, and TryRead never blocks.
+TEST(ChannelTest, WakeUp) {
+  Channel channel(1);
+  std::atomic<size_t> wakes = 0;
+  channel.SetWakeUp([&wakes]() { wakes++; });
+
+  std::vector<Channel::Message> messages;
+  EXPECT_FALSE(channel.TryRead(&messages));
+  channel.Write(0, MakeMessage(0, 7));
+  EXPECT_EQ(wakes.load(), 1);
+  channel.WriteInput(MakeMessage(UNDEFINED_NODE_INDEX, 8));
+  EXPECT_EQ(wakes.load(), 2);
+  EXPECT_EQ(channel.Depth(), 2);
+
+  ASSERT_TRUE(channel.TryRead(&messages));
+  ASSERT_EQ(messages.size(), 2);
+  EXPECT_EQ(messages.at(0).target, 7);
+  EXPECT_EQ(messages.at(1).target, 8);
+  EXPECT_EQ(channel.Depth(), 0);
+  EXPECT_FALSE(channel.TryRead(&messages));
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,43 @@
+// Durable checkpoints of the state of flows.
+//
+// A checkpoint of a flow consists of the state of all its stateful operators
+// (see Operator::Checkpoint()), in all partitions, as batches of records.
+// Checkpoints are persisted by the underlying database together with a
+// watermark: the checkpoint reflects all the writes up to the watermark, so
+// that a flow can be restored from it by replaying only later writes.
+#ifndef K9DB_DATAFLOW_CHECKPOINT_H_
+#define K9DB_DATAFLOW_CHECKPOINT_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+// The records of one batch of the state of one operator.
+struct CheckpointBatch {
+  PartitionIndex partition;
+  NodeIndex node;
+  // Index of the batch among the batches of the operator.
+  uint32_t batch;
+  std::vector<Record> records;
+};
+
+// The schema of the records of a batch given (partition, node, batch).
+using CheckpointSchemas =
+    std::function<SchemaRef(PartitionIndex, NodeIndex, uint32_t)>;
+
+struct FlowCheckpoint {
+  uint64_t watermark;
+  std::vector<CheckpointBatch> batches;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_CHECKPOINT_H_
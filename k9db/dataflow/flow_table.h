@@ -0,0 +1,82 @@
+// Maps flow indices (see Channel::Message) to their flows.
+//
+// Workers look up the flow of every message they process, so the table is
+// read without any locks: it is append-only and entries never move once
+// added. The table is made of segments of doubling sizes (1, 2, 4, ...), and
+// a new segment is allocated whenever the previous ones are full.
+//
+// A flow must be added before any message for it is written to a channel, the
+// channel then makes the added flow visible to the worker reading the message.
+#ifndef K9DB_DATAFLOW_FLOW_TABLE_H_
+#define K9DB_DATAFLOW_FLOW_TABLE_H_
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "glog/logging.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+class DataFlowGraph;
+
+class FlowTable {
+ public:
+  FlowTable() : size_(0), segments_() {}
+
+  // Not copyable or movable.
+  FlowTable(const FlowTable &) = delete;
+  FlowTable &operator=(const FlowTable &) = delete;
+
+  // Adds the flow and returns its index. Calls to Add() must be synchronized
+  // (e.g. under the exclusive lock of DataFlowState).
+  FlowIndex Add(DataFlowGraph *flow) {
+    FlowIndex index = this->size_++;
+    auto [segment, offset] = Locate(index);
+    CHECK_LT(segment, SEGMENTS) << "Too many flows";
+    if (offset == 0) {
+      this->segments_[segment] =
+          std::make_unique<DataFlowGraph *[]>(size_t(1) << segment);
+    }
+    this->segments_[segment][offset] = flow;
+    return index;
+  }
+
+  // Replaces the flow at the given index. Must be synchronized like Add(), and
+  // no message for that index may be written or processed concurrently.
+  void Replace(FlowIndex index, DataFlowGraph *flow) {
+    CHECK_LT(index, this->size_) << "Flow was not added";
+    auto [segment, offset] = Locate(index);
+    this->segments_[segment][offset] = flow;
+  }
+
+  // The flow with the given index, which must have been added.
+  DataFlowGraph *Get(FlowIndex index) const {
+    auto [segment, offset] = Locate(index);
+    return this->segments_[segment][offset];
+  }
+
+  size_t Size() const { return this->size_; }
+
+ private:
+  static constexpr size_t SEGMENTS = 32;
+
+  // Segment k holds indices [2^k - 1, 2^(k+1) - 1).
+  static std::pair<size_t, size_t> Locate(FlowIndex index) {
+    uint64_t i = static_cast<uint64_t>(index) + 1;
+    size_t segment = std::bit_width(i) - 1;
+    return {segment, i - (uint64_t(1) << segment)};
+  }
+
+  size_t size_;
+  std::array<std::unique_ptr<DataFlowGraph *[]>, SEGMENTS> segments_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_FLOW_TABLE_H_
@@ -0,0 +1,41 @@
+#include "k9db/dataflow/flow_table.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+// Flows keep their index and address across segments.
+TEST(FlowTableTest, AddAndGet) {
+  constexpr size_t kFlows = 1000;
+  std::vector<int> flows(kFlows);
+  FlowTable table;
+  for (size_t i = 0; i < kFlows; i++) {
+    DataFlowGraph *flow = reinterpret_cast<DataFlowGraph *>(&flows.at(i));
+    EXPECT_EQ(table.Add(flow), i);
+    EXPECT_EQ(table.Size(), i + 1);
+  }
+  for (FlowIndex i = 0; i < kFlows; i++) {
+    EXPECT_EQ(table.Get(i), reinterpret_cast<DataFlowGraph *>(&flows.at(i)));
+  }
+}
+
+// Replaced flows keep their index.
+TEST(FlowTableTest, Replace) {
+  std::vector<int> flows(4);
+  FlowTable table;
+  for (size_t i = 0; i < 3; i++) {
+    table.Add(reinterpret_cast<DataFlowGraph *>(&flows.at(i)));
+  }
+  table.Replace(1, reinterpret_cast<DataFlowGraph *>(&flows.at(3)));
+  EXPECT_EQ(table.Size(), 3u);
+  EXPECT_EQ(table.Get(0), reinterpret_cast<DataFlowGraph *>(&flows.at(0)));
+  EXPECT_EQ(table.Get(1), reinterpret_cast<DataFlowGraph *>(&flows.at(3)));
+  EXPECT_EQ(table.Get(2), reinterpret_cast<DataFlowGraph *>(&flows.at(2)));
+}
+
+}  // namespace dataflow
+}  // namespace k9db
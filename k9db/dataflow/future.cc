@@ -1,5 +1,8 @@
 #include "k9db/dataflow/future.h"
 
+#include <limits>
+#include <utility>
+
 #include "glog/logging.h"
 
 namespace k9db {
@@ -10,14 +13,21 @@ Promise Future::GetPromise() {
 }
 
 void Future::Increment() {
-  uint16_t value = this->counter_++;
+  uint32_t value = this->counter_++;
   CHECK_GT(value, 0) << "Late promise";
+  CHECK_LT(value, std::numeric_limits<uint32_t>::max()) << "Too many promises";
 }
 
 void Future::Decrement() {
-  uint16_t value = this->counter_--;
+  uint32_t value = this->counter_--;
   CHECK_GT(value, 0) << "Early promise";
   if (value == 1) {
+    if (this->done_) {
+      std::function<void()> done = std::move(this->done_);
+      delete this;
+      done();
+      return;
+    }
     // Only one thread should be waiting on the single future object.
     this->semaphore_.release();
   }
@@ -33,6 +43,12 @@ void Future::Wait() {
   }
 }
 
+void Future::Then(std::function<void()> &&done) {
+  CHECK(this->consistent_) << "Inconsistent futures never resolve";
+  this->done_ = std::move(done);
+  this->Decrement();
+}
+
 void Promise::Resolve() {
   if (this->future_ != nullptr) {
     this->future_->Decrement();
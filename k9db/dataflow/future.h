@@ -4,8 +4,12 @@
 #include <atomic>
 // NOLINTNEXTLINE
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 // NOLINTNEXTLINE
 #include <mutex>
+// NOLINTNEXTLINE
+#include <semaphore>
 
 #include "gtest/gtest_prod.h"
 
@@ -35,14 +39,21 @@ class Future {
 
   // Blocks until the future resolves.
   void Wait();
+  // Instead of waiting, calls done (from the thread resolving the last
+  // promise) once the future resolves, and deletes the future. The future must
+  // be allocated with new and be consistent.
+  void Then(std::function<void()> &&done);
 
  private:
   void Increment();
   void Decrement();
 
   bool consistent_;
-  std::atomic<uint16_t> counter_;
+  // Number of pending promises, each derived promise (e.g. one per message
+  // produced while processing a batch) holds one.
+  std::atomic<uint32_t> counter_;
   std::binary_semaphore semaphore_;
+  std::function<void()> done_;
 
   // Allow promise to change counter value.
   friend class Promise;
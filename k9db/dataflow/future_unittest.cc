@@ -16,6 +16,19 @@ TEST(FutureTest, BasicTest) {
   future.Wait();
 }
 
+TEST(FutureTest, ThenTest) {
+  bool done = false;
+  Future *future = new Future(true);
+  Promise p1 = future->GetPromise();
+  Promise p2 = p1.Derive();
+  future->Then([&done]() { done = true; });
+  EXPECT_FALSE(done);
+  p2.Resolve();
+  EXPECT_FALSE(done);
+  p1.Resolve();
+  EXPECT_TRUE(done);
+}
+
 TEST(FutureTest, InconsistentTest) {
   Future future(false);
   Promise p1 = future.GetPromise();
@@ -13,6 +13,7 @@
 #include "k9db/dataflow/ops/input.h"
 #include "k9db/dataflow/ops/matview.h"
 #include "k9db/dataflow/ops/project.h"
+#include "k9db/dataflow/ops/topk.h"
 #include "k9db/dataflow/ops/union.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
@@ -97,14 +98,15 @@ NodeIndex DataFlowGraphGenerator::AddAggregateOperator(
   CHECK(this->graph_->AddNode(std::move(op), parent_ptr));
   return this->graph_->LastOperatorIndex();
 }
-NodeIndex DataFlowGraphGenerator::AddJoinOperator(NodeIndex left_parent,
-                                                  NodeIndex right_parent,
-                                                  ColumnID left_column,
-                                                  ColumnID right_column,
-                                                  JoinModeEnum mode) {
+NodeIndex DataFlowGraphGenerator::AddJoinOperator(
+    NodeIndex left_parent, NodeIndex right_parent,
+    const std::vector<ColumnID> &left_columns,
+    const std::vector<ColumnID> &right_columns, JoinModeEnum mode,
+    const std::vector<ColumnID> &left_keep,
+    const std::vector<ColumnID> &right_keep) {
   // Create equijoin operator.
-  std::unique_ptr<EquiJoinOperator> op =
-      std::make_unique<EquiJoinOperator>(left_column, right_column, mode);
+  std::unique_ptr<EquiJoinOperator> op = std::make_unique<EquiJoinOperator>(
+      left_columns, right_columns, mode, left_keep, right_keep);
   // Add the operator to the graph.
   Operator *left_ptr = this->graph_->GetNode(left_parent);
   Operator *right_ptr = this->graph_->GetNode(right_parent);
@@ -113,6 +115,18 @@ NodeIndex DataFlowGraphGenerator::AddJoinOperator(NodeIndex left_parent,
   CHECK(this->graph_->AddNode(std::move(op), {left_ptr, right_ptr}));
   return this->graph_->LastOperatorIndex();
 }
+NodeIndex DataFlowGraphGenerator::AddTopKOperator(
+    NodeIndex parent, const std::vector<ColumnID> &group_cols,
+    const std::vector<ColumnID> &sort_cols, size_t limit) {
+  // Create top k operator.
+  std::unique_ptr<TopKOperator> op =
+      std::make_unique<TopKOperator>(group_cols, sort_cols, limit);
+  // Add the operator to the graph.
+  Operator *parent_ptr = this->graph_->GetNode(parent);
+  CHECK(parent_ptr);
+  CHECK(this->graph_->AddNode(std::move(op), parent_ptr));
+  return this->graph_->LastOperatorIndex();
+}
 
 // Output materialized views.
 NodeIndex DataFlowGraphGenerator::AddMatviewOperator(
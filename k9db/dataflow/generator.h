@@ -44,9 +44,19 @@ class DataFlowGraphGenerator {
                                  AggregateFunctionEnum agg_func,
                                  ColumnID agg_col,
                                  const std::string &agg_col_name);
+  // Only the columns in left_keep (right_keep) are kept in the join state and
+  // output, all columns are kept if empty (see EquiJoinOperator).
   NodeIndex AddJoinOperator(NodeIndex left_parent, NodeIndex right_parent,
-                            ColumnID left_column, ColumnID right_column,
-                            JoinModeEnum mode);
+                            const std::vector<ColumnID> &left_columns,
+                            const std::vector<ColumnID> &right_columns,
+                            JoinModeEnum mode,
+                            const std::vector<ColumnID> &left_keep,
+                            const std::vector<ColumnID> &right_keep);
+  // Keep the first limit records (by sort_cols) of every group.
+  NodeIndex AddTopKOperator(NodeIndex parent,
+                            const std::vector<ColumnID> &group_cols,
+                            const std::vector<ColumnID> &sort_cols,
+                            size_t limit);
 
   // Adding output materialized views.
   // Unordered mat view.
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iterator>
 #include <list>
+#include <sstream>
 #include <tuple>
 #include <utility>
 // NOLINTNEXTLINE
@@ -16,6 +17,7 @@
 #include "k9db/dataflow/ops/forward_view.h"
 #include "k9db/dataflow/ops/input.h"
 #include "k9db/dataflow/ops/project.h"
+#include "k9db/dataflow/ops/topk.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/util/merge_sort.h"
 
@@ -137,9 +139,10 @@ void DataFlowGraph::Initialize(
       }
     }
   }
+  this->has_exchanges_ = exchanges.size() > 0;
   for (const auto &[key, parent, child] : exchanges) {
     auto exchange = std::make_unique<ExchangeOperator>(
-        this->flow_name_, this->size_, channels, key);
+        this->index_, this->size_, channels, key);
     partition->InsertNode(std::move(exchange), parent, child);
   }
 
@@ -367,6 +370,117 @@ std::vector<Record> DataFlowGraph::LookupKeyGreater(const Key &key, int limit,
   return records;
 }
 
+// Partial state.
+bool DataFlowGraph::SupportsPartial() const {
+  return this->matview_partition_match_ && this->matview_keys_.size() > 0 &&
+         !this->has_exchanges_ && this->partitions_.front()->forwards().empty();
+}
+
+void DataFlowGraph::Partial(uint64_t budget) {
+  CHECK(this->SupportsPartial()) << "Flow cannot be partial";
+  // The budget is split evenly between partitions.
+  uint64_t partition_budget = std::max<uint64_t>(budget / this->size_, 1);
+  for (auto matview : this->matviews_) {
+    matview->Partial(partition_budget);
+  }
+}
+
+std::vector<Key> DataFlowGraph::Misses(const std::vector<Key> &keys) const {
+  std::vector<Key> misses;
+  for (const Key &key : keys) {
+    PartitionIndex partition = key.Hash() % this->partitions_.size();
+    if (!this->matviews_.at(partition)->Filled(key)) {
+      misses.push_back(key);
+    }
+  }
+  return misses;
+}
+
+void DataFlowGraph::Fill(
+    const Key &key,
+    std::unordered_map<std::string, std::vector<Record>> &&inputs) const {
+  PartitionIndex partition = key.Hash() % this->partitions_.size();
+  // Compute the records of key by processing the input records with a fresh
+  // (empty) clone of the partition that holds key. There are no exchanges, so
+  // processing is synchronous and stays within the clone.
+  std::unique_ptr<DataFlowGraphPartition> upquery =
+      this->partitions_.at(partition)->Clone(partition, {});
+  for (auto &[input_name, records] : inputs) {
+    InputOperator *input = upquery->GetInputNode(input_name);
+    input->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(records),
+                             Promise::None.Derive());
+  }
+  std::vector<Record> records = upquery->outputs().at(0)->Lookup(key);
+  this->matviews_.at(partition)->Fill(key, std::move(records));
+}
+
+// Checkpointing.
+bool DataFlowGraph::SupportsCheckpoint() const {
+  return !this->partial() && this->partitions_.front()->forwards().empty();
+}
+
+// The signature is persisted with checkpoints, so it must not depend on the
+// build: it hashes the plan and the schemas of the inputs with 64-bit FNV-1a.
+std::string DataFlowGraph::Signature() const {
+  const DataFlowGraphPartition *partition = this->partitions_.front().get();
+  std::ostringstream description;
+  description << partition->DebugString();
+  std::vector<std::string> inputs = this->inputs_;
+  std::sort(inputs.begin(), inputs.end());
+  for (const std::string &input : inputs) {
+    description << input << partition->GetInputNode(input)->output_schema();
+  }
+
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : description.str()) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return std::to_string(this->size_) + "|" + std::to_string(hash);
+}
+
+std::vector<CheckpointBatch> DataFlowGraph::Checkpoint() const {
+  CHECK(this->SupportsCheckpoint()) << "Flow cannot be checkpointed";
+  std::vector<CheckpointBatch> result;
+  for (PartitionIndex p = 0; p < this->size_; p++) {
+    const auto &nodes = this->partitions_.at(p)->nodes();
+    for (NodeIndex index = 0; index < nodes.size(); index++) {
+      std::vector<std::vector<Record>> batches = nodes.at(index)->Checkpoint();
+      for (uint32_t b = 0; b < batches.size(); b++) {
+        result.push_back({p, index, b, std::move(batches.at(b))});
+      }
+    }
+  }
+  return result;
+}
+
+std::vector<SchemaRef> DataFlowGraph::CheckpointSchemas(NodeIndex node) const {
+  Operator *op = this->partitions_.front()->GetNode(node);
+  CHECK_NOTNULL(op);
+  return op->CheckpointSchemas();
+}
+
+void DataFlowGraph::Restore(std::vector<CheckpointBatch> &&batches) const {
+  CHECK(this->SupportsCheckpoint()) << "Flow cannot be restored";
+  // Group the batches by operator.
+  std::unordered_map<Operator *, std::vector<std::vector<Record>>> state;
+  for (CheckpointBatch &batch : batches) {
+    Operator *op = this->partitions_.at(batch.partition)->GetNode(batch.node);
+    CHECK_NOTNULL(op);
+    std::vector<std::vector<Record>> &op_state = state[op];
+    if (op_state.empty()) {
+      op_state.resize(op->CheckpointSchemas().size());
+    }
+    std::vector<Record> &records = op_state.at(batch.batch);
+    records.insert(records.end(),
+                   std::make_move_iterator(batch.records.begin()),
+                   std::make_move_iterator(batch.records.end()));
+  }
+  for (auto &[op, op_state] : state) {
+    op->Restore(std::move(op_state));
+  }
+}
+
 // Debugging information.
 uint64_t DataFlowGraph::SizeInMemory(std::vector<Record> *output) const {
   uint64_t total_size = 0;
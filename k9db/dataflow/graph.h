@@ -1,6 +1,7 @@
 #ifndef K9DB_DATAFLOW_GRAPH_H_
 #define K9DB_DATAFLOW_GRAPH_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -8,6 +9,7 @@
 
 #include "gtest/gtest_prod.h"
 #include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/checkpoint.h"
 #include "k9db/dataflow/graph_partition.h"
 #include "k9db/dataflow/key.h"
 #include "k9db/dataflow/ops/matview.h"
@@ -21,8 +23,12 @@ namespace dataflow {
 // A graph is made out of many partitions.
 class DataFlowGraph {
  public:
-  DataFlowGraph(const std::string &flow_name, PartitionIndex partitions)
-      : flow_name_(flow_name), size_(partitions) {}
+  DataFlowGraph(const std::string &flow_name, FlowIndex index,
+                PartitionIndex partitions)
+      : flow_name_(flow_name),
+        index_(index),
+        size_(partitions),
+        has_exchanges_(false) {}
 
   void Initialize(
       std::unique_ptr<DataFlowGraphPartition> &&partition,
@@ -37,6 +43,7 @@ class DataFlowGraph {
 
   // Accessors.
   const std::string &flow_name() const { return this->flow_name_; }
+  FlowIndex index() const { return this->index_; }
   const std::vector<std::string> &Inputs() const { return this->inputs_; }
   const SchemaRef &output_schema() const { return this->output_schema_; }
   const std::vector<ColumnID> &matview_keys() const {
@@ -71,12 +78,44 @@ class DataFlowGraph {
   std::vector<Record> LookupKeyGreater(const Key &key, int limit,
                                        size_t offset) const;
 
+  // Partial state (see MatViewOperator::Partial()).
+  // Only supported when the output is keyed and the flow has no exchanges and
+  // no parent views, so that the records of a key depend only on the records
+  // of every input that have the same value of the input partition key.
+  bool SupportsPartial() const;
+  void Partial(uint64_t budget);
+  bool partial() const { return this->matviews_.front()->partial(); }
+  // The keys among keys that are not filled.
+  std::vector<Key> Misses(const std::vector<Key> &keys) const;
+  // Upquery: compute the records of key from the given input records (from
+  // every input, the records whose partition key equals key), and fill key
+  // with them.
+  void Fill(const Key &key,
+            std::unordered_map<std::string, std::vector<Record>> &&inputs)
+      const;
+
+  // Checkpointing (see checkpoint.h).
+  // Partial flows are not checkpointed, since they are cheap to rebuild, and
+  // neither are flows over other views, since they are updated through the
+  // views they read from.
+  bool SupportsCheckpoint() const;
+  // Identifies the structure of the flow: a checkpoint is only restored into
+  // a flow with the same signature (same plan, input schemas, and number of
+  // partitions). Stable across builds.
+  std::string Signature() const;
+  std::vector<CheckpointBatch> Checkpoint() const;
+  // The schemas of the batches of the given node (same in all partitions).
+  std::vector<SchemaRef> CheckpointSchemas(NodeIndex node) const;
+  // Must be called before the flow processes any records.
+  void Restore(std::vector<CheckpointBatch> &&batches) const;
+
   // Debugging information.
   uint64_t SizeInMemory(std::vector<Record> *output) const;
   std::vector<Record> DebugRecords() const;
 
  private:
   std::string flow_name_;
+  FlowIndex index_;
   PartitionIndex size_;
   // partitions and their inputs and outputs.
   std::vector<std::unique_ptr<DataFlowGraphPartition>> partitions_;
@@ -95,6 +134,8 @@ class DataFlowGraph {
   // will be empty.
   std::vector<ColumnID> matview_keys_;
   bool matview_partition_match_;
+  // Whether exchanges were added to the partitions.
+  bool has_exchanges_;
 
   // Unit tests need to look inside partitions_, inkeys_, and outkey_.
   FRIEND_TEST(DataFlowGraphTest, JoinAggregateFunctionality);
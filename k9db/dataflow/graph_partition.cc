@@ -2,7 +2,6 @@
 
 #include <memory>
 #include <queue>
-#include <set>
 #include <unordered_set>
 #include <utility>
 
@@ -52,9 +51,13 @@ bool DataFlowGraphPartition::AddNode(std::unique_ptr<Operator> &&op,
     op->AddParent(parent);
   }
 
-  const auto &[_, inserted] = this->nodes_.emplace(idx, std::move(op));
-  CHECK(inserted);
-  return inserted;
+  // Clone() adds nodes out of order.
+  if (idx >= this->nodes_.size()) {
+    this->nodes_.resize(idx + 1);
+  }
+  CHECK(this->nodes_.at(idx) == nullptr);
+  this->nodes_.at(idx) = std::move(op);
+  return true;
 }
 
 bool DataFlowGraphPartition::InsertNode(std::unique_ptr<Operator> &&op,
@@ -69,9 +72,7 @@ bool DataFlowGraphPartition::InsertNode(std::unique_ptr<Operator> &&op,
   op->AddParent(parent);
   child->AddParentAt(op.get(), parent_index);
 
-  const auto &[_, inserted] = this->nodes_.emplace(idx, std::move(op));
-  CHECK(inserted);
-  return inserted;
+  this->nodes_.push_back(std::move(op));
   return true;
 }
 
@@ -84,14 +85,8 @@ void DataFlowGraphPartition::_Process(const std::string &input_name,
 
 std::string DataFlowGraphPartition::DebugString() const {
   // Go over nodes in order (of index).
-  std::set<NodeIndex> ordered_nodes;
-  for (const auto &[idx, _] : this->nodes_) {
-    ordered_nodes.insert(idx);
-  }
-
   std::string str = "[\n";
-  for (auto idx : ordered_nodes) {
-    const auto &node = this->nodes_.at(idx);
+  for (const auto &node : this->nodes_) {
     str += " {\n";
     str += node->DebugString();
     str += " },\n";
@@ -102,12 +97,8 @@ std::string DataFlowGraphPartition::DebugString() const {
 std::vector<Record> DataFlowGraphPartition::DebugRecords() const {
   std::vector<Record> records;
   // Go over nodes in order (of index).
-  std::set<NodeIndex> ordered_nodes;
-  for (const auto &[idx, _] : this->nodes_) {
-    ordered_nodes.insert(idx);
-  }
-  for (auto idx : ordered_nodes) {
-    records.push_back(this->nodes_.at(idx)->DebugRecord());
+  for (const auto &node : this->nodes_) {
+    records.push_back(node->DebugRecord());
   }
   return records;
 }
@@ -115,7 +106,7 @@ std::vector<Record> DataFlowGraphPartition::DebugRecords() const {
 uint64_t DataFlowGraphPartition::SizeInMemory(
     const std::string &flow_name, std::vector<Record> *output) const {
   uint64_t size = 0;
-  for (const auto &[_, node] : this->nodes_) {
+  for (const auto &node : this->nodes_) {
     size += node->SizeInMemory(flow_name, output);
   }
   return size;
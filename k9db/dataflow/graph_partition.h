@@ -69,15 +69,15 @@ class DataFlowGraphPartition {
   const std::vector<MatViewOperator *> &outputs() const {
     return this->outputs_;
   }
-  const std::unordered_map<NodeIndex, std::unique_ptr<Operator>> &nodes()
-      const {
+  const std::vector<std::unique_ptr<Operator>> &nodes() const {
     return this->nodes_;
   }
 
   // Get node by its index.
   inline Operator *GetNode(NodeIndex node_index) const {
-    auto it = nodes_.find(node_index);
-    return it == nodes_.end() ? nullptr : it->second.get();
+    return node_index < this->nodes_.size()
+               ? this->nodes_[node_index].get()
+               : nullptr;
   }
   InputOperator *GetInputNode(const std::string &input_name) const {
     return this->inputs_.at(input_name);
@@ -115,7 +115,8 @@ class DataFlowGraphPartition {
   std::vector<MatViewOperator *> outputs_;
 
   // Nodes have doubly edges from parent to children and back stored inside.
-  std::unordered_map<NodeIndex, std::unique_ptr<Operator>> nodes_;
+  // Indexed by NodeIndex (node indices are dense).
+  std::vector<std::unique_ptr<Operator>> nodes_;
 };
 
 }  // namespace dataflow
@@ -468,10 +468,10 @@ inline void MatViewContentsEqualsIndexed(MatViewOperator *matview,
 // Make a placeholder exchange to check that cloning exchanges
 // works correctly.
 std::unique_ptr<ExchangeOperator> MakeExchange(const PartitionKey &key) {
-  std::string flow_name = "testflow";
+  FlowIndex flow_index = 0;
   PartitionIndex partitions = 0;
   std::vector<Channel *> chans;
-  return std::make_unique<ExchangeOperator>(flow_name, partitions, chans, key);
+  return std::make_unique<ExchangeOperator>(flow_index, partitions, chans, key);
 }
 
 // Tests!
@@ -691,6 +691,32 @@ TEST(DataFlowGraphPartitionTest, CloneExchangeReprTest) {
   ASSERT_EQ(g2->DebugString(), g2_clone->DebugString());
 }
 
+// Records forwarded to several children share their data.
+TEST(DataFlowGraphPartitionTest, ForkSharesRecords) {
+  // Schema must survive records.
+  SchemaRef schema = MakeLeftSchema();
+  // Make graph with input feeding two views.
+  DataFlowGraphPartition g{0};
+  auto in = std::make_unique<InputOperator>("test-table", schema);
+  auto matview1 = std::make_unique<UnorderedMatViewOperator>(schema.keys());
+  auto matview2 = std::make_unique<UnorderedMatViewOperator>(schema.keys());
+  Operator *in_ptr = in.get();
+  EXPECT_TRUE(g.AddInputNode(std::move(in)));
+  EXPECT_TRUE(g.AddOutputOperator(std::move(matview1), in_ptr));
+  EXPECT_TRUE(g.AddOutputOperator(std::move(matview2), in_ptr));
+  // Process records.
+  g._Process("test-table", MakeLeftRecords(schema));
+  // Both views have the records, backed by the same data.
+  std::vector<Record> records = MakeLeftRecords(schema);
+  MatViewContentsEquals(g.outputs().at(0), records);
+  MatViewContentsEquals(g.outputs().at(1), records);
+  for (const Record &record : records) {
+    std::vector<Record> r1 = g.outputs().at(0)->Lookup(record.GetKey());
+    std::vector<Record> r2 = g.outputs().at(1)->Lookup(record.GetKey());
+    EXPECT_EQ(&r1.front().GetString(1), &r2.front().GetString(1));
+  }
+}
+
 #ifndef K9DB_VALGRIND_MODE
 TEST(RecordTest, TestDuplicateInputGraph) {
   // Create a schema.
@@ -102,14 +102,15 @@ void Operator::BroadcastToChildren(std::vector<Record> &&records,
 
   // We are at a fork in the graph with many children.
   for (size_t i = 0; i < this->children_.size() - 1; i++) {
-    // We need to copy the records for each child (except the last one).
-    std::vector<Record> copy;
-    copy.reserve(records.size());
+    // Each child (except the last one) gets its own vector of records, but
+    // they all share the same underlying data.
+    std::vector<Record> shared;
+    shared.reserve(records.size());
     for (const Record &r : records) {
-      copy.push_back(r.Copy());
+      shared.push_back(r.Share());
     }
-    // Move the copy to child.
-    this->children_.at(i)->ProcessAndForward(this->index_, std::move(copy),
+    // Move the shared records to child.
+    this->children_.at(i)->ProcessAndForward(this->index_, std::move(shared),
                                              promise.Derive());
   }
   // Reuse promise for the last child.
@@ -150,6 +151,9 @@ std::string Operator::DebugString() const {
     case Operator::Type::EXCHANGE:
       type_str = "EXCHANGE";
       break;
+    case Operator::Type::TOP_K:
+      type_str = "TOP_K";
+      break;
   }
 
   std::string str = "";
@@ -220,6 +224,9 @@ Record Operator::DebugRecord() const {
     case Operator::Type::FORWARD_VIEW:
       record.SetString(std::make_unique<std::string>("FORWARD_VIEW"), 1);
       break;
+    case Operator::Type::TOP_K:
+      record.SetString(std::make_unique<std::string>("TOP_K"), 1);
+      break;
   }
   // Output schema.
   std::stringstream out_buffer;
@@ -34,6 +34,7 @@ class Operator {
     PROJECT,
     AGGREGATE,
     EXCHANGE,
+    TOP_K,
   };
 
   // Cannot copy an operator.
@@ -47,6 +48,10 @@ class Operator {
    * through the dataflow graph. I.e., the batch will be processed through this
    * node and then pushed to all children nodes for further processing.
    * Internally calls process(...) function.
+   * Records may share their data with records seen by other operators or
+   * stored in their state (see Record::Share()), thus operators must never
+   * modify the data of records they are given, and instead create new
+   * records when data changes (e.g. projection or join outputs).
    * @param source
    * @param records
    * @return
@@ -70,6 +75,15 @@ class Operator {
   uint64_t SizeInMemory(const std::string &flow_name,
                         std::vector<Record> *output) const;
 
+  // Checkpointing.
+  // Stateful operators expose their state as batches of records, where all the
+  // records of the i-th batch have schema CheckpointSchemas().at(i). Restore()
+  // rebuilds the state from such batches, and must only be called before the
+  // operator processes any records.
+  virtual std::vector<SchemaRef> CheckpointSchemas() const { return {}; }
+  virtual std::vector<std::vector<Record>> Checkpoint() const { return {}; }
+  virtual void Restore(std::vector<std::vector<Record>> &&batches) {}
+
  protected:
   explicit Operator(Type type) : index_(UNDEFINED_NODE_INDEX), type_(type) {}
 
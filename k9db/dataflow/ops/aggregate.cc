@@ -36,6 +36,16 @@ void AggregateOperator::ComputeOutputSchema() {
         this->aggregate_column_type_ != sqlast::ColumnDefinition::Type::INT) {
       LOG(FATAL) << "Unsupported column type for Sum aggregate";
     }
+  } else if (this->aggregate_function_ == Function::MIN ||
+             this->aggregate_function_ == Function::MAX) {
+    if (this->aggregate_column_name_ == "") {
+      this->aggregate_column_name_ =
+          this->aggregate_function_ == Function::MIN ? "Min" : "Max";
+    }
+    this->aggregate_column_type_ =
+        this->input_schemas_.at(0).TypeOf(this->aggregate_column_index_);
+  } else {
+    this->aggregate_column_type_ = sqlast::ColumnDefinition::Type::UINT;
   }
 
   // Obtain column names and types.
@@ -64,6 +74,20 @@ void AggregateOperator::ComputeOutputSchema() {
   // Now we know the output schema.
   this->output_schema_ =
       SchemaFactory::Create(out_column_names, out_column_types, out_keys);
+
+  // The schema of checkpointed state: the group columns, value, v1, and v2.
+  size_t group_count = this->group_columns_.size();
+  std::vector<std::string> state_names(out_column_names.begin(),
+                                       out_column_names.begin() + group_count);
+  std::vector<sqlast::ColumnDefinition::Type> state_types(
+      out_column_types.begin(), out_column_types.begin() + group_count);
+  state_names.insert(state_names.end(), {"__value", "__v1", "__v2"});
+  state_types.insert(state_types.end(),
+                     {this->aggregate_column_type_,
+                      this->aggregate_column_type_,
+                      sqlast::ColumnDefinition::Type::UINT});
+  this->state_schema_ =
+      SchemaFactory::Create(state_names, state_types, out_keys);
 }
 
 // Construct an output record with this->output_schema_.
@@ -259,6 +283,57 @@ std::vector<Record> AggregateOperator::Process(NodeIndex source,
         }
         break;
       }
+      case Function::MIN:
+      case Function::MAX: {
+        auto record_value = record.GetValue(this->aggregate_column_index_);
+        // NULLs are ignored by MIN and MAX.
+        if (record_value.IsNull()) {
+          continue;
+        }
+        if (!record.IsPositive()) {
+          // Negative record: remove value in record from the group.
+          if (!this->state_.Contains(group_key)) {
+            LOG(FATAL) << "Negative record not seen before in aggregate";
+          }
+          // Save old value and update the state.
+          AggregateData &data = this->state_.Get(group_key).front();
+          if (old_values.count(group_key) == 0) {
+            old_values.emplace(group_key, data.value);
+          }
+          auto it = data.values.find(record_value);
+          if (it == data.values.end()) {
+            LOG(FATAL) << "Negative record not seen before in aggregate";
+          }
+          data.values.erase(it);
+          if (data.values.empty()) {
+            this->state_.Erase(group_key);
+            continue;
+          }
+          data.value = this->aggregate_function_ == Function::MIN
+                           ? *data.values.begin()
+                           : *data.values.rbegin();
+        } else {
+          // Positive record: add value in record to the group.
+          if (this->state_.Contains(group_key)) {
+            AggregateData &data = this->state_.Get(group_key).front();
+            if (old_values.count(group_key) == 0) {
+              old_values.emplace(group_key, data.value);
+            }
+            data.values.insert(record_value);
+            data.value = this->aggregate_function_ == Function::MIN
+                             ? *data.values.begin()
+                             : *data.values.rbegin();
+          } else {
+            if (old_values.count(group_key) == 0) {
+              // Put in null value.
+              old_values.emplace(group_key, sqlast::Value());
+            }
+            AggregateData data = {record_value, {}, {}, {record_value}};
+            this->state_.Insert(group_key, std::move(data));
+          }
+        }
+        break;
+      }
     }
   }
 
@@ -283,6 +358,71 @@ std::vector<Record> AggregateOperator::Process(NodeIndex source,
   return output;
 }
 
+// Checkpointing.
+std::vector<std::vector<Record>> AggregateOperator::Checkpoint() const {
+  size_t value_column = this->group_columns_.size();
+  std::vector<Record> records;
+  for (const Key &key : this->state_.Keys()) {
+    const AggregateData &data = this->state_.Get(key).front();
+    if (this->aggregate_function_ == Function::MIN ||
+        this->aggregate_function_ == Function::MAX) {
+      for (const sqlast::Value &value : data.values) {
+        Record record{this->state_schema_, true};
+        for (size_t i = 0; i < key.size(); i++) {
+          record.SetValue(key.value(i), i);
+        }
+        record.SetValue(value, value_column);
+        record.SetNull(true, value_column + 1);
+        record.SetNull(true, value_column + 2);
+        records.push_back(std::move(record));
+      }
+    } else {
+      Record record{this->state_schema_, true};
+      for (size_t i = 0; i < key.size(); i++) {
+        record.SetValue(key.value(i), i);
+      }
+      record.SetValue(data.value, value_column);
+      record.SetValue(data.v1, value_column + 1);
+      record.SetValue(data.v2, value_column + 2);
+      records.push_back(std::move(record));
+    }
+  }
+  std::vector<std::vector<Record>> batches;
+  batches.push_back(std::move(records));
+  return batches;
+}
+
+void AggregateOperator::Restore(std::vector<std::vector<Record>> &&batches) {
+  CHECK_EQ(batches.size(), 1u) << "Bad aggregate checkpoint";
+  size_t value_column = this->group_columns_.size();
+  std::vector<ColumnID> key_columns;
+  for (size_t i = 0; i < value_column; i++) {
+    key_columns.push_back(i);
+  }
+  for (const Record &record : batches.front()) {
+    Key key = record.GetValues(key_columns);
+    sqlast::Value value = record.GetValue(value_column);
+    if (this->aggregate_function_ == Function::MIN ||
+        this->aggregate_function_ == Function::MAX) {
+      if (!this->state_.Contains(key)) {
+        AggregateData data = {value, {}, {}, {value}};
+        this->state_.Insert(key, std::move(data));
+        continue;
+      }
+      AggregateData &data = this->state_.Get(key).front();
+      data.values.insert(value);
+      data.value = this->aggregate_function_ == Function::MIN
+                       ? *data.values.begin()
+                       : *data.values.rbegin();
+    } else {
+      AggregateData data = {std::move(value),
+                            record.GetValue(value_column + 1),
+                            record.GetValue(value_column + 2)};
+      this->state_.Insert(key, std::move(data));
+    }
+  }
+}
+
 // Clone this operator.
 std::unique_ptr<Operator> AggregateOperator::Clone() const {
   return std::make_unique<AggregateOperator>(
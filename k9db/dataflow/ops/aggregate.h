@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
 #include <tuple>
 // NOLINTNEXTLINE
@@ -26,15 +27,35 @@ namespace dataflow {
 
 class AggregateOperator : public Operator {
  private:
+  // Orders values for MIN and MAX (strings are ordered lexicographically).
+  struct ValueCompare {
+    bool operator()(const sqlast::Value &l, const sqlast::Value &r) const {
+      if (l.type() == sqlast::Value::Type::TEXT &&
+          r.type() == sqlast::Value::Type::TEXT) {
+        return l.GetString() < r.GetString();
+      }
+      return l < r;
+    }
+  };
+
   // Data we need to store to compute the aggregate.
   // For COUNT and SUM this is a single integer value with empty v1 and v2.
   // For AVG, this is three values, the average, sum, and count.
+  // For MIN and MAX, this is the current minimum (maximum) and all the values
+  // in the group, so that the next one is known when the current one is
+  // deleted.
   struct AggregateData {
     sqlast::Value value;
     sqlast::Value v1;
     sqlast::Value v2;
+    std::multiset<sqlast::Value, ValueCompare> values;
     uint64_t SizeInMemory() const {
-      return value.SizeInMemory() + v1.SizeInMemory() + v2.SizeInMemory();
+      uint64_t size =
+          value.SizeInMemory() + v1.SizeInMemory() + v2.SizeInMemory();
+      for (const sqlast::Value &v : values) {
+        size += v.SizeInMemory();
+      }
+      return size;
     }
   };
 
@@ -74,6 +95,15 @@ class AggregateOperator : public Operator {
     return this->group_columns_;
   }
 
+  // One record per group with the group columns followed by value, v1 and v2
+  // of its AggregateData. For MIN and MAX, there is instead one record per
+  // value in the group (in the value column).
+  std::vector<SchemaRef> CheckpointSchemas() const override {
+    return {this->state_schema_};
+  }
+  std::vector<std::vector<Record>> Checkpoint() const override;
+  void Restore(std::vector<std::vector<Record>> &&batches) override;
+
  protected:
   std::vector<Record> Process(NodeIndex source, std::vector<Record> &&records,
                               const Promise &promise) override;
@@ -91,6 +121,8 @@ class AggregateOperator : public Operator {
   ColumnID aggregate_column_index_;
   std::string aggregate_column_name_;
   sqlast::ColumnDefinition::Type aggregate_column_type_;
+  // Schema of checkpointed state.
+  SchemaRef state_schema_;
 
   // Construct an output record with this->output_schema_.
   // The first n-1 columns are assigned values from the given key corresponding
@@ -111,6 +143,9 @@ class AggregateOperator : public Operator {
   FRIEND_TEST(AggregateOperatorTest, SumGoesAwayWithFilter);
   FRIEND_TEST(AggregateOperatorTest, CountGoesAwayOnDelete);
   FRIEND_TEST(AggregateOperatorTest, SimpleAverage);
+  FRIEND_TEST(AggregateOperatorTest, MinPositiveNegative);
+  FRIEND_TEST(AggregateOperatorTest, MaxText);
+  FRIEND_TEST(AggregateOperatorTest, CheckpointRestore);
 };
 
 }  // namespace dataflow
@@ -4,7 +4,7 @@
 namespace k9db {
 namespace dataflow {
 
-enum AggregateFunctionEnum { NO_AGGREGATE, COUNT, SUM, AVG };
+enum AggregateFunctionEnum { NO_AGGREGATE, COUNT, SUM, AVG, MIN, MAX };
 
 }  // namespace dataflow
 }  // namespace k9db
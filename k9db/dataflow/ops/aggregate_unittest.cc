@@ -602,5 +602,150 @@ TEST(AggregateOperatorTest, SimpleAverage) {
   compareRecordStreams(&output3, &expected_records3);
 }
 
+TEST(AggregateOperatorTest, MinPositiveNegative) {
+  SchemaRef schema = CreateSchemaPrimaryKey();
+  std::vector<ColumnID> group_columns = {1};
+  ColumnID aggregate_column = 2;
+  AggregateOperator::Function aggregate_function =
+      AggregateOperator::Function::MIN;
+  // create aggregate operator..
+  AggregateOperator aggregate =
+      AggregateOperator(group_columns, aggregate_function, aggregate_column);
+  aggregate.input_schemas_.push_back(schema);
+  aggregate.ComputeOutputSchema();
+  EXPECT_EQ(aggregate.output_schema_.NameOf(1), "Min");
+
+  // Description: The test consists of three stages:
+  // STAGE1: records are fed for two groups.
+  // STAGE2: the minimum of one group is deleted, the next smallest value
+  // (and not a recomputation from scratch) becomes the minimum.
+  // STAGE3: a new minimum is inserted and the other group is emptied.
+
+  // Records to be fed
+  std::vector<Record> records1;
+  records1.emplace_back(schema, true, 1_s, 2_s, 9_s);
+  records1.emplace_back(schema, true, 2_s, 2_s, 4_s);
+  records1.emplace_back(schema, true, 3_s, 2_s, 4_s);
+  records1.emplace_back(schema, true, 4_s, 5_s, 6_s);
+
+  // STAGE1
+  std::vector<Record> expected_records1;
+  expected_records1.emplace_back(aggregate.output_schema_, true, 2_s, 4_s);
+  expected_records1.emplace_back(aggregate.output_schema_, true, 5_s, 6_s);
+  std::vector<Record> outputs1 = aggregate.Process(
+      UNDEFINED_NODE_INDEX, std::move(records1), Promise::None);
+  compareRecordStreams(&expected_records1, &outputs1);
+
+  // STAGE2: deleting one of the duplicate minimums changes nothing.
+  std::vector<Record> records2;
+  records2.emplace_back(schema, false, 2_s, 2_s, 4_s);
+  std::vector<Record> outputs2 = aggregate.Process(
+      UNDEFINED_NODE_INDEX, std::move(records2), Promise::None);
+  EXPECT_EQ(outputs2.size(), 0);
+  std::vector<Record> records3;
+  records3.emplace_back(schema, false, 3_s, 2_s, 4_s);
+  std::vector<Record> expected_records2;
+  expected_records2.emplace_back(aggregate.output_schema_, false, 2_s, 4_s);
+  expected_records2.emplace_back(aggregate.output_schema_, true, 2_s, 9_s);
+  outputs2 = aggregate.Process(UNDEFINED_NODE_INDEX, std::move(records3),
+                               Promise::None);
+  compareRecordStreams(&expected_records2, &outputs2);
+
+  // STAGE3
+  std::vector<Record> records4;
+  records4.emplace_back(schema, true, 5_s, 2_s, -1_s);
+  records4.emplace_back(schema, false, 4_s, 5_s, 6_s);
+  std::vector<Record> expected_records3;
+  expected_records3.emplace_back(aggregate.output_schema_, false, 2_s, 9_s);
+  expected_records3.emplace_back(aggregate.output_schema_, false, 5_s, 6_s);
+  expected_records3.emplace_back(aggregate.output_schema_, true, 2_s, -1_s);
+  std::vector<Record> outputs3 = aggregate.Process(
+      UNDEFINED_NODE_INDEX, std::move(records4), Promise::None);
+  compareRecordStreams(&expected_records3, &outputs3);
+}
+
+TEST(AggregateOperatorTest, MaxText) {
+  SchemaRef schema = CreateSchemaString();
+  std::vector<ColumnID> group_columns = {3};
+  ColumnID aggregate_column = 1;
+  AggregateOperator::Function aggregate_function =
+      AggregateOperator::Function::MAX;
+  // create aggregate operator..
+  AggregateOperator aggregate =
+      AggregateOperator(group_columns, aggregate_function, aggregate_column);
+  aggregate.input_schemas_.push_back(schema);
+  aggregate.ComputeOutputSchema();
+  EXPECT_EQ(aggregate.output_schema_.TypeOf(1), CType::TEXT);
+
+  // Strings are compared lexicographically (not by length first).
+  std::vector<Record> records1;
+  records1.emplace_back(schema, true, 1_s, "b"_uptr, 0_s, 1_s);
+  records1.emplace_back(schema, true, 2_s, "aa"_uptr, 0_s, 1_s);
+  records1.emplace_back(schema, true, 3_s, "c"_uptr, 0_s, 1_s);
+  std::vector<Record> outputs1 = aggregate.Process(
+      UNDEFINED_NODE_INDEX, std::move(records1), Promise::None);
+  ASSERT_EQ(outputs1.size(), 1);
+  EXPECT_EQ(outputs1.at(0),
+            Record(aggregate.output_schema_, true, 1_s, "c"_uptr));
+
+  std::vector<Record> records2;
+  records2.emplace_back(schema, false, 3_s, "c"_uptr, 0_s, 1_s);
+  std::vector<Record> outputs2 = aggregate.Process(
+      UNDEFINED_NODE_INDEX, std::move(records2), Promise::None);
+  ASSERT_EQ(outputs2.size(), 2);
+  EXPECT_EQ(outputs2.at(0),
+            Record(aggregate.output_schema_, false, 1_s, "c"_uptr));
+  EXPECT_EQ(outputs2.at(1),
+            Record(aggregate.output_schema_, true, 1_s, "b"_uptr));
+}
+
+// Restoring a checkpoint into a fresh operator gives the same future outputs.
+TEST(AggregateOperatorTest, CheckpointRestore) {
+  SchemaRef schema = CreateSchemaPrimaryKey();
+  std::vector<ColumnID> group_columns = {1};
+  for (auto function :
+       {AggregateOperator::Function::AVG, AggregateOperator::Function::MIN}) {
+    AggregateOperator aggregate(group_columns, function, 2);
+    aggregate.input_schemas_.push_back(schema);
+    aggregate.ComputeOutputSchema();
+    AggregateOperator restored(group_columns, function, 2);
+    restored.input_schemas_.push_back(schema);
+    restored.ComputeOutputSchema();
+
+    std::vector<Record> records1;
+    records1.emplace_back(schema, true, 1_s, 2_s, 9_s);
+    records1.emplace_back(schema, true, 2_s, 2_s, 4_s);
+    records1.emplace_back(schema, true, 3_s, 5_s, 5_s);
+    aggregate.Process(UNDEFINED_NODE_INDEX, std::move(records1),
+                      Promise::None);
+
+    // Checkpoint and restore.
+    std::vector<SchemaRef> schemas = aggregate.CheckpointSchemas();
+    std::vector<std::vector<Record>> batches = aggregate.Checkpoint();
+    ASSERT_EQ(schemas.size(), 1);
+    ASSERT_EQ(batches.size(), 1);
+    for (const Record &record : batches.at(0)) {
+      EXPECT_EQ(record.schema(), schemas.at(0));
+    }
+    restored.Restore(std::move(batches));
+    EXPECT_EQ(restored.state_.count(), aggregate.state_.count());
+
+    // Both operators produce the same outputs from here on.
+    std::vector<Record> records2;
+    records2.emplace_back(schema, false, 2_s, 2_s, 4_s);
+    records2.emplace_back(schema, true, 4_s, 5_s, 1_s);
+    std::vector<Record> copy;
+    for (const Record &record : records2) {
+      copy.push_back(record.Copy());
+    }
+    std::vector<Record> expected = aggregate.Process(
+        UNDEFINED_NODE_INDEX, std::move(records2), Promise::None);
+    std::vector<Record> outputs =
+        restored.Process(UNDEFINED_NODE_INDEX, std::move(copy), Promise::None);
+    EXPECT_EQ(outputs.size(), 4);
+    compareRecordStreams(&expected, &outputs);
+  }
+}
+
 }  // namespace dataflow
 }  // namespace k9db
@@ -4,11 +4,12 @@
 
 #include "k9db/dataflow/ops/equijoin.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
 #include "glog/logging.h"
-#include "k9db/dataflow/key.h"
+#include "k9db/dataflow/record_batch.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/sqlast/ast.h"
 
@@ -35,15 +36,11 @@ inline void CopyIntoRecord(sqlast::ColumnDefinition::Type datatype,
       break;
     case sqlast::ColumnDefinition::Type::DATETIME:
       // Copies the string.
-      target->SetDateTime(
-          std::make_unique<std::string>(source.GetDateTime(source_index)),
-          target_index);
+      target->SetDateTime(source.GetDateTime(source_index), target_index);
       break;
     case sqlast::ColumnDefinition::Type::TEXT:
       // Copies the string.
-      target->SetString(
-          std::make_unique<std::string>(source.GetString(source_index)),
-          target_index);
+      target->SetString(source.GetString(source_index), target_index);
       target->SetNull(false, target_index);
       break;
     default:
@@ -51,35 +48,113 @@ inline void CopyIntoRecord(sqlast::ColumnDefinition::Type datatype,
   }
 }
 
+// The schema of stored records, with only the kept columns. Keys are
+// preserved if all key columns are kept.
+SchemaRef PrunedSchema(const SchemaRef &schema,
+                       const std::vector<ColumnID> &keep) {
+  if (keep.empty()) {
+    return schema;
+  }
+  std::vector<std::string> names;
+  std::vector<sqlast::ColumnDefinition::Type> types;
+  std::vector<ColumnID> keys;
+  for (ColumnID col : keep) {
+    names.push_back(schema.NameOf(col));
+    types.push_back(schema.TypeOf(col));
+  }
+  for (ColumnID key : schema.keys()) {
+    auto it = std::find(keep.begin(), keep.end(), key);
+    if (it == keep.end()) {
+      keys.clear();
+      break;
+    }
+    keys.push_back(it - keep.begin());
+  }
+  return SchemaFactory::Create(names, types, keys);
+}
+
+// The join columns among the kept columns.
+std::vector<ColumnID> KeptColumns(const std::vector<ColumnID> &ids,
+                                  const std::vector<ColumnID> &keep) {
+  if (keep.empty()) {
+    return ids;
+  }
+  std::vector<ColumnID> result;
+  for (ColumnID id : ids) {
+    auto it = std::find(keep.begin(), keep.end(), id);
+    if (it == keep.end()) {
+      LOG(FATAL) << "join column " << id << " is not kept in join operator!";
+    }
+    result.push_back(it - keep.begin());
+  }
+  return result;
+}
+
 }  // namespace
 
+EquiJoinOperator::EquiJoinOperator(const std::vector<ColumnID> &left_ids,
+                                   const std::vector<ColumnID> &right_ids,
+                                   Mode mode,
+                                   const std::vector<ColumnID> &left_keep,
+                                   const std::vector<ColumnID> &right_keep)
+    : Operator(Operator::Type::EQUIJOIN),
+      left_ids_(left_ids),
+      right_ids_(right_ids),
+      mode_(mode),
+      left_keep_(left_keep),
+      right_keep_(right_keep) {
+  CHECK_GT(left_ids.size(), 0u) << "join operator without join columns!";
+  CHECK_EQ(left_ids.size(), right_ids.size()) << "mismatched join columns!";
+  for (ColumnID left_id : left_ids) {
+    if (left_id > MAX_JOIN_COLUMNS) {
+      LOG(FATAL) << "implausible column ID " << left_id << " in join operator!";
+    }
+  }
+  for (ColumnID right_id : right_ids) {
+    if (right_id > MAX_JOIN_COLUMNS) {
+      LOG(FATAL) << "implausible column ID " << right_id
+                 << " in join operator!";
+    }
+  }
+  this->left_cols_ = KeptColumns(left_ids, left_keep);
+  this->right_cols_ = KeptColumns(right_ids, right_keep);
+}
+
 Operator *EquiJoinOperator::left() const { return this->parents_.at(0); }
 Operator *EquiJoinOperator::right() const { return this->parents_.at(1); }
 
 std::vector<Record> EquiJoinOperator::Process(NodeIndex source,
                                               std::vector<Record> &&records,
                                               const Promise &promise) {
-  std::vector<Record> output;
-  for (Record &record : records) {
+  // Joined records are allocated together in one batch.
+  RecordBatch output(this->output_schema_, records.size());
+  for (Record &input : records) {
     // In comparison to a normal HashJoin in a database, here
     // records flow from one operator in.
 
     // Append all input records to the corresponding hashtable.
     if (source == this->left()->index()) {
+      Record record =
+          this->Prune(std::move(input), this->left_keep_, this->left_schema_);
+      // The hash is computed once, and used to probe all the tables.
+      uint64_t hash = JoinTable::Hash(record, this->left_cols_);
       // Find matching record from right table.
-      Key lvalue = record.GetValues({this->left_id_});
-      if (this->right_table_.Contains(lvalue)) {
+      const std::vector<Record> *rights =
+          this->right_table_.Find(record, this->left_cols_, hash);
+      if (rights != nullptr) {
         // Matching records exist.
-        for (const Record &right : this->right_table_.Get(lvalue)) {
-          if (this->mode_ == Mode::RIGHT) {
-            // Negate any previously emitted NULL + right records.
-            if (this->emitted_nulls_.Contains(lvalue)) {
-              for (const Record &rnull : this->emitted_nulls_.Get(lvalue)) {
-                this->EmitRow(this->null_records_.at(0), rnull, &output, false);
-              }
-              this->emitted_nulls_.Erase(lvalue);
+        if (this->mode_ == Mode::RIGHT) {
+          // Negate any previously emitted NULL + right records.
+          const std::vector<Record> *rnulls =
+              this->emitted_nulls_.Find(record, this->left_cols_, hash);
+          if (rnulls != nullptr) {
+            for (const Record &rnull : *rnulls) {
+              this->EmitRow(this->null_records_.at(0), rnull, &output, false);
             }
+            this->emitted_nulls_.Erase(record, this->left_cols_, hash);
           }
+        }
+        for (const Record &right : *rights) {
           this->EmitRow(record, right, &output, record.IsPositive());
         }
       } else if (this->mode_ == Mode::LEFT) {
@@ -87,33 +162,39 @@ std::vector<Record> EquiJoinOperator::Process(NodeIndex source,
         this->EmitRow(record, this->null_records_.at(1), &output,
                       record.IsPositive());
         if (record.IsPositive()) {
-          this->emitted_nulls_.Insert(lvalue, record.Copy());
+          this->emitted_nulls_.Insert(hash, record.Compact());
         } else {
-          this->emitted_nulls_.Delete(lvalue, record.Copy());
+          this->emitted_nulls_.Delete(hash, record);
         }
       }
 
       // Save record in the appropriate table.
       if (record.IsPositive()) {
-        this->left_table_.Insert(lvalue, std::move(record));
+        this->left_table_.Insert(hash, record.Compact());
       } else {
-        this->left_table_.Delete(lvalue, std::move(record));
+        this->left_table_.Delete(hash, record);
       }
     } else if (source == this->right()->index()) {
+      Record record =
+          this->Prune(std::move(input), this->right_keep_, this->right_schema_);
+      uint64_t hash = JoinTable::Hash(record, this->right_cols_);
       // Find matching record from left table.
-      Key rvalue = record.GetValues({this->right_id_});
-      if (this->left_table_.Contains(rvalue)) {
+      const std::vector<Record> *lefts =
+          this->left_table_.Find(record, this->right_cols_, hash);
+      if (lefts != nullptr) {
         // Matching records exist.
-        for (const Record &left : this->left_table_.Get(rvalue)) {
-          if (this->mode_ == Mode::LEFT) {
-            // Negate any previously emitted Left + NULL records.
-            if (this->emitted_nulls_.Contains(rvalue)) {
-              for (const Record &lnull : this->emitted_nulls_.Get(rvalue)) {
-                this->EmitRow(lnull, this->null_records_.at(1), &output, false);
-              }
-              this->emitted_nulls_.Erase(rvalue);
+        if (this->mode_ == Mode::LEFT) {
+          // Negate any previously emitted Left + NULL records.
+          const std::vector<Record> *lnulls =
+              this->emitted_nulls_.Find(record, this->right_cols_, hash);
+          if (lnulls != nullptr) {
+            for (const Record &lnull : *lnulls) {
+              this->EmitRow(lnull, this->null_records_.at(1), &output, false);
             }
+            this->emitted_nulls_.Erase(record, this->right_cols_, hash);
           }
+        }
+        for (const Record &left : *lefts) {
           this->EmitRow(left, record, &output, record.IsPositive());
         }
       } else if (mode_ == Mode::RIGHT) {
@@ -121,17 +202,17 @@ std::vector<Record> EquiJoinOperator::Process(NodeIndex source,
         this->EmitRow(this->null_records_.at(0), record, &output,
                       record.IsPositive());
         if (record.IsPositive()) {
-          this->emitted_nulls_.Insert(rvalue, record.Copy());
+          this->emitted_nulls_.Insert(hash, record.Compact());
         } else {
-          this->emitted_nulls_.Delete(rvalue, record.Copy());
+          this->emitted_nulls_.Delete(hash, record);
         }
       }
 
       // Save record in the appropriate table.
       if (record.IsPositive()) {
-        this->right_table_.Insert(rvalue, std::move(record));
+        this->right_table_.Insert(hash, record.Compact());
       } else {
-        this->right_table_.Delete(rvalue, std::move(record));
+        this->right_table_.Delete(hash, record);
       }
     } else {
       LOG(FATAL) << "EquiJoinOperator got input from Node " << source
@@ -139,7 +220,7 @@ std::vector<Record> EquiJoinOperator::Process(NodeIndex source,
                  << this->right()->index();
     }
   }
-  return output;
+  return output.Release();
 }
 
 void EquiJoinOperator::ComputeOutputSchema() {
@@ -149,45 +230,50 @@ void EquiJoinOperator::ComputeOutputSchema() {
     return;
   }
 
-  // Get the schema's of the two parents.
-  const SchemaRef &lschema = this->input_schemas_.at(0);
-  const SchemaRef &rschema = this->input_schemas_.at(1);
+  // Get the schema's of the two parents, without the columns we do not keep.
+  this->left_schema_ =
+      PrunedSchema(this->input_schemas_.at(0), this->left_keep_);
+  this->right_schema_ =
+      PrunedSchema(this->input_schemas_.at(1), this->right_keep_);
+  const SchemaRef &lschema = this->left_schema_;
+  const SchemaRef &rschema = this->right_schema_;
 
   // Construct joined schema.
   std::vector<sqlast::ColumnDefinition::Type> types = lschema.column_types();
   std::vector<std::string> names = lschema.column_names();
   std::vector<ColumnID> keys = lschema.keys();
 
+  // Right join columns are dropped.
+  this->right_emit_.clear();
   for (size_t i = 0; i < rschema.size(); i++) {
-    if (i != this->right_id_) {
+    auto it = std::find(this->right_cols_.begin(), this->right_cols_.end(), i);
+    if (it == this->right_cols_.end()) {
+      this->right_emit_.emplace_back(i, types.size());
       types.push_back(rschema.TypeOf(i));
       names.push_back(rschema.NameOf(i));
     }
   }
   for (ColumnID key_id : rschema.keys()) {
-    // right_id_ column is dropped, if it is part of the key, we must
-    // substitute it with left_id_ so that the key is complete.
-    if (key_id == this->right_id_) {
-      for (size_t i = 0; i < keys.size(); i++) {
-        // left_id_ already part of key.
-        if (keys.at(i) == this->left_id_) {
-          break;
-        }
-        // Insert left_id_ in order.
-        if (keys.at(i) > this->left_id_) {
-          keys.insert(keys.begin() + i, this->left_id_);
-          break;
-        }
-        // Push at the end.
-        if (i == keys.size() - 1) {
-          keys.push_back(this->left_id_);
+    auto it =
+        std::find(this->right_cols_.begin(), this->right_cols_.end(), key_id);
+    if (it != this->right_cols_.end()) {
+      // A right join column is dropped, if it is part of the key, we must
+      // substitute it with the corresponding left column so that the key is
+      // complete.
+      ColumnID left_col = this->left_cols_.at(it - this->right_cols_.begin());
+      if (std::find(keys.begin(), keys.end(), left_col) == keys.end()) {
+        // Insert in order.
+        auto pos = std::find_if(keys.begin(), keys.end(),
+                                [&](ColumnID k) { return k > left_col; });
+        keys.insert(pos, left_col);
+      }
+    } else {
+      for (const auto &[right_col, output_col] : this->right_emit_) {
+        if (right_col == key_id) {
+          keys.push_back(output_col);
           break;
         }
       }
-    } else if (key_id < this->right_id_) {
-      keys.push_back(lschema.size() + key_id);
-    } else {
-      keys.push_back(lschema.size() + key_id - 1);
     }
   }
 
@@ -195,52 +281,92 @@ void EquiJoinOperator::ComputeOutputSchema() {
   this->output_schema_ = SchemaFactory::Create(names, types, keys);
 
   // Initialize left and right null records
-  this->null_records_.push_back(
-      std::move(Record::NULLRecord(this->input_schemas_.at(0))));
-  this->null_records_.push_back(
-      std::move(Record::NULLRecord(this->input_schemas_.at(1))));
+  this->null_records_.push_back(std::move(Record::NULLRecord(lschema)));
+  this->null_records_.push_back(std::move(Record::NULLRecord(rschema)));
 
   // Initialize the state.
-  this->left_table_.Initialize(this->output_schema_);
-  this->right_table_.Initialize(this->output_schema_);
-  this->emitted_nulls_.Initialize(this->output_schema_);
+  this->left_table_.Initialize(this->left_cols_);
+  this->right_table_.Initialize(this->right_cols_);
+  if (this->mode_ == Mode::RIGHT) {
+    this->emitted_nulls_.Initialize(this->right_cols_);
+  } else {
+    this->emitted_nulls_.Initialize(this->left_cols_);
+  }
+}
+
+Record EquiJoinOperator::Prune(Record &&record,
+                               const std::vector<ColumnID> &keep,
+                               const SchemaRef &schema) const {
+  if (keep.empty()) {
+    return std::move(record);
+  }
+  Record pruned{schema, record.IsPositive()};
+  for (size_t i = 0; i < keep.size(); i++) {
+    CopyIntoRecord(schema.TypeOf(i), &pruned, record, i, keep.at(i));
+  }
+  return pruned;
 }
 
 void EquiJoinOperator::EmitRow(const Record &left, const Record &right,
-                               std::vector<Record> *output, bool positive) {
+                               RecordBatch *output, bool positive) {
   const SchemaRef &lschema = left.schema();
   const SchemaRef &rschema = right.schema();
 
-  // Create a concatenated record, dropping key column from left side.
-  Record record{this->output_schema_, positive};
+  // Create a concatenated record, dropping join columns from right side.
+  Record &record = output->Add(positive);
   for (size_t i = 0; i < lschema.size(); i++) {
     if (left.IsNull(i))
       record.SetNull(true, i);
     else
       CopyIntoRecord(lschema.TypeOf(i), &record, left, i, i);
   }
-  for (size_t i = 0; i < rschema.size(); i++) {
-    if (i == this->right_id_) {
-      continue;
-    }
-    size_t j = i + lschema.size();
-    if (i > this->right_id_) {
-      j--;
-    }
+  for (const auto &[i, j] : this->right_emit_) {
     if (right.IsNull(i)) {
       record.SetNull(true, j);
     } else {
       CopyIntoRecord(rschema.TypeOf(i), &record, right, j, i);
     }
   }
+}
+
+// Checkpointing.
+std::vector<SchemaRef> EquiJoinOperator::CheckpointSchemas() const {
+  if (this->mode_ == Mode::RIGHT) {
+    return {this->left_schema_, this->right_schema_, this->right_schema_};
+  }
+  return {this->left_schema_, this->right_schema_, this->left_schema_};
+}
 
-  // add result record to output
-  output->push_back(std::move(record));
+std::vector<std::vector<Record>> EquiJoinOperator::Checkpoint() const {
+  std::vector<std::vector<Record>> batches;
+  batches.push_back(this->left_table_.All());
+  batches.push_back(this->right_table_.All());
+  batches.push_back(this->emitted_nulls_.All());
+  return batches;
+}
+
+void EquiJoinOperator::Restore(std::vector<std::vector<Record>> &&batches) {
+  CHECK_EQ(batches.size(), 3u) << "Bad join checkpoint";
+  const std::vector<ColumnID> &nulls_cols =
+      this->mode_ == Mode::RIGHT ? this->right_cols_ : this->left_cols_;
+  for (Record &record : batches.at(0)) {
+    uint64_t hash = JoinTable::Hash(record, this->left_cols_);
+    this->left_table_.Insert(hash, std::move(record));
+  }
+  for (Record &record : batches.at(1)) {
+    uint64_t hash = JoinTable::Hash(record, this->right_cols_);
+    this->right_table_.Insert(hash, std::move(record));
+  }
+  for (Record &record : batches.at(2)) {
+    uint64_t hash = JoinTable::Hash(record, nulls_cols);
+    this->emitted_nulls_.Insert(hash, std::move(record));
+  }
 }
 
 std::unique_ptr<Operator> EquiJoinOperator::Clone() const {
-  return std::make_unique<EquiJoinOperator>(this->left_id_, this->right_id_,
-                                            this->mode_);
+  return std::make_unique<EquiJoinOperator>(this->left_ids_, this->right_ids_,
+                                            this->mode_, this->left_keep_,
+                                            this->right_keep_);
 }
 
 }  // namespace dataflow
@@ -2,13 +2,16 @@
 #define K9DB_DATAFLOW_OPS_EQUIJOIN_H_
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest_prod.h"
 #include "k9db/dataflow/operator.h"
 #include "k9db/dataflow/ops/equijoin_enum.h"
-#include "k9db/dataflow/ops/grouped_data.h"
+#include "k9db/dataflow/ops/join_table.h"
 #include "k9db/dataflow/record.h"
+#include "k9db/dataflow/record_batch.h"
+#include "k9db/dataflow/schema.h"
 #include "k9db/dataflow/types.h"
 
 namespace k9db {
@@ -25,24 +28,29 @@ class EquiJoinOperator : public Operator {
   EquiJoinOperator(const EquiJoinOperator &other) = delete;
   EquiJoinOperator &operator=(const EquiJoinOperator &other) = delete;
 
+  // Join on a single column from each side.
   EquiJoinOperator(ColumnID left_id, ColumnID right_id, Mode mode = Mode::INNER)
-      : Operator(Operator::Type::EQUIJOIN),
-        left_id_(left_id),
-        right_id_(right_id),
-        mode_(mode) {
-    if (left_id > MAX_JOIN_COLUMNS) {
-      LOG(FATAL) << "implausible column ID " << left_id << " in join operator!";
-    }
-    if (right_id > MAX_JOIN_COLUMNS) {
-      LOG(FATAL) << "implausible column ID " << right_id
-                 << " in join operator!";
-    }
-  }
+      : EquiJoinOperator(std::vector<ColumnID>{left_id},
+                         std::vector<ColumnID>{right_id}, mode) {}
+
+  // Join on a composite key: left_ids[i] must equal right_ids[i] for all i.
+  // If left_keep (right_keep) is not empty, only the listed columns of the left
+  // (right) side are stored in the join state and emitted, in the listed
+  // order. This allows dropping columns that are not needed downstream from
+  // the state. The kept columns must include the join columns.
+  EquiJoinOperator(const std::vector<ColumnID> &left_ids,
+                   const std::vector<ColumnID> &right_ids,
+                   Mode mode = Mode::INNER,
+                   const std::vector<ColumnID> &left_keep = {},
+                   const std::vector<ColumnID> &right_keep = {});
 
   Operator *left() const;
   Operator *right() const;
-  ColumnID left_id() const { return this->left_id_; }
-  ColumnID right_id() const { return this->right_id_; }
+  // Join columns in the input schemas.
+  const std::vector<ColumnID> &left_ids() const { return this->left_ids_; }
+  const std::vector<ColumnID> &right_ids() const { return this->right_ids_; }
+  // Join columns in the output schema.
+  const std::vector<ColumnID> &output_ids() const { return this->left_cols_; }
 
   uint64_t SizeInMemory() const override {
     return this->left_table_.SizeInMemory() +
@@ -50,12 +58,17 @@ class EquiJoinOperator : public Operator {
            this->emitted_nulls_.SizeInMemory();
   }
 
+  // The left table, the right table, and the records emitted with NULLs.
+  std::vector<SchemaRef> CheckpointSchemas() const override;
+  std::vector<std::vector<Record>> Checkpoint() const override;
+  void Restore(std::vector<std::vector<Record>> &&batches) override;
+
  protected:
   /*!
    * processes a batch of input rows and writes output to output.
    * Output schema of join (i.e. records written to output) is defined as
-   * concatenated left schema and right schema with key column from the right
-   * schema dropped.
+   * concatenated left schema and right schema with key columns from the right
+   * schema dropped (and without any columns that are not kept).
    */
   std::vector<Record> Process(NodeIndex source, std::vector<Record> &&records,
                               const Promise &promise) override;
@@ -66,23 +79,39 @@ class EquiJoinOperator : public Operator {
   std::unique_ptr<Operator> Clone() const override;
 
  private:
-  // Columns on which join is computed.
-  ColumnID left_id_;
-  ColumnID right_id_;
+  // Columns on which join is computed (in the input schemas).
+  std::vector<ColumnID> left_ids_;
+  std::vector<ColumnID> right_ids_;
   Mode mode_;
-  UnorderedGroupedData left_table_;
-  UnorderedGroupedData right_table_;
+  // Columns of the input schemas kept in the state (empty means all).
+  std::vector<ColumnID> left_keep_;
+  std::vector<ColumnID> right_keep_;
+  // The join columns in the schemas of the stored records.
+  std::vector<ColumnID> left_cols_;
+  std::vector<ColumnID> right_cols_;
+  // Schemas of the stored records (the input schemas if nothing is pruned).
+  SchemaRef left_schema_;
+  SchemaRef right_schema_;
+  // (stored right column, output column) for every right column that is
+  // emitted (i.e. not a join column).
+  std::vector<std::pair<ColumnID, ColumnID>> right_emit_;
+  JoinTable left_table_;
+  JoinTable right_table_;
   // Keeps track of (left records + NULL) or (NULL + right records) columns that
   // have been emitted. This is later used to generate corresponding
   // negative records
-  UnorderedGroupedData emitted_nulls_;
+  JoinTable emitted_nulls_;
   // Records consisting entirely of NULL values. at index 0 is meant to be for
   // left schema and at index 1 is meant to be for right schema.
   std::vector<Record> null_records_;
 
+  // Drop the columns that are not kept from a record of the given side.
+  Record Prune(Record &&record, const std::vector<ColumnID> &keep,
+               const SchemaRef &schema) const;
+
   // Join left and right and store it in output.
   void EmitRow(const Record &left, const Record &right,
-               std::vector<Record> *output, bool positive);
+               RecordBatch *output, bool positive);
 
   FRIEND_TEST(EquiJoinOperatorTest, JoinedSchemaTest);
   FRIEND_TEST(EquiJoinOperatorTest, BasicJoinTest);
@@ -91,6 +120,9 @@ class EquiJoinOperator : public Operator {
   FRIEND_TEST(EquiJoinOperatorTest, BasicLeftJoinTest);
   FRIEND_TEST(EquiJoinOperatorTest, BasicRightJoinTest);
   FRIEND_TEST(EquiJoinOperatorTest, LeftJoinTest);
+  FRIEND_TEST(EquiJoinOperatorTest, CompositeKeyJoinTest);
+  FRIEND_TEST(EquiJoinOperatorTest, PrunedJoinTest);
+  FRIEND_TEST(EquiJoinOperatorTest, CheckpointRestore);
 };
 
 }  // namespace dataflow
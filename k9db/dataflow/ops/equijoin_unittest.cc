@@ -609,5 +609,184 @@ TEST(EquiJoinOperatorTest, LeftJoinTest) {
   EXPECT_EQ(output, expected_records);
 }
 
+TEST(EquiJoinOperatorTest, CompositeKeyJoinTest) {
+  SchemaRef lschema = Schema1();
+  SchemaRef rschema = Schema3();
+  std::vector<Record> lrecords;
+  std::vector<Record> rrecords;
+  std::vector<Record> rdeletes;
+  lrecords.emplace_back(lschema, true, 1_u, std::make_unique<std::string>("a"),
+                        10_s);
+  lrecords.emplace_back(lschema, true, 2_u, std::make_unique<std::string>("b"),
+                        20_s);
+  rrecords.emplace_back(rschema, true, 1_u, 10_s,
+                        std::make_unique<std::string>("x"));
+  rrecords.emplace_back(rschema, true, 1_u, 20_s,
+                        std::make_unique<std::string>("y"));
+  rrecords.emplace_back(rschema, true, 2_u, 20_s,
+                        std::make_unique<std::string>("z"));
+  rdeletes.emplace_back(rschema, false, 1_u, 10_s,
+                        std::make_unique<std::string>("x"));
+
+  // Join on ID = ID2 and Category = Category.
+  DataFlowGraphPartition g{0};
+  auto iop1 = std::make_unique<InputOperator>("test-table1", lschema);
+  auto iop2 = std::make_unique<InputOperator>("test-table2", rschema);
+  auto op = std::make_unique<EquiJoinOperator>(std::vector<ColumnID>{0, 2},
+                                               std::vector<ColumnID>{0, 1});
+  auto iop1_ptr = iop1.get();
+  auto iop2_ptr = iop2.get();
+  auto op_ptr = op.get();
+  EXPECT_TRUE(g.AddInputNode(std::move(iop1)));
+  EXPECT_TRUE(g.AddInputNode(std::move(iop2)));
+  EXPECT_TRUE(g.AddNode(std::move(op), {iop1_ptr, iop2_ptr}));
+
+  // Both join columns of the right side are dropped.
+  const SchemaRef &joined = op_ptr->output_schema();
+  std::vector<std::string> joined_names = {"ID", "Item", "Category", "Text"};
+  std::vector<ColumnID> joined_keys = {0};
+  EXPECT_EQ(joined.column_names(), joined_names);
+  EXPECT_EQ(joined.keys(), joined_keys);
+  EXPECT_EQ(op_ptr->output_ids(), (std::vector<ColumnID>{0, 2}));
+
+  std::vector<Record> expected_records;
+  expected_records.emplace_back(joined, true, 1_u,
+                                std::make_unique<std::string>("a"), 10_s,
+                                std::make_unique<std::string>("x"));
+  expected_records.emplace_back(joined, true, 2_u,
+                                std::make_unique<std::string>("b"), 20_s,
+                                std::make_unique<std::string>("z"));
+  expected_records.emplace_back(joined, false, 1_u,
+                                std::make_unique<std::string>("a"), 10_s,
+                                std::make_unique<std::string>("x"));
+
+  // Process records.
+  std::vector<Record> output =
+      op_ptr->Process(0, CopyVec(lrecords), Promise::None);
+  EXPECT_EQ(output.size(), 0);
+  EXPECT_EQ(op_ptr->left_table_.count(), 2);
+  std::vector<Record> output1 =
+      op_ptr->Process(1, CopyVec(rrecords), Promise::None);
+  output.insert(output.end(), std::make_move_iterator(output1.begin()),
+                std::make_move_iterator(output1.end()));
+  EXPECT_EQ(op_ptr->right_table_.count(), 3);
+  std::vector<Record> ry;
+  ry.push_back(rrecords.at(1).Copy());
+  EXPECT_EQ(op_ptr->right_table_.Lookup(rrecords.at(1).GetValues({0, 1})), ry);
+  output1 = op_ptr->Process(1, CopyVec(rdeletes), Promise::None);
+  output.insert(output.end(), std::make_move_iterator(output1.begin()),
+                std::make_move_iterator(output1.end()));
+  EXPECT_EQ(op_ptr->right_table_.count(), 2);
+  EXPECT_EQ(op_ptr->right_table_.Lookup(rdeletes.at(0).GetValues({0, 1})),
+            std::vector<Record>{});
+  EXPECT_EQ(output, expected_records);
+}
+
+TEST(EquiJoinOperatorTest, PrunedJoinTest) {
+  SchemaRef lschema = Schema1();
+  SchemaRef rschema = Schema2();
+  std::vector<Record> lrecords;
+  std::vector<Record> rrecords;
+  lrecords.emplace_back(lschema, true, 0_u,
+                        std::make_unique<std::string>("item0"), -5_s);
+  rrecords.emplace_back(rschema, true, 100_u, -5_s,
+                        std::make_unique<std::string>("descrp0"));
+
+  // Only keep (Category, ID) from the left and (Category, Description) from
+  // the right.
+  DataFlowGraphPartition g{0};
+  auto iop1 = std::make_unique<InputOperator>("test-table1", lschema);
+  auto iop2 = std::make_unique<InputOperator>("test-table2", rschema);
+  auto op = std::make_unique<EquiJoinOperator>(
+      std::vector<ColumnID>{2}, std::vector<ColumnID>{1},
+      EquiJoinOperator::Mode::INNER, std::vector<ColumnID>{2, 0},
+      std::vector<ColumnID>{1, 2});
+  auto iop1_ptr = iop1.get();
+  auto iop2_ptr = iop2.get();
+  auto op_ptr = op.get();
+  EXPECT_TRUE(g.AddInputNode(std::move(iop1)));
+  EXPECT_TRUE(g.AddInputNode(std::move(iop2)));
+  EXPECT_TRUE(g.AddNode(std::move(op), {iop1_ptr, iop2_ptr}));
+
+  const SchemaRef &joined = op_ptr->output_schema();
+  std::vector<std::string> joined_names = {"Category", "ID", "Description"};
+  std::vector<CType> joined_types = {CType::INT, CType::UINT, CType::TEXT};
+  std::vector<ColumnID> joined_keys = {0, 1};
+  EXPECT_EQ(joined.column_names(), joined_names);
+  EXPECT_EQ(joined.column_types(), joined_types);
+  EXPECT_EQ(joined.keys(), joined_keys);
+  EXPECT_EQ(op_ptr->output_ids(), std::vector<ColumnID>{0});
+
+  // Process records.
+  std::vector<Record> output =
+      op_ptr->Process(0, CopyVec(lrecords), Promise::None);
+  EXPECT_EQ(output.size(), 0);
+  std::vector<Record> stored =
+      op_ptr->left_table_.Lookup(lrecords.at(0).GetValues({2}));
+  EXPECT_EQ(stored.size(), 1);
+  EXPECT_EQ(stored.at(0).schema().size(), 2);
+  EXPECT_EQ(stored.at(0).GetInt(0), -5);
+  EXPECT_EQ(stored.at(0).GetUInt(1), 0);
+  output = op_ptr->Process(1, CopyVec(rrecords), Promise::None);
+  EXPECT_EQ(op_ptr->right_table_.count(), 1);
+
+  std::vector<Record> expected_records;
+  expected_records.emplace_back(joined, true, -5_s, 0_u,
+                                std::make_unique<std::string>("descrp0"));
+  EXPECT_EQ(output, expected_records);
+}
+
+// A restored join (including the nulls it emitted) behaves like the original.
+TEST(EquiJoinOperatorTest, CheckpointRestore) {
+  SchemaRef lschema = Schema1();
+  SchemaRef rschema = Schema2();
+  std::vector<Record> lrecords;
+  std::vector<Record> rrecords;
+  lrecords.emplace_back(lschema, true, 0_u, "item0"_uptr, -5_s);
+  rrecords.emplace_back(rschema, true, 100_u, -5_s, "descrp0"_uptr);
+  rrecords.emplace_back(rschema, true, 101_u, 7_s, "descrp1"_uptr);
+
+  // Two identical graphs.
+  DataFlowGraphPartition g1{0};
+  DataFlowGraphPartition g2{0};
+  std::vector<EquiJoinOperator *> ops;
+  for (DataFlowGraphPartition *g : {&g1, &g2}) {
+    auto iop1 = std::make_unique<InputOperator>("test-table1", lschema);
+    auto iop2 = std::make_unique<InputOperator>("test-table2", rschema);
+    auto op =
+        std::make_unique<EquiJoinOperator>(2, 1, EquiJoinOperator::Mode::RIGHT);
+    auto iop1_ptr = iop1.get();
+    auto iop2_ptr = iop2.get();
+    ops.push_back(op.get());
+    EXPECT_TRUE(g->AddInputNode(std::move(iop1)));
+    EXPECT_TRUE(g->AddInputNode(std::move(iop2)));
+    EXPECT_TRUE(g->AddNode(std::move(op), {iop1_ptr, iop2_ptr}));
+  }
+
+  // Right records without matches emit nulls.
+  std::vector<Record> output =
+      ops.at(0)->Process(1, CopyVec(rrecords), Promise::None);
+  EXPECT_EQ(output.size(), 2);
+
+  // Checkpoint and restore into the second graph.
+  std::vector<SchemaRef> schemas = ops.at(0)->CheckpointSchemas();
+  std::vector<std::vector<Record>> batches = ops.at(0)->Checkpoint();
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(batches.at(0).size(), 0);
+  EXPECT_EQ(batches.at(1).size(), 2);
+  EXPECT_EQ(batches.at(2).size(), 2);
+  EXPECT_EQ(schemas.at(1), rschema);
+  ops.at(1)->Restore(std::move(batches));
+  EXPECT_EQ(ops.at(1)->right_table_.count(), 2);
+  EXPECT_EQ(ops.at(1)->emitted_nulls_.count(), 2);
+
+  // A matching left record retracts the emitted null in both.
+  std::vector<Record> expected =
+      ops.at(0)->Process(0, CopyVec(lrecords), Promise::None);
+  output = ops.at(1)->Process(0, CopyVec(lrecords), Promise::None);
+  EXPECT_EQ(output.size(), 2);
+  EXPECT_EQ(output, expected);
+}
+
 }  // namespace dataflow
 }  // namespace k9db
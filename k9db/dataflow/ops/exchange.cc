@@ -27,7 +27,7 @@ std::vector<Record> ExchangeOperator::Process(NodeIndex source,
   for (auto &[partition, records] : partitioned) {
     if (partition != this->partition()) {
       this->channels_.at(partition)->Write(
-          this->partition(), {this->flow_name_, std::move(records),
+          this->partition(), {this->flow_, std::move(records),
                               this->index(), this->index(), promise.Derive()});
     }
   }
@@ -40,7 +40,7 @@ void ExchangeOperator::ComputeOutputSchema() {
 }
 
 std::unique_ptr<Operator> ExchangeOperator::Clone() const {
-  return std::make_unique<ExchangeOperator>(this->flow_name_, this->partitions_,
+  return std::make_unique<ExchangeOperator>(this->flow_, this->partitions_,
                                             this->channels_, this->outkey_);
 }
 
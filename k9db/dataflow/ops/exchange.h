@@ -21,11 +21,11 @@ class ExchangeOperator : public Operator {
   ExchangeOperator(const ExchangeOperator &other) = delete;
   ExchangeOperator &operator=(const ExchangeOperator &other) = delete;
 
-  ExchangeOperator(const std::string &flow_name, size_t partitions,
+  ExchangeOperator(FlowIndex flow, size_t partitions,
                    const std::vector<Channel *> &channels,
                    const PartitionKey &outkey)
       : Operator(Operator::Type::EXCHANGE),
-        flow_name_(flow_name),
+        flow_(flow),
         partitions_(partitions),
         channels_(channels),
         outkey_(outkey) {}
@@ -67,7 +67,7 @@ class ExchangeOperator : public Operator {
   std::unique_ptr<Operator> Clone() const override;
 
  private:
-  std::string flow_name_;
+  FlowIndex flow_;
   size_t partitions_;
   std::vector<Channel *> channels_;
   PartitionKey outkey_;  // partitioning key.
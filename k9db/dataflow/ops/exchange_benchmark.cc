@@ -0,0 +1,116 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/future.h"
+#include "k9db/dataflow/graph_partition.h"
+#include "k9db/dataflow/operator.h"
+#include "k9db/dataflow/ops/benchmark_utils.h"
+#include "k9db/dataflow/ops/exchange.h"
+#include "k9db/dataflow/ops/identity.h"
+#include "k9db/dataflow/ops/input.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+// Every partition of an input -> exchange -> identity flow is driven by its
+// own worker thread reading from its channel (without the work stealing of
+// DataFlowState's Scheduler).
+// Each iteration writes a batch of records into every partition and waits for
+// all of them (including records exchanged between partitions) to be
+// processed.
+// NOLINTNEXTLINE
+static void ExchangeAllToAll(benchmark::State &state) {
+  size_t partitions = state.range(0);
+  size_t batch_size = state.range(1);
+  SchemaRef schema = MakeSchema(false, true);
+  FlowIndex flow_index = 0;
+
+  // Channels.
+  std::vector<std::unique_ptr<Channel>> channels;
+  std::vector<Channel *> chans;
+  for (size_t i = 0; i < partitions; i++) {
+    channels.push_back(std::make_unique<Channel>(partitions));
+    chans.push_back(channels.back().get());
+  }
+
+  // Make a flow and clone it per partition.
+  DataFlowGraphPartition g{0};
+  auto input = std::make_unique<InputOperator>("test-table", schema);
+  auto exchange =
+      std::make_unique<ExchangeOperator>(flow_index, partitions, chans,
+                                         PartitionKey{0});
+  auto identity = std::make_unique<IdentityOperator>();
+  Operator *input_ptr = input.get();
+  Operator *exchange_ptr = exchange.get();
+  g.AddInputNode(std::move(input));
+  g.AddNode(std::move(exchange), input_ptr);
+  g.AddNode(std::move(identity), exchange_ptr);
+  std::vector<std::unique_ptr<DataFlowGraphPartition>> flow;
+  for (size_t i = 0; i < partitions; i++) {
+    flow.push_back(g.Clone(i, {}));
+  }
+  NodeIndex input_index = input_ptr->index();
+
+  // Start the workers.
+  std::atomic<bool> stop = false;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < partitions; i++) {
+    workers.emplace_back([&, i]() {
+      std::vector<Channel::Message> messages;
+      while (!stop) {
+        if (!chans.at(i)->TryRead(&messages)) {
+          std::this_thread::yield();
+          continue;
+        }
+        for (Channel::Message &msg : messages) {
+          Operator *op = flow.at(i)->GetNode(msg.target);
+          op->ProcessAndForward(msg.source, std::move(msg.records),
+                                std::move(msg.promise));
+        }
+        messages.clear();
+      }
+    });
+  }
+
+  size_t processed = 0;
+  for (auto _ : state) {
+    Future future(true);
+    Promise promise = future.GetPromise();
+    for (size_t i = 0; i < partitions; i++) {
+      std::vector<Record> records;
+      records.reserve(batch_size);
+      for (uint64_t j = 0; j < batch_size; j++) {
+        records.emplace_back(schema, true, processed + j, j);
+      }
+      chans.at(i)->WriteInput({flow_index, std::move(records),
+                               UNDEFINED_NODE_INDEX, input_index,
+                               promise.Derive()});
+    }
+    promise.Resolve();
+    future.Wait();
+    processed += partitions * batch_size;
+  }
+  state.SetItemsProcessed(processed);
+
+  // Stop the workers.
+  stop = true;
+  for (size_t i = 0; i < partitions; i++) {
+    workers.at(i).join();
+  }
+}
+
+BENCHMARK(ExchangeAllToAll)
+    ->UseRealTime()
+    ->ArgsProduct({{2, 4, 16}, {1, 100}});
+
+}  // namespace dataflow
+}  // namespace k9db
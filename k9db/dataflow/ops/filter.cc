@@ -5,6 +5,10 @@
 
 #include "glog/logging.h"
 
+// Batches with fewer records are filtered record by record, since gathering
+// their columns costs more than vectorizing saves.
+#define KERNEL_MIN_RECORDS 16
+
 // The value in v must be of the same type as the corresponding one in the
 // record schema.
 #define COLUMN_VALUE_CMP_MACRO(col, v, OP)                      \
@@ -86,6 +90,38 @@ namespace dataflow {
 
 void FilterOperator::ComputeOutputSchema() {
   this->output_schema_ = this->input_schemas_.at(0);
+  this->CompileKernels();
+}
+
+void FilterOperator::CompileKernels() {
+  this->kernels_.clear();
+  this->residual_.clear();
+  if (this->input_schemas_.empty()) {
+    return;
+  }
+  // Comparisons of two null columns accept the record regardless of any other
+  // operation, which only holds if operations are evaluated in order.
+  for (const FilterOperation &operation : this->ops_) {
+    if (operation.is_column()) {
+      this->residual_ = this->ops_;
+      return;
+    }
+  }
+  const SchemaRef &schema = this->input_schemas_.at(0);
+  for (const FilterOperation &operation : this->ops_) {
+    const sqlast::Value *literal = nullptr;
+    if (operation.op() != Operation::IS_NULL &&
+        operation.op() != Operation::IS_NOT_NULL) {
+      literal = &operation.right_value();
+    }
+    std::optional<FilterKernel> kernel = FilterKernel::Compile(
+        schema, operation.left(), operation.op(), literal);
+    if (kernel.has_value()) {
+      this->kernels_.push_back(std::move(kernel.value()));
+    } else {
+      this->residual_.push_back(operation);
+    }
+  }
 }
 
 std::vector<Record> FilterOperator::Process(NodeIndex source,
@@ -93,16 +129,37 @@ std::vector<Record> FilterOperator::Process(NodeIndex source,
                                             const Promise &promise) {
   std::vector<Record> output;
   output.reserve(records.size());
-  for (Record &record : records) {
-    if (this->Accept(record)) {
-      output.push_back(std::move(record));
+  if (records.size() < KERNEL_MIN_RECORDS || this->kernels_.empty()) {
+    for (Record &record : records) {
+      if (this->Accept(record)) {
+        output.push_back(std::move(record));
+      }
+    }
+    return output;
+  }
+
+  // Narrow down the selection with the kernels, then check the residual
+  // operations on the selected records only.
+  Selection selection(records.size(), 1);
+  ColumnBatch batch(records);
+  for (const FilterKernel &kernel : this->kernels_) {
+    kernel.Run(&batch, &selection);
+  }
+  for (size_t i = 0; i < records.size(); i++) {
+    if (selection[i] && this->Accept(records[i], this->residual_)) {
+      output.push_back(std::move(records[i]));
     }
   }
   return output;
 }
 
 bool FilterOperator::Accept(const Record &record) const {
-  for (const auto &operation : this->ops_) {
+  return this->Accept(record, this->ops_);
+}
+
+bool FilterOperator::Accept(const Record &record,
+                            const std::vector<FilterOperation> &ops) const {
+  for (const auto &operation : ops) {
     switch (operation.op()) {
       case Operation::LESS_THAN:
         GENERIC_CMP_MACRO(operation, <);
@@ -144,6 +201,8 @@ bool FilterOperator::Accept(const Record &record) const {
 std::unique_ptr<Operator> FilterOperator::Clone() const {
   auto clone = std::make_unique<FilterOperator>();
   clone->ops_ = this->ops_;
+  clone->kernels_ = this->kernels_;
+  clone->residual_ = this->residual_;
   return clone;
 }
 
@@ -11,6 +11,7 @@
 #include "gtest/gtest_prod.h"
 #include "k9db/dataflow/operator.h"
 #include "k9db/dataflow/ops/filter_enum.h"
+#include "k9db/dataflow/ops/kernels.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/types.h"
 #include "k9db/sqlast/ast.h"
@@ -32,9 +33,11 @@ class FilterOperator : public Operator {
   // Add filter conditions/operations.
   void AddNullOperation(ColumnID column, Operation op) {
     this->ops_.emplace_back(column, op);
+    this->CompileKernels();
   }
   void AddLiteralOperation(ColumnID column, uint64_t value, Operation op) {
     this->ops_.emplace_back(column, sqlast::Value(value), op);
+    this->CompileKernels();
   }
   void AddLiteralOperation(ColumnID column, int64_t value, Operation op) {
     // Everything gets parsed in the ast and calcite as a *signed* int.
@@ -48,13 +51,16 @@ class FilterOperator : public Operator {
     } else {
       this->ops_.emplace_back(column, sqlast::Value(value), op);
     }
+    this->CompileKernels();
   }
   void AddLiteralOperation(ColumnID column, const std::string &value,
                            Operation op) {
     this->ops_.emplace_back(column, sqlast::Value(value), op);
+    this->CompileKernels();
   }
   void AddColumnOperation(ColumnID left, ColumnID right, Operation op) {
     this->ops_.emplace_back(left, right, op);
+    this->CompileKernels();
   }
 
  protected:
@@ -106,7 +112,15 @@ class FilterOperator : public Operator {
     bool col_;
   };
 
+  // Compile the operations that can be vectorized into kernels, the rest are
+  // residual and evaluated per record (needs the input schema).
+  void CompileKernels();
+  bool Accept(const Record &record,
+              const std::vector<FilterOperation> &ops) const;
+
   std::vector<FilterOperation> ops_;
+  std::vector<FilterKernel> kernels_;
+  std::vector<FilterOperation> residual_;
 
   // Allow tests to use .Process(...) directly.
   FRIEND_TEST(FilterOperatorTest, SingleAccept);
@@ -117,6 +131,7 @@ class FilterOperator : public Operator {
   FRIEND_TEST(FilterOperatorTest, TypeMistmatch);
   FRIEND_TEST(FilterOperatorTest, ImplicitTypeConversion);
   FRIEND_TEST(FilterOperatorTest, IsNullAccept);
+  FRIEND_TEST(FilterOperatorTest, VectorizedBatch);
 };
 
 }  // namespace dataflow
@@ -1,8 +1,12 @@
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "k9db/dataflow/graph_partition.h"
 #include "k9db/dataflow/ops/benchmark_utils.h"
 #include "k9db/dataflow/ops/filter.h"
+#include "k9db/dataflow/ops/input.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/dataflow/types.h"
@@ -53,8 +57,42 @@ static void FilterDiscards(benchmark::State &state) {
   state.SetItemsProcessed(processed);
 }
 
+// NOLINTNEXTLINE
+static void FilterBatch(benchmark::State &state) {
+  SchemaRef schema = MakeSchema(false, true);
+
+  // Generator function: generates batches of records for benchmarking, about
+  // half of them pass the filter.
+  RecordGenFunc gen = [schema, &state] {
+    std::vector<Record> records;
+    for (int i = 0; i < state.range(0); ++i) {
+      records.emplace_back(schema, true, uint64_t(i), uint64_t(i % 10));
+    }
+    return records;
+  };
+
+  // The filter needs its input schema to vectorize its conditions.
+  DataFlowGraphPartition g{0};
+  auto in = std::make_unique<InputOperator>("test-table1", schema);
+  auto op = std::make_unique<FilterOperator>();
+  op->AddLiteralOperation(1, 5_u, FilterOperator::Operation::LESS_THAN);
+  op->AddLiteralOperation(0, 0_u, FilterOperator::Operation::GREATER_THAN);
+  auto in_ptr = in.get();
+  auto op_ptr = op.get();
+  g.AddInputNode(std::move(in));
+  g.AddNode(std::move(op), in_ptr);
+
+  size_t processed = 0;
+  for (auto _ : state) {
+    ProcessBenchmark(op_ptr, UNDEFINED_NODE_INDEX, gen);
+    processed += state.range(0);
+  }
+  state.SetItemsProcessed(processed);
+}
+
 BENCHMARK(FilterPasses);
 BENCHMARK(FilterDiscards);
+BENCHMARK(FilterBatch)->Arg(10)->Arg(100)->Arg(1000);
 
 }  // namespace dataflow
 }  // namespace k9db
@@ -309,5 +309,64 @@ TEST(FilterOperatorTest, IsNullAccept) {
   EXPECT_FALSE(filter2.Accept(records.at(2)));
 }
 
+// Large batches are filtered by kernels (integer conditions) and record by
+// record (the rest), the output must match filtering one record at a time.
+TEST(FilterOperatorTest, VectorizedBatch) {
+  SchemaRef schema = CreateSchema();
+
+  FilterOperator filter1;
+  FilterOperator filter2;
+  filter1.input_schemas_.push_back(schema);
+  filter2.input_schemas_.push_back(schema);
+  filter1.AddLiteralOperation(0, 20_u, FilterOperator::Operation::LESS_THAN);
+  filter1.AddLiteralOperation(2, -8_s,
+                              FilterOperator::Operation::GREATER_THAN_OR_EQUAL);
+  filter1.AddLiteralOperation(1, "x", FilterOperator::Operation::NOT_EQUAL);
+  filter2.AddNullOperation(2, FilterOperator::Operation::IS_NULL);
+  EXPECT_EQ(filter1.kernels_.size(), 2u);
+  EXPECT_EQ(filter1.residual_.size(), 1u);
+  EXPECT_EQ(filter2.kernels_.size(), 1u);
+  EXPECT_EQ(filter2.residual_.size(), 0u);
+
+  // Create some records, with nulls sprinkled in.
+  std::vector<Record> records;
+  for (size_t i = 0; i < 64; i++) {
+    Record &record = records.emplace_back(schema);
+    if (i % 7 == 0) {
+      record.SetNull(true, 0);
+    } else {
+      record.SetUInt(i, 0);
+    }
+    record.SetString(std::make_unique<std::string>(i % 5 == 0 ? "x" : "y"), 1);
+    if (i % 6 == 0) {
+      record.SetNull(true, 2);
+    } else {
+      record.SetInt(static_cast<int64_t>(i) - 16, 2);
+    }
+  }
+
+  // Filter one record at a time.
+  std::vector<Record> expected1;
+  std::vector<Record> expected2;
+  for (const Record &record : records) {
+    if (filter1.Accept(record)) {
+      expected1.push_back(record.Copy());
+    }
+    if (filter2.Accept(record)) {
+      expected2.push_back(record.Copy());
+    }
+  }
+  EXPECT_FALSE(expected1.empty());
+  EXPECT_EQ(expected2.size(), 11u);
+
+  // Filter the whole batch.
+  EXPECT_EQ(filter1.Process(UNDEFINED_NODE_INDEX, CopyVec(records),
+                            Promise::None),
+            expected1);
+  EXPECT_EQ(filter2.Process(UNDEFINED_NODE_INDEX, CopyVec(records),
+                            Promise::None),
+            expected2);
+}
+
 }  // namespace dataflow
 }  // namespace k9db
@@ -76,7 +76,9 @@ class GroupedData<T, std::enable_if_t<!std::is_null_pointer<T>::value>> {
 // to having composite keys.
 // 1. Lookup by key via #Lookup(key): these return a vector of records
 //    corresponding to the given key in whatever underlying order they are
-//    stored in. The vector owns these records (they are copies).
+//    stored in. The records in the vector share their storage with the stored
+//    records (see Record::Share()), so reads do not copy any data, but the
+//    returned records must not be modified.
 //    These also have a version with optional arguments for an offset and limit.
 // 2. Complete iteration via #All(): this returns a vector of all the records in
 //    all the keys with the underlying order of keys and/or records.
@@ -200,7 +202,7 @@ class GroupedDataT : public GroupedData<RecordCompare> {
     auto end = it->second.end();
     std::advance(begin, offset);
 
-    // Copy records.
+    // Share records.
     std::vector<R> result;
     result.reserve(limit > -1 ? limit : it->second.size() - offset);
     for (auto it = begin; it != end; ++it) {
@@ -208,7 +210,7 @@ class GroupedDataT : public GroupedData<RecordCompare> {
         break;
       }
       if constexpr (std::is_same<R, Record>::value) {
-        result.push_back(it->Copy());
+        result.push_back(it->Share());
       } else {
         // Use copy constructor.
         result.push_back(*it);
@@ -237,14 +239,14 @@ class GroupedDataT : public GroupedData<RecordCompare> {
       --offset;
     }
 
-    // Copy records.
+    // Share records.
     std::vector<R> result;
     for (auto it = begin; it != end; ++it) {
       if (limit > -1 && result.size() >= static_cast<size_t>(limit)) {
         break;
       }
       if constexpr (std::is_same<R, Record>::value) {
-        result.push_back(it->Copy());
+        result.push_back(it->Share());
       } else {
         // Use copy constructor.
         result.push_back(*it);
@@ -273,7 +275,7 @@ class GroupedDataT : public GroupedData<RecordCompare> {
           return result;
         }
         if constexpr (std::is_same<R, Record>::value) {
-          result.push_back(it->Copy());
+          result.push_back(it->Share());
         } else {
           // Use copy constructor.
           result.push_back(*it);
@@ -297,7 +299,7 @@ class GroupedDataT : public GroupedData<RecordCompare> {
         }
 
         if constexpr (std::is_same<R, Record>::value) {
-          result.push_back(it2->Copy());
+          result.push_back(it2->Share());
         } else {
           // Use copy constructor.
           result.push_back(*it2);
@@ -378,7 +380,29 @@ class GroupedDataT : public GroupedData<RecordCompare> {
   }
   // Erase all entires keyed by key.
   bool Erase(const Key &k) {
-    this->contents_.erase(k);
+    auto it = this->contents_.find(k);
+    if (it == this->contents_.end()) {
+      return false;
+    }
+    V &bucket = it->second;
+    this->count_ -= bucket.size();
+    // Drop the erased records from the pk index.
+    if constexpr (std::is_same<R, Record>::value) {
+      if (this->schema_has_pk_) {
+        for (auto rit = bucket.cbegin(); rit != bucket.cend(); ++rit) {
+          auto pk_it = this->pk_index_.find(rit->GetKey());
+          if (pk_it == this->pk_index_.end()) {
+            continue;
+          }
+          auto &list = pk_it->second;
+          list.remove(rit);
+          if (list.size() == 0) {
+            this->pk_index_.erase(pk_it);
+          }
+        }
+      }
+    }
+    this->contents_.erase(it);
     return true;
   }
 
@@ -522,6 +546,7 @@ class GroupedDataT : public GroupedData<RecordCompare> {
 
   // This is not for use in Matview.
   V &Get(const Key &key) { return this->contents_.at(key); }
+  const V &Get(const Key &key) const { return this->contents_.at(key); }
 
  private:
   // Total number of records.
@@ -0,0 +1,308 @@
+#include "k9db/dataflow/ops/join_table.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "glog/logging.h"
+#include "k9db/sqlast/ast.h"
+
+// Must be a power of 2.
+#define INITIAL_SLOTS 16
+// Grow when more than 3/4 of the slots are used.
+#define LOAD_NUMERATOR 3
+#define LOAD_DENOMINATOR 4
+
+namespace k9db {
+namespace dataflow {
+
+namespace {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+// std::hash<uint64_t> is the identity, mix bits so that keys that are close
+// together (e.g. auto increment ids) do not land in neighboring slots.
+inline uint64_t Mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+inline uint64_t Combine(uint64_t hash, uint64_t value) {
+  return Mix(hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6)));
+}
+
+// Hashes of individual values. Nulls hash like 0.
+inline uint64_t HashString(const std::string &str) {
+  return std::hash<std::string>{}(str);
+}
+inline uint64_t HashCell(const Record &record, ColumnID col) {
+  if (record.IsNull(col)) {
+    return 0;
+  }
+  switch (record.schema().TypeOf(col)) {
+    case CType::UINT:
+      return record.GetUInt(col);
+    case CType::INT:
+      return static_cast<uint64_t>(record.GetInt(col));
+    case CType::TEXT:
+      return HashString(record.GetString(col));
+    case CType::DATETIME:
+      return HashString(record.GetDateTime(col));
+    default:
+      LOG(FATAL) << "Unsupported data type in join key";
+  }
+  return 0;
+}
+inline uint64_t HashValue(const sqlast::Value &value) {
+  switch (value.type()) {
+    case sqlast::Value::Type::_NULL:
+      return 0;
+    case sqlast::Value::Type::UINT:
+      return value.GetUInt();
+    case sqlast::Value::Type::INT:
+      return static_cast<uint64_t>(value.GetInt());
+    case sqlast::Value::Type::TEXT:
+      return HashString(value.GetString());
+    default:
+      LOG(FATAL) << "Unsupported data type in join key";
+  }
+  return 0;
+}
+
+// Whether the join key of l (columns lcols) is equal to the join key of r
+// (columns rcols). Like Key, a null is equal to a null, and values of
+// different types are never equal (DATETIME and TEXT are both strings).
+inline bool KeyEquals(const Record &l, const std::vector<ColumnID> &lcols,
+                      const Record &r, const std::vector<ColumnID> &rcols) {
+  for (size_t i = 0; i < lcols.size(); i++) {
+    ColumnID lc = lcols[i];
+    ColumnID rc = rcols[i];
+    bool lnull = l.IsNull(lc);
+    if (lnull != r.IsNull(rc)) {
+      return false;
+    }
+    if (lnull) {
+      continue;
+    }
+    CType type = l.schema().TypeOf(lc);
+    CType rtype = r.schema().TypeOf(rc);
+    bool ltext = type == CType::TEXT || type == CType::DATETIME;
+    bool rtext = rtype == CType::TEXT || rtype == CType::DATETIME;
+    if (type != rtype && !(ltext && rtext)) {
+      return false;
+    }
+    switch (type) {
+      case CType::UINT:
+        if (l.GetUInt(lc) != r.GetUInt(rc)) {
+          return false;
+        }
+        break;
+      case CType::INT:
+        if (l.GetInt(lc) != r.GetInt(rc)) {
+          return false;
+        }
+        break;
+      case CType::TEXT:
+      case CType::DATETIME: {
+        const std::string &lstr =
+            type == CType::TEXT ? l.GetString(lc) : l.GetDateTime(lc);
+        const std::string &rstr =
+            rtype == CType::TEXT ? r.GetString(rc) : r.GetDateTime(rc);
+        if (lstr != rstr) {
+          return false;
+        }
+        break;
+      }
+      default:
+        LOG(FATAL) << "Unsupported data type in join key";
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+JoinTable::JoinTable()
+    : cols_(), slots_(INITIAL_SLOTS), used_(0), count_(0) {}
+
+void JoinTable::Initialize(const std::vector<ColumnID> &cols) {
+  this->cols_ = cols;
+  this->slots_.clear();
+  this->slots_.resize(INITIAL_SLOTS);
+  this->used_ = 0;
+  this->count_ = 0;
+}
+
+// Hashing.
+uint64_t JoinTable::Hash(const Record &record,
+                         const std::vector<ColumnID> &cols) {
+  uint64_t hash = cols.size();
+  for (ColumnID col : cols) {
+    hash = Combine(hash, HashCell(record, col));
+  }
+  return hash;
+}
+uint64_t JoinTable::Hash(const Key &key) {
+  uint64_t hash = key.size();
+  for (size_t i = 0; i < key.size(); i++) {
+    hash = Combine(hash, HashValue(key.value(i)));
+  }
+  return hash;
+}
+
+// Probing.
+size_t JoinTable::Probe(const Record &probe,
+                        const std::vector<ColumnID> &probe_cols,
+                        uint64_t hash) const {
+  CHECK_EQ(probe_cols.size(), this->cols_.size()) << "Bad join key size";
+  size_t mask = this->slots_.size() - 1;
+  size_t index = hash & mask;
+  while (true) {
+    const Slot &slot = this->slots_[index];
+    if (slot.records.empty()) {
+      return index;
+    }
+    if (slot.hash == hash &&
+        KeyEquals(slot.records.front(), this->cols_, probe, probe_cols)) {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+const std::vector<Record> *JoinTable::Find(
+    const Record &probe, const std::vector<ColumnID> &probe_cols,
+    uint64_t hash) const {
+  const Slot &slot = this->slots_[this->Probe(probe, probe_cols, hash)];
+  if (slot.records.empty()) {
+    return nullptr;
+  }
+  return &slot.records;
+}
+
+// Modifying.
+void JoinTable::Insert(uint64_t hash, Record &&record) {
+  size_t index = this->Probe(record, this->cols_, hash);
+  if (this->slots_[index].records.empty()) {
+    // New key, make sure there is room for it.
+    if ((this->used_ + 1) * LOAD_DENOMINATOR >
+        this->slots_.size() * LOAD_NUMERATOR) {
+      this->Grow();
+      index = this->Probe(record, this->cols_, hash);
+    }
+    this->slots_[index].hash = hash;
+    this->used_++;
+  }
+  this->slots_[index].records.push_back(std::move(record));
+  this->count_++;
+}
+
+bool JoinTable::Delete(uint64_t hash, const Record &record) {
+  size_t index = this->Probe(record, this->cols_, hash);
+  std::vector<Record> &records = this->slots_[index].records;
+  for (auto it = records.begin(); it != records.end(); ++it) {
+    if (*it == record) {
+      records.erase(it);
+      this->count_--;
+      if (records.empty()) {
+        this->RemoveSlot(index);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void JoinTable::Erase(const Record &probe,
+                      const std::vector<ColumnID> &probe_cols, uint64_t hash) {
+  size_t index = this->Probe(probe, probe_cols, hash);
+  if (!this->slots_[index].records.empty()) {
+    this->count_ -= this->slots_[index].records.size();
+    this->slots_[index].records.clear();
+    this->RemoveSlot(index);
+  }
+}
+
+// Backward shift deletion: move back any following slots whose probe sequence
+// passes through the emptied slot, so that probing never needs tombstones.
+void JoinTable::RemoveSlot(size_t index) {
+  size_t mask = this->slots_.size() - 1;
+  size_t hole = index;
+  size_t next = (hole + 1) & mask;
+  while (!this->slots_[next].records.empty()) {
+    size_t home = this->slots_[next].hash & mask;
+    // Distance from home of next, and of the hole.
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      this->slots_[hole] = std::move(this->slots_[next]);
+      this->slots_[next].records.clear();
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  this->used_--;
+}
+
+void JoinTable::Grow() {
+  std::vector<Slot> old = std::move(this->slots_);
+  this->slots_.clear();
+  this->slots_.resize(old.size() * 2);
+  size_t mask = this->slots_.size() - 1;
+  for (Slot &slot : old) {
+    if (slot.records.empty()) {
+      continue;
+    }
+    size_t index = slot.hash & mask;
+    while (!this->slots_[index].records.empty()) {
+      index = (index + 1) & mask;
+    }
+    this->slots_[index] = std::move(slot);
+  }
+}
+
+// Inspecting.
+std::vector<Record> JoinTable::Lookup(const Key &key) const {
+  CHECK_EQ(key.size(), this->cols_.size()) << "Bad join key size";
+  uint64_t hash = JoinTable::Hash(key);
+  size_t mask = this->slots_.size() - 1;
+  for (size_t index = hash & mask; !this->slots_[index].records.empty();
+       index = (index + 1) & mask) {
+    const Slot &slot = this->slots_[index];
+    if (slot.hash == hash &&
+        slot.records.front().GetValues(this->cols_) == key) {
+      std::vector<Record> result;
+      result.reserve(slot.records.size());
+      for (const Record &record : slot.records) {
+        result.push_back(record.Share());
+      }
+      return result;
+    }
+  }
+  return {};
+}
+
+std::vector<Record> JoinTable::All() const {
+  std::vector<Record> result;
+  result.reserve(this->count_);
+  for (const Slot &slot : this->slots_) {
+    for (const Record &record : slot.records) {
+      result.push_back(record.Share());
+    }
+  }
+  return result;
+}
+
+uint64_t JoinTable::SizeInMemory() const {
+  uint64_t size = this->slots_.size() * sizeof(Slot);
+  for (const Slot &slot : this->slots_) {
+    for (const Record &record : slot.records) {
+      size += record.SizeInMemory();
+    }
+  }
+  return size;
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,94 @@
+// The state of one side of a join.
+//
+// Records are grouped by the values of their join columns (the join key),
+// which may span several columns. Groups live in a single open addressing
+// (linear probing) array of slots, each slot keeping the 64-bit hash of its
+// key next to its records. Lookups compare hashes first, and only compare
+// the actual key values of the first record in a slot when the hashes match.
+// Unlike GroupedData, no Key (i.e. vector of sqlast::Value) is ever allocated:
+// the key is read directly from the records.
+#ifndef K9DB_DATAFLOW_OPS_JOIN_TABLE_H_
+#define K9DB_DATAFLOW_OPS_JOIN_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "k9db/dataflow/key.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+class JoinTable {
+ public:
+  JoinTable();
+
+  // Cannot copy the state.
+  JoinTable(const JoinTable &) = delete;
+  JoinTable &operator=(const JoinTable &) = delete;
+
+  // The join columns of records stored in this table.
+  void Initialize(const std::vector<ColumnID> &cols);
+
+  // Hash of the values of the given columns of a record. Records from
+  // different schemas have equal hashes if the values in their join columns
+  // are equal, so that a record from one side can probe the other side.
+  static uint64_t Hash(const Record &record, const std::vector<ColumnID> &cols);
+  static uint64_t Hash(const Key &key);
+
+  // Records whose join key is equal to the values of probe_cols in probe, or
+  // nullptr if there are none. hash must be Hash(probe, probe_cols).
+  // The returned pointer is invalidated by Insert(), Delete() and Erase().
+  const std::vector<Record> *Find(const Record &probe,
+                                  const std::vector<ColumnID> &probe_cols,
+                                  uint64_t hash) const;
+
+  // hash must be Hash(record, cols) where cols are the join columns given
+  // to Initialize().
+  void Insert(uint64_t hash, Record &&record);
+  // Delete one record equal to the given record. Returns false if no such
+  // record exists.
+  bool Delete(uint64_t hash, const Record &record);
+  // Erase all records with the join key of probe.
+  void Erase(const Record &probe, const std::vector<ColumnID> &probe_cols,
+             uint64_t hash);
+
+  // Lookup by a key (for tests and debugging, this allocates).
+  std::vector<Record> Lookup(const Key &key) const;
+  // All records in the table, in no particular order (shared).
+  std::vector<Record> All() const;
+
+  // Count of records in the table.
+  size_t count() const { return this->count_; }
+  // Total size consumed in memory.
+  uint64_t SizeInMemory() const;
+
+ private:
+  // A slot is empty iff it has no records.
+  struct Slot {
+    uint64_t hash;
+    std::vector<Record> records;
+  };
+
+  // Index of the slot holding the given key, or of the empty slot where it
+  // would go.
+  size_t Probe(const Record &probe, const std::vector<ColumnID> &probe_cols,
+               uint64_t hash) const;
+  // Empty the slot at index and shift back any records displaced by it.
+  void RemoveSlot(size_t index);
+  // Double the number of slots.
+  void Grow();
+
+  std::vector<ColumnID> cols_;
+  std::vector<Slot> slots_;
+  // Non-empty slots.
+  size_t used_;
+  // Total records.
+  size_t count_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_OPS_JOIN_TABLE_H_
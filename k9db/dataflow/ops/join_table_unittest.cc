@@ -0,0 +1,120 @@
+#include "k9db/dataflow/ops/join_table.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/key.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/sqlast/ast.h"
+#include "k9db/util/ints.h"
+
+namespace k9db {
+namespace dataflow {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+namespace {
+
+SchemaRef MakeSchema() {
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  return SchemaFactory::Create(names, types, keys);
+}
+
+SchemaRef MakeOtherSchema() {
+  std::vector<std::string> names = {"Col1", "Col2"};
+  std::vector<CType> types = {CType::INT, CType::TEXT};
+  std::vector<ColumnID> keys = {};
+  return SchemaFactory::Create(names, types, keys);
+}
+
+}  // namespace
+
+// Records of different schemas with equal join keys find each other.
+TEST(JoinTableTest, FindAcrossSchemas) {
+  SchemaRef schema = MakeSchema();
+  SchemaRef other = MakeOtherSchema();
+  std::vector<ColumnID> cols = {1, 2};
+  std::vector<ColumnID> other_cols = {1, 0};
+
+  JoinTable table;
+  table.Initialize(cols);
+  Record r1{schema, true, 0_u, "a"_uptr, 5_s};
+  Record r2{schema, true, 1_u, "a"_uptr, 5_s};
+  Record r3{schema, true, 2_u, "a"_uptr, 6_s};
+  table.Insert(JoinTable::Hash(r1, cols), r1.Copy());
+  table.Insert(JoinTable::Hash(r2, cols), r2.Copy());
+  table.Insert(JoinTable::Hash(r3, cols), r3.Copy());
+  EXPECT_EQ(table.count(), 3);
+
+  Record probe{other, true, 5_s, "a"_uptr};
+  uint64_t hash = JoinTable::Hash(probe, other_cols);
+  EXPECT_EQ(hash, JoinTable::Hash(r1, cols));
+  const std::vector<Record> *found = table.Find(probe, other_cols, hash);
+  ASSERT_NE(found, nullptr);
+  ASSERT_EQ(found->size(), 2);
+  EXPECT_EQ(found->at(0), r1);
+  EXPECT_EQ(found->at(1), r2);
+
+  Record miss{other, true, 5_s, "b"_uptr};
+  EXPECT_EQ(table.Find(miss, other_cols, JoinTable::Hash(miss, other_cols)),
+            nullptr);
+
+  // Lookup by key hashes the same way.
+  Key key = r3.GetValues(cols);
+  EXPECT_EQ(JoinTable::Hash(key), JoinTable::Hash(r3, cols));
+  std::vector<Record> expected;
+  expected.push_back(r3.Copy());
+  EXPECT_EQ(table.Lookup(key), expected);
+}
+
+// Deleting and erasing keeps every other key reachable, through growth and
+// backward shifting of collided slots.
+TEST(JoinTableTest, InsertDeleteMany) {
+  SchemaRef schema = MakeSchema();
+  std::vector<ColumnID> cols = {0};
+  JoinTable table;
+  table.Initialize(cols);
+  for (uint64_t i = 0; i < 1000; i++) {
+    for (uint64_t j = 0; j < 2; j++) {
+      Record r{schema, true, i, std::make_unique<std::string>("v"),
+               static_cast<int64_t>(j)};
+      table.Insert(JoinTable::Hash(r, cols), std::move(r));
+    }
+  }
+  EXPECT_EQ(table.count(), 2000);
+
+  // Delete one record of the even keys, and erase the odd keys entirely.
+  for (uint64_t i = 0; i < 1000; i++) {
+    Record r{schema, false, i, std::make_unique<std::string>("v"), 0_s};
+    uint64_t hash = JoinTable::Hash(r, cols);
+    if (i % 2 == 0) {
+      EXPECT_TRUE(table.Delete(hash, r));
+      EXPECT_FALSE(table.Delete(hash, r));
+    } else {
+      table.Erase(r, cols, hash);
+    }
+  }
+  EXPECT_EQ(table.count(), 500);
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    Record r{schema, true, i, std::make_unique<std::string>("v"), 1_s};
+    const std::vector<Record> *found =
+        table.Find(r, cols, JoinTable::Hash(r, cols));
+    if (i % 2 == 0) {
+      ASSERT_NE(found, nullptr);
+      ASSERT_EQ(found->size(), 1);
+      EXPECT_EQ(found->at(0), r);
+    } else {
+      EXPECT_EQ(found, nullptr);
+    }
+  }
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,212 @@
+#include "k9db/dataflow/ops/kernels.h"
+
+#include <functional>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace k9db {
+namespace dataflow {
+
+namespace {
+
+// Filter kernels.
+using FilterFunction = void (*)(const uint64_t *values, const uint8_t *nulls,
+                                uint64_t literal, uint8_t *selection,
+                                size_t size);
+
+template <typename T, typename Compare>
+void CompareLiteral(const uint64_t *values, const uint8_t *nulls,
+                    uint64_t literal, uint8_t *selection, size_t size) {
+  const T *typed = reinterpret_cast<const T *>(values);
+  T value = static_cast<T>(literal);
+  Compare compare;
+  for (size_t i = 0; i < size; i++) {
+    selection[i] &= static_cast<uint8_t>(compare(typed[i], value)) & ~nulls[i];
+  }
+}
+
+void SelectNull(const uint64_t *, const uint8_t *nulls, uint64_t,
+                uint8_t *selection, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    selection[i] &= nulls[i];
+  }
+}
+
+void SelectNotNull(const uint64_t *, const uint8_t *nulls, uint64_t,
+                   uint8_t *selection, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    selection[i] &= ~nulls[i];
+  }
+}
+
+template <typename T>
+FilterFunction CompareFunction(FilterOperationEnum op) {
+  switch (op) {
+    case FilterOperationEnum::LESS_THAN:
+      return &CompareLiteral<T, std::less<T>>;
+    case FilterOperationEnum::LESS_THAN_OR_EQUAL:
+      return &CompareLiteral<T, std::less_equal<T>>;
+    case FilterOperationEnum::GREATER_THAN:
+      return &CompareLiteral<T, std::greater<T>>;
+    case FilterOperationEnum::GREATER_THAN_OR_EQUAL:
+      return &CompareLiteral<T, std::greater_equal<T>>;
+    case FilterOperationEnum::EQUAL:
+      return &CompareLiteral<T, std::equal_to<T>>;
+    case FilterOperationEnum::NOT_EQUAL:
+      return &CompareLiteral<T, std::not_equal_to<T>>;
+    default:
+      return nullptr;
+  }
+}
+
+// Arithmetic kernels, over the bits of the operands: two's complement makes
+// + and - the same for INT and UINT (and mixes of them).
+template <bool PLUS, bool LEFT_COLUMN, bool RIGHT_COLUMN>
+void Arithmetic(const uint64_t *left, const uint64_t *right, uint64_t *output,
+                size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    uint64_t l = LEFT_COLUMN ? left[i] : *left;
+    uint64_t r = RIGHT_COLUMN ? right[i] : *right;
+    output[i] = PLUS ? l + r : l - r;
+  }
+}
+
+template <bool PLUS>
+void Arithmetic(const uint64_t *left, bool left_column, const uint64_t *right,
+                bool right_column, uint64_t *output, size_t size) {
+  if (left_column && right_column) {
+    Arithmetic<PLUS, true, true>(left, right, output, size);
+  } else if (left_column) {
+    Arithmetic<PLUS, true, false>(left, right, output, size);
+  } else if (right_column) {
+    Arithmetic<PLUS, false, true>(left, right, output, size);
+  } else {
+    Arithmetic<PLUS, false, false>(left, right, output, size);
+  }
+}
+
+}  // namespace
+
+// ColumnBatch.
+const std::vector<uint64_t> &ColumnBatch::Values(ColumnID column) {
+  auto it = this->values_.find(column);
+  if (it != this->values_.end()) {
+    return it->second;
+  }
+  std::vector<uint64_t> &values = this->values_[column];
+  values.resize(this->records_.size());
+  if (this->records_.empty()) {
+    return values;
+  }
+  switch (this->records_.front().schema().TypeOf(column)) {
+    case sqlast::ColumnDefinition::Type::UINT:
+      for (size_t i = 0; i < this->records_.size(); i++) {
+        const Record &record = this->records_[i];
+        values[i] = record.IsNull(column) ? 0 : record.GetUInt(column);
+      }
+      break;
+    case sqlast::ColumnDefinition::Type::INT:
+      for (size_t i = 0; i < this->records_.size(); i++) {
+        const Record &record = this->records_[i];
+        values[i] = record.IsNull(column)
+                        ? 0
+                        : static_cast<uint64_t>(record.GetInt(column));
+      }
+      break;
+    default:
+      LOG(FATAL) << "Only integer columns can be vectorized";
+  }
+  return values;
+}
+
+const std::vector<uint8_t> &ColumnBatch::Nulls(ColumnID column) {
+  auto it = this->nulls_.find(column);
+  if (it != this->nulls_.end()) {
+    return it->second;
+  }
+  std::vector<uint8_t> &nulls = this->nulls_[column];
+  nulls.resize(this->records_.size());
+  for (size_t i = 0; i < this->records_.size(); i++) {
+    nulls[i] = this->records_[i].IsNull(column) ? 0xFF : 0x00;
+  }
+  return nulls;
+}
+
+// FilterKernel.
+std::optional<FilterKernel> FilterKernel::Compile(
+    const SchemaRef &schema, ColumnID column, FilterOperationEnum op,
+    const sqlast::Value *literal) {
+  if (op == FilterOperationEnum::IS_NULL) {
+    return FilterKernel(column, 0, true, &SelectNull);
+  }
+  if (op == FilterOperationEnum::IS_NOT_NULL) {
+    return FilterKernel(column, 0, true, &SelectNotNull);
+  }
+  if (literal == nullptr) {
+    return {};
+  }
+  switch (schema.TypeOf(column)) {
+    case sqlast::ColumnDefinition::Type::UINT:
+      if (literal->type() == sqlast::Value::Type::UINT) {
+        return FilterKernel(column, literal->GetUInt(), false,
+                            CompareFunction<uint64_t>(op));
+      }
+      return {};
+    case sqlast::ColumnDefinition::Type::INT:
+      if (literal->type() == sqlast::Value::Type::INT) {
+        return FilterKernel(column, static_cast<uint64_t>(literal->GetInt()),
+                            false, CompareFunction<int64_t>(op));
+      }
+      return {};
+    default:
+      return {};
+  }
+}
+
+void FilterKernel::Run(ColumnBatch *batch, Selection *selection) const {
+  const std::vector<uint8_t> &nulls = batch->Nulls(this->column_);
+  const uint64_t *values =
+      this->nulls_only_ ? nullptr : batch->Values(this->column_).data();
+  this->function_(values, nulls.data(), this->literal_, selection->data(),
+                  batch->size());
+}
+
+// ArithmeticKernel.
+ArithmeticKernel::ArithmeticKernel(ProjectOperationEnum op, Operand &&left,
+                                   Operand &&right)
+    : op_(op), left_(std::move(left)), right_(std::move(right)) {
+  CHECK(op == ProjectOperationEnum::PLUS || op == ProjectOperationEnum::MINUS);
+}
+
+void ArithmeticKernel::Run(ColumnBatch *batch, std::vector<uint64_t> *output,
+                           std::vector<uint8_t> *nulls) const {
+  size_t size = batch->size();
+  output->resize(size);
+  nulls->assign(size, 0);
+
+  bool lcol = this->left_.column.has_value();
+  bool rcol = this->right_.column.has_value();
+  const uint64_t *left =
+      lcol ? batch->Values(*this->left_.column).data() : &this->left_.literal;
+  const uint64_t *right = rcol ? batch->Values(*this->right_.column).data()
+                               : &this->right_.literal;
+  if (this->op_ == ProjectOperationEnum::PLUS) {
+    Arithmetic<true>(left, lcol, right, rcol, output->data(), size);
+  } else {
+    Arithmetic<false>(left, lcol, right, rcol, output->data(), size);
+  }
+
+  // Only null if both operands are null columns.
+  if (lcol && rcol) {
+    const uint8_t *lnulls = batch->Nulls(*this->left_.column).data();
+    const uint8_t *rnulls = batch->Nulls(*this->right_.column).data();
+    uint8_t *out = nulls->data();
+    for (size_t i = 0; i < size; i++) {
+      out[i] = lnulls[i] & rnulls[i];
+    }
+  }
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,113 @@
+// Vectorized kernels for filter and project operators over large batches.
+//
+// A ColumnBatch gathers the integer columns of a batch of records into
+// contiguous arrays (once per column, on demand). Kernels are specialized for
+// the types and operation of a filter condition or arithmetic projection when
+// the operator computes its output schema, and run over these arrays in
+// branch-free loops that the compiler vectorizes (SIMD).
+//
+// Filter kernels narrow down a selection vector, with one byte per record that
+// is 1 as long as the record satisfies all kernels that ran so far.
+#ifndef K9DB_DATAFLOW_OPS_KERNELS_H_
+#define K9DB_DATAFLOW_OPS_KERNELS_H_
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "k9db/dataflow/ops/filter_enum.h"
+#include "k9db/dataflow/ops/project_enum.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+#include "k9db/sqlast/ast.h"
+
+namespace k9db {
+namespace dataflow {
+
+using Selection = std::vector<uint8_t>;
+
+class ColumnBatch {
+ public:
+  explicit ColumnBatch(const std::vector<Record> &records)
+      : records_(records), values_(), nulls_() {}
+
+  // Not copyable or movable.
+  ColumnBatch(const ColumnBatch &) = delete;
+  ColumnBatch &operator=(const ColumnBatch &) = delete;
+
+  size_t size() const { return this->records_.size(); }
+
+  // The values of an INT or UINT column, as the bits of a (u)int64_t, with
+  // 0 for null.
+  const std::vector<uint64_t> &Values(ColumnID column);
+  // 0xFF if the value of the column is null, 0 otherwise (i.e. a mask).
+  const std::vector<uint8_t> &Nulls(ColumnID column);
+
+ private:
+  const std::vector<Record> &records_;
+  std::unordered_map<ColumnID, std::vector<uint64_t>> values_;
+  std::unordered_map<ColumnID, std::vector<uint8_t>> nulls_;
+};
+
+// Compares an INT or UINT column with a literal of the same type, or checks
+// whether a column is null.
+class FilterKernel {
+ public:
+  // Nothing is compiled for other types or operations, which need to be
+  // evaluated per record instead.
+  static std::optional<FilterKernel> Compile(const SchemaRef &schema,
+                                             ColumnID column,
+                                             FilterOperationEnum op,
+                                             const sqlast::Value *literal);
+
+  void Run(ColumnBatch *batch, Selection *selection) const;
+
+ private:
+  using Function = void (*)(const uint64_t *values, const uint8_t *nulls,
+                            uint64_t literal, uint8_t *selection, size_t size);
+
+  FilterKernel(ColumnID column, uint64_t literal, bool nulls_only,
+               Function function)
+      : column_(column),
+        literal_(literal),
+        nulls_only_(nulls_only),
+        function_(function) {}
+
+  ColumnID column_;
+  // The bits of the literal.
+  uint64_t literal_;
+  // IS (NOT) NULL does not need the values of the column.
+  bool nulls_only_;
+  Function function_;
+};
+
+// Adds or subtracts two INT or UINT operands (columns or literals). As per
+// ProjectOperator, nulls are treated as 0, and the output is only null if
+// both operands are null columns.
+class ArithmeticKernel {
+ public:
+  struct Operand {
+    std::optional<ColumnID> column;
+    // The bits of the literal, if not a column.
+    uint64_t literal;
+  };
+
+  ArithmeticKernel(ProjectOperationEnum op, Operand &&left, Operand &&right);
+
+  // Computes the bits of the output of every record, and whether it is null
+  // (non-zero if null).
+  void Run(ColumnBatch *batch, std::vector<uint64_t> *output,
+           std::vector<uint8_t> *nulls) const;
+
+ private:
+  ProjectOperationEnum op_;
+  Operand left_;
+  Operand right_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_OPS_KERNELS_H_
@@ -1,6 +1,9 @@
 #ifndef K9DB_DATAFLOW_OPS_MATVIEW_H_
 #define K9DB_DATAFLOW_OPS_MATVIEW_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 // NOLINTNEXTLINE
 #include <mutex>
@@ -10,6 +13,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/node_hash_map.h"
 #include "glog/logging.h"
 #include "gtest/gtest_prod.h"
 #include "k9db/dataflow/key.h"
@@ -42,6 +46,8 @@ class MatViewOperator : public Operator {
   virtual bool Contains(const Key &key) const = 0;
 
   // Record API.
+  // Returned records are read-only views of the stored records, they remain
+  // valid after the view is updated (see Record::Share()).
   virtual size_t count() const = 0;
   virtual std::vector<Record> All(int limit = -1) const = 0;
   virtual std::vector<Record> Lookup(const Key &key, int limit = -1,
@@ -50,6 +56,21 @@ class MatViewOperator : public Operator {
   int limit() const { return this->limit_; }
   size_t offset() const { return this->offset_; }
 
+  // Partial state API.
+  // A partial view only stores the records of keys that were filled (on
+  // demand), and keeps the size of these records under the given budget (in
+  // bytes) by evicting cold keys. Updates to keys that are not filled are
+  // dropped. Must be set before any records are processed.
+  void Partial(uint64_t budget) {
+    CHECK_EQ(this->count(), 0u) << "Making a non empty matview partial";
+    this->budget_ = budget;
+  }
+  bool partial() const { return this->budget_ > 0; }
+  // Whether the records of this key are stored (always true if not partial).
+  virtual bool Filled(const Key &key) const = 0;
+  // Store the given records as all the records of the key.
+  virtual void Fill(const Key &key, std::vector<Record> &&records) = 0;
+
   void outkey(const PartitionKey &outkey) { this->outkey_ = outkey; }
   PartitionKey &outkey() { return this->outkey_; }
 
@@ -61,13 +82,16 @@ class MatViewOperator : public Operator {
       : Operator(Operator::Type::MAT_VIEW),
         key_cols_(key_cols),
         limit_(limit),
-        offset_(offset) {}
+        offset_(offset),
+        budget_(0) {}
 
   // Data members.
   std::vector<ColumnID> key_cols_;
   int limit_;
   size_t offset_;
   PartitionKey outkey_;
+  // 0 if not partial.
+  uint64_t budget_;
 
   // Allow tests to set input_schemas_ directly.
   FRIEND_TEST(MatViewOperatorTest, EmptyMatView);
@@ -81,6 +105,10 @@ class MatViewOperator : public Operator {
   FRIEND_TEST(MatViewOperatorTest, LookupGreater);
   FRIEND_TEST(MatViewOperatorTest, AllOnRecordOrdered);
   FRIEND_TEST(MatViewOperatorTest, NightmareScenarioNegativePositiveOutOfOrder);
+  FRIEND_TEST(MatViewOperatorTest, SharedReads);
+  FRIEND_TEST(MatViewOperatorTest, PartialDropsUnfilled);
+  FRIEND_TEST(MatViewOperatorTest, PartialEvictsCold);
+  FRIEND_TEST(MatViewOperatorTest, CheckpointRestore);
 };
 
 // Actual implementation is generic over T: the underlying GroupedDataT
@@ -94,6 +122,10 @@ class MatViewOperator : public Operator {
 // PrimaryKey.
 // For a detailed description of usage and the various cases, check out the
 // extended comment inside ./grouped_data.h
+//
+// When partial, filled keys are evicted using CLOCK: keys are kept in a ring
+// with a reference bit that lookups set, and eviction sweeps the ring clearing
+// bits until it finds a key whose bit is unset.
 template <typename T>
 class MatViewOperatorT : public MatViewOperator {
  public:
@@ -106,14 +138,24 @@ class MatViewOperatorT : public MatViewOperator {
             typename std::enable_if<T::NoCompare::value, X>::type * = nullptr>
   explicit MatViewOperatorT(const std::vector<ColumnID> &key_cols,
                             int limit = -1, size_t offset = 0)
-      : MatViewOperator(key_cols, limit, offset), contents_() {}
+      : MatViewOperator(key_cols, limit, offset),
+        contents_(),
+        filled_(),
+        clock_(),
+        hand_(0),
+        filled_size_(0) {}
 
   template <typename X = void,
             typename std::enable_if<!T::NoCompare::value, X>::type * = nullptr>
   MatViewOperatorT(const std::vector<ColumnID> &key_cols,
                    const Record::Compare &compare, int limit = -1,
                    size_t offset = 0)
-      : MatViewOperator(key_cols, limit, offset), contents_(compare) {
+      : MatViewOperator(key_cols, limit, offset),
+        contents_(compare),
+        filled_(),
+        clock_(),
+        hand_(0),
+        filled_size_(0) {
     // Record ordered.
     // If a limit is provided (but no offset), we can store only the top
     // 3*limit records, to reduce memory overhead.
@@ -171,9 +213,38 @@ class MatViewOperatorT : public MatViewOperator {
   std::vector<Record> Lookup(const Key &key, int limit = -1,
                              size_t offset = 0) const override {
     std::shared_lock<std::shared_mutex> lock(this->mtx_);
+    this->Touch(key);
     return this->contents_.Lookup(key, limit, offset);
   }
 
+  // Partial state API.
+  bool Filled(const Key &key) const override {
+    std::shared_lock<std::shared_mutex> lock(this->mtx_);
+    return this->budget_ == 0 || this->filled_.contains(key);
+  }
+  void Fill(const Key &key, std::vector<Record> &&records) override {
+    std::unique_lock<std::shared_mutex> lock(this->mtx_);
+    CHECK(this->partial()) << "Filling a matview that is not partial";
+    if (this->filled_.contains(key)) {
+      return;  // Filled concurrently.
+    }
+    uint64_t size = 0;
+    for (const Record &record : records) {
+      size += record.SizeInMemory();
+    }
+    // Make room before filling, so that key is not evicted before it is read.
+    this->Evict(this->budget_ - std::min(this->budget_, size));
+    for (Record &record : records) {
+      if (!this->contents_.Insert(key, std::move(record))) {
+        LOG(FATAL) << "Failed to insert record in matview";
+      }
+    }
+    // Unreferenced until the key is read.
+    this->filled_[key].size = size;
+    this->clock_.push_back(key);
+    this->filled_size_ += size;
+  }
+
   // Ordering instantiation specific API.
   template <typename X = void,
             typename std::enable_if<!T::NoCompare::value, X>::type * = nullptr>
@@ -192,6 +263,7 @@ class MatViewOperatorT : public MatViewOperator {
   std::vector<Record> LookupGreater(const Key &key, const Record &cmp,
                                     int limit = -1, size_t offset = 0) const {
     std::shared_lock<std::shared_mutex> lock(this->mtx_);
+    this->Touch(key);
     return this->contents_.LookupGreater(key, cmp, limit, offset);
   }
   template <typename X = void,
@@ -222,6 +294,9 @@ class MatViewOperatorT : public MatViewOperator {
     result += "  \"order\": \"" + order_str + "\",\n";
     result += "  \"LIMIT\": " + std::to_string(this->limit_) + ",\n";
     result += "  \"OFFSET\": " + std::to_string(this->offset_) + ",\n";
+    if (this->partial()) {
+      result += "  \"PARTIAL\": " + std::to_string(this->budget_) + ",\n";
+    }
     return result;
   }
   Record DebugRecord() const override {
@@ -250,6 +325,23 @@ class MatViewOperatorT : public MatViewOperator {
     return this->contents_.SizeInMemory();
   }
 
+  // Checkpointing: the contents of the view (partial views are never
+  // checkpointed).
+  std::vector<SchemaRef> CheckpointSchemas() const override {
+    return {this->output_schema_};
+  }
+  std::vector<std::vector<Record>> Checkpoint() const override {
+    std::vector<std::vector<Record>> batches;
+    batches.push_back(this->All());
+    return batches;
+  }
+  void Restore(std::vector<std::vector<Record>> &&batches) override {
+    CHECK_EQ(batches.size(), 1u) << "Bad matview checkpoint";
+    CHECK_EQ(this->budget_, 0u) << "Restoring a partial matview";
+    this->Process(UNDEFINED_NODE_INDEX, std::move(batches.front()),
+                  Promise::None);
+  }
+
  protected:
   // Override Operator functions.
   std::vector<Record> Process(NodeIndex source, std::vector<Record> &&records,
@@ -257,16 +349,36 @@ class MatViewOperatorT : public MatViewOperator {
     std::unique_lock<std::shared_mutex> lock(this->mtx_);
     for (Record &r : records) {
       Key key = r.GetValues(this->key_cols_);
+      if (this->budget_ > 0) {
+        // Drop updates to keys that are not filled, they are recomputed from
+        // scratch when filled.
+        auto it = this->filled_.find(key);
+        if (it == this->filled_.end()) {
+          continue;
+        }
+        uint64_t size = r.SizeInMemory();
+        if (r.IsPositive()) {
+          it->second.size += size;
+          this->filled_size_ += size;
+        } else {
+          size = std::min(size, it->second.size);
+          it->second.size -= size;
+          this->filled_size_ -= size;
+        }
+      }
       if (r.IsPositive()) {
-        if (!this->contents_.Insert(key, r.Copy())) {
+        if (!this->contents_.Insert(key, r.Compact())) {
           LOG(FATAL) << "Failed to insert record in matview";
         }
       } else {
-        if (!this->contents_.Delete(key, r.Copy())) {
+        if (!this->contents_.Delete(key, r.Share())) {
           LOG(FATAL) << "Failed to delete record in matview";
         }
       }
     }
+    if (this->budget_ > 0) {
+      this->Evict(this->budget_);
+    }
     return std::move(records);
   }
   void ComputeOutputSchema() override {
@@ -285,7 +397,48 @@ class MatViewOperatorT : public MatViewOperator {
   }
 
  private:
+  struct FilledKey {
+    // Total size of the records of the key.
+    uint64_t size = 0;
+    // CLOCK reference bit, set by (concurrent) lookups.
+    mutable std::atomic<bool> referenced{false};
+  };
+
+  // Mark key as recently used, must hold the lock (shared).
+  void Touch(const Key &key) const {
+    if (this->budget_ > 0) {
+      auto it = this->filled_.find(key);
+      if (it != this->filled_.end()) {
+        it->second.referenced.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+  // Evict keys until the size of filled keys is <= target, must hold the lock
+  // (unique).
+  void Evict(uint64_t target) {
+    while (this->filled_size_ > target && !this->clock_.empty()) {
+      if (this->hand_ >= this->clock_.size()) {
+        this->hand_ = 0;
+      }
+      auto it = this->filled_.find(this->clock_.at(this->hand_));
+      if (it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+        this->hand_++;
+        continue;
+      }
+      this->filled_size_ -= it->second.size;
+      this->contents_.Erase(it->first);
+      this->filled_.erase(it);
+      this->clock_.at(this->hand_) = std::move(this->clock_.back());
+      this->clock_.pop_back();
+    }
+  }
+
   T contents_;
+  // Partial state: filled keys, and the CLOCK ring over them.
+  absl::node_hash_map<Key, FilledKey> filled_;
+  std::vector<Key> clock_;
+  size_t hand_;
+  uint64_t filled_size_;
   mutable std::shared_mutex mtx_;
 };
 
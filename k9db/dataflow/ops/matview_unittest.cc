@@ -486,7 +486,7 @@ TEST(MatViewOperatorTest, LookupGreater) {
 
   // Process and check.
   matview.ProcessAndForward(UNDEFINED_NODE_INDEX, CopyVec(records),
-                            Promise::None.Derive());
+                             Promise::None.Derive());
 
   EXPECT_EQ(matview.count(), records.size());
   EXPECT_EQ_MSET(matview.All(), records);
@@ -545,7 +545,7 @@ TEST(MatViewOperatorTest, AllOnRecordOrdered) {
 
   // Process and check.
   matview.ProcessAndForward(UNDEFINED_NODE_INDEX, CopyVec(records),
-                            Promise::None.Derive());
+                             Promise::None.Derive());
   EXPECT_EQ(matview.count(), records.size());
   EXPECT_EQ_MSET(matview.All(), records);
   EXPECT_EQ_ORDER(matview.All(), sorted);
@@ -642,5 +642,235 @@ TEST(MatViewOperatorTest, NightmareScenarioNegativePositiveOutOfOrder) {
   }
 }
 
+// Reads share the storage of the records in the view.
+TEST(MatViewOperatorTest, SharedReads) {
+  // Create a schema.
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  Record::Compare compare{{2}};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  // Create some records.
+  std::vector<Record> records;
+  records.emplace_back(schema, true, 1_u,
+                       std::make_unique<std::string>("hello!"), -5_s);
+  records.emplace_back(schema, true, 1_u,
+                       std::make_unique<std::string>("bye!"), 7_s);
+
+  // Create materialized views.
+  std::vector<std::unique_ptr<MatViewOperator>> views;
+  views.emplace_back(new UnorderedMatViewOperator(keys));
+  views.emplace_back(new KeyOrderedMatViewOperator(keys));
+  views.emplace_back(new RecordOrderedMatViewOperator(keys, compare));
+
+  // Test all views.
+  for (std::unique_ptr<MatViewOperator> &matview : views) {
+    matview->input_schemas_.push_back(schema);
+    matview->ComputeOutputSchema();
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, CopyVec(records),
+                               Promise::None.Derive());
+
+    // Reading twice gives records backed by the same data.
+    Key key = records.at(0).GetKey();
+    std::vector<Record> read1 = matview->Lookup(key);
+    std::vector<Record> read2 = matview->All();
+    ASSERT_EQ(read1.size(), 2);
+    ASSERT_EQ(read2.size(), 2);
+    EXPECT_EQ_MSET(CopyVec(read1), records);
+    EXPECT_EQ_MSET(CopyVec(read2), records);
+    for (const Record &r : read1) {
+      auto it = std::find(read2.begin(), read2.end(), r);
+      ASSERT_NE(it, read2.end());
+      EXPECT_EQ(&r.GetString(1), &it->GetString(1));
+    }
+
+    // Read records remain valid after they are deleted from the view.
+    std::vector<Record> deletes;
+    deletes.push_back(records.at(0).Copy());
+    deletes.push_back(records.at(1).Copy());
+    deletes.at(0).SetPositive(false);
+    deletes.at(1).SetPositive(false);
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(deletes),
+                               Promise::None.Derive());
+    EXPECT_EQ(matview->count(), 0);
+    EXPECT_EQ_MSET(std::move(read1), records);
+  }
+}
+
+// Partial views only store (and update) filled keys.
+TEST(MatViewOperatorTest, PartialDropsUnfilled) {
+  // Create a schema.
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  Record::Compare compare{{2}};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  // Create some records.
+  std::vector<Record> records;
+  records.emplace_back(schema, true, 1_u, std::make_unique<std::string>("a"),
+                       1_s);
+  records.emplace_back(schema, true, 2_u, std::make_unique<std::string>("b"),
+                       2_s);
+  records.emplace_back(schema, true, 1_u, std::make_unique<std::string>("c"),
+                       3_s);
+  Key key1 = records.at(0).GetValues(keys);
+  Key key2 = records.at(1).GetValues(keys);
+
+  // Create materialized views.
+  std::vector<std::unique_ptr<MatViewOperator>> views;
+  views.emplace_back(new UnorderedMatViewOperator(keys));
+  views.emplace_back(new KeyOrderedMatViewOperator(keys));
+  views.emplace_back(new RecordOrderedMatViewOperator(keys, compare));
+
+  // Test all views.
+  for (std::unique_ptr<MatViewOperator> &matview : views) {
+    matview->input_schemas_.push_back(schema);
+    matview->ComputeOutputSchema();
+    matview->Partial(1 << 20);
+    EXPECT_TRUE(matview->partial());
+    EXPECT_FALSE(matview->Filled(key1));
+
+    // Nothing is filled, updates are dropped.
+    std::vector<Record> batch;
+    batch.push_back(records.at(0).Copy());
+    batch.push_back(records.at(1).Copy());
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(batch),
+                               Promise::None.Derive());
+    EXPECT_EQ(matview->count(), 0);
+
+    // Fill key1, it now receives updates, but key2 does not.
+    std::vector<Record> fill;
+    fill.push_back(records.at(0).Copy());
+    matview->Fill(key1, std::move(fill));
+    EXPECT_TRUE(matview->Filled(key1));
+    EXPECT_FALSE(matview->Filled(key2));
+    batch.clear();
+    batch.push_back(records.at(1).Copy());
+    batch.push_back(records.at(2).Copy());
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(batch),
+                               Promise::None.Derive());
+    EXPECT_EQ(matview->count(), 2);
+    std::vector<Record> expected;
+    expected.push_back(records.at(0).Copy());
+    expected.push_back(records.at(2).Copy());
+    EXPECT_EQ_MSET(matview->Lookup(key1), expected);
+    EXPECT_EQ(matview->Lookup(key2).size(), 0);
+
+    // Deletes apply to filled keys.
+    batch.clear();
+    batch.push_back(records.at(0).Copy());
+    batch.back().SetPositive(false);
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(batch),
+                               Promise::None.Derive());
+    EXPECT_EQ(matview->count(), 1);
+    EXPECT_TRUE(matview->Filled(key1));
+  }
+}
+
+// Cold keys are evicted to stay within the budget.
+TEST(MatViewOperatorTest, PartialEvictsCold) {
+  // Create a schema.
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  // Create some records of equal size.
+  std::vector<Record> records;
+  for (uint64_t i = 0; i < 4; i++) {
+    records.emplace_back(schema, true, i % 3,
+                         std::make_unique<std::string>("a"),
+                         static_cast<int64_t>(i));
+  }
+  uint64_t size = records.at(0).SizeInMemory();
+  Key key0 = records.at(0).GetValues(keys);
+  Key key1 = records.at(1).GetValues(keys);
+  Key key2 = records.at(2).GetValues(keys);
+
+  // Room for two records.
+  std::unique_ptr<MatViewOperator> matview =
+      std::make_unique<UnorderedMatViewOperator>(keys);
+  matview->input_schemas_.push_back(schema);
+  matview->ComputeOutputSchema();
+  matview->Partial(2 * size);
+
+  std::vector<Record> fill;
+  fill.push_back(records.at(0).Copy());
+  matview->Fill(key0, std::move(fill));
+  fill.clear();
+  fill.push_back(records.at(1).Copy());
+  matview->Fill(key1, std::move(fill));
+  EXPECT_EQ(matview->count(), 2);
+
+  // Reading key0 keeps it, key1 is evicted to make room for key2.
+  EXPECT_EQ(matview->Lookup(key0).size(), 1);
+  fill.clear();
+  fill.push_back(records.at(2).Copy());
+  matview->Fill(key2, std::move(fill));
+  EXPECT_TRUE(matview->Filled(key0));
+  EXPECT_FALSE(matview->Filled(key1));
+  EXPECT_TRUE(matview->Filled(key2));
+  EXPECT_EQ(matview->count(), 2);
+
+  // Growing key0 evicts key2, which was not read since it was filled.
+  std::vector<Record> batch;
+  batch.push_back(records.at(3).Copy());
+  matview->ProcessAndForward(UNDEFINED_NODE_INDEX, std::move(batch),
+                             Promise::None.Derive());
+  EXPECT_TRUE(matview->Filled(key0));
+  EXPECT_FALSE(matview->Filled(key2));
+  EXPECT_EQ(matview->count(), 2);
+  EXPECT_EQ(matview->Lookup(key0).size(), 2);
+}
+
+// Restoring a checkpoint gives back the same contents.
+TEST(MatViewOperatorTest, CheckpointRestore) {
+  // Create a schema.
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  Record::Compare compare{{2}};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  // Create some records.
+  std::vector<Record> records;
+  records.emplace_back(schema, true, 1_u, "hello!"_uptr, -5_s);
+  records.emplace_back(schema, true, 1_u, "bye!"_uptr, 7_s);
+  records.emplace_back(schema, true, 2_u, "world!"_uptr, 0_s);
+
+  // Create pairs of materialized views.
+  std::vector<std::unique_ptr<MatViewOperator>> views;
+  std::vector<std::unique_ptr<MatViewOperator>> restored;
+  views.emplace_back(new UnorderedMatViewOperator(keys));
+  views.emplace_back(new KeyOrderedMatViewOperator(keys));
+  views.emplace_back(new RecordOrderedMatViewOperator(keys, compare));
+  restored.emplace_back(new UnorderedMatViewOperator(keys));
+  restored.emplace_back(new KeyOrderedMatViewOperator(keys));
+  restored.emplace_back(new RecordOrderedMatViewOperator(keys, compare));
+
+  // Test all views.
+  for (size_t i = 0; i < views.size(); i++) {
+    MatViewOperator *matview = views.at(i).get();
+    MatViewOperator *copy = restored.at(i).get();
+    matview->input_schemas_.push_back(schema);
+    matview->ComputeOutputSchema();
+    copy->input_schemas_.push_back(schema);
+    copy->ComputeOutputSchema();
+    matview->ProcessAndForward(UNDEFINED_NODE_INDEX, CopyVec(records),
+                               Promise::None.Derive());
+
+    std::vector<SchemaRef> schemas = matview->CheckpointSchemas();
+    ASSERT_EQ(schemas.size(), 1);
+    EXPECT_EQ(schemas.at(0), schema);
+    copy->Restore(matview->Checkpoint());
+    EXPECT_EQ(copy->count(), 3);
+    EXPECT_EQ_MSET(copy->All(), records);
+    Key key = records.at(0).GetKey();
+    EXPECT_EQ_MSET(copy->Lookup(key), matview->Lookup(key));
+  }
+}
+
 }  // namespace dataflow
 }  // namespace k9db
@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "glog/logging.h"
+#include "k9db/dataflow/record_batch.h"
 #include "k9db/dataflow/schema.h"
 
 #define ARITHMETIC_WITH_RIGHT_LITERAL_MACRO(OP)                     \
@@ -97,6 +98,9 @@
 // In above macro an edge case is being handled for (uint MINUS uint) -> int
 // ARITHMETIC_WITH_COLUMN_MACRO
 
+// Batches with fewer records are projected one record at a time.
+#define KERNEL_MIN_RECORDS 16
+
 namespace k9db {
 namespace dataflow {
 
@@ -192,6 +196,34 @@ void ProjectOperator::ComputeOutputSchema() {
 
   this->output_schema_ =
       SchemaFactory::Create(out_column_names, out_column_types, out_keys);
+
+  // Compile the arithmetic projections into kernels.
+  this->kernels_.clear();
+  for (const auto &projection : this->projections_) {
+    if (projection.column() || projection.literal()) {
+      this->kernels_.emplace_back();
+      continue;
+    }
+    auto operand = [](const sqlast::Value &v) -> ArithmeticKernel::Operand {
+      if (v.type() == sqlast::Value::Type::INT) {
+        return {{}, static_cast<uint64_t>(v.GetInt())};
+      }
+      return {{}, v.GetUInt()};
+    };
+    ArithmeticKernel::Operand left, right;
+    if (projection.left_column()) {
+      left = {projection.getLeftColumn(), 0};
+    } else {
+      left = operand(projection.getLeftLiteral());
+    }
+    if (projection.right_column()) {
+      right = {projection.getRightColumn(), 0};
+    } else {
+      right = operand(projection.getRightLiteral());
+    }
+    this->kernels_.emplace_back(std::in_place, projection.getOperation(),
+                                std::move(left), std::move(right));
+  }
 }
 
 // TODO(babman): In order to preserve the projected names, we may create a
@@ -202,120 +234,148 @@ void ProjectOperator::ComputeOutputSchema() {
 std::vector<Record> ProjectOperator::Process(NodeIndex source,
                                              std::vector<Record> &&records,
                                              const Promise &promise) {
-  std::vector<Record> output;
-  for (const Record &record : records) {
-    output.emplace_back(this->output_schema_, record.IsPositive());
-    Record &out_record = output.back();
-    for (size_t i = 0; i < this->projections_.size(); i++) {
-      const auto &projection = this->projections_.at(i);
+  // Arithmetic projections over large batches are computed by their kernels.
+  size_t size = this->projections_.size();
+  std::vector<std::vector<uint64_t>> values(size);
+  std::vector<std::vector<uint8_t>> nulls(size);
+  bool vectorized = records.size() >= KERNEL_MIN_RECORDS;
+  if (vectorized) {
+    ColumnBatch batch(records);
+    for (size_t i = 0; i < size; i++) {
+      if (this->kernels_.at(i).has_value()) {
+        this->kernels_.at(i)->Run(&batch, &values.at(i), &nulls.at(i));
+      }
+    }
+  }
+
+  // Output records are allocated together in one batch.
+  RecordBatch output(this->output_schema_, records.size());
+  for (size_t r = 0; r < records.size(); r++) {
+    const Record &record = records.at(r);
+    Record &out_record = output.Add(record.IsPositive());
+    for (size_t i = 0; i < size; i++) {
+      if (!vectorized || !this->kernels_.at(i).has_value()) {
+        this->ProjectValue(record, i, &out_record);
+      } else if (nulls.at(i).at(r) != 0) {
+        out_record.SetNull(true, i);
+      } else if (this->output_schema_.TypeOf(i) ==
+                 sqlast::ColumnDefinition::Type::UINT) {
+        out_record.SetUInt(values.at(i).at(r), i);
+      } else {
+        out_record.SetInt(static_cast<int64_t>(values.at(i).at(r)), i);
+      }
+    }
+  }
+
+  return output.Release();
+}
+
+void ProjectOperator::ProjectValue(const Record &record, size_t i,
+                                   Record *out) const {
+  Record &out_record = *out;
+  const auto &projection = this->projections_.at(i);
 
-      if (projection.column()) {
-        // Project an existing column.
-        ColumnID column = projection.getLeftColumn();
-        if (record.IsNull(column)) {
-          out_record.SetNull(true, i);
-          continue;
+  if (projection.column()) {
+    // Project an existing column.
+    ColumnID column = projection.getLeftColumn();
+    if (record.IsNull(column)) {
+      out_record.SetNull(true, i);
+      return;
+    }
+    switch (this->output_schema_.TypeOf(i)) {
+      case sqlast::ColumnDefinition::Type::UINT:
+        out_record.SetUInt(record.GetUInt(column), i);
+        break;
+      case sqlast::ColumnDefinition::Type::INT:
+        out_record.SetInt(record.GetInt(column), i);
+        break;
+      case sqlast::ColumnDefinition::Type::TEXT: {
+        out_record.SetString(record.GetString(column), i);
+        break;
+      }
+      // TODO(malte): DATETIME should not be stored as a string,
+      // see below
+      case sqlast::ColumnDefinition::Type::DATETIME:
+        out_record.SetDateTime(record.GetDateTime(column), i);
+        break;
+      default:
+        LOG(FATAL) << "Unsupported column type "
+                   << this->output_schema_.TypeOf(i) << " in project";
+    }
+
+  } else if (projection.literal()) {
+    // Project a literal.
+    const sqlast::Value &literal = projection.getLeftLiteral();
+    switch (this->output_schema_.TypeOf(i)) {
+      case sqlast::ColumnDefinition::Type::UINT:
+        out_record.SetUInt(literal.GetUInt(), i);
+        break;
+      case sqlast::ColumnDefinition::Type::INT:
+        out_record.SetInt(literal.GetInt(), i);
+        break;
+      case sqlast::ColumnDefinition::Type::TEXT:
+        out_record.SetString(literal.GetString(), i);
+        break;
+      default:
+        LOG(FATAL) << "Unsupported literal type in project";
+    }
+
+  } else {
+    if (projection.left_column() && projection.right_column()) {
+      ColumnID left = projection.getLeftColumn();
+      ColumnID right = projection.getRightColumn();
+      switch (projection.getOperation()) {
+        case Operation::MINUS: {
+          ARITHMETIC_WITH_COLUMN_MACRO(-)
+          break;
         }
-        switch (this->output_schema_.TypeOf(i)) {
-          case sqlast::ColumnDefinition::Type::UINT:
-            out_record.SetUInt(record.GetUInt(column), i);
-            break;
-          case sqlast::ColumnDefinition::Type::INT:
-            out_record.SetInt(record.GetInt(column), i);
-            break;
-          case sqlast::ColumnDefinition::Type::TEXT: {
-            out_record.SetString(
-                std::make_unique<std::string>(record.GetString(column)), i);
-            break;
-          }
-          // TODO(malte): DATETIME should not be stored as a string,
-          // see below
-          case sqlast::ColumnDefinition::Type::DATETIME:
-            out_record.SetDateTime(
-                std::make_unique<std::string>(record.GetDateTime(column)), i);
-            break;
-          default:
-            LOG(FATAL) << "Unsupported column type "
-                       << this->output_schema_.TypeOf(i) << " in project";
+        case Operation::PLUS: {
+          ARITHMETIC_WITH_COLUMN_MACRO(+)
+          break;
         }
+        default:
+          LOG(FATAL) << "Unsupported arithmetic operation in project";
+      }
 
-      } else if (projection.literal()) {
-        // Project a literal.
-        const sqlast::Value &literal = projection.getLeftLiteral();
-        switch (this->output_schema_.TypeOf(i)) {
-          case sqlast::ColumnDefinition::Type::UINT:
-            out_record.SetUInt(literal.GetUInt(), i);
-            break;
-          case sqlast::ColumnDefinition::Type::INT:
-            out_record.SetInt(literal.GetInt(), i);
-            break;
-          case sqlast::ColumnDefinition::Type::TEXT:
-            out_record.SetString(
-                std::make_unique<std::string>(literal.GetString()), i);
-            break;
-          default:
-            LOG(FATAL) << "Unsupported literal type in project";
+    } else if (projection.left_column()) {
+      ColumnID left = projection.getLeftColumn();
+      const sqlast::Value &right = projection.getRightLiteral();
+      switch (projection.getOperation()) {
+        case Operation::MINUS: {
+          ARITHMETIC_WITH_RIGHT_LITERAL_MACRO(-)
+          break;
         }
+        case Operation::PLUS: {
+          ARITHMETIC_WITH_RIGHT_LITERAL_MACRO(+)
+          break;
+        }
+        default:
+          LOG(FATAL) << "Unsupported arithmetic operation in project";
+      }
 
-      } else {
-        if (projection.left_column() && projection.right_column()) {
-          ColumnID left = projection.getLeftColumn();
-          ColumnID right = projection.getRightColumn();
-          switch (projection.getOperation()) {
-            case Operation::MINUS: {
-              ARITHMETIC_WITH_COLUMN_MACRO(-)
-              break;
-            }
-            case Operation::PLUS: {
-              ARITHMETIC_WITH_COLUMN_MACRO(+)
-              break;
-            }
-            default:
-              LOG(FATAL) << "Unsupported arithmetic operation in project";
-          }
-
-        } else if (projection.left_column()) {
-          ColumnID left = projection.getLeftColumn();
-          const sqlast::Value &right = projection.getRightLiteral();
-          switch (projection.getOperation()) {
-            case Operation::MINUS: {
-              ARITHMETIC_WITH_RIGHT_LITERAL_MACRO(-)
-              break;
-            }
-            case Operation::PLUS: {
-              ARITHMETIC_WITH_RIGHT_LITERAL_MACRO(+)
-              break;
-            }
-            default:
-              LOG(FATAL) << "Unsupported arithmetic operation in project";
-          }
-
-        } else {
-          const sqlast::Value &left = projection.getLeftLiteral();
-          ColumnID right = projection.getRightColumn();
-          switch (projection.getOperation()) {
-            case Operation::MINUS: {
-              ARITHMETIC_WITH_LEFT_LITERAL_MACRO(-)
-              break;
-            }
-            case Operation::PLUS: {
-              ARITHMETIC_WITH_LEFT_LITERAL_MACRO(+)
-              break;
-            }
-            default:
-              LOG(FATAL) << "Unsupported arithmetic operation in project";
-          }
+    } else {
+      const sqlast::Value &left = projection.getLeftLiteral();
+      ColumnID right = projection.getRightColumn();
+      switch (projection.getOperation()) {
+        case Operation::MINUS: {
+          ARITHMETIC_WITH_LEFT_LITERAL_MACRO(-)
+          break;
         }
+        case Operation::PLUS: {
+          ARITHMETIC_WITH_LEFT_LITERAL_MACRO(+)
+          break;
+        }
+        default:
+          LOG(FATAL) << "Unsupported arithmetic operation in project";
       }
     }
   }
-
-  return output;
 }
 
 std::unique_ptr<Operator> ProjectOperator::Clone() const {
   auto clone = std::make_unique<ProjectOperator>();
   clone->projections_ = this->projections_;
+  clone->kernels_ = this->kernels_;
   return clone;
 }
 
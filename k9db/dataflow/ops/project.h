@@ -12,6 +12,7 @@
 
 #include "gtest/gtest_prod.h"
 #include "k9db/dataflow/operator.h"
+#include "k9db/dataflow/ops/kernels.h"
 #include "k9db/dataflow/ops/project_enum.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/types.h"
@@ -170,7 +171,13 @@ class ProjectOperator : public Operator {
     Operation op_;
   };
 
+  // Project the value of one projection of a record.
+  void ProjectValue(const Record &record, size_t i, Record *out) const;
+
   std::vector<ProjectionOperation> projections_;
+  // The kernel of every arithmetic projection (compiled with the output
+  // schema), nothing for other projections.
+  std::vector<std::optional<ArithmeticKernel>> kernels_;
 
   // Allow tests to use .Process(...) directly.
   FRIEND_TEST(ProjectOperatorTest, BatchTestColumn);
@@ -181,6 +188,7 @@ class ProjectOperator : public Operator {
   FRIEND_TEST(ProjectOperatorTest, OutputSchemaCompositeKeyTest);
   FRIEND_TEST(ProjectOperatorTest, NullValueTest);
   FRIEND_TEST(ProjectOperatorTest, ArithmeticAndNullValueTest);
+  FRIEND_TEST(ProjectOperatorTest, VectorizedBatch);
 };
 
 }  // namespace dataflow
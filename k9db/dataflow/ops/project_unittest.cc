@@ -325,5 +325,71 @@ TEST(ProjectOperatorTest, ArithmeticAndNullValueTest) {
   EXPECT_EQ(outputs, expected_records);
 }
 
+// Arithmetic projections over large batches are computed by kernels, the
+// output must match projecting one record at a time.
+TEST(ProjectOperatorTest, VectorizedBatch) {
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::INT, CType::UINT};
+  std::vector<ColumnID> keys = {0};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  ProjectOperator project = ProjectOperator();
+  project.AddColumnProjection(schema.NameOf(0), 0);
+  project.AddArithmeticProjectionColumns(
+      "Sum", ProjectOperator::Operation::PLUS, 0, 2);
+  project.AddArithmeticProjectionColumns(
+      "Delta", ProjectOperator::Operation::MINUS, 1, 2);
+  project.AddArithmeticProjectionLiteralRight(
+      "Minus", ProjectOperator::Operation::MINUS, 1, 10_s);
+  project.AddArithmeticProjectionLiteralLeft(
+      "Plus", ProjectOperator::Operation::PLUS, 3_u, 2);
+  project.input_schemas_.push_back(schema);
+  project.ComputeOutputSchema();
+  EXPECT_EQ(project.output_schema_.TypeOf(1), CType::UINT);
+  EXPECT_FALSE(project.kernels_.at(0).has_value());
+  for (size_t i = 1; i < 5; i++) {
+    EXPECT_TRUE(project.kernels_.at(i).has_value());
+  }
+
+  // Records to be fed, with nulls sprinkled in.
+  std::vector<Record> records;
+  for (size_t i = 0; i < 64; i++) {
+    Record &record = records.emplace_back(schema, true);
+    record.SetUInt(i, 0);
+    if (i % 3 == 0) {
+      record.SetNull(true, 1);
+    } else {
+      record.SetInt(static_cast<int64_t>(i) * -7, 1);
+    }
+    if (i % 4 == 0) {
+      record.SetNull(true, 2);
+    } else {
+      record.SetUInt(i * 2, 2);
+    }
+  }
+
+  // Project one record at a time.
+  std::vector<Record> expected;
+  for (const Record &record : records) {
+    std::vector<Record> single;
+    single.push_back(record.Copy());
+    for (Record &output : project.Process(UNDEFINED_NODE_INDEX,
+                                          std::move(single), Promise::None)) {
+      expected.push_back(std::move(output));
+    }
+  }
+  EXPECT_TRUE(expected.at(0).IsNull(2));
+  EXPECT_EQ(expected.at(1).GetInt(3), -17);
+
+  // Project the whole batch.
+  std::vector<Record> copy;
+  for (const Record &record : records) {
+    copy.push_back(record.Copy());
+  }
+  EXPECT_EQ(project.Process(UNDEFINED_NODE_INDEX, std::move(copy),
+                            Promise::None),
+            expected);
+}
+
 }  // namespace dataflow
 }  // namespace k9db
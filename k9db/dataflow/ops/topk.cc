@@ -0,0 +1,198 @@
+#include "k9db/dataflow/ops/topk.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace k9db {
+namespace dataflow {
+
+void TopKOperator::ComputeOutputSchema() {
+  this->output_schema_ = this->input_schemas_.at(0);
+}
+
+// Maintaining groups.
+void TopKOperator::Insert(Group *group, Record &&record) {
+  // Records that belong after the last buffered one go to overflow, unless
+  // overflow is empty (and then the buffer holds all records of the group).
+  if (!group->overflow.empty() &&
+      !this->compare_(record, *group->buffer.rbegin())) {
+    group->overflow.push_back(std::move(record));
+    return;
+  }
+  group->buffer.insert(std::move(record));
+  if (group->buffer.size() > 2 * this->k_) {
+    auto last = std::prev(group->buffer.end());
+    group->overflow.push_back(std::move(group->buffer.extract(last).value()));
+  }
+}
+
+bool TopKOperator::Delete(Group *group, const Record &record) {
+  bool found = false;
+  auto [begin, end] = group->buffer.equal_range(record);
+  for (auto it = begin; it != end; ++it) {
+    if (*it == record) {
+      group->buffer.erase(it);
+      found = true;
+      break;
+    }
+  }
+  if (!found) {
+    for (size_t i = 0; i < group->overflow.size(); i++) {
+      if (group->overflow.at(i) == record) {
+        if (i != group->overflow.size() - 1) {
+          std::swap(group->overflow.at(i), group->overflow.back());
+        }
+        group->overflow.pop_back();
+        found = true;
+        break;
+      }
+    }
+  }
+  // Underflow: refill from overflow.
+  if (group->buffer.size() < this->k_ && !group->overflow.empty()) {
+    this->Refill(group);
+  }
+  return found;
+}
+
+void TopKOperator::Refill(Group *group) {
+  std::vector<Record> &overflow = group->overflow;
+  size_t count = std::min(2 * this->k_ - group->buffer.size(), overflow.size());
+  if (count < overflow.size()) {
+    std::nth_element(overflow.begin(), overflow.begin() + count,
+                     overflow.end(), this->compare_);
+  }
+  for (size_t i = 0; i < count; i++) {
+    group->buffer.insert(std::move(overflow.at(i)));
+  }
+  overflow.erase(overflow.begin(), overflow.begin() + count);
+}
+
+std::vector<Record> TopKOperator::Top(const Group &group) const {
+  std::vector<Record> result;
+  for (const Record &record : group.buffer) {
+    if (result.size() == this->k_) {
+      break;
+    }
+    result.push_back(record.Share());
+  }
+  return result;
+}
+
+std::vector<Record> TopKOperator::Process(NodeIndex source,
+                                          std::vector<Record> &&records,
+                                          const Promise &promise) {
+  // The first k records of every group touched by records, prior to processing
+  // records. The output is the difference between these and the first k
+  // records after processing.
+  absl::flat_hash_map<Key, std::vector<Record>> old_tops;
+  for (Record &record : records) {
+    Key group_key = record.GetValues(this->group_columns_);
+    auto it = this->groups_.find(group_key);
+    if (old_tops.count(group_key) == 0) {
+      if (it == this->groups_.end()) {
+        old_tops.emplace(group_key, std::vector<Record>());
+      } else {
+        old_tops.emplace(group_key, this->Top(it->second));
+      }
+    }
+    if (record.IsPositive()) {
+      if (it == this->groups_.end()) {
+        it = this->groups_.emplace(group_key, Group(this->compare_)).first;
+      }
+      this->Insert(&it->second, record.Compact());
+    } else {
+      if (it == this->groups_.end() || !this->Delete(&it->second, record)) {
+        LOG(FATAL) << "Negative record not seen before in top k";
+      }
+      if (it->second.buffer.empty()) {
+        this->groups_.erase(it);
+      }
+    }
+  }
+
+  // Emit records only for groups whose first k records changed.
+  std::vector<Record> output;
+  for (auto &[group_key, old_top] : old_tops) {
+    std::vector<Record> new_top;
+    auto it = this->groups_.find(group_key);
+    if (it != this->groups_.end()) {
+      new_top = this->Top(it->second);
+    }
+    // Records in both are unchanged.
+    std::vector<bool> kept(new_top.size(), false);
+    for (Record &record : old_top) {
+      bool found = false;
+      for (size_t i = 0; i < new_top.size(); i++) {
+        if (!kept.at(i) && new_top.at(i) == record) {
+          kept.at(i) = true;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        record.SetPositive(false);
+        output.push_back(std::move(record));
+      }
+    }
+    for (size_t i = 0; i < new_top.size(); i++) {
+      if (!kept.at(i)) {
+        output.push_back(std::move(new_top.at(i)));
+      }
+    }
+  }
+  return output;
+}
+
+uint64_t TopKOperator::SizeInMemory() const {
+  uint64_t size = 0;
+  for (const auto &[_, group] : this->groups_) {
+    for (const Record &record : group.buffer) {
+      size += record.SizeInMemory();
+    }
+    for (const Record &record : group.overflow) {
+      size += record.SizeInMemory();
+    }
+  }
+  return size;
+}
+
+// Checkpointing.
+std::vector<std::vector<Record>> TopKOperator::Checkpoint() const {
+  std::vector<Record> records;
+  for (const auto &[_, group] : this->groups_) {
+    for (const Record &record : group.buffer) {
+      records.push_back(record.Share());
+    }
+    for (const Record &record : group.overflow) {
+      records.push_back(record.Share());
+    }
+  }
+  std::vector<std::vector<Record>> batches;
+  batches.push_back(std::move(records));
+  return batches;
+}
+
+void TopKOperator::Restore(std::vector<std::vector<Record>> &&batches) {
+  CHECK_EQ(batches.size(), 1u) << "Bad top k checkpoint";
+  for (Record &record : batches.front()) {
+    Key group_key = record.GetValues(this->group_columns_);
+    auto it = this->groups_.find(group_key);
+    if (it == this->groups_.end()) {
+      it = this->groups_.emplace(group_key, Group(this->compare_)).first;
+    }
+    this->Insert(&it->second, std::move(record));
+  }
+}
+
+// Clone this operator.
+std::unique_ptr<Operator> TopKOperator::Clone() const {
+  return std::make_unique<TopKOperator>(this->group_columns_,
+                                        this->compare_.cols(), this->k_);
+}
+
+}  // namespace dataflow
+}  // namespace k9db
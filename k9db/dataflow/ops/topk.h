@@ -0,0 +1,105 @@
+#ifndef K9DB_DATAFLOW_OPS_TOPK_H_
+#define K9DB_DATAFLOW_OPS_TOPK_H_
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "glog/logging.h"
+#include "gtest/gtest_prod.h"
+#include "k9db/dataflow/key.h"
+#include "k9db/dataflow/operator.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+// Only lets through the first k records (ordered by sort_columns) of every
+// group, where groups are determined by the values of group_columns.
+// The output schema is the same as the input schema.
+//
+// The operator outputs changes to the first k records of a group, including
+// records that move into the first k when another one is deleted. To that end,
+// the records of a group are split in two:
+// 1. a bounded ordered buffer with the smallest records of the group (up to
+//    2 * k records), from which the first k records are emitted.
+// 2. an unordered overflow with the remaining records, which costs nothing to
+//    insert into.
+// When deletes shrink the buffer under k records, it is lazily refilled with
+// the smallest records from the overflow.
+class TopKOperator : public Operator {
+ public:
+  TopKOperator() = delete;
+  // Cannot copy an operator.
+  TopKOperator(const TopKOperator &other) = delete;
+  TopKOperator &operator=(const TopKOperator &other) = delete;
+
+  TopKOperator(const std::vector<ColumnID> &group_columns,
+               const std::vector<ColumnID> &sort_columns, size_t k)
+      : Operator(Operator::Type::TOP_K),
+        group_columns_(group_columns),
+        compare_(sort_columns),
+        k_(k),
+        groups_() {
+    CHECK_GT(k, 0u) << "TopKOperator with k = 0";
+  }
+
+  const std::vector<ColumnID> &group_columns() const {
+    return this->group_columns_;
+  }
+  const std::vector<ColumnID> &sort_columns() const {
+    return this->compare_.cols();
+  }
+  size_t k() const { return this->k_; }
+
+  uint64_t SizeInMemory() const override;
+
+  // All the records of all groups (both buffered and overflowing).
+  std::vector<SchemaRef> CheckpointSchemas() const override {
+    return {this->output_schema_};
+  }
+  std::vector<std::vector<Record>> Checkpoint() const override;
+  void Restore(std::vector<std::vector<Record>> &&batches) override;
+
+ protected:
+  std::vector<Record> Process(NodeIndex source, std::vector<Record> &&records,
+                              const Promise &promise) override;
+
+  void ComputeOutputSchema() override;
+
+  std::unique_ptr<Operator> Clone() const override;
+
+ private:
+  struct Group {
+    explicit Group(const Record::Compare &compare) : buffer(compare) {}
+    // All records in buffer are <= all records in overflow.
+    std::multiset<Record, Record::Compare> buffer;
+    std::vector<Record> overflow;
+  };
+
+  // Add record to / remove record from a group.
+  void Insert(Group *group, Record &&record);
+  bool Delete(Group *group, const Record &record);
+  // Move the smallest records of overflow to the buffer.
+  void Refill(Group *group);
+  // The first k records of the group (shared).
+  std::vector<Record> Top(const Group &group) const;
+
+  std::vector<ColumnID> group_columns_;
+  Record::Compare compare_;
+  size_t k_;
+  absl::flat_hash_map<Key, Group> groups_;
+
+  FRIEND_TEST(TopKOperatorTest, InsertBeyondK);
+  FRIEND_TEST(TopKOperatorTest, DeletePromotes);
+  FRIEND_TEST(TopKOperatorTest, RefillFromOverflow);
+  FRIEND_TEST(TopKOperatorTest, CheckpointRestore);
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_OPS_TOPK_H_
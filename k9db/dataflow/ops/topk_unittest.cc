@@ -0,0 +1,177 @@
+#include "k9db/dataflow/ops/topk.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+#include "k9db/sqlast/ast.h"
+#include "k9db/util/ints.h"
+
+namespace k9db {
+namespace dataflow {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+namespace {
+
+// (ID, Story, Time): the top k per story by time.
+SchemaRef MakeSchema() {
+  std::vector<std::string> names = {"ID", "Story", "Time"};
+  std::vector<CType> types = {CType::UINT, CType::UINT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  return SchemaFactory::Create(names, types, keys);
+}
+
+std::unique_ptr<TopKOperator> MakeOperator(size_t k) {
+  return std::make_unique<TopKOperator>(std::vector<ColumnID>{1},
+                                        std::vector<ColumnID>{2}, k);
+}
+
+}  // namespace
+
+TEST(TopKOperatorTest, InsertBeyondK) {
+  SchemaRef schema = MakeSchema();
+  std::unique_ptr<TopKOperator> op = MakeOperator(2);
+  op->input_schemas_.push_back(schema);
+  op->ComputeOutputSchema();
+  EXPECT_EQ(op->output_schema(), schema);
+
+  std::vector<Record> records;
+  records.emplace_back(schema, true, 0_u, 1_u, 30_s);
+  records.emplace_back(schema, true, 1_u, 1_u, 20_s);
+  records.emplace_back(schema, true, 2_u, 1_u, 40_s);
+  std::vector<Record> output =
+      op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  ASSERT_EQ(output.size(), 2);
+  EXPECT_EQ(output.at(0), Record(schema, true, 1_u, 1_u, 20_s));
+  EXPECT_EQ(output.at(1), Record(schema, true, 0_u, 1_u, 30_s));
+
+  // A record that is smaller than the current second replaces it, other
+  // groups are not affected.
+  records.clear();
+  records.emplace_back(schema, true, 3_u, 2_u, 5_s);
+  output = op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  ASSERT_EQ(output.size(), 1);
+  EXPECT_EQ(output.at(0), Record(schema, true, 3_u, 2_u, 5_s));
+  records.clear();
+  records.emplace_back(schema, true, 4_u, 1_u, 10_s);
+  output = op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  ASSERT_EQ(output.size(), 2);
+  EXPECT_EQ(output.at(0), Record(schema, false, 0_u, 1_u, 30_s));
+  EXPECT_FALSE(output.at(0).IsPositive());
+  EXPECT_EQ(output.at(1), Record(schema, true, 4_u, 1_u, 10_s));
+  EXPECT_TRUE(output.at(1).IsPositive());
+
+  // A record that is larger than the first k produces nothing.
+  records.clear();
+  records.emplace_back(schema, true, 5_u, 1_u, 60_s);
+  output = op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  EXPECT_EQ(output.size(), 0);
+}
+
+TEST(TopKOperatorTest, DeletePromotes) {
+  SchemaRef schema = MakeSchema();
+  std::unique_ptr<TopKOperator> op = MakeOperator(2);
+  op->input_schemas_.push_back(schema);
+  op->ComputeOutputSchema();
+
+  std::vector<Record> records;
+  records.emplace_back(schema, true, 0_u, 1_u, 30_s);
+  records.emplace_back(schema, true, 1_u, 1_u, 20_s);
+  records.emplace_back(schema, true, 2_u, 1_u, 40_s);
+  op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+
+  // Deleting the first brings in the third.
+  records.clear();
+  records.emplace_back(schema, false, 1_u, 1_u, 20_s);
+  std::vector<Record> output =
+      op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  ASSERT_EQ(output.size(), 2);
+  EXPECT_EQ(output.at(0), Record(schema, false, 1_u, 1_u, 20_s));
+  EXPECT_FALSE(output.at(0).IsPositive());
+  EXPECT_EQ(output.at(1), Record(schema, true, 2_u, 1_u, 40_s));
+  EXPECT_TRUE(output.at(1).IsPositive());
+
+  // Deleting everything removes the group.
+  records.clear();
+  records.emplace_back(schema, false, 0_u, 1_u, 30_s);
+  records.emplace_back(schema, false, 2_u, 1_u, 40_s);
+  output = op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  EXPECT_EQ(output.size(), 2);
+  EXPECT_EQ(op->groups_.size(), 0);
+}
+
+// Records beyond 2 * k are kept out of the ordered buffer, and brought back
+// when deletes empty the buffer.
+TEST(TopKOperatorTest, RefillFromOverflow) {
+  SchemaRef schema = MakeSchema();
+  std::unique_ptr<TopKOperator> op = MakeOperator(2);
+  op->input_schemas_.push_back(schema);
+  op->ComputeOutputSchema();
+
+  std::vector<Record> records;
+  for (uint64_t i = 0; i < 10; i++) {
+    records.emplace_back(schema, true, i, 1_u, static_cast<int64_t>(10 - i));
+  }
+  op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+  const auto &group = op->groups_.begin()->second;
+  EXPECT_EQ(group.buffer.size(), 4);
+  EXPECT_EQ(group.overflow.size(), 6);
+
+  // Delete the smallest 8 one at a time: the first k stay exact.
+  for (uint64_t i = 9; i > 1; i--) {
+    records.clear();
+    records.emplace_back(schema, false, i, 1_u, static_cast<int64_t>(10 - i));
+    std::vector<Record> output =
+        op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+    ASSERT_EQ(output.size(), 2);
+    EXPECT_EQ(output.at(0), Record(schema, false, i, 1_u,
+                                   static_cast<int64_t>(10 - i)));
+    EXPECT_EQ(output.at(1), Record(schema, true, i - 2, 1_u,
+                                   static_cast<int64_t>(12 - i)));
+  }
+  EXPECT_EQ(group.buffer.size(), 2);
+  EXPECT_EQ(group.overflow.size(), 0);
+}
+
+TEST(TopKOperatorTest, CheckpointRestore) {
+  SchemaRef schema = MakeSchema();
+  std::unique_ptr<TopKOperator> op = MakeOperator(2);
+  op->input_schemas_.push_back(schema);
+  op->ComputeOutputSchema();
+  std::unique_ptr<TopKOperator> restored = MakeOperator(2);
+  restored->input_schemas_.push_back(schema);
+  restored->ComputeOutputSchema();
+
+  std::vector<Record> records;
+  for (uint64_t i = 0; i < 6; i++) {
+    records.emplace_back(schema, true, i, i % 2, static_cast<int64_t>(i));
+  }
+  op->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+
+  // All records, including the ones outside the top k, are checkpointed.
+  std::vector<std::vector<Record>> batches = op->Checkpoint();
+  ASSERT_EQ(batches.size(), 1);
+  EXPECT_EQ(batches.at(0).size(), 6);
+  restored->Restore(std::move(batches));
+  EXPECT_EQ(restored->groups_.size(), 2);
+
+  // Deleting from the top k promotes the same record in both.
+  for (TopKOperator *o : {op.get(), restored.get()}) {
+    records.clear();
+    records.emplace_back(schema, false, 0_u, 0_u, 0_s);
+    std::vector<Record> output =
+        o->Process(UNDEFINED_NODE_INDEX, std::move(records), Promise::None);
+    ASSERT_EQ(output.size(), 2);
+    EXPECT_EQ(output.at(0), Record(schema, false, 0_u, 0_u, 0_s));
+    EXPECT_EQ(output.at(1), Record(schema, true, 4_u, 0_u, 4_s));
+  }
+}
+
+}  // namespace dataflow
+}  // namespace k9db
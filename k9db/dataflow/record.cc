@@ -14,29 +14,30 @@ Record Record::Copy() const {
   record.timestamp_ = this->timestamp_;
 
   // Copy bitmap
-  record.bitmap_ = nullptr;
-  if (bitmap_) {
-    record.bitmap_ = new uint64_t[NumBits()];
-    memcpy(record.bitmap_, this->bitmap_, NumBits() * sizeof(uint64_t));
-  }
+  memcpy(record.Bitmap(), this->Bitmap(),
+         this->block_->NumBits() * sizeof(uint64_t));
 
   // Copy data.
+  uint32_t row = record.Row();
   for (size_t i = 0; i < this->schema_.size(); i++) {
     if (!this->IsNull(i)) {
       const auto &type = this->schema_.column_types().at(i);
       switch (type) {
         case sqlast::ColumnDefinition::Type::UINT:
-          record.data_[i].uint = this->data_[i].uint;
+          record.Cell(i).uint = this->Cell(i).uint;
           break;
         case sqlast::ColumnDefinition::Type::INT:
-          record.data_[i].sint = this->data_[i].sint;
+          record.Cell(i).sint = this->Cell(i).sint;
           break;
         case sqlast::ColumnDefinition::Type::TEXT:
         // TODO(malte): DATETIME should not be stored as a string,
         // see below
         case sqlast::ColumnDefinition::Type::DATETIME:
-          record.data_[i].str =
-              std::make_unique<std::string>(*this->data_[i].str);
+          // Copied into the inline slot of the new record.
+          if (this->Cell(i).str != nullptr) {
+            record.block_->AssignString(&record.Cell(i), i, row,
+                                        *this->Cell(i).str);
+          }
           break;
         default:
           LOG(FATAL) << "Unsupported data type " << type << " in record copy!";
@@ -47,6 +48,22 @@ Record Record::Copy() const {
   return record;
 }
 
+// Shallow (shared) copying.
+Record Record::Share() const {
+  this->block_->Ref();
+  Record record{this->block_, this->Row(), this->positive_};
+  record.timestamp_ = this->timestamp_;
+  return record;
+}
+
+// Shallow copying unless other rows are kept alive along with this one.
+Record Record::Compact() const {
+  if (this->block_->capacity() == 1) {
+    return this->Share();
+  }
+  return this->Copy();
+}
+
 // Size in memory.
 size_t Record::SizeInMemory() const {
   size_t size = sizeof(Record);
@@ -55,8 +72,8 @@ size_t Record::SizeInMemory() const {
       switch (this->schema_.TypeOf(i)) {
         case sqlast::ColumnDefinition::Type::TEXT:
         case sqlast::ColumnDefinition::Type::DATETIME:
-          if (this->data_[i].str != nullptr) {
-            size += this->data_[i].str->size();
+          if (this->Cell(i).str != nullptr) {
+            size += this->Cell(i).str->size();
           }
           break;
         case sqlast::ColumnDefinition::Type::UINT:
@@ -73,44 +90,54 @@ size_t Record::SizeInMemory() const {
 void Record::SetUInt(uint64_t uint, size_t i) {
   CheckType(i, sqlast::ColumnDefinition::Type::UINT);
   CHECK(!IsNull(i));
-  this->data_[i].uint = uint;
+  this->Cell(i).uint = uint;
 }
 void Record::SetInt(int64_t sint, size_t i) {
   CheckType(i, sqlast::ColumnDefinition::Type::INT);
   CHECK(!IsNull(i));
-  this->data_[i].sint = sint;
+  this->Cell(i).sint = sint;
 }
 void Record::SetString(std::unique_ptr<std::string> &&v, size_t i) {
   CheckType(i, sqlast::ColumnDefinition::Type::TEXT);
   CHECK(!IsNull(i));
-  this->data_[i].str = std::move(v);
+  this->block_->AdoptString(&this->Cell(i), v.release());
 }
 void Record::SetDateTime(std::unique_ptr<std::string> &&v, size_t i) {
   CheckType(i, sqlast::ColumnDefinition::Type::DATETIME);
   CHECK(!IsNull(i));
-  this->data_[i].str = std::move(v);
+  this->block_->AdoptString(&this->Cell(i), v.release());
+}
+void Record::SetString(const std::string &v, size_t i) {
+  CheckType(i, sqlast::ColumnDefinition::Type::TEXT);
+  CHECK(!IsNull(i));
+  this->block_->AssignString(&this->Cell(i), i, this->Row(), v);
+}
+void Record::SetDateTime(const std::string &v, size_t i) {
+  CheckType(i, sqlast::ColumnDefinition::Type::DATETIME);
+  CHECK(!IsNull(i));
+  this->block_->AssignString(&this->Cell(i), i, this->Row(), v);
 }
 uint64_t Record::GetUInt(size_t i) const {
   CheckType(i, sqlast::ColumnDefinition::Type::UINT);
   CHECK(!IsNull(i));
-  return this->data_[i].uint;
+  return this->Cell(i).uint;
 }
 int64_t Record::GetInt(size_t i) const {
   CheckType(i, sqlast::ColumnDefinition::Type::INT);
   CHECK(!IsNull(i));
-  return this->data_[i].sint;
+  return this->Cell(i).sint;
 }
 const std::string &Record::GetString(size_t i) const {
   CheckType(i, sqlast::ColumnDefinition::Type::TEXT);
   CHECK(!IsNull(i));
-  CHECK_NOTNULL(this->data_[i].str);
-  return *(this->data_[i].str);
+  CHECK_NOTNULL(this->Cell(i).str);
+  return *(this->Cell(i).str);
 }
 const std::string &Record::GetDateTime(size_t i) const {
   CheckType(i, sqlast::ColumnDefinition::Type::DATETIME);
   CHECK(!IsNull(i));
-  CHECK_NOTNULL(this->data_[i].str);
-  return *(this->data_[i].str);
+  CHECK_NOTNULL(this->Cell(i).str);
+  return *(this->Cell(i).str);
 }
 
 // Data access with generic type.
@@ -128,15 +155,15 @@ Key Record::GetValues(const std::vector<ColumnID> &cols) const {
     }
     switch (this->schema_.TypeOf(col)) {
       case sqlast::ColumnDefinition::Type::UINT:
-        key.AddValue(this->data_[col].uint);
+        key.AddValue(this->Cell(col).uint);
         break;
       case sqlast::ColumnDefinition::Type::INT:
-        key.AddValue(this->data_[col].sint);
+        key.AddValue(this->Cell(col).sint);
         break;
       case sqlast::ColumnDefinition::Type::TEXT:
       case sqlast::ColumnDefinition::Type::DATETIME:
-        if (this->data_[col].str) {
-          key.AddValue(*this->data_[col].str);
+        if (this->Cell(col).str) {
+          key.AddValue(*this->Cell(col).str);
         } else {
           key.AddValue("");
         }
@@ -154,12 +181,12 @@ sqlast::Value Record::GetValue(ColumnID col) const {
   }
   switch (this->schema_.TypeOf(col)) {
     case sqlast::ColumnDefinition::Type::UINT:
-      return sqlast::Value(this->data_[col].uint);
+      return sqlast::Value(this->Cell(col).uint);
     case sqlast::ColumnDefinition::Type::INT:
-      return sqlast::Value(this->data_[col].sint);
+      return sqlast::Value(this->Cell(col).sint);
     case sqlast::ColumnDefinition::Type::TEXT:
     case sqlast::ColumnDefinition::Type::DATETIME:
-      return sqlast::Value(*this->data_[col].str);
+      return sqlast::Value(*this->Cell(col).str);
     default:
       LOG(FATAL) << "Unsupported data type in value extraction!";
   }
@@ -181,10 +208,10 @@ void Record::SetValue(const sqlast::Value &value, size_t i) {
       this->SetInt(value.GetInt(), i);
       break;
     case sqlast::ColumnDefinition::Type::TEXT:
-      this->SetString(std::make_unique<std::string>(value.GetString()), i);
+      this->SetString(value.GetString(), i);
       break;
     case sqlast::ColumnDefinition::Type::DATETIME:
-      this->SetDateTime(std::make_unique<std::string>(value.GetString()), i);
+      this->SetDateTime(value.GetString(), i);
       break;
   }
 }
@@ -198,14 +225,14 @@ size_t Record::Hash(const std::vector<ColumnID> &cols) const {
     }
     switch (this->schema_.TypeOf(col)) {
       case sqlast::ColumnDefinition::Type::UINT:
-        hash_value += std::hash<std::uint64_t>{}(this->data_[col].uint);
+        hash_value += std::hash<std::uint64_t>{}(this->Cell(col).uint);
         break;
       case sqlast::ColumnDefinition::Type::INT:
-        hash_value += std::hash<std::int64_t>{}(this->data_[col].sint);
+        hash_value += std::hash<std::int64_t>{}(this->Cell(col).sint);
         break;
       case sqlast::ColumnDefinition::Type::TEXT:
       case sqlast::ColumnDefinition::Type::DATETIME:
-        hash_value += std::hash<std::string>{}(*this->data_[col].str);
+        hash_value += std::hash<std::string>{}(*this->Cell(col).str);
         break;
       default:
         LOG(FATAL) << "Unsupported data type when computing hash of record!";
@@ -277,41 +304,40 @@ bool Record::operator==(const Record &other) const {
     return false;
   }
 
-  // compare bitmaps
-  CHECK_EQ(NumBits(), other.NumBits());
-
-  // check whether bitmaps are different
-  if ((!bitmap_ && other.bitmap_) || (bitmap_ && !other.bitmap_)) return false;
-  if (bitmap_) {
-    CHECK(other.bitmap_);
-    if (0 != memcmp(bitmap_, other.bitmap_, NumBits() * sizeof(uint64_t)))
-      return false;
+  // Compare bitmaps.
+  CHECK_EQ(this->block_->NumBits(), other.block_->NumBits());
+  if (0 != memcmp(this->Bitmap(), other.Bitmap(),
+                  this->block_->NumBits() * sizeof(uint64_t))) {
+    return false;
   }
 
-  // Compare data (deep compare).
+  // Compare data (deep compare), null cells are equal regardless of content.
   for (size_t i = 0; i < this->schema_.size(); i++) {
+    if (this->IsNull(i)) {
+      continue;
+    }
     const auto &type = this->schema_.column_types().at(i);
     switch (type) {
       case sqlast::ColumnDefinition::Type::UINT:
-        if (this->data_[i].uint != other.data_[i].uint) {
+        if (this->Cell(i).uint != other.Cell(i).uint) {
           return false;
         }
         break;
       case sqlast::ColumnDefinition::Type::INT:
-        if (this->data_[i].sint != other.data_[i].sint) {
+        if (this->Cell(i).sint != other.Cell(i).sint) {
           return false;
         }
         break;
       case sqlast::ColumnDefinition::Type::TEXT:
       case sqlast::ColumnDefinition::Type::DATETIME:
         // If the pointers are not literally identical pointers.
-        if (this->data_[i].str != other.data_[i].str) {
+        if (this->Cell(i).str != other.Cell(i).str) {
           // Either is null but not both.
-          if (!this->data_[i].str || !other.data_[i].str) {
+          if (!this->Cell(i).str || !other.Cell(i).str) {
             return false;
           }
           // Compare contents.
-          if (*this->data_[i].str != *other.data_[i].str) {
+          if (*this->Cell(i).str != *other.Cell(i).str) {
             return false;
           }
         }
@@ -337,15 +363,15 @@ std::ostream &operator<<(std::ostream &os, const k9db::dataflow::Record &r) {
 
     switch (r.schema_.TypeOf(i)) {
       case sqlast::ColumnDefinition::Type::UINT:
-        os << r.data_[i].uint << "|";
+        os << r.Cell(i).uint << "|";
         break;
       case sqlast::ColumnDefinition::Type::INT:
-        os << r.data_[i].sint << "|";
+        os << r.Cell(i).sint << "|";
         break;
       case sqlast::ColumnDefinition::Type::DATETIME:
       case sqlast::ColumnDefinition::Type::TEXT:
-        if (r.data_[i].str) {
-          os << *r.data_[i].str << "|";
+        if (r.Cell(i).str) {
+          os << *r.Cell(i).str << "|";
         } else {
           os << "[nullptr]"
              << "|";
@@ -14,6 +14,7 @@
 
 #include "glog/logging.h"
 #include "k9db/dataflow/key.h"
+#include "k9db/dataflow/record_block.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/dataflow/types.h"
 #include "k9db/sqlast/ast.h"
@@ -41,12 +42,12 @@ class Record {
   // Records can move (e.g. for inserting into vectors and maps).
   Record(Record &&o)
       : data_(o.data_),
-        bitmap_(o.bitmap_),
+        block_(o.block_),
         schema_(o.schema_),
         timestamp_(o.timestamp_),
         positive_(o.positive_) {
     o.data_ = nullptr;
-    o.bitmap_ = nullptr;
+    o.block_ = nullptr;
   }
   // Need to be able to move-assign for cases when std::vector<Record>
   // has elements deleted in the middle, and has to move the remaining
@@ -57,20 +58,23 @@ class Record {
     this->FreeRecordData();
     // Move things.
     this->data_ = o.data_;
+    this->block_ = o.block_;
     this->timestamp_ = o.timestamp_;
     this->positive_ = o.positive_;
-    this->bitmap_ = o.bitmap_;
     // Invalidate other.
     o.data_ = nullptr;
-    o.bitmap_ = nullptr;
+    o.block_ = nullptr;
     return *this;
   }
 
   // Allocate memory but do not put any values in yet!
+  // The record is backed by its own single-row RecordBlock.
   explicit Record(const SchemaRef &schema, bool positive = true)
       : schema_(schema), timestamp_(0), positive_(positive) {
-    this->data_ = new RecordData[schema.size()];
-    this->bitmap_ = nullptr;
+    uint32_t row;
+    this->block_ = RecordBlock::Allocate(schema, 1);
+    this->block_->ClaimRow(&row);
+    this->data_ = this->block_->Row(row);
   }
 
   // Create record and set all the data together.
@@ -80,9 +84,8 @@ class Record {
     this->SetData(std::forward<Args>(ts)...);
   }
 
-  // Destructor: we have to manually destruct all unique_ptrs in unions
-  // and delete the data array on the heap (unions do not call destructors
-  // of their data automatically).
+  // Destructor: releases this record's reference to its block. Strings are
+  // freed by the block when its last reference is released.
   ~Record() { this->FreeRecordData(); }
 
   // Helper function to create a record consisting onyl of nulls
@@ -94,9 +97,21 @@ class Record {
     return r;
   }
 
-  // Explicit deep copying.
+  // Explicit deep copying. The copy is always backed by its own single-row
+  // block, regardless of how this record is stored.
   Record Copy() const;
 
+  // Shallow copying: the returned record is a view into the same underlying
+  // storage as this record, and costs no allocations. The data is shared, and
+  // thus must not be modified through either record afterwards (use Copy() if
+  // the copy is to be modified). Positivity and timestamp are not shared.
+  Record Share() const;
+
+  // A record to keep in long-lived operator state. Shares this record if it
+  // is backed by its own block, and copies it otherwise, so that the stored
+  // record does not keep the rest of a RecordBatch block alive.
+  Record Compact() const;
+
   // Set all data in one shot regardless of types and counts.
   template <typename... Args>
   void SetData(Args &&... ts) {
@@ -109,47 +124,29 @@ class Record {
   // Data access.
   void SetUInt(uint64_t uint, size_t i);
   void SetInt(int64_t sint, size_t i);
+  // Takes ownership of the given string.
   void SetString(std::unique_ptr<std::string> &&v, size_t i);
   void SetDateTime(std::unique_ptr<std::string> &&v, size_t i);
+  // Copies the given string into the record's inline storage. This avoids
+  // a heap allocation for short strings.
+  void SetString(const std::string &v, size_t i);
+  void SetDateTime(const std::string &v, size_t i);
   uint64_t GetUInt(size_t i) const;
   int64_t GetInt(size_t i) const;
   const std::string &GetString(size_t i) const;
   const std::string &GetDateTime(size_t i) const;
 
   inline bool IsNull(size_t i) const {
-    if (!bitmap_) return false;
-
-    CHECK(bitmap_);
-    auto bitmap_block_idx = i / 64;
-    auto bitmap_idx = i % 64;
-    CHECK_LT(bitmap_block_idx, NumBits());
-    return bitmap_[bitmap_block_idx] & (0x1ul << bitmap_idx);
+    CHECK_LT(i / 64, this->block_->NumBits());
+    return this->Bitmap()[i / 64] & (0x1ul << (i % 64));
   }
 
   inline void SetNull(bool isnull, size_t i) {
-    // shortcut: if isnull=false and no bitmap, no change
-    if (!isnull && !bitmap_) return;
-
-    // lazy init bitmap
-    lazyBitmap();
-
-    CHECK(bitmap_);
-    auto bitmap_block_idx = i / 64;
-    auto bitmap_idx = i % 64;
-    CHECK_LT(bitmap_block_idx, NumBits());
-    if (isnull)
-      bitmap_[bitmap_block_idx] |= (0x1ul << bitmap_idx);
-    else
-      bitmap_[bitmap_block_idx] &= ~(0x1ul << bitmap_idx);
-
-    // compact bitmap, i.e. when all fields become 0, then release bitmap
-    // --> important when using == comparison invariant to remove a couple
-    // checks there as well.
-    uint64_t reduced_bitmap = 0;
-    for (unsigned i = 0; i < NumBits(); ++i) reduced_bitmap |= bitmap_[i];
-    if (0 == reduced_bitmap) {
-      delete[] bitmap_;
-      bitmap_ = nullptr;
+    CHECK_LT(i / 64, this->block_->NumBits());
+    if (isnull) {
+      this->Bitmap()[i / 64] |= (0x1ul << (i % 64));
+    } else {
+      this->Bitmap()[i / 64] &= ~(0x1ul << (i % 64));
     }
   }
 
@@ -203,30 +200,32 @@ class Record {
         } else if (l_null && r_null) {
           continue;
         }
+        const RecordData &lcell = l.Cell(i);
+        const RecordData &rcell = r.Cell(i);
         switch (types.at(i)) {
           case sqlast::ColumnDefinition::Type::UINT:
-            if (l.data_[i].uint < r.data_[i].uint) {
+            if (lcell.uint < rcell.uint) {
               return true;
-            } else if (l.data_[i].uint != r.data_[i].uint) {
+            } else if (lcell.uint != rcell.uint) {
               return false;
             }
             break;
           case sqlast::ColumnDefinition::Type::INT:
-            if (l.data_[i].sint < r.data_[i].sint) {
+            if (lcell.sint < rcell.sint) {
               return true;
-            } else if (l.data_[i].sint != r.data_[i].sint) {
+            } else if (lcell.sint != rcell.sint) {
               return false;
             }
             break;
           case sqlast::ColumnDefinition::Type::TEXT:
           case sqlast::ColumnDefinition::Type::DATETIME: {
-            if (l.data_[i].str->size() != r.data_[i].str->size()) {
-              return l.data_[i].str->size() < r.data_[i].str->size();
+            if (lcell.str->size() != rcell.str->size()) {
+              return lcell.str->size() < rcell.str->size();
             }
-            for (size_t j = 0; j < l.data_[i].str->size(); j++) {
-              if (l.data_[i].str->at(j) < r.data_[i].str->at(j)) {
+            for (size_t j = 0; j < lcell.str->size(); j++) {
+              if (lcell.str->at(j) < rcell.str->at(j)) {
                 return true;
-              } else if (l.data_[i].str->at(j) != r.data_[i].str->at(j)) {
+              } else if (lcell.str->at(j) != rcell.str->at(j)) {
                 return false;
               }
             }
@@ -243,6 +242,15 @@ class Record {
   };
 
  private:
+  // A view into the given row of a (shared) block, used by RecordBatch.
+  // The record takes ownership of one reference to block.
+  Record(RecordBlock *block, uint32_t row, bool positive)
+      : data_(block->Row(row)),
+        block_(block),
+        schema_(block->schema()),
+        timestamp_(0),
+        positive_(positive) {}
+
   // Recursive helper used in SetData(...).
   template <typename Arg, typename... Args>
   void SetDataRecursive(size_t index, Arg &&t, Args &&... ts) {
@@ -258,7 +266,7 @@ class Record {
         case sqlast::ColumnDefinition::Type::UINT:
           if constexpr (std::is_same<std::remove_reference_t<Arg>,
                                      uint64_t>::value) {
-            this->data_[index].uint = t;
+            this->Cell(index).uint = t;
           } else {
             LOG(FATAL) << "Type mismatch in SetData at index " << index
                        << ", expected " << this->schema_.TypeOf(index)
@@ -268,7 +276,7 @@ class Record {
         case sqlast::ColumnDefinition::Type::INT:
           if constexpr (std::is_same<std::remove_reference_t<Arg>,
                                      int64_t>::value) {
-            this->data_[index].sint = t;
+            this->Cell(index).sint = t;
           } else {
             LOG(FATAL) << "Type mismatch in SetData at index " << index
                        << ", expected " << this->schema_.TypeOf(index)
@@ -276,19 +284,10 @@ class Record {
           }
           break;
         case sqlast::ColumnDefinition::Type::TEXT:
-          if constexpr (std::is_same<std::remove_reference_t<Arg>,
-                                     std::unique_ptr<std::string>>::value) {
-            this->data_[index].str = std::move(t);
-          } else {
-            LOG(FATAL) << "Type mismatch in SetData at index " << index
-                       << ", expected " << this->schema_.TypeOf(index)
-                       << ", got " << util::TypeNameFor(t);
-          }
-          break;
         case sqlast::ColumnDefinition::Type::DATETIME:
           if constexpr (std::is_same<std::remove_reference_t<Arg>,
                                      std::unique_ptr<std::string>>::value) {
-            this->data_[index].str = std::move(t);
+            this->block_->AdoptString(&this->Cell(index), t.release());
           } else {
             LOG(FATAL) << "Type mismatch in SetData at index " << index
                        << ", expected " << this->schema_.TypeOf(index)
@@ -309,25 +308,21 @@ class Record {
     }
   }
 
-  union RecordData {
-    uint64_t uint;
-    int64_t sint;
-    std::unique_ptr<std::string> str;
-    // Initially garbage.
-    RecordData() : str() {}
-    // We cant tell if we are using str or not, destructing it must be done
-    // by the Record class externally.
-    ~RecordData() {}
-  };
-
-  // 37 bytes but with alignment it is really 40 bytes.
-  RecordData *data_;  // [8 B]
-  uint64_t *bitmap_;  // [8 B]
-  SchemaRef schema_;  // [8 B]
-  int timestamp_;     // [4 B]
-  bool positive_;     // [1 B]
+  // Points to the cell of column 0 of this record's row inside block_.
+  // Cells of a row are block_->capacity() apart (columnar layout).
+  RecordData *data_;    // [8 B]
+  RecordBlock *block_;  // [8 B]
+  SchemaRef schema_;    // [8 B]
+  int timestamp_;       // [4 B]
+  bool positive_;       // [1 B]
 
-  inline size_t NumBits() const { return schema_.size() / 64 + 1; }
+  inline RecordData &Cell(size_t i) const {
+    return this->data_[i * this->block_->capacity()];
+  }
+  inline uint64_t *Bitmap() const {
+    return this->block_->Bitmap(this->block_->RowOf(this->data_));
+  }
+  inline uint32_t Row() const { return this->block_->RowOf(this->data_); }
 
   inline void CheckType(size_t i, sqlast::ColumnDefinition::Type t) const {
     CHECK_NOTNULL(this->data_);
@@ -338,33 +333,15 @@ class Record {
   }
 
   inline void FreeRecordData() {
-    // Free bitmap
-    if (this->bitmap_ != nullptr) {
-      delete[] this->bitmap_;
-      this->bitmap_ = nullptr;
-    }
-
-    if (this->data_ != nullptr) {
-      // Destruct unique_ptrs.
-      for (size_t i = 0; i < this->schema_.size(); i++) {
-        const auto &type = this->schema_.column_types().at(i);
-        if (type == sqlast::ColumnDefinition::Type::TEXT ||
-            type == sqlast::ColumnDefinition::Type::DATETIME) {
-          this->data_[i].str = std::unique_ptr<std::string>();
-        }
-      }
-      // Delete allocated unions.
-      delete[] this->data_;
+    if (this->block_ != nullptr) {
+      this->block_->Unref();
+      this->block_ = nullptr;
       this->data_ = nullptr;
     }
   }
 
-  void lazyBitmap() {
-    if (!this->bitmap_) {
-      this->bitmap_ = new uint64_t[NumBits()];
-      memset(bitmap_, 0, NumBits() * sizeof(uint64_t));
-    }
-  }
+  // Allowed to construct views into shared blocks.
+  friend class RecordBatch;
 };
 
 }  // namespace dataflow
@@ -0,0 +1,77 @@
+#include "k9db/dataflow/record_batch.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+// Blocks never exceed this many records, larger batches use several blocks.
+#define MAX_BLOCK_CAPACITY 4096u
+
+namespace k9db {
+namespace dataflow {
+
+RecordBatch::RecordBatch(const SchemaRef &schema, size_t capacity)
+    : schema_(schema),
+      block_capacity_(std::clamp<size_t>(capacity, 1, MAX_BLOCK_CAPACITY)),
+      block_(nullptr),
+      records_() {
+  this->records_.reserve(capacity);
+}
+
+RecordBatch::~RecordBatch() {
+  if (this->block_ != nullptr) {
+    this->block_->Unref();
+  }
+}
+
+RecordBatch::RecordBatch(RecordBatch &&o)
+    : schema_(o.schema_),
+      block_capacity_(o.block_capacity_),
+      block_(o.block_),
+      records_(std::move(o.records_)) {
+  o.block_ = nullptr;
+}
+RecordBatch &RecordBatch::operator=(RecordBatch &&o) {
+  if (this != &o) {
+    if (this->block_ != nullptr) {
+      this->block_->Unref();
+    }
+    this->schema_ = o.schema_;
+    this->block_capacity_ = o.block_capacity_;
+    this->block_ = o.block_;
+    this->records_ = std::move(o.records_);
+    o.block_ = nullptr;
+  }
+  return *this;
+}
+
+Record &RecordBatch::Add(bool positive) {
+  uint32_t row;
+  if (this->block_ == nullptr || !this->block_->ClaimRow(&row)) {
+    this->Grow();
+    CHECK(this->block_->ClaimRow(&row));
+  }
+  // The record holds its own reference to the block.
+  this->block_->Ref();
+  this->records_.push_back(Record(this->block_, row, positive));
+  return this->records_.back();
+}
+
+std::vector<Record> RecordBatch::Release() {
+  std::vector<Record> result = std::move(this->records_);
+  this->records_.clear();
+  return result;
+}
+
+void RecordBatch::Grow() {
+  if (this->block_ != nullptr) {
+    // Underestimated capacity: grow geometrically.
+    this->block_->Unref();
+    this->block_capacity_ =
+        std::min(this->block_capacity_ * 2, MAX_BLOCK_CAPACITY);
+  }
+  this->block_ = RecordBlock::Allocate(this->schema_, this->block_capacity_);
+}
+
+}  // namespace dataflow
+}  // namespace k9db
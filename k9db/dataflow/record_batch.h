@@ -0,0 +1,85 @@
+#ifndef K9DB_DATAFLOW_RECORD_BATCH_H_
+#define K9DB_DATAFLOW_RECORD_BATCH_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/record_block.h"
+#include "k9db/dataflow/schema.h"
+
+namespace k9db {
+namespace dataflow {
+
+// A batch of records sharing one schema, backed by per-batch arena storage.
+//
+// Records added to the batch are views into shared RecordBlocks: the cells,
+// null bitmaps, and (short) strings of all the records in the batch are stored
+// in a few contiguous allocations rather than in several small allocations per
+// record. The records are ordinary dataflow::Records, and can be handed to
+// operators via Release(). A record keeps its block alive, so records may
+// safely outlive the batch they were built in. Stateful operators store
+// Record::Compact() copies, so a single stored record does not keep its whole
+// block alive.
+//
+// Usage:
+//   RecordBatch batch(schema, records.size());
+//   for (...) {
+//     Record &record = batch.Add(true);
+//     record.SetUInt(...);
+//   }
+//   return batch.Release();
+class RecordBatch {
+ public:
+  // capacity is a hint for the number of records that will be added. The batch
+  // grows beyond it if needed.
+  RecordBatch(const SchemaRef &schema, size_t capacity);
+  ~RecordBatch();
+
+  // Not copyable.
+  RecordBatch(const RecordBatch &) = delete;
+  RecordBatch &operator=(const RecordBatch &) = delete;
+  // Movable.
+  RecordBatch(RecordBatch &&o);
+  RecordBatch &operator=(RecordBatch &&o);
+
+  // Add a new record to the batch. Values are initially unset, similar to
+  // Record(schema, positive).
+  Record &Add(bool positive = true);
+
+  // Add a new record and set all its data in one shot.
+  template <typename... Args>
+  Record &Emplace(bool positive, Args &&... ts) {
+    Record &record = this->Add(positive);
+    record.SetData(std::forward<Args>(ts)...);
+    return record;
+  }
+
+  // Accessors.
+  const SchemaRef &schema() const { return this->schema_; }
+  size_t size() const { return this->records_.size(); }
+  bool empty() const { return this->records_.empty(); }
+  Record &at(size_t i) { return this->records_.at(i); }
+  const Record &at(size_t i) const { return this->records_.at(i); }
+  std::vector<Record> &records() { return this->records_; }
+
+  // Give up the records in this batch (e.g. to return them from
+  // Operator::Process). The batch is empty afterwards, and can be reused.
+  std::vector<Record> Release();
+
+ private:
+  // Allocate a new block to hold the next records.
+  void Grow();
+
+  SchemaRef schema_;
+  uint32_t block_capacity_;
+  // The block currently being filled, we hold one reference to it.
+  RecordBlock *block_;
+  std::vector<Record> records_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_RECORD_BATCH_H_
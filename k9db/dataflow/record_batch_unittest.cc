@@ -0,0 +1,128 @@
+#include "k9db/dataflow/record_batch.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/record.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/sqlast/ast.h"
+#include "k9db/util/ints.h"
+
+namespace k9db {
+namespace dataflow {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+namespace {
+
+SchemaRef MakeSchema() {
+  std::vector<std::string> names = {"Col1", "Col2", "Col3"};
+  std::vector<CType> types = {CType::UINT, CType::TEXT, CType::INT};
+  std::vector<ColumnID> keys = {0};
+  return SchemaFactory::Create(names, types, keys);
+}
+
+}  // namespace
+
+// Records in a batch behave like ordinary records.
+TEST(RecordBatchTest, AddAndRead) {
+  SchemaRef schema = MakeSchema();
+  RecordBatch batch(schema, 3);
+  for (uint64_t i = 0; i < 3; i++) {
+    Record &record = batch.Add(i % 2 == 0);
+    record.SetUInt(i, 0);
+    record.SetString("str" + std::to_string(i), 1);
+    record.SetInt(-static_cast<int64_t>(i), 2);
+  }
+  batch.Emplace(true, 10_u, "hello"_uptr, NullValue());
+
+  std::vector<Record> records = batch.Release();
+  EXPECT_TRUE(batch.empty());
+  ASSERT_EQ(records.size(), 4);
+  for (uint64_t i = 0; i < 3; i++) {
+    EXPECT_EQ(records.at(i).GetUInt(0), i);
+    EXPECT_EQ(records.at(i).GetString(1), "str" + std::to_string(i));
+    EXPECT_EQ(records.at(i).GetInt(2), -static_cast<int64_t>(i));
+    EXPECT_EQ(records.at(i).IsPositive(), i % 2 == 0);
+    EXPECT_EQ(records.at(i), Record(schema, i % 2 == 0, i,
+                                    std::make_unique<std::string>(
+                                        "str" + std::to_string(i)),
+                                    -static_cast<int64_t>(i)));
+  }
+  EXPECT_EQ(records.at(3), Record(schema, true, 10_u, "hello"_uptr,
+                                  NullValue()));
+  EXPECT_TRUE(records.at(3).IsNull(2));
+  EXPECT_FALSE(records.at(3).IsNull(1));
+}
+
+// The batch grows beyond its initial capacity.
+TEST(RecordBatchTest, Grow) {
+  SchemaRef schema = MakeSchema();
+  RecordBatch batch(schema, 2);
+  for (uint64_t i = 0; i < 100; i++) {
+    batch.Emplace(true, i, std::make_unique<std::string>(std::to_string(i)),
+                  static_cast<int64_t>(i));
+  }
+  ASSERT_EQ(batch.size(), 100);
+  for (uint64_t i = 0; i < 100; i++) {
+    EXPECT_EQ(batch.at(i).GetUInt(0), i);
+    EXPECT_EQ(batch.at(i).GetString(1), std::to_string(i));
+  }
+}
+
+// Records outlive their batch, and copies are standalone.
+TEST(RecordBatchTest, Lifetime) {
+  SchemaRef schema = MakeSchema();
+  std::vector<Record> records;
+  {
+    RecordBatch batch(schema, 2);
+    batch.Emplace(true, 1_u, "a long string that does not fit inline"_uptr,
+                  5_s);
+    batch.Emplace(false, 2_u, "short"_uptr, 6_s);
+    records = batch.Release();
+  }
+  Record copy = records.at(1).Copy();
+  records.erase(records.begin());
+  EXPECT_EQ(records.at(0), copy);
+  EXPECT_NE(&records.at(0).GetString(1), &copy.GetString(1));
+  records.clear();
+  EXPECT_EQ(copy.GetUInt(0), 2_u);
+  EXPECT_EQ(copy.GetString(1), "short");
+  EXPECT_EQ(copy.GetInt(2), 6_s);
+  EXPECT_FALSE(copy.IsPositive());
+}
+
+// Compacted records do not share the block of their batch.
+TEST(RecordBatchTest, Compact) {
+  SchemaRef schema = MakeSchema();
+  RecordBatch batch(schema, 2);
+  batch.Emplace(true, 1_u, "a"_uptr, 5_s);
+  batch.Emplace(false, 2_u, "b"_uptr, 6_s);
+  std::vector<Record> records = batch.Release();
+  Record compact = records.at(1).Compact();
+  EXPECT_EQ(compact, records.at(1));
+  EXPECT_NE(&compact.GetString(1), &records.at(1).GetString(1));
+  EXPECT_FALSE(compact.IsPositive());
+
+  // A standalone record is shared as is.
+  Record again = compact.Compact();
+  EXPECT_EQ(&again.GetString(1), &compact.GetString(1));
+}
+
+// Overwriting strings in place.
+TEST(RecordBatchTest, OverwriteStrings) {
+  SchemaRef schema = MakeSchema();
+  RecordBatch batch(schema, 1);
+  Record &record = batch.Add();
+  record.SetString("inline", 1);
+  record.SetString(std::make_unique<std::string>("adopted"), 1);
+  EXPECT_EQ(record.GetString(1), "adopted");
+  record.SetString("inline again", 1);
+  EXPECT_EQ(record.GetString(1), "inline again");
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,133 @@
+#include "k9db/dataflow/record_block.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace k9db {
+namespace dataflow {
+
+namespace {
+
+inline size_t Align8(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+inline bool IsString(sqlast::ColumnDefinition::Type type) {
+  return type == sqlast::ColumnDefinition::Type::TEXT ||
+         type == sqlast::ColumnDefinition::Type::DATETIME;
+}
+
+}  // namespace
+
+RecordBlock::RecordBlock(const SchemaRef &schema, uint32_t capacity,
+                         uint32_t nbits, uint32_t ntext, size_t bytes)
+    : refs_(1),
+      capacity_(capacity),
+      size_(0),
+      nbits_(nbits),
+      ntext_(ntext),
+      schema_(schema),
+      bytes_(bytes),
+      cells_(nullptr),
+      bitmaps_(nullptr),
+      slot_index_(nullptr),
+      slots_(nullptr) {}
+
+RecordBlock *RecordBlock::Allocate(const SchemaRef &schema,
+                                   uint32_t capacity) {
+  CHECK_GT(capacity, 0u);
+  size_t ncols = schema.size();
+  uint32_t nbits = ncols / 64 + 1;
+  uint32_t ntext = 0;
+  for (sqlast::ColumnDefinition::Type type : schema.column_types()) {
+    if (IsString(type)) {
+      ntext++;
+    }
+  }
+
+  // Compute the layout: header | cells | bitmaps | slot index | slots.
+  size_t header_size = Align8(sizeof(RecordBlock));
+  size_t cells_size = sizeof(RecordData) * ncols * capacity;
+  size_t bitmaps_size = sizeof(uint64_t) * nbits * capacity;
+  size_t index_size = Align8(sizeof(uint32_t) * ncols);
+  size_t slots_size = sizeof(std::string) * ntext * capacity;
+  size_t bytes =
+      header_size + cells_size + bitmaps_size + index_size + slots_size;
+
+  // One allocation for everything.
+  char *memory = static_cast<char *>(::operator new(bytes));
+  RecordBlock *block =
+      new (memory) RecordBlock(schema, capacity, nbits, ntext, bytes);
+  char *ptr = memory + header_size;
+  block->cells_ = reinterpret_cast<RecordData *>(ptr);
+  ptr += cells_size;
+  block->bitmaps_ = reinterpret_cast<uint64_t *>(ptr);
+  ptr += bitmaps_size;
+  block->slot_index_ = reinterpret_cast<uint32_t *>(ptr);
+  ptr += index_size;
+  block->slots_ = reinterpret_cast<std::string *>(ptr);
+
+  // Initialize cells and bitmaps, string slots are constructed on first use.
+  for (size_t i = 0; i < ncols * capacity; i++) {
+    new (block->cells_ + i) RecordData();
+  }
+  memset(block->bitmaps_, 0, bitmaps_size);
+  uint32_t slot = 0;
+  for (size_t c = 0; c < ncols; c++) {
+    block->slot_index_[c] = IsString(schema.TypeOf(c)) ? slot++ : 0;
+  }
+  return block;
+}
+
+void RecordBlock::Free(RecordBlock *block) {
+  // Free all strings held by the claimed rows.
+  const SchemaRef &schema = block->schema_;
+  for (size_t c = 0; c < schema.size(); c++) {
+    if (IsString(schema.TypeOf(c))) {
+      RecordData *column = block->Column(c);
+      for (uint32_t row = 0; row < block->size_; row++) {
+        block->ReleaseString(column + row);
+      }
+    }
+  }
+  block->~RecordBlock();
+  ::operator delete(static_cast<void *>(block));
+}
+
+// String management.
+void RecordBlock::AssignString(RecordData *cell, ColumnID c, uint32_t row,
+                               const std::string &str) {
+  if (cell->str != nullptr) {
+    *cell->str = str;
+  } else {
+    cell->str = new (this->Slot(c, row)) std::string(str);
+  }
+}
+void RecordBlock::AssignString(RecordData *cell, ColumnID c, uint32_t row,
+                               std::string &&str) {
+  if (cell->str != nullptr) {
+    *cell->str = std::move(str);
+  } else {
+    cell->str = new (this->Slot(c, row)) std::string(std::move(str));
+  }
+}
+void RecordBlock::AdoptString(RecordData *cell, std::string *str) {
+  this->ReleaseString(cell);
+  cell->str = str;
+}
+void RecordBlock::ReleaseString(RecordData *cell) {
+  if (cell->str != nullptr) {
+    if (this->IsSlot(cell->str)) {
+      cell->str->~basic_string();
+    } else {
+      delete cell->str;
+    }
+    cell->str = nullptr;
+  }
+}
+
+}  // namespace dataflow
+}  // namespace k9db
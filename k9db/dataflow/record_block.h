@@ -0,0 +1,143 @@
+// A RecordBlock is the backing storage of one or more dataflow::Records that
+// share a schema.
+//
+// A block is a single heap allocation that holds the cells of up to
+// `capacity` records. Cells are laid out column by column, i.e. the cells of
+// column c for all the rows of the block are contiguous, followed by one
+// contiguous null bitmap for all rows, followed by inline string slots for
+// TEXT and DATETIME columns. Strings written into a slot are constructed in
+// place, and thus short strings (that fit in std::string's small buffer) do not
+// require any heap allocation.
+//
+// A standalone Record (e.g. one created with Record(schema)) is backed by a
+// block of capacity 1. A RecordBatch hands out Records that are views into a
+// larger shared block, so that building a batch of n records requires a single
+// allocation rather than O(n * columns) ones.
+//
+// Blocks are reference counted: every Record viewing a row of the block, as
+// well as the RecordBatch filling it, holds one reference. The block (and all
+// the strings it owns) is destroyed when the last reference is dropped.
+
+#ifndef K9DB_DATAFLOW_RECORD_BLOCK_H_
+#define K9DB_DATAFLOW_RECORD_BLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+// A single cell in a record.
+union RecordData {
+  uint64_t uint;
+  int64_t sint;
+  // Either points to an inline string slot inside the owning RecordBlock, or
+  // to a heap allocated string adopted from a std::unique_ptr. The owning
+  // RecordBlock tells these apart and frees them accordingly.
+  std::string *str;
+  // Initially empty.
+  RecordData() : str(nullptr) {}
+};
+
+class RecordBlock {
+ public:
+  // Allocate a block for the given schema that can hold up to capacity rows.
+  // The returned block has a single reference owned by the caller.
+  static RecordBlock *Allocate(const SchemaRef &schema, uint32_t capacity);
+
+  // Not copyable or movable: records point inside the block.
+  RecordBlock(const RecordBlock &) = delete;
+  RecordBlock(RecordBlock &&) = delete;
+  RecordBlock &operator=(const RecordBlock &) = delete;
+  RecordBlock &operator=(RecordBlock &&) = delete;
+
+  // Reference counting.
+  inline void Ref(uint32_t count = 1) {
+    this->refs_.fetch_add(count, std::memory_order_relaxed);
+  }
+  inline void Unref() {
+    if (this->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      RecordBlock::Free(this);
+    }
+  }
+
+  // Claim the next unused row. Returns false if the block is full.
+  inline bool ClaimRow(uint32_t *row) {
+    if (this->size_ == this->capacity_) {
+      return false;
+    }
+    *row = this->size_++;
+    return true;
+  }
+
+  // Layout accessors.
+  const SchemaRef &schema() const { return this->schema_; }
+  uint32_t capacity() const { return this->capacity_; }
+  uint32_t size() const { return this->size_; }
+  uint32_t NumBits() const { return this->nbits_; }
+
+  // The cells of column c (for all rows) are contiguous.
+  inline RecordData *Column(ColumnID c) const {
+    return this->cells_ + static_cast<size_t>(c) * this->capacity_;
+  }
+  inline RecordData *Row(uint32_t row) const { return this->cells_ + row; }
+  inline uint32_t RowOf(const RecordData *row_data) const {
+    return static_cast<uint32_t>(row_data - this->cells_);
+  }
+  inline uint64_t *Bitmap(uint32_t row) const {
+    return this->bitmaps_ + static_cast<size_t>(row) * this->nbits_;
+  }
+
+  // String management. cell must belong to column c and the given row.
+  // Copies the string into the cell, reusing whatever storage the cell has.
+  void AssignString(RecordData *cell, ColumnID c, uint32_t row,
+                    const std::string &str);
+  void AssignString(RecordData *cell, ColumnID c, uint32_t row,
+                    std::string &&str);
+  // Adopt a heap allocated string (e.g. released from a std::unique_ptr).
+  void AdoptString(RecordData *cell, std::string *str);
+  // Free whatever string the cell holds and set it to nullptr.
+  void ReleaseString(RecordData *cell);
+
+  // Size of the block in memory (not counting heap strings).
+  size_t SizeInMemory() const { return this->bytes_; }
+
+ private:
+  RecordBlock(const SchemaRef &schema, uint32_t capacity, uint32_t nbits,
+              uint32_t ntext, size_t bytes);
+
+  // Destroys all strings and deallocates the block.
+  static void Free(RecordBlock *block);
+
+  inline std::string *Slot(ColumnID c, uint32_t row) const {
+    return this->slots_ +
+           static_cast<size_t>(this->slot_index_[c]) * this->capacity_ + row;
+  }
+  inline bool IsSlot(const std::string *str) const {
+    return str >= this->slots_ &&
+           str < this->slots_ + static_cast<size_t>(this->ntext_) *
+                                    this->capacity_;
+  }
+
+  std::atomic<uint32_t> refs_;
+  uint32_t capacity_;
+  uint32_t size_;
+  uint32_t nbits_;
+  uint32_t ntext_;
+  SchemaRef schema_;
+  size_t bytes_;
+  // Pointers into the allocation that immediately follows this header.
+  RecordData *cells_;
+  uint64_t *bitmaps_;
+  uint32_t *slot_index_;  // ColumnID -> index of its string slots.
+  std::string *slots_;    // raw storage, constructed on first use.
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_RECORD_BLOCK_H_
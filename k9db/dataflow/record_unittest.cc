@@ -500,5 +500,34 @@ TEST(RecordTest, ExplicitCopy) {
   EXPECT_EQ(record.IsPositive(), record2.IsPositive());
 }
 
+TEST(RecordTest, SharedCopy) {
+  // Create a schema.
+  std::vector<std::string> names = {"Col1", "Col2"};
+  std::vector<CType> types = {CType::INT, CType::TEXT};
+  std::vector<ColumnID> keys = {0};
+  SchemaRef schema = SchemaFactory::Create(names, types, keys);
+
+  // Create a record and share it.
+  std::unique_ptr<Record> record =
+      std::make_unique<Record>(schema, false, 5_s, "hello"_uptr);
+  const std::string *str = &record->GetString(1);
+  Record record2 = record->Share();
+
+  // Values are equal, and strings are the same.
+  EXPECT_EQ(*record, record2);
+  EXPECT_EQ(&record2.GetString(1), str);
+  EXPECT_EQ(record->GetTimestamp(), record2.GetTimestamp());
+  EXPECT_EQ(record->IsPositive(), record2.IsPositive());
+
+  // Positivity is not shared.
+  record2.SetPositive(true);
+  EXPECT_FALSE(record->IsPositive());
+
+  // The shared record outlives the original.
+  record = nullptr;
+  EXPECT_EQ(record2.GetInt(0), 5_s);
+  EXPECT_EQ(record2.GetString(1), "hello");
+}
+
 }  // namespace dataflow
 }  // namespace k9db
@@ -0,0 +1,115 @@
+// A bounded, lock-free FIFO ring buffer with many producers and a single
+// consumer.
+//
+// Every slot carries a sequence number that tells producers and the consumer
+// whether the slot is free for the current lap around the ring or holds a
+// value, so that no locks are needed on either side.
+// Producers claim a position by advancing tail_ with a CAS. A single producer
+// never contends, and values pushed by the same producer are popped in the
+// order they were pushed.
+// The consumer is the only thread advancing head_, and thus needs no atomic
+// read-modify-write operations at all.
+#ifndef K9DB_DATAFLOW_RING_BUFFER_H_
+#define K9DB_DATAFLOW_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace k9db {
+namespace dataflow {
+
+template <typename T>
+class RingBuffer {
+ public:
+  // capacity must be a power of 2.
+  explicit RingBuffer(size_t capacity)
+      : slots_(new Slot[capacity]), mask_(capacity - 1), tail_(0), head_(0) {
+    CHECK_GT(capacity, 0u);
+    CHECK_EQ(capacity & (capacity - 1), 0u) << "Capacity must be power of 2";
+    for (size_t i = 0; i < capacity; i++) {
+      this->slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Not copyable or movable.
+  RingBuffer(const RingBuffer &) = delete;
+  RingBuffer &operator=(const RingBuffer &) = delete;
+
+  size_t capacity() const { return this->mask_ + 1; }
+
+  // Called by (any) producer. Returns false if the buffer is full, in which
+  // case value is left untouched.
+  bool TryPush(T &&value) {
+    size_t pos = this->tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+      slot = &this->slots_[pos & this->mask_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        // Slot is free for this lap, try to claim it.
+        if (this->tail_.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // Slot still holds a value from the previous lap: buffer is full.
+        return false;
+      } else {
+        // Another producer claimed this position, catch up.
+        pos = this->tail_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->value.emplace(std::move(value));
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the consumer. Moves up to limit values into output, and returns
+  // how many were moved.
+  size_t PopInto(std::vector<T> *output, size_t limit) {
+    size_t count = 0;
+    while (count < limit) {
+      Slot &slot = this->slots_[this->head_ & this->mask_];
+      if (slot.seq.load(std::memory_order_acquire) != this->head_ + 1) {
+        break;
+      }
+      output->push_back(std::move(*slot.value));
+      slot.value.reset();
+      // Free the slot for the next lap.
+      slot.seq.store(this->head_ + this->mask_ + 1, std::memory_order_release);
+      this->head_++;
+      count++;
+    }
+    return count;
+  }
+
+  // Called by the consumer.
+  bool Empty() const {
+    const Slot &slot = this->slots_[this->head_ & this->mask_];
+    return slot.seq.load(std::memory_order_acquire) != this->head_ + 1;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    std::optional<T> value;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  // Producers and the consumer are kept on different cache lines.
+  alignas(64) std::atomic<size_t> tail_;
+  alignas(64) size_t head_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_RING_BUFFER_H_
@@ -0,0 +1,157 @@
+#include "k9db/dataflow/scheduler.h"
+
+#include <utility>
+
+#include "glog/logging.h"
+
+// Number of times an idle worker looks for work (yielding in between) before
+// it parks.
+#define IDLE_SPINS 64
+
+namespace k9db {
+namespace dataflow {
+
+// Constructor and destructor.
+Scheduler::Scheduler(const std::vector<Channel *> &channels, Runner &&runner)
+    : partitions_(),
+      runner_(std::move(runner)),
+      threads_(),
+      stop_(false),
+      joined_(false),
+      epoch_(0),
+      sleepers_(0),
+      mtx_(),
+      cv_() {
+  for (Channel *chan : channels) {
+    this->partitions_.push_back(std::make_unique<Partition>(chan));
+    chan->SetWakeUp([this]() { this->WakeUp(); });
+  }
+  for (PartitionIndex i = 0; i < this->partitions_.size(); i++) {
+    this->threads_.emplace_back([this, i]() { this->Work(i); });
+  }
+}
+Scheduler::~Scheduler() { CHECK(this->joined_); }
+
+// Statistics.
+std::vector<Scheduler::Stats> Scheduler::GetStats() const {
+  std::vector<Stats> result;
+  for (PartitionIndex i = 0; i < this->partitions_.size(); i++) {
+    const Partition &p = *this->partitions_.at(i);
+    result.push_back({i, p.chan->Depth(), p.processed.load(), p.stolen.load(),
+                      p.steals.load()});
+  }
+  return result;
+}
+
+// Stopping workers.
+void Scheduler::Shutdown() {
+  if (!this->stop_.exchange(true)) {
+    LOG(INFO) << "Shutting down dataflow workers";
+    {
+      std::unique_lock<std::mutex> lock(this->mtx_);
+      this->epoch_.fetch_add(1);
+      this->cv_.notify_all();
+    }
+    this->Join();
+    LOG(INFO) << "Terminated dataflow workers";
+  }
+  this->joined_ = true;
+}
+void Scheduler::Join() {
+  for (std::thread &thread : this->threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  this->joined_ = true;
+}
+
+// The loop of every worker.
+void Scheduler::Work(PartitionIndex home) {
+  LOG(INFO) << "Starting dataflow worker " << home;
+  size_t spins = 0;
+  while (!this->stop_.load()) {
+    // Anything written after this point changes the epoch, which keeps us from
+    // parking below.
+    uint64_t epoch = this->epoch_.load();
+
+    // Home partition first, then steal.
+    PartitionIndex victim;
+    bool worked = this->Run(home, home);
+    if (!worked && this->FindVictim(home, &victim)) {
+      worked = this->Run(home, victim);
+    }
+
+    // After running a partition we always look again before parking: messages
+    // written to it while we had it claimed may have been skipped by others.
+    if (worked) {
+      spins = 0;
+      continue;
+    }
+    if (++spins < IDLE_SPINS) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Park.
+    std::unique_lock<std::mutex> lock(this->mtx_);
+    this->sleepers_.fetch_add(1);
+    while (this->epoch_.load() == epoch && !this->stop_.load()) {
+      this->cv_.wait(lock);
+    }
+    this->sleepers_.fetch_sub(1);
+    spins = 0;
+  }
+}
+
+bool Scheduler::Run(PartitionIndex worker, PartitionIndex partition) {
+  Partition &p = *this->partitions_.at(partition);
+  if (p.chan->Depth() == 0 || p.claimed.load(std::memory_order_relaxed) ||
+      p.claimed.exchange(true, std::memory_order_acquire)) {
+    return false;
+  }
+
+  // Releasing the claim publishes the state of the partition's operators to
+  // whichever worker claims it next.
+  std::vector<Channel::Message> messages;
+  bool read = p.chan->TryRead(&messages);
+  if (read) {
+    size_t count = messages.size();
+    this->runner_(partition, std::move(messages));
+    p.processed.fetch_add(count, std::memory_order_relaxed);
+    if (worker != partition) {
+      p.stolen.fetch_add(count, std::memory_order_relaxed);
+      p.steals.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  p.claimed.store(false, std::memory_order_release);
+  return read;
+}
+
+bool Scheduler::FindVictim(PartitionIndex home, PartitionIndex *victim) const {
+  size_t deepest = 0;
+  for (PartitionIndex i = 0; i < this->partitions_.size(); i++) {
+    const Partition &p = *this->partitions_.at(i);
+    if (i == home || p.claimed.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    size_t depth = p.chan->Depth();
+    if (depth > deepest) {
+      deepest = depth;
+      *victim = i;
+    }
+  }
+  return deepest > 0;
+}
+
+// Called after every write to any channel.
+void Scheduler::WakeUp() {
+  this->epoch_.fetch_add(1);
+  if (this->sleepers_.load() > 0) {
+    std::unique_lock<std::mutex> lock(this->mtx_);
+    this->cv_.notify_one();
+  }
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,104 @@
+// A work-stealing scheduler for dataflow partitions.
+//
+// Every partition has a channel, and the messages in a channel must be
+// processed in order by one thread at a time, since they modify the state of
+// that partition's operators. Partitions are thus the units of work: a worker
+// claims a partition, processes everything queued in its channel, and releases
+// it.
+// Every worker has a home partition that it prefers, but idle workers steal
+// other partitions (deepest queue first) rather than waiting, so that a busy
+// partition does not keep the messages of other partitions waiting for the
+// worker it is hogging.
+#ifndef K9DB_DATAFLOW_SCHEDULER_H_
+#define K9DB_DATAFLOW_SCHEDULER_H_
+
+#include <atomic>
+// NOLINTNEXTLINE
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+// NOLINTNEXTLINE
+#include <mutex>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+#include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+class Scheduler {
+ public:
+  // Processes messages read from the channel of the given partition.
+  using Runner =
+      std::function<void(PartitionIndex, std::vector<Channel::Message> &&)>;
+
+  // Statistics of one partition.
+  struct Stats {
+    PartitionIndex partition;
+    // Messages currently queued.
+    uint64_t queued;
+    // Messages processed, and how many of these were processed by a worker
+    // other than the home worker of the partition.
+    uint64_t processed;
+    uint64_t stolen;
+    // Number of times the partition was stolen.
+    uint64_t steals;
+  };
+
+  // One worker is started per channel, with that channel's partition as home.
+  Scheduler(const std::vector<Channel *> &channels, Runner &&runner);
+  ~Scheduler();
+
+  // Not copyable or movable.
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  std::vector<Stats> GetStats() const;
+
+  void Shutdown();
+  void Join();
+
+ private:
+  struct Partition {
+    explicit Partition(Channel *chan)
+        : chan(chan), claimed(false), processed(0), stolen(0), steals(0) {}
+    Channel *chan;
+    // Held by the one worker currently processing this partition.
+    std::atomic<bool> claimed;
+    std::atomic<uint64_t> processed;
+    std::atomic<uint64_t> stolen;
+    std::atomic<uint64_t> steals;
+  };
+
+  // The loop of every worker.
+  void Work(PartitionIndex home);
+  // Claim the partition and process what is in its channel, returns false if
+  // it was already claimed or had nothing queued.
+  bool Run(PartitionIndex worker, PartitionIndex partition);
+  // The unclaimed partition with the most queued messages, other than home.
+  bool FindVictim(PartitionIndex home, PartitionIndex *victim) const;
+
+  // Called after every write to any channel.
+  void WakeUp();
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  Runner runner_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> stop_;
+  bool joined_;
+
+  // Idle workers park until the epoch changes (i.e. something was written).
+  std::atomic<uint64_t> epoch_;
+  std::atomic<size_t> sleepers_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_SCHEDULER_H_
@@ -0,0 +1,131 @@
+#include "k9db/dataflow/scheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+// NOLINTNEXTLINE
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/future.h"
+#include "k9db/dataflow/types.h"
+
+namespace k9db {
+namespace dataflow {
+
+namespace {
+
+Channel::Message MakeMessage(NodeIndex target) {
+  return {0, {}, UNDEFINED_NODE_INDEX, target, Promise::None.Derive()};
+}
+
+std::vector<Channel *> MakeChannels(
+    size_t partitions, std::vector<std::unique_ptr<Channel>> *channels) {
+  std::vector<Channel *> chans;
+  for (size_t i = 0; i < partitions; i++) {
+    channels->push_back(std::make_unique<Channel>(partitions));
+    chans.push_back(channels->back().get());
+  }
+  return chans;
+}
+
+}  // namespace
+
+// Messages of every partition are processed in order, and never by two
+// workers at the same time.
+TEST(SchedulerTest, PartitionOrder) {
+  constexpr size_t kPartitions = 4;
+  constexpr size_t kMessages = 2000;
+  std::vector<std::unique_ptr<Channel>> channels;
+  std::vector<Channel *> chans = MakeChannels(kPartitions, &channels);
+
+  std::vector<size_t> next(kPartitions, 0);
+  std::vector<std::atomic<bool>> running(kPartitions);
+  std::atomic<size_t> total = 0;
+  Scheduler scheduler(chans, [&](PartitionIndex p,
+                                 std::vector<Channel::Message> &&messages) {
+    EXPECT_FALSE(running.at(p).exchange(true));
+    for (Channel::Message &msg : messages) {
+      EXPECT_EQ(msg.target, next.at(p)++);
+    }
+    running.at(p).store(false);
+    total += messages.size();
+  });
+
+  // A single (skewed) client writes most of the messages to partition 0.
+  std::vector<std::thread> clients;
+  for (size_t p = 0; p < kPartitions; p++) {
+    clients.emplace_back([&chans, p]() {
+      size_t count = p == 0 ? kMessages * 4 : kMessages;
+      for (size_t i = 0; i < count; i++) {
+        chans.at(p)->WriteInput(MakeMessage(i));
+      }
+    });
+  }
+  for (std::thread &client : clients) {
+    client.join();
+  }
+  while (total.load() < kMessages * (kPartitions + 3)) {
+    std::this_thread::yield();
+  }
+
+  // Check stats.
+  uint64_t processed = 0;
+  for (const Scheduler::Stats &stats : scheduler.GetStats()) {
+    EXPECT_EQ(stats.queued, 0u);
+    EXPECT_LE(stats.stolen, stats.processed);
+    processed += stats.processed;
+  }
+  EXPECT_EQ(processed, kMessages * (kPartitions + 3));
+  EXPECT_EQ(next.at(0), kMessages * 4);
+
+  scheduler.Shutdown();
+}
+
+// A partition that is busy does not hold up the others, even if it is the
+// home partition of the worker processing it.
+TEST(SchedulerTest, BusyPartition) {
+  constexpr size_t kMessages = 100;
+  std::vector<std::unique_ptr<Channel>> channels;
+  std::vector<Channel *> chans = MakeChannels(2, &channels);
+
+  std::atomic<bool> started = false;
+  std::atomic<bool> release = false;
+  std::atomic<size_t> total = 0;
+  Scheduler scheduler(chans, [&](PartitionIndex p,
+                                 std::vector<Channel::Message> &&messages) {
+    if (p == 0) {
+      started.store(true);
+      while (!release.load()) {
+        std::this_thread::yield();
+      }
+    }
+    total += messages.size();
+  });
+
+  // Keep one worker busy with partition 0.
+  chans.at(0)->WriteInput(MakeMessage(0));
+  while (!started.load()) {
+    std::this_thread::yield();
+  }
+
+  // Partition 1 is processed by the other worker.
+  for (size_t i = 0; i < kMessages; i++) {
+    chans.at(1)->WriteInput(MakeMessage(i));
+  }
+  while (total.load() < kMessages) {
+    std::this_thread::yield();
+  }
+
+  release.store(true);
+  while (total.load() < kMessages + 1) {
+    std::this_thread::yield();
+  }
+  scheduler.Shutdown();
+}
+
+}  // namespace dataflow
+}  // namespace k9db
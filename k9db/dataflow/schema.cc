@@ -156,5 +156,30 @@ SchemaRef SchemaFactory::LIST_INDICES_SCHEMA =
                               sqlast::ColumnDefinition::Type::TEXT},
                           std::vector<ColumnID>{});
 
+SchemaRef SchemaFactory::STORAGE_SETTINGS_SCHEMA =
+    SchemaFactory::Create(std::vector<std::string>{"Setting", "Value"},
+                          std::vector<sqlast::ColumnDefinition::Type>{
+                              sqlast::ColumnDefinition::Type::TEXT,
+                              sqlast::ColumnDefinition::Type::TEXT},
+                          std::vector<ColumnID>{0});
+
+SchemaRef SchemaFactory::SCHEDULER_STATS_SCHEMA = SchemaFactory::Create(
+    std::vector<std::string>{"Partition", "Queued", "Processed", "Stolen",
+                             "Steals"},
+    std::vector<sqlast::ColumnDefinition::Type>{
+        sqlast::ColumnDefinition::Type::UINT,
+        sqlast::ColumnDefinition::Type::UINT,
+        sqlast::ColumnDefinition::Type::UINT,
+        sqlast::ColumnDefinition::Type::UINT,
+        sqlast::ColumnDefinition::Type::UINT},
+    std::vector<ColumnID>{0});
+
+SchemaRef SchemaFactory::VISIBILITY_STATS_SCHEMA =
+    SchemaFactory::Create(std::vector<std::string>{"Metric", "Value"},
+                          std::vector<sqlast::ColumnDefinition::Type>{
+                              sqlast::ColumnDefinition::Type::TEXT,
+                              sqlast::ColumnDefinition::Type::UINT},
+                          std::vector<ColumnID>{0});
+
 }  // namespace dataflow
 }  // namespace k9db
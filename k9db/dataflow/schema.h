@@ -113,6 +113,9 @@ class SchemaFactory {
   static SchemaRef PERF_LIST_SCHEMA;
   static SchemaRef EXPLAIN_QUERY_SCHEMA;
   static SchemaRef LIST_INDICES_SCHEMA;
+  static SchemaRef STORAGE_SETTINGS_SCHEMA;
+  static SchemaRef SCHEDULER_STATS_SCHEMA;
+  static SchemaRef VISIBILITY_STATS_SCHEMA;
 };
 
 }  // namespace dataflow
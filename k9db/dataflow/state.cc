@@ -5,6 +5,7 @@
 
 #include "k9db/dataflow/state.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -19,60 +20,49 @@
 namespace k9db {
 namespace dataflow {
 
-// DataFlowState::Worker.
-DataFlowState::Worker::Worker(size_t id, Channel *chan, DataFlowState *state)
-    : id_(id), state_(state), stop_(false) {
-  this->thread_ = std::thread([this, chan]() {
-    LOG(INFO) << "Starting dataflow worker " << this->id_;
-    while (!this->stop_) {
-      std::vector<Channel::Message> messages = chan->Read();
-      for (Channel::Message &msg : messages) {
-        this->state_->mtx_.lock_shared();
-        auto &flow = this->state_->flows_.at(msg.flow_name);
-        this->state_->mtx_.unlock_shared();
-        Operator *op = flow->GetPartition(this->id_)->GetNode(msg.target);
-        op->ProcessAndForward(msg.source, std::move(msg.records),
-                              std::move(msg.promise));
-      }
-    }
-  });
-}
-DataFlowState::Worker::~Worker() { CHECK(this->stop_); }
-void DataFlowState::Worker::Shutdown() {
-  if (!this->stop_) {
-    LOG(INFO) << "Shutting down dataflow worker " << this->id_;
-    this->stop_ = true;
-    this->state_->channels_.at(this->id_)->Shutdown();
-    this->thread_.join();
-    LOG(INFO) << "Terminated dataflow worker " << this->id_;
-  }
-}
-void DataFlowState::Worker::Join() { this->thread_.join(); }
-
 // DataFlowState.
 // Constructors and destructors.
 DataFlowState::~DataFlowState() { CHECK(this->joined_); }
-DataFlowState::DataFlowState(size_t workers, bool consistent)
-    : workers_(workers), consistent_(consistent), joined_(false) {
-  // Create a channel for every worker.
+DataFlowState::DataFlowState(size_t workers, bool consistent,
+                             bool async_writes, bool checkpoints)
+    : workers_(workers),
+      consistent_(consistent),
+      async_writes_(async_writes),
+      checkpoints_(checkpoints),
+      joined_(false),
+      writes_() {
+  CHECK(consistent || !async_writes) << "Async writes require consistency";
+  CHECK(consistent || !checkpoints) << "Checkpoints require consistency";
+
+  // Create a channel for every partition.
+  std::vector<Channel *> chans;
   for (size_t i = 0; i < workers; i++) {
     this->channels_.emplace_back(std::make_unique<Channel>(workers));
-    this->threads_.emplace_back(
-        std::make_unique<Worker>(i, this->channels_.at(i).get(), this));
+    chans.push_back(this->channels_.back().get());
   }
+  this->batcher_ = std::make_unique<Batcher>(chans, consistent);
+
+  // Start the workers, any worker may process any partition.
+  this->scheduler_ = std::make_unique<Scheduler>(
+      chans, [this](PartitionIndex partition,
+                    std::vector<Channel::Message> &&messages) {
+        for (Channel::Message &msg : messages) {
+          DataFlowGraph *flow = this->flow_table_.Get(msg.flow);
+          Operator *op = flow->GetPartition(partition)->GetNode(msg.target);
+          op->ProcessAndForward(msg.source, std::move(msg.records),
+                                std::move(msg.promise));
+        }
+      });
 }
 
 // Worker related functions.
 void DataFlowState::Shutdown() {
-  for (auto &worker : this->threads_) {
-    worker->Shutdown();
-  }
+  this->writes_.WaitAll();
+  this->scheduler_->Shutdown();
   this->joined_ = true;
 }
 void DataFlowState::Join() {
-  for (auto &worker : this->threads_) {
-    worker->Join();
-  }
+  this->scheduler_->Join();
   this->joined_ = true;
 }
 
@@ -110,14 +100,22 @@ SchemaRef DataFlowState::GetTableSchema(const TableName &table_name) const {
 
 // Manage flows.
 void DataFlowState::AddFlow(const FlowName &name,
-                            std::unique_ptr<DataFlowGraphPartition> &&flow) {
+                            std::unique_ptr<DataFlowGraphPartition> &&flow,
+                            uint64_t partial_budget, bool backfilling) {
   std::unique_lock lock(this->mtx_);
   // Map input names to this flow.
   for (const auto &[input_name, input] : flow->inputs()) {
-    this->flows_per_input_table_[input_name].push_back(name);
+    if (backfilling) {
+      this->backfilling_per_input_table_[input_name]++;
+    } else {
+      this->flows_per_input_table_[input_name].push_back(name);
+    }
     this->all_flows_[input_name].insert(name);
     this->all_tables_[name].insert(input_name);
   }
+  if (backfilling) {
+    this->backfilling_.insert(name);
+  }
 
   // Create a non-owning vector of channels.
   std::vector<Channel *> chans;
@@ -145,11 +143,60 @@ void DataFlowState::AddFlow(const FlowName &name,
   }
 
   // Turn the given partition into a graph with many partitions.
-  auto graph = std::make_unique<DataFlowGraph>(name, this->workers_);
+  FlowIndex index = this->flow_table_.Size();
+  auto graph = std::make_unique<DataFlowGraph>(name, index, this->workers_);
   graph->Initialize(std::move(flow), chans, parents);
+  if (partial_budget > 0) {
+    if (graph->SupportsPartial()) {
+      graph->Partial(partial_budget);
+    } else {
+      LOG(WARNING) << "Flow " << name << " cannot be partial";
+    }
+  }
+  CHECK_EQ(this->flow_table_.Add(graph.get()), index);
   this->flows_.emplace(name, std::move(graph));
 }
 
+void DataFlowState::FinishBackfill(const FlowName &name) {
+  std::unique_lock lock(this->mtx_);
+  CHECK_EQ(this->backfilling_.erase(name), 1u) << "Flow is not backfilling";
+  for (const TableName &input_name : this->flows_.at(name)->Inputs()) {
+    this->flows_per_input_table_[input_name].push_back(name);
+    auto it = this->backfilling_per_input_table_.find(input_name);
+    if (--it->second == 0) {
+      this->backfilling_per_input_table_.erase(it);
+    }
+  }
+}
+
+void DataFlowState::RestartBackfill(
+    const FlowName &name, std::unique_ptr<DataFlowGraphPartition> &&flow) {
+  std::unique_lock lock(this->mtx_);
+  CHECK_EQ(this->backfilling_.count(name), 1u) << "Flow is not backfilling";
+  CHECK(flow->forwards().empty()) << "Cannot backfill a flow over views";
+
+  // Create a non-owning vector of channels.
+  std::vector<Channel *> chans;
+  for (auto &channel : this->channels_) {
+    chans.push_back(channel.get());
+  }
+
+  // The new graph takes the index of the old one.
+  std::unique_ptr<DataFlowGraph> &graph = this->flows_.at(name);
+  FlowIndex index = graph->index();
+  auto replacement =
+      std::make_unique<DataFlowGraph>(name, index, this->workers_);
+  replacement->Initialize(std::move(flow), chans, {});
+  this->flow_table_.Replace(index, replacement.get());
+  graph = std::move(replacement);
+}
+
+void DataFlowState::MarkSynchronous(const FlowName &name) {
+  std::unique_lock lock(this->mtx_);
+  CHECK_EQ(this->flows_.count(name), 1u) << "Flow does not exist";
+  this->synchronous_.insert(name);
+}
+
 const DataFlowGraph &DataFlowState::GetFlow(const FlowName &name) const {
   std::shared_lock lock(this->mtx_);
   return *this->flows_.at(name);
@@ -170,11 +217,25 @@ bool DataFlowState::HasFlow(const FlowName &name) const {
   return this->flows_.count(name) == 1;
 }
 
+bool DataFlowState::IsBackfilling(const FlowName &name) const {
+  std::shared_lock lock(this->mtx_);
+  return this->backfilling_.count(name) == 1;
+}
+
 bool DataFlowState::HasFlowsFor(const TableName &table_name) const {
   std::shared_lock lock(this->mtx_);
   return this->flows_per_input_table_.count(table_name) == 1;
 }
 
+bool DataFlowState::LogsWritesTo(const TableName &table_name) const {
+  std::shared_lock lock(this->mtx_);
+  if (this->backfilling_per_input_table_.count(table_name) == 1) {
+    return true;
+  }
+  return this->checkpoints_ &&
+         this->flows_per_input_table_.count(table_name) == 1;
+}
+
 Record DataFlowState::CreateRecord(const sqlast::Insert &insert_stmt) const {
   // Create an empty positive record with appropriate schema.
   const std::string &table_name = insert_stmt.table_name();
@@ -192,37 +253,74 @@ Record DataFlowState::CreateRecord(const sqlast::Insert &insert_stmt) const {
 }
 
 void DataFlowState::ProcessRecords(const TableName &table_name,
-                                   std::vector<Record> &&records) {
+                                   std::vector<Record> &&records,
+                                   uint64_t *write) {
   if (records.size() > 0 && this->HasFlowsFor(table_name)) {
-    // One future for the entirety of the record processing.
-    Future future(this->consistent_);
+    // One future for the entirety of the record processing. With async
+    // writes, it outlives this call and marks the write visible once resolved.
+    std::unique_ptr<Future> owned;
+    Future *future;
+    uint64_t seq = 0;
+    if (this->async_writes_) {
+      seq = this->writes_.Issue();
+      future = new Future(true);
+    } else {
+      owned = std::make_unique<Future>(this->consistent_);
+      future = owned.get();
+    }
 
-    // Send copies per flow (except last flow).
+    // With async writes, synchronous flows resolve their own future, which
+    // is waited on before returning.
+    Future synchronous(true);
     this->mtx_.lock_shared();
     const std::vector<FlowName> &flow_names =
         this->flows_per_input_table_.at(table_name);
+    std::vector<Future *> futures(flow_names.size(), future);
+    if (this->async_writes_) {
+      for (size_t i = 0; i < flow_names.size(); i++) {
+        if (this->synchronous_.count(flow_names.at(i)) == 1) {
+          futures.at(i) = &synchronous;
+        }
+      }
+    }
     this->mtx_.unlock_shared();
+
+    // Send shared records per flow (except last flow). Records are not
+    // modified inside flows, so all flows can read the same data.
     for (size_t i = 0; i < flow_names.size() - 1; i++) {
       const std::string &flow_name = flow_names.at(i);
-      std::vector<Record> copy;
-      copy.reserve(records.size());
+      std::vector<Record> shared;
+      shared.reserve(records.size());
       for (const Record &r : records) {
-        copy.push_back(r.Copy());
+        shared.push_back(r.Share());
       }
-      this->ProcessRecordsByFlowName(flow_name, table_name, std::move(copy),
-                                     future.GetPromise());
+      this->ProcessRecordsByFlowName(flow_name, table_name, std::move(shared),
+                                     futures.at(i)->GetPromise());
     }
 
     // Move into last flow.
     const std::string &flow_name = flow_names.back();
     this->ProcessRecordsByFlowName(flow_name, table_name, std::move(records),
-                                   future.GetPromise());
+                                   futures.back()->GetPromise());
 
     // Wait for the future to get resolved.
-    future.Wait();
+    if (this->async_writes_) {
+      future->Then([this, seq]() { this->writes_.Complete(seq); });
+      if (write != nullptr) {
+        *write = std::max(*write, seq);
+      }
+    } else {
+      future->Wait();
+    }
+    synchronous.Wait();
   }
 }
 
+void DataFlowState::WaitForWrite(uint64_t write) const {
+  this->writes_.Wait(write);
+}
+void DataFlowState::WaitForWrites() const { this->writes_.WaitAll(); }
+
 void DataFlowState::ProcessRecordsByFlowName(const FlowName &flow_name,
                                              const TableName &table_name,
                                              std::vector<Record> &&records,
@@ -233,10 +331,10 @@ void DataFlowState::ProcessRecordsByFlowName(const FlowName &flow_name,
   auto partitions = flow->PartitionInputs(table_name, std::move(records));
   for (auto &[partition, vec] : partitions) {
     Channel::Message msg = {
-        flow_name, std::move(vec), UNDEFINED_NODE_INDEX,
+        flow->index(), std::move(vec), UNDEFINED_NODE_INDEX,
         flow->GetPartition(partition)->GetInputNode(table_name)->index(),
         promise.Derive()};
-    this->channels_.at(partition)->WriteInput(std::move(msg));
+    this->batcher_->Write(partition, std::move(msg));
   }
   promise.Resolve();
 }
@@ -265,5 +363,37 @@ sql::SqlResult DataFlowState::FlowDebug(const std::string &flow_name) const {
                                           flow->DebugRecords()));
 }
 
+sql::SqlResult DataFlowState::SchedulerStats() const {
+  const SchemaRef &schema = SchemaFactory::SCHEDULER_STATS_SCHEMA;
+  std::vector<Record> records;
+  for (const Scheduler::Stats &stats : this->scheduler_->GetStats()) {
+    records.emplace_back(schema, true, static_cast<uint64_t>(stats.partition),
+                         stats.queued, stats.processed, stats.stolen,
+                         stats.steals);
+  }
+  return sql::SqlResult(
+      sql::SqlResultSet("#SCHEDULER", schema, std::move(records)));
+}
+
+sql::SqlResult DataFlowState::VisibilityStats() const {
+  const SchemaRef &schema = SchemaFactory::VISIBILITY_STATS_SCHEMA;
+  VisibilityTracker::Stats stats = this->writes_.GetStats();
+  std::vector<Record> records;
+  records.emplace_back(schema, true, std::make_unique<std::string>("Issued"),
+                       stats.issued);
+  records.emplace_back(schema, true, std::make_unique<std::string>("Visible"),
+                       stats.visible);
+  records.emplace_back(schema, true, std::make_unique<std::string>("Pending"),
+                       stats.issued - stats.visible);
+  records.emplace_back(schema, true,
+                       std::make_unique<std::string>("Last lag (us)"),
+                       stats.last_lag_us);
+  records.emplace_back(schema, true,
+                       std::make_unique<std::string>("Max lag (us)"),
+                       stats.max_lag_us);
+  return sql::SqlResult(
+      sql::SqlResultSet("#VISIBILITY", schema, std::move(records)));
+}
+
 }  // namespace dataflow
 }  // namespace k9db
@@ -3,23 +3,26 @@
 // The state includes the currently installed flows, including their operators
 // and state.
 
-#include <atomic>
-#include <list>
+#include <cstdint>
 #include <memory>
-#include <string>
 // NOLINTNEXTLINE
-#include <thread>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "k9db/dataflow/batcher.h"
 #include "k9db/dataflow/channel.h"
+#include "k9db/dataflow/flow_table.h"
 #include "k9db/dataflow/graph.h"
 #include "k9db/dataflow/graph_partition.h"
 #include "k9db/dataflow/operator.h"
 #include "k9db/dataflow/ops/input.h"
 #include "k9db/dataflow/record.h"
+#include "k9db/dataflow/scheduler.h"
 #include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/visibility.h"
 #include "k9db/sql/result.h"
 #include "k9db/sqlast/ast.h"
 
@@ -34,23 +37,14 @@ using TableName = std::string;
 using FlowName = std::string;
 
 class DataFlowState {
- private:
-  class Worker {
-   public:
-    Worker(size_t id, Channel *chan, DataFlowState *state);
-    ~Worker();
-    void Shutdown();
-    void Join();
-
-   private:
-    size_t id_;
-    DataFlowState *state_;
-    std::thread thread_;
-    std::atomic<bool> stop_;
-  };
-
  public:
-  explicit DataFlowState(size_t workers, bool consistent);
+  // With async_writes (requires consistent), writes return before flows
+  // process them, and readers wait for the writes they need to see (see
+  // WaitForWrite()).
+  // With checkpoints (requires consistent), flows may be checkpointed, and all
+  // writes to their inputs are logged so they can catch up from a checkpoint.
+  DataFlowState(size_t workers, bool consistent, bool async_writes = false,
+                bool checkpoints = false);
   ~DataFlowState();
 
   // Manage schemas.
@@ -61,23 +55,52 @@ class DataFlowState {
   SchemaRef GetTableSchema(const TableName &table_name) const;
 
   // Add and manage flows.
+  // If partial_budget > 0 and the flow supports it, the flow is made partial
+  // with that memory budget (see DataFlowGraph::Partial()).
+  // A backfilling flow is not fed updates to its input tables until
+  // FinishBackfill() is called, but writes to these tables are still logged
+  // so it can catch up with them.
   void AddFlow(const FlowName &name,
-               std::unique_ptr<DataFlowGraphPartition> &&flow);
+               std::unique_ptr<DataFlowGraphPartition> &&flow,
+               uint64_t partial_budget = 0, bool backfilling = false);
+  void FinishBackfill(const FlowName &name);
+  // Replaces the graph of a backfilling flow by a new, empty one, so that the
+  // flow can be backfilled again from scratch. The flow must not be
+  // processing any records.
+  void RestartBackfill(const FlowName &name,
+                       std::unique_ptr<DataFlowGraphPartition> &&flow);
+  // Synchronous flows process writes before the writes return, even with
+  // async_writes, e.g. data subject indices, which decide the ownership of
+  // subsequent writes.
+  void MarkSynchronous(const FlowName &name);
 
   const DataFlowGraph &GetFlow(const FlowName &name) const;
 
   std::vector<std::string> GetFlows() const;
 
   bool HasFlow(const FlowName &name) const;
+  bool IsBackfilling(const FlowName &name) const;
 
   bool HasFlowsFor(const TableName &table_name) const;
+  // Whether writes to this table need to be logged (see Session::LogRecords()):
+  // only while a flow over it is backfilling, or if flows are checkpointed.
+  bool LogsWritesTo(const TableName &table_name) const;
 
   // Process raw data from sharder and use it to update flows.
   Record CreateRecord(const sqlast::Insert &insert_stmt) const;
 
   // Process raw data from sharder and use it to update flows.
+  // If given, write is advanced to the sequence number of this write, which
+  // can be waited on to read the write from views (other than synchronous
+  // flows, which reflect it when this returns).
   void ProcessRecords(const TableName &table_name,
-                      std::vector<Record> &&records);
+                      std::vector<Record> &&records, uint64_t *write = nullptr);
+
+  // Blocks until the given write (see ProcessRecords()) is visible in views.
+  // Only ever blocks with async writes.
+  void WaitForWrite(uint64_t write) const;
+  // Blocks until all writes so far are visible in views.
+  void WaitForWrites() const;
 
   void ProcessRecordsByFlowName(const FlowName &flow_name,
                                 const TableName &table_name,
@@ -86,6 +109,8 @@ class DataFlowState {
 
   sql::SqlResult SizeInMemory() const;
   sql::SqlResult FlowDebug(const std::string &flow_name) const;
+  sql::SqlResult SchedulerStats() const;
+  sql::SqlResult VisibilityStats() const;
 
   // Get all views that will be affected by a table update.
   std::vector<FlowName> GetFlowsAffectBy(const TableName &table) const {
@@ -107,6 +132,9 @@ class DataFlowState {
 
   // Shutdown all worker threads.
   size_t workers() const { return this->workers_; }
+  bool consistent() const { return this->consistent_; }
+  bool async_writes() const { return this->async_writes_; }
+  bool checkpoints() const { return this->checkpoints_; }
   void Shutdown();
   void Join();
 
@@ -114,11 +142,18 @@ class DataFlowState {
   // The number of worker threads.
   size_t workers_;
   bool consistent_;
+  bool async_writes_;
+  bool checkpoints_;
   bool joined_;
 
-  // Channel for every worker.
+  // Writes that were acknowledged before they were processed.
+  VisibilityTracker writes_;
+
+  // Channel for every partition, and the workers processing them.
   std::vector<std::unique_ptr<Channel>> channels_;
-  std::list<std::unique_ptr<Worker>> threads_;
+  std::unique_ptr<Scheduler> scheduler_;
+  // Batches client inputs to channels.
+  std::unique_ptr<Batcher> batcher_;
 
   // Maps every table to its logical schema.
   // The logical schema is the contract between client code and our DB.
@@ -128,7 +163,14 @@ class DataFlowState {
 
   // DataFlow graphs and views.
   std::unordered_map<FlowName, std::unique_ptr<DataFlowGraph>> flows_;
+  // The same graphs by index, for workers (lock-free).
+  FlowTable flow_table_;
   std::unordered_map<TableName, std::vector<FlowName>> flows_per_input_table_;
+  // Flows still being backfilled, and the tables they need logged.
+  std::unordered_set<FlowName> backfilling_;
+  std::unordered_map<TableName, size_t> backfilling_per_input_table_;
+  // Flows processed synchronously with async_writes.
+  std::unordered_set<FlowName> synchronous_;
   // This includes flows_per_input_table_ and their nested views.
   std::unordered_map<TableName, std::unordered_set<FlowName>> all_flows_;
   std::unordered_map<FlowName, std::unordered_set<TableName>> all_tables_;
@@ -7,6 +7,7 @@
 namespace k9db {
 namespace dataflow {
 
+typedef uint32_t FlowIndex;
 typedef uint32_t NodeIndex;
 typedef uint32_t PartitionIndex;
 typedef uint32_t ColumnID;
@@ -14,6 +15,8 @@ typedef std::vector<ColumnID> PartitionKey;
 
 static const NodeIndex UNDEFINED_NODE_INDEX =
     std::numeric_limits<NodeIndex>::max();
+static const FlowIndex UNDEFINED_FLOW_INDEX =
+    std::numeric_limits<FlowIndex>::max();
 
 }  // namespace dataflow
 }  // namespace k9db
@@ -0,0 +1,64 @@
+#include "k9db/dataflow/visibility.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace k9db {
+namespace dataflow {
+
+uint64_t VisibilityTracker::Issue() {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  uint64_t seq = ++this->issued_;
+  this->pending_.emplace(seq, std::make_pair(Clock::now(), false));
+  return seq;
+}
+
+void VisibilityTracker::Complete(uint64_t seq) {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  auto it = this->pending_.find(seq);
+  CHECK(it != this->pending_.end()) << "Write " << seq << " is not pending";
+  it->second.second = true;
+
+  // Advance over the prefix of processed writes.
+  Clock::time_point now = Clock::now();
+  uint64_t visible = this->visible_.load();
+  while (!this->pending_.empty() && this->pending_.begin()->second.second) {
+    auto first = this->pending_.begin();
+    uint64_t lag = std::chrono::duration_cast<std::chrono::microseconds>(
+                       now - first->second.first)
+                       .count();
+    this->last_lag_us_ = lag;
+    this->max_lag_us_ = std::max(this->max_lag_us_, lag);
+    visible = first->first;
+    this->pending_.erase(first);
+  }
+  if (visible != this->visible_.load()) {
+    this->visible_.store(visible);
+    this->cv_.notify_all();
+  }
+}
+
+void VisibilityTracker::Wait(uint64_t seq) const {
+  if (this->visible_.load() >= seq) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  this->cv_.wait(lock, [&]() { return this->visible_.load() >= seq; });
+}
+
+void VisibilityTracker::WaitAll() const {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  uint64_t seq = this->issued_;
+  this->cv_.wait(lock, [&]() { return this->visible_.load() >= seq; });
+}
+
+VisibilityTracker::Stats VisibilityTracker::GetStats() const {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  return {this->issued_, this->visible_.load(), this->last_lag_us_,
+          this->max_lag_us_};
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -0,0 +1,72 @@
+// Tracks writes that are acknowledged before the dataflow processes them
+// (asynchronous writes), so that readers can wait for specific writes to be
+// visible in views.
+//
+// Writes are numbered in the order they are issued, but may be processed out
+// of order. A write is visible once it and every write before it has been
+// processed.
+#ifndef K9DB_DATAFLOW_VISIBILITY_H_
+#define K9DB_DATAFLOW_VISIBILITY_H_
+
+#include <atomic>
+#include <chrono>
+// NOLINTNEXTLINE
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+// NOLINTNEXTLINE
+#include <mutex>
+#include <utility>
+
+namespace k9db {
+namespace dataflow {
+
+class VisibilityTracker {
+ public:
+  struct Stats {
+    uint64_t issued;
+    uint64_t visible;
+    // Time between issuing a write and it becoming visible.
+    uint64_t last_lag_us;
+    uint64_t max_lag_us;
+  };
+
+  VisibilityTracker()
+      : issued_(0), visible_(0), pending_(), last_lag_us_(0), max_lag_us_(0) {}
+
+  // Not copyable or movable.
+  VisibilityTracker(const VisibilityTracker &) = delete;
+  VisibilityTracker &operator=(const VisibilityTracker &) = delete;
+
+  // The sequence number of a new write (starting from 1).
+  uint64_t Issue();
+  // The write was processed by all the flows it affects (from any thread).
+  void Complete(uint64_t seq);
+
+  // Blocks until the given write (and all writes before it) is visible. Never
+  // blocks for 0, or if the write is already visible.
+  void Wait(uint64_t seq) const;
+  // Blocks until every write issued so far is visible.
+  void WaitAll() const;
+
+  Stats GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  mutable std::mutex mtx_;
+  mutable std::condition_variable cv_;
+  uint64_t issued_;
+  // Every write up to here is visible.
+  std::atomic<uint64_t> visible_;
+  // Writes that are not visible yet, with the time they were issued and
+  // whether they were processed.
+  std::map<uint64_t, std::pair<Clock::time_point, bool>> pending_;
+  uint64_t last_lag_us_;
+  uint64_t max_lag_us_;
+};
+
+}  // namespace dataflow
+}  // namespace k9db
+
+#endif  // K9DB_DATAFLOW_VISIBILITY_H_
@@ -0,0 +1,54 @@
+#include "k9db/dataflow/visibility.h"
+
+#include <atomic>
+// NOLINTNEXTLINE
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace k9db {
+namespace dataflow {
+
+TEST(VisibilityTest, InOrder) {
+  VisibilityTracker tracker;
+  EXPECT_EQ(tracker.Issue(), 1u);
+  EXPECT_EQ(tracker.Issue(), 2u);
+  tracker.Wait(0);
+
+  tracker.Complete(1);
+  tracker.Wait(1);
+  VisibilityTracker::Stats stats = tracker.GetStats();
+  EXPECT_EQ(stats.issued, 2u);
+  EXPECT_EQ(stats.visible, 1u);
+
+  tracker.Complete(2);
+  tracker.WaitAll();
+  stats = tracker.GetStats();
+  EXPECT_EQ(stats.visible, 2u);
+  EXPECT_LE(stats.last_lag_us, stats.max_lag_us);
+}
+
+// A write is only visible once all writes before it are.
+TEST(VisibilityTest, OutOfOrder) {
+  VisibilityTracker tracker;
+  tracker.Issue();
+  tracker.Issue();
+  tracker.Issue();
+  tracker.Complete(3);
+  tracker.Complete(2);
+  EXPECT_EQ(tracker.GetStats().visible, 0u);
+
+  std::atomic<bool> visible = false;
+  std::thread reader([&]() {
+    tracker.Wait(2);
+    visible.store(true);
+  });
+  EXPECT_FALSE(visible.load());
+  tracker.Complete(1);
+  reader.join();
+  EXPECT_TRUE(visible.load());
+  EXPECT_EQ(tracker.GetStats().visible, 3u);
+}
+
+}  // namespace dataflow
+}  // namespace k9db
@@ -9,15 +9,23 @@
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "k9db/dataflow/graph.h"
 #include "k9db/explain.h"
 #include "k9db/planner/planner.h"
 #include "k9db/shards/sqlengine/engine.h"
+#include "k9db/sqlast/ast.h"
 #include "k9db/sqlast/command.h"
 #include "k9db/util/status.h"
 #include "k9db/util/upgradable_lock.h"
 
+DEFINE_bool(checkpoint_views, false,
+            "Checkpoint views on clean shutdown (consistent only), this logs "
+            "all writes to their input tables");
+DEFINE_bool(async_writes, false,
+            "Acknowledge writes before views reflect them (consistent only)");
+
 namespace k9db {
 
 namespace {
@@ -100,6 +108,20 @@ absl::StatusOr<std::optional<SqlResult>> SpecialStatements(
     if (absl::StartsWith(split.at(1), "INDICES")) {
       return connection->state->ListIndices();
     }
+    if (absl::StartsWith(split.at(1), "STORAGE")) {
+      return connection->state->StorageSettings();
+    }
+    if (absl::StartsWith(split.at(1), "SCHEDULER")) {
+      return connection->state->SchedulerStats();
+    }
+    if (absl::StartsWith(split.at(1), "VISIBILITY")) {
+      return connection->state->VisibilityStats();
+    }
+  }
+  if (absl::StartsWith(sql, "CHECKPOINT")) {
+    MOVE_OR_RETURN(SqlResult result,
+                   shards::sqlengine::CheckpointViews(connection));
+    return result;
   }
   if (absl::StartsWith(sql, "CTX")) {
     std::vector<std::string> split = absl::StrSplit(sql, ' ');
@@ -129,7 +151,14 @@ bool initialize(size_t workers, bool consistent, const std::string &db_name,
   }
 
   // Initialize the global state including the rocksdb interface.
-  K9DB_STATE = new State(workers, consistent);
+  if (FLAGS_async_writes && !consistent) {
+    LOG(WARNING) << "Async writes are disabled for inconsistent dataflows";
+  }
+  if (FLAGS_checkpoint_views && !consistent) {
+    LOG(WARNING) << "Checkpoints are disabled for inconsistent dataflows";
+  }
+  K9DB_STATE = new State(workers, consistent, FLAGS_async_writes && consistent,
+                         FLAGS_checkpoint_views && consistent);
   std::vector<std::string> stmts = K9DB_STATE->Initialize(db_name, db_path);
 
   // Create a temporary session in order to reload the pre-existing tables and
@@ -231,6 +260,18 @@ void shutdown_planner(bool shutdown_jvm) {
 
 bool shutdown(bool shutdown_jvm) {
   if (K9DB_STATE != nullptr) {
+    // Checkpoint views so they are restored rather than recomputed on restart.
+    if (K9DB_STATE->DataflowState().checkpoints()) {
+      Connection connection;
+      if (open(&connection)) {
+        absl::StatusOr<SqlResult> status =
+            shards::sqlengine::CheckpointViews(&connection);
+        if (!status.ok()) {
+          LOG(WARNING) << "Cannot checkpoint views: " << status.status();
+        }
+        close(&connection);
+      }
+    }
     shutdown_planner(shutdown_jvm);
     delete K9DB_STATE;
     K9DB_STATE = nullptr;
@@ -268,6 +309,7 @@ absl::StatusOr<const PreparedStatement *> prepare(Connection *connection,
       const auto &dstate = state->DataflowState();
       MOVE_OR_RETURN(prepared::CanonicalDescriptor descriptor,
                      prepared::MakeInsertCanonical(canonical, dstate));
+      prepared::ParseCanonical(&descriptor);
       // Store descriptor for future queries.
       state->AddCanonicalStatement(canonical, std::move(descriptor));
     } else {
@@ -287,6 +329,7 @@ absl::StatusOr<const PreparedStatement *> prepare(Connection *connection,
       } else {
         prepared::FromTables(canonical, state->DataflowState(), &descriptor);
       }
+      prepared::ParseCanonical(&descriptor);
       // Store descriptor for future queries.
       state->AddCanonicalStatement(canonical, std::move(descriptor));
     }
@@ -312,6 +355,12 @@ absl::StatusOr<SqlResult> exec(Connection *connection, size_t stmt_id,
   const prepared::PreparedStatementDescriptor &stmt =
       connection->stmts.at(stmt_id);
   try {
+    // Bind args into the statement parsed when it was prepared.
+    if (stmt.canonical->statement != nullptr) {
+      std::unique_ptr<sqlast::AbstractStatement> statement =
+          prepared::BindStatement(stmt, args);
+      return shards::sqlengine::Shard(*statement, connection);
+    }
     sqlast::SQLCommand sql = prepared::PopulateStatement(stmt, args);
     return shards::sqlengine::Shard(sql, connection);
   } catch (std::exception &e) {
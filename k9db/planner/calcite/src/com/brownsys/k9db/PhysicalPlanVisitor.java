@@ -9,9 +9,13 @@ import com.brownsys.k9db.operators.MatViewOperatorFactory;
 import com.brownsys.k9db.operators.ProjectOperatorFactory;
 import com.brownsys.k9db.operators.UnionOperatorFactory;
 import java.util.ArrayList;
+import java.util.IdentityHashMap;
 import java.util.Stack;
+import org.apache.calcite.plan.RelOptUtil;
+import org.apache.calcite.rel.RelFieldCollation;
 import org.apache.calcite.rel.RelNode;
 import org.apache.calcite.rel.RelShuttleImpl;
+import org.apache.calcite.rel.core.AggregateCall;
 import org.apache.calcite.rel.core.TableScan;
 import org.apache.calcite.rel.logical.LogicalAggregate;
 import org.apache.calcite.rel.logical.LogicalFilter;
@@ -19,16 +23,20 @@ import org.apache.calcite.rel.logical.LogicalJoin;
 import org.apache.calcite.rel.logical.LogicalProject;
 import org.apache.calcite.rel.logical.LogicalSort;
 import org.apache.calcite.rel.logical.LogicalUnion;
+import org.apache.calcite.util.ImmutableBitSet;
 import org.apache.calcite.util.Pair;
 
 public class PhysicalPlanVisitor extends RelShuttleImpl {
   private final Stack<ArrayList<Integer>> childrenOperators;
   private final Stack<ArrayList<PlanningContext>> childrenContexts;
+  // The output columns of every operator that are used by the operators above it.
+  private final IdentityHashMap<RelNode, ImmutableBitSet> usedColumns;
 
   public PhysicalPlanVisitor(DataFlowGraphLibrary.DataFlowGraphGenerator generator) {
     PlanningContext.useGenerator(generator);
     this.childrenOperators = new Stack<ArrayList<Integer>>();
     this.childrenContexts = new Stack<ArrayList<PlanningContext>>();
+    this.usedColumns = new IdentityHashMap<RelNode, ImmutableBitSet>();
   }
 
   /*
@@ -39,6 +47,9 @@ public class PhysicalPlanVisitor extends RelShuttleImpl {
     this.childrenOperators.push(new ArrayList<Integer>());
     this.childrenContexts.push(new ArrayList<PlanningContext>());
 
+    // Find which columns are used downstream, so that joins only keep these in their state.
+    this.collectUsedColumns(plan, ImmutableBitSet.range(plan.getRowType().getFieldCount()));
+
     // Start visiting.
     plan.accept(this);
 
@@ -56,6 +67,58 @@ public class PhysicalPlanVisitor extends RelShuttleImpl {
     }
   }
 
+  /*
+   * Finds the columns used by the parents of every operator, top down.
+   */
+  private void collectUsedColumns(RelNode node, ImmutableBitSet used) {
+    ImmutableBitSet previous = this.usedColumns.get(node);
+    if (previous != null) {
+      if (previous.contains(used)) {
+        return;
+      }
+      used = used.union(previous);
+    }
+    this.usedColumns.put(node, used);
+
+    if (node instanceof LogicalProject) {
+      // All projected expressions are computed, even unused ones.
+      LogicalProject project = (LogicalProject) node;
+      this.collectUsedColumns(
+          project.getInput(), RelOptUtil.InputFinder.bits(project.getProjects(), null));
+    } else if (node instanceof LogicalFilter) {
+      LogicalFilter filter = (LogicalFilter) node;
+      this.collectUsedColumns(
+          filter.getInput(), used.union(RelOptUtil.InputFinder.bits(filter.getCondition())));
+    } else if (node instanceof LogicalJoin) {
+      LogicalJoin join = (LogicalJoin) node;
+      ImmutableBitSet all = used.union(RelOptUtil.InputFinder.bits(join.getCondition()));
+      int leftCount = join.getLeft().getRowType().getFieldCount();
+      int count = join.getRowType().getFieldCount();
+      this.collectUsedColumns(join.getLeft(), all.get(0, leftCount));
+      this.collectUsedColumns(join.getRight(), all.get(leftCount, count).shift(-leftCount));
+    } else if (node instanceof LogicalAggregate) {
+      LogicalAggregate aggregate = (LogicalAggregate) node;
+      ImmutableBitSet.Builder builder = aggregate.getGroupSet().rebuild();
+      for (AggregateCall call : aggregate.getAggCallList()) {
+        builder.addAll(call.getArgList());
+      }
+      this.collectUsedColumns(aggregate.getInput(), builder.build());
+    } else if (node instanceof LogicalSort) {
+      LogicalSort sort = (LogicalSort) node;
+      ImmutableBitSet.Builder builder = used.rebuild();
+      for (RelFieldCollation collation : sort.getCollation().getFieldCollations()) {
+        builder.set(collation.getFieldIndex());
+      }
+      this.collectUsedColumns(sort.getInput(), builder.build());
+    } else {
+      // Unions, table scans, and anything else: all input columns are used.
+      for (RelNode input : node.getInputs()) {
+        this.collectUsedColumns(
+            input, ImmutableBitSet.range(input.getRowType().getFieldCount()));
+      }
+    }
+  }
+
   /*
    * Actual planning code.
    */
@@ -102,7 +165,8 @@ public class PhysicalPlanVisitor extends RelShuttleImpl {
     PlanningContext context = pair.right;
 
     JoinOperatorFactory joinFactory = new JoinOperatorFactory(context);
-    return new Pair<>(joinFactory.createOperator(join, children), context);
+    return new Pair<>(
+        joinFactory.createOperator(join, children, this.usedColumns.get(join)), context);
   }
 
   private Pair<ArrayList<Integer>, PlanningContext> analyzeLogicalProject(LogicalProject project) {
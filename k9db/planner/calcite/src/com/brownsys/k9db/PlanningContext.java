@@ -38,6 +38,9 @@ public class PlanningContext {
   // column x, and disregards column y. Calcite on the other hand keeps both.
   // This map is responsible for mapping a Calcite column index to the corresponding
   // column's index in k9db. Note: y will be mapped to x.
+  // Columns that a join does not keep in its state (because nothing downstream uses them) are
+  // mapped to PRUNED.
+  public static final int PRUNED = -1;
   private final HashMap<Integer, Integer> columnTranslation;
   private final ArrayList<Integer> keyColumns;
   private final SharedContext shared;
@@ -63,14 +66,14 @@ public class PlanningContext {
       case JOIN:
         assert this.orderColumns.isEmpty();
         assert other.orderColumns.isEmpty();
-        HashSet<Integer> ids = new HashSet<Integer>();
-        for (Map.Entry<Integer, Integer> entry : this.columnTranslation.entrySet()) {
-          ids.add(entry.getValue());
-        }
         int leftCount = this.columnTranslation.size();
-        int realCount = ids.size();
+        int realCount = this.getK9dbColumnCount();
         for (Map.Entry<Integer, Integer> entry : other.columnTranslation.entrySet()) {
-          this.columnTranslation.put(entry.getKey() + leftCount, entry.getValue() + realCount);
+          int k9dbIndex = entry.getValue();
+          if (k9dbIndex != PRUNED) {
+            k9dbIndex += realCount;
+          }
+          this.columnTranslation.put(entry.getKey() + leftCount, k9dbIndex);
         }
         for (int key : other.keyColumns) {
           this.keyColumns.add(realCount + key);
@@ -125,11 +128,21 @@ public class PlanningContext {
   // Duplicated columns (because of a join).
   public int getK9dbColumnCount() {
     HashSet<Integer> k9dbIndices = new HashSet<Integer>(this.columnTranslation.values());
+    k9dbIndices.remove(PRUNED);
     return k9dbIndices.size();
   }
 
   public int getK9dbIndex(int calciteIndex) {
-    return this.columnTranslation.get(calciteIndex);
+    int k9dbIndex = this.columnTranslation.get(calciteIndex);
+    if (k9dbIndex == PRUNED) {
+      throw new IllegalStateException("Column " + calciteIndex + " was pruned by a join");
+    }
+    return k9dbIndex;
+  }
+
+  // Whether the given Calcite column is still in the k9db schema.
+  public boolean isPruned(int calciteIndex) {
+    return this.columnTranslation.get(calciteIndex) == PRUNED;
   }
 
   public void setDuplicate(int duplicateK9dbIndex, int actualK9dbIndex) {
@@ -171,6 +184,40 @@ public class PlanningContext {
     this.orderColumns = modOrderColumns;
   }
 
+  // A join dropped the given k9db column from its output: it is not used downstream.
+  public void setPruned(int prunedK9dbIndex) {
+    HashSet<Integer> keys = new HashSet<Integer>(this.columnTranslation.keySet());
+    for (int key : keys) {
+      int k9dbIndex = this.columnTranslation.get(key);
+      if (k9dbIndex == prunedK9dbIndex) {
+        this.columnTranslation.put(key, PRUNED);
+      } else if (k9dbIndex > prunedK9dbIndex) {
+        this.columnTranslation.put(key, k9dbIndex - 1);
+      }
+    }
+
+    for (int i = 0; i < this.keyColumns.size(); i++) {
+      int key = this.keyColumns.get(i);
+      if (key == prunedK9dbIndex) {
+        throw new IllegalArgumentException("Key column is pruned by join");
+      } else if (key > prunedK9dbIndex) {
+        this.keyColumns.set(i, key - 1);
+      }
+    }
+
+    HashSet<Integer> modOrderColumns = new HashSet<Integer>();
+    for (Integer col : this.orderColumns) {
+      if (col == prunedK9dbIndex) {
+        throw new IllegalArgumentException("Compare column is pruned by join");
+      } else if (col > prunedK9dbIndex) {
+        modOrderColumns.add(col - 1);
+      } else {
+        modOrderColumns.add(col);
+      }
+    }
+    this.orderColumns = modOrderColumns;
+  }
+
   public void setColumnTranslation(
       HashMap<Integer, Integer> translation, HashMap<Integer, Integer> keyTranslation) {
     this.columnTranslation.clear();
@@ -49,6 +49,16 @@ public class AggregateOperatorFactory {
           assert aggCall.getArgList().size() == 1;
           aggCol = this.context.getK9dbIndex(aggCall.getArgList().get(0));
           break;
+        case MIN:
+          functionEnum = DataFlowGraphLibrary.MIN;
+          assert aggCall.getArgList().size() == 1;
+          aggCol = this.context.getK9dbIndex(aggCall.getArgList().get(0));
+          break;
+        case MAX:
+          functionEnum = DataFlowGraphLibrary.MAX;
+          assert aggCall.getArgList().size() == 1;
+          aggCol = this.context.getK9dbIndex(aggCall.getArgList().get(0));
+          break;
         default:
           throw new IllegalArgumentException("Invalid aggregate function");
       }
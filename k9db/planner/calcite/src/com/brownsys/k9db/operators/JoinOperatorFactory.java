@@ -3,13 +3,17 @@ package com.brownsys.k9db.operators;
 import com.brownsys.k9db.PlanningContext;
 import com.brownsys.k9db.nativelib.DataFlowGraphLibrary;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.HashSet;
 import java.util.List;
+import java.util.TreeSet;
+import org.apache.calcite.plan.RelOptUtil;
 import org.apache.calcite.rel.logical.LogicalJoin;
 import org.apache.calcite.rex.RexCall;
 import org.apache.calcite.rex.RexInputRef;
 import org.apache.calcite.rex.RexNode;
 import org.apache.calcite.sql.SqlKind;
+import org.apache.calcite.util.ImmutableBitSet;
 
 public class JoinOperatorFactory {
   private final PlanningContext context;
@@ -18,39 +22,134 @@ public class JoinOperatorFactory {
     this.context = context;
   }
 
-  public int createOperator(LogicalJoin join, ArrayList<Integer> children) {
+  // usedColumns are the (Calcite) output columns of the join that are used downstream, or null if
+  // they are not known. Columns of either side that are neither used nor join columns are not kept
+  // in the join state.
+  public int createOperator(
+      LogicalJoin join, ArrayList<Integer> children, ImmutableBitSet usedColumns) {
     // Find the size of the schema of the left relation.
     int leftCalciteCount = join.getLeft().getRowType().getFieldCount();
     int leftK9dbCount = 0;
     HashSet<Integer> dups = new HashSet<>();
     for (int i = 0; i < leftCalciteCount; i++) {
+      if (this.context.isPruned(i)) {
+        continue;
+      }
       int p = this.context.getK9dbIndex(i);
       if (!dups.contains(p)) {
         dups.add(p);
         leftK9dbCount++;
       }
     }
+    int rightK9dbCount = this.context.getK9dbColumnCount() - leftK9dbCount;
 
     // Visit the join condition, extract the column ids for the left and right relation.
-    RexNode condition = join.getCondition();
+    // The condition is either a single == or a conjunction (AND) of ==.
+    List<RexNode> conjuncts = RelOptUtil.conjunctions(join.getCondition());
+    if (conjuncts.isEmpty()) {
+      throw new IllegalArgumentException("Join without an equality condition");
+    }
+    int[] leftK9dbIndices = new int[conjuncts.size()];
+    int[] rightK9dbIndices = new int[conjuncts.size()];
+    for (int i = 0; i < conjuncts.size(); i++) {
+      // Only support == for now.
+      RexNode condition = conjuncts.get(i);
+      if (!condition.isA(SqlKind.EQUALS)) {
+        throw new IllegalArgumentException("Unsupported join condition " + condition);
+      }
+      List<RexNode> operands = ((RexCall) condition).getOperands();
 
-    // Only support == for now.
-    assert condition.isA(SqlKind.EQUALS);
-    List<RexNode> operands = ((RexCall) condition).getOperands();
-    assert operands.size() == 2;
+      // Join condition must be over a column per input relation.
+      RexNode leftCondition = operands.get(0);
+      RexNode rightCondition = operands.get(1);
+      if (!(leftCondition instanceof RexInputRef) || !(rightCondition instanceof RexInputRef)) {
+        throw new IllegalArgumentException("Join condition must compare two columns " + condition);
+      }
+
+      int leftCalciteIndex = ((RexInputRef) leftCondition).getIndex();
+      int rightCalciteIndex = ((RexInputRef) rightCondition).getIndex();
+      if (leftCalciteIndex >= leftCalciteCount) {
+        // Condition is written as right == left.
+        int tmp = leftCalciteIndex;
+        leftCalciteIndex = rightCalciteIndex;
+        rightCalciteIndex = tmp;
+      }
+      if (leftCalciteIndex >= leftCalciteCount || rightCalciteIndex < leftCalciteCount) {
+        throw new IllegalArgumentException("Join condition must compare two columns " + condition);
+      }
+      leftK9dbIndices[i] = this.context.getK9dbIndex(leftCalciteIndex);
+      rightK9dbIndices[i] = this.context.getK9dbIndex(rightCalciteIndex);
+    }
 
-    // Join condition must be over a column per input relation.
-    RexNode leftCondition = operands.get(0);
-    RexNode rightCondition = operands.get(1);
-    assert leftCondition instanceof RexInputRef;
-    assert rightCondition instanceof RexInputRef;
+    // Find the columns to keep in the join state: the columns used downstream, the join columns,
+    // and the key and compare columns of the matview. k9db indices are over the concatenation of
+    // the left and right schemas here.
+    TreeSet<Integer> kept = new TreeSet<>();
+    if (usedColumns == null) {
+      for (int i = 0; i < leftK9dbCount + rightK9dbCount; i++) {
+        kept.add(i);
+      }
+    } else {
+      for (int calciteIndex : usedColumns) {
+        kept.add(this.context.getK9dbIndex(calciteIndex));
+      }
+    }
+    for (int i = 0; i < conjuncts.size(); i++) {
+      kept.add(leftK9dbIndices[i]);
+      kept.add(rightK9dbIndices[i]);
+    }
+    for (int key : this.context.getMatViewKeys()) {
+      kept.add(key);
+    }
+    kept.addAll(this.context.getOrderColumns());
+    // An empty keep list keeps all the columns of that side.
+    int[] leftKeep = new int[0];
+    int[] rightKeep = new int[0];
+    if (kept.headSet(leftK9dbCount).size() < leftK9dbCount) {
+      leftKeep = new int[kept.headSet(leftK9dbCount).size()];
+      int i = 0;
+      for (int col : kept.headSet(leftK9dbCount)) {
+        leftKeep[i++] = col;
+      }
+    }
+    if (kept.tailSet(leftK9dbCount).size() < rightK9dbCount) {
+      rightKeep = new int[kept.tailSet(leftK9dbCount).size()];
+      int i = 0;
+      for (int col : kept.tailSet(leftK9dbCount)) {
+        rightKeep[i++] = col - leftK9dbCount;
+      }
+    }
+    ArrayList<Integer> pruned = new ArrayList<>();
+    for (int i = 0; i < leftK9dbCount + rightK9dbCount; i++) {
+      if (!kept.contains(i)) {
+        pruned.add(i);
+      }
+    }
 
-    int leftCalciteIndex = ((RexInputRef) leftCondition).getIndex();
-    int rightCalciteIndex = ((RexInputRef) rightCondition).getIndex();
-    int leftK9dbIndex = this.context.getK9dbIndex(leftCalciteIndex);
-    int rightK9dbIndex = this.context.getK9dbIndex(rightCalciteIndex);
-    this.context.setDuplicate(rightK9dbIndex, leftK9dbIndex);
-    rightK9dbIndex -= leftK9dbCount;
+    // The right join columns are dropped from the output. Dropping a column shifts the ones
+    // after it, so drop them from last to first.
+    Integer[] order = new Integer[conjuncts.size()];
+    for (int i = 0; i < order.length; i++) {
+      order[i] = i;
+    }
+    Arrays.sort(order, (a, b) -> Integer.compare(rightK9dbIndices[b], rightK9dbIndices[a]));
+    for (int i : order) {
+      this.context.setDuplicate(rightK9dbIndices[i], leftK9dbIndices[i]);
+    }
+    // The output does not have the pruned columns either. Pruned columns are not join columns,
+    // so their index only shifts by the right join columns before them.
+    for (int p = pruned.size() - 1; p >= 0; p--) {
+      int prunedK9dbIndex = pruned.get(p);
+      for (int i = 0; i < rightK9dbIndices.length; i++) {
+        if (rightK9dbIndices[i] < pruned.get(p)) {
+          prunedK9dbIndex--;
+        }
+      }
+      this.context.setPruned(prunedK9dbIndex);
+    }
+    for (int i = 0; i < rightK9dbIndices.length; i++) {
+      rightK9dbIndices[i] -= leftK9dbCount;
+    }
 
     // Set up all join operator parameters.
     int leftInput = children.get(0);
@@ -66,9 +165,11 @@ public class JoinOperatorFactory {
                 .AddJoinOperator(
                     leftInput,
                     rightInput,
-                    leftK9dbIndex,
-                    rightK9dbIndex,
-                    DataFlowGraphLibrary.INNER);
+                    leftK9dbIndices,
+                    rightK9dbIndices,
+                    DataFlowGraphLibrary.INNER,
+                    leftKeep,
+                    rightKeep);
         break;
       case LEFT:
         joinOperator =
@@ -77,9 +178,11 @@ public class JoinOperatorFactory {
                 .AddJoinOperator(
                     leftInput,
                     rightInput,
-                    leftK9dbIndex,
-                    rightK9dbIndex,
-                    DataFlowGraphLibrary.LEFT);
+                    leftK9dbIndices,
+                    rightK9dbIndices,
+                    DataFlowGraphLibrary.LEFT,
+                    leftKeep,
+                    rightKeep);
         break;
       case RIGHT:
         joinOperator =
@@ -88,9 +191,11 @@ public class JoinOperatorFactory {
                 .AddJoinOperator(
                     leftInput,
                     rightInput,
-                    leftK9dbIndex,
-                    rightK9dbIndex,
-                    DataFlowGraphLibrary.RIGHT);
+                    leftK9dbIndices,
+                    rightK9dbIndices,
+                    DataFlowGraphLibrary.RIGHT,
+                    leftKeep,
+                    rightKeep);
         break;
       case ANTI:
       case FULL:
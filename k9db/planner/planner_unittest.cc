@@ -1,5 +1,6 @@
 #include "k9db/planner/planner.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -1196,6 +1197,82 @@ TEST(PlannerTest, BasicLeftJoin) {
   state.Shutdown();
 }
 
+// Joins do not keep columns that are not used downstream in their state.
+TEST(PlannerTest, JoinPrunesUnusedColumns) {
+  // Create a schema.
+  dataflow::SchemaRef schema1 = dataflow::SchemaFactory::Create(
+      {"ID", "NAME"}, {CType::INT, CType::TEXT}, {0});
+  dataflow::SchemaRef schema2 = dataflow::SchemaFactory::Create(
+      {"ID", "ASSIGNMENT"}, {CType::INT, CType::TEXT}, {0});
+  dataflow::SchemaRef schema3 = dataflow::SchemaFactory::Create(
+      {"ID", "STUDENT_ID", "ASSIGNMENT_ID", "TS"},
+      {CType::INT, CType::INT, CType::INT, CType::INT}, {0});
+
+  // Make a dummy query.
+  std::string query =
+      "SELECT students.NAME, assignments.ASSIGNMENT "
+      "FROM submissions "
+      "  JOIN students ON submissions.STUDENT_ID = students.ID "
+      "  JOIN assignments ON submissions.ASSIGNMENT_ID = assignments.ID";
+
+  // Create a dummy state.
+  dataflow::DataFlowState state(0, false);
+  state.AddTableSchema("students", schema1);
+  state.AddTableSchema("assignments", schema2);
+  state.AddTableSchema("submissions", schema3);
+
+  // Plan the graph via calcite.
+  auto graph = PlanGraph(&state, query);
+
+  // TS is never used, and STUDENT_ID is not used after the first join.
+  size_t joins = 0;
+  for (const auto &node : graph->nodes()) {
+    if (node->type() == dataflow::Operator::Type::EQUIJOIN) {
+      const std::vector<std::string> &names =
+          node->output_schema().column_names();
+      EXPECT_EQ(std::count(names.begin(), names.end(), "TS"), 0);
+      if (++joins == 2) {
+        EXPECT_EQ(std::count(names.begin(), names.end(), "STUDENT_ID"), 0);
+      }
+    }
+  }
+  EXPECT_EQ(joins, 2u);
+
+  // Materialized View.
+  dataflow::MatViewOperator *matview = graph->outputs().at(0);
+  EXPECT_EQ(matview->output_schema().column_names(),
+            (std::vector<std::string>{"NAME", "ASSIGNMENT"}));
+
+  // Try to process some records through flow.
+  std::vector<dataflow::Record> records;
+  records.emplace_back(schema1, true, 0_s, std::make_unique<std::string>("s1"));
+  records.emplace_back(schema1, true, 1_s, std::make_unique<std::string>("s2"));
+  graph->_Process("students", std::move(records));
+
+  records.clear();
+  records.emplace_back(schema2, true, 10_s,
+                       std::make_unique<std::string>("a1"));
+  records.emplace_back(schema2, true, 20_s,
+                       std::make_unique<std::string>("a2"));
+  graph->_Process("assignments", std::move(records));
+
+  records.clear();
+  records.emplace_back(schema3, true, 0_s, 0_s, 10_s, 100_s);
+  records.emplace_back(schema3, true, 1_s, 1_s, 20_s, 200_s);
+  graph->_Process("submissions", std::move(records));
+
+  // Check that processing was correct.
+  dataflow::SchemaRef schema4 = matview->output_schema();
+  std::vector<dataflow::Record> expected;
+  expected.emplace_back(schema4, true, std::make_unique<std::string>("s1"),
+                        std::make_unique<std::string>("a1"));
+  expected.emplace_back(schema4, true, std::make_unique<std::string>("s2"),
+                        std::make_unique<std::string>("a2"));
+  EXPECT_EQ_MSET(matview->All(), expected);
+
+  state.Shutdown();
+}
+
 // Test case with limit and offset.
 TEST(PlannerTest, SimpleLimitOffset) {
   // Create a schema.
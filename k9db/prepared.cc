@@ -2,7 +2,9 @@
 #include "k9db/prepared.h"
 
 #include <cassert>
+#include <exception>
 #include <memory>
+#include <optional>
 // NOLINTNEXTLINE
 #include <regex>
 #include <unordered_set>
@@ -13,6 +15,7 @@
 #include "k9db/dataflow/ops/input.h"
 #include "k9db/dataflow/ops/matview.h"
 #include "k9db/sqlast/hacky.h"
+#include "k9db/sqlast/parser.h"
 #include "k9db/util/status.h"
 
 namespace k9db {
@@ -28,8 +31,9 @@ namespace {
 // Find a column name (identifier) qualified with an optional table name.
 #define TABLE_COLUMN_NAME "\\b(?:([A-Za-z0-9_]+)\\.|)([A-Za-z0-9_]+)"
 
-// Components for matching expressions with ? in WHERE clauses.
-#define OP "\\s*(=|<|>|<=|>=)\\s*"
+// Components for matching expressions with ? in WHERE clauses, or with
+// <column> + ? in UPDATE ... SET <column> = <column> + ?.
+#define OP "\\s*(=|<|>|<=|>=|\\+)\\s*"
 #define Q "\\?"
 
 // Regexes made out of above components.
@@ -47,6 +51,7 @@ static std::regex CANONICAL_PARAM_REGEX{TABLE_COLUMN_NAME OP Q};
 
 static std::regex VIEW_FEATURES_REGEX{SUM_OR_COUNT "|" EXPENSIVE};
 static std::regex NESTED_QUERY{SELECT ".*" SELECT};
+#undef SELECT  // Clashes with AbstractStatement::Type::SELECT below.
 
 // Helper function that:
 // 1) Removes all quoted text ("", '', ``)
@@ -95,6 +100,172 @@ std::string CleanCanonicalQuery(const CanonicalQuery &query) {
   return cleaned_query;
 }
 
+// The i-th ? of a canonical statement is parsed into a text value starting
+// with \0, which cannot appear in the text of a query.
+std::string PlaceholderSQLString(size_t i) {
+  std::string str = "'";
+  str.push_back('\0');
+  str.append(std::to_string(i));
+  str.push_back('\'');
+  return str;
+}
+std::optional<size_t> PlaceholderIndex(const sqlast::Value &value) {
+  if (value.type() != sqlast::Value::TEXT) {
+    return {};
+  }
+  const std::string &str = value.GetString();
+  if (str.empty() || str.front() != '\0') {
+    return {};
+  }
+  return std::stoull(str.substr(1));
+}
+
+// Copies a parsed canonical statement, replacing placeholders with the values
+// bound to the corresponding ?.
+class Binder {
+ public:
+  explicit Binder(std::vector<std::vector<sqlast::Value>> &&values)
+      : values_(std::move(values)), bound_(0) {}
+
+  // Returns nullptr if the statement type cannot be bound.
+  std::unique_ptr<sqlast::AbstractStatement> Bind(
+      const sqlast::AbstractStatement &stmt) {
+    switch (stmt.type()) {
+      case sqlast::AbstractStatement::Type::INSERT:
+      case sqlast::AbstractStatement::Type::REPLACE: {
+        const auto &insert = static_cast<const sqlast::Insert &>(stmt);
+        std::unique_ptr<sqlast::Insert> result;
+        if (stmt.type() == sqlast::AbstractStatement::Type::REPLACE) {
+          result = std::make_unique<sqlast::Replace>(insert.table_name());
+        } else {
+          result = std::make_unique<sqlast::Insert>(insert.table_name());
+        }
+        std::vector<std::string> columns = insert.GetColumns();
+        std::vector<sqlast::Value> values;
+        values.reserve(insert.GetValues().size());
+        for (const sqlast::Value &value : insert.GetValues()) {
+          values.push_back(this->BindValue(value));
+        }
+        result->SetColumns(std::move(columns));
+        result->SetValues(std::move(values));
+        return result;
+      }
+      case sqlast::AbstractStatement::Type::SELECT: {
+        const auto &select = static_cast<const sqlast::Select &>(stmt);
+        auto result = std::make_unique<sqlast::Select>(select.table_name());
+        for (const sqlast::Select::ResultColumn &column : select.GetColumns()) {
+          result->AddColumn(column);
+        }
+        result->offset() = select.offset();
+        result->limit() = select.limit();
+        if (select.HasWhereClause()) {
+          result->SetWhereClause(this->BindBinary(*select.GetWhereClause()));
+        }
+        return result;
+      }
+      case sqlast::AbstractStatement::Type::UPDATE: {
+        const auto &update = static_cast<const sqlast::Update &>(stmt);
+        auto result = std::make_unique<sqlast::Update>(update.table_name());
+        for (size_t i = 0; i < update.GetColumns().size(); i++) {
+          const sqlast::Expression &value = *update.GetValues().at(i);
+          result->AddColumnValue(update.GetColumns().at(i),
+                                 this->BindExpression(value));
+        }
+        if (update.HasWhereClause()) {
+          result->SetWhereClause(this->BindBinary(*update.GetWhereClause()));
+        }
+        return result;
+      }
+      case sqlast::AbstractStatement::Type::DELETE: {
+        const auto &del = static_cast<const sqlast::Delete &>(stmt);
+        auto result = std::make_unique<sqlast::Delete>(del.table_name());
+        if (del.HasWhereClause()) {
+          result->SetWhereClause(this->BindBinary(*del.GetWhereClause()));
+        }
+        return result;
+      }
+      default:
+        return nullptr;
+    }
+  }
+
+  // Number of placeholders replaced so far.
+  size_t bound() const { return this->bound_; }
+
+ private:
+  // Takes the values bound to placeholder i.
+  std::vector<sqlast::Value> Take(size_t i) {
+    if (i >= this->values_.size()) {
+      LOG(FATAL) << "Placeholder of a ? that does not exist";
+    }
+    this->bound_++;
+    return std::move(this->values_.at(i));
+  }
+
+  sqlast::Value BindValue(const sqlast::Value &value) {
+    std::optional<size_t> index = PlaceholderIndex(value);
+    if (!index.has_value()) {
+      return value;
+    }
+    std::vector<sqlast::Value> values = this->Take(index.value());
+    if (values.size() != 1) {
+      LOG(FATAL) << "Bound " << values.size() << " values to a single ?";
+    }
+    return std::move(values.front());
+  }
+
+  std::unique_ptr<sqlast::Expression> BindExpression(
+      const sqlast::Expression &expr) {
+    switch (expr.type()) {
+      case sqlast::Expression::Type::LITERAL: {
+        const auto &literal =
+            static_cast<const sqlast::LiteralExpression &>(expr);
+        return std::make_unique<sqlast::LiteralExpression>(
+            this->BindValue(literal.value()));
+      }
+      case sqlast::Expression::Type::EQ:
+      case sqlast::Expression::Type::AND:
+      case sqlast::Expression::Type::GREATER_THAN:
+      case sqlast::Expression::Type::IN:
+      case sqlast::Expression::Type::IS:
+      case sqlast::Expression::Type::PLUS:
+      case sqlast::Expression::Type::MINUS:
+        return this->BindBinary(
+            static_cast<const sqlast::BinaryExpression &>(expr));
+      default:
+        return expr.Clone();
+    }
+  }
+
+  std::unique_ptr<sqlast::BinaryExpression> BindBinary(
+      const sqlast::BinaryExpression &expr) {
+    const sqlast::Expression *left = expr.GetLeft();
+    const sqlast::Expression *right = expr.GetRight();
+    // <column> = ? with several values becomes <column> IN (?, ...).
+    if (expr.type() == sqlast::Expression::Type::EQ &&
+        right->type() == sqlast::Expression::Type::LITERAL) {
+      const auto *literal =
+          static_cast<const sqlast::LiteralExpression *>(right);
+      std::optional<size_t> index = PlaceholderIndex(literal->value());
+      if (index.has_value() && this->values_.at(index.value()).size() != 1) {
+        auto result = std::make_unique<sqlast::BinaryExpression>(
+            sqlast::Expression::Type::IN);
+        result->SetLeft(left->Clone());
+        result->SetRight(std::make_unique<sqlast::LiteralListExpression>(
+            this->Take(index.value())));
+        return result;
+      }
+    }
+    auto result = std::make_unique<sqlast::BinaryExpression>(expr.type());
+    result->SetLeft(this->BindExpression(*left));
+    result->SetRight(this->BindExpression(*right));
+    return result;
+  }
+
+  std::vector<std::vector<sqlast::Value>> values_;
+  size_t bound_;
+};
+
 }  // namespace
 
 // Turn query into canonical form.
@@ -281,6 +452,64 @@ sqlast::SQLCommand PopulateStatement(const PreparedStatementDescriptor &stmt,
   return command;
 }
 
+// Parse the canonical statement once with placeholders in place of ?.
+void ParseCanonical(CanonicalDescriptor *stmt) {
+  PreparedStatementDescriptor placeholders;
+  placeholders.canonical = stmt;
+  placeholders.total_count = stmt->args_count;
+  std::vector<std::string> args;
+  for (size_t i = 0; i < stmt->args_count; i++) {
+    placeholders.arg_value_count.push_back(1);
+    args.push_back(PlaceholderSQLString(i));
+  }
+
+  absl::StatusOr<std::unique_ptr<sqlast::AbstractStatement>> parsed;
+  try {
+    sqlast::SQLParser parser;
+    parsed = parser.Parse(PopulateStatement(placeholders, args));
+  } catch (std::exception &e) {
+    return;
+  }
+  if (!parsed.ok()) {
+    return;
+  }
+
+  // Make sure we can bind every ? into the parsed statement, otherwise the
+  // statement is re-parsed on every execution.
+  std::vector<std::vector<sqlast::Value>> values(stmt->args_count);
+  for (std::vector<sqlast::Value> &value : values) {
+    value.emplace_back();
+  }
+  Binder binder(std::move(values));
+  if (binder.Bind(*parsed.value()) == nullptr ||
+      binder.bound() != stmt->args_count) {
+    return;
+  }
+  stmt->statement = std::move(parsed.value());
+}
+
+// Bind concrete values into a copy of the parsed canonical statement.
+std::unique_ptr<sqlast::AbstractStatement> BindStatement(
+    const PreparedStatementDescriptor &stmt,
+    const std::vector<std::string> &args) {
+  const CanonicalDescriptor *canonical = stmt.canonical;
+  if (canonical->statement == nullptr) {
+    LOG(FATAL) << "Binding unparsed statement " << canonical->canonical_query;
+  }
+  // The values of each canonical ?, IN (?, ...) binds several values.
+  std::vector<std::vector<sqlast::Value>> values(canonical->args_count);
+  size_t v = 0;
+  for (size_t i = 0; i < canonical->args_count; i++) {
+    size_t count = stmt.arg_value_count.at(i);
+    values.at(i).reserve(count);
+    for (size_t j = 0; j < count; j++) {
+      values.at(i).push_back(sqlast::Value::FromSQLString(args.at(v + j)));
+    }
+    v += count;
+  }
+  return Binder(std::move(values)).Bind(*canonical->statement);
+}
+
 // Extract type information about ? arguments from flow.
 void FromFlow(const std::string &flow_name,
               const dataflow::DataFlowGraph &graph, CanonicalDescriptor *stmt) {
@@ -1,6 +1,7 @@
 #ifndef K9DB_PREPARED_H_
 #define K9DB_PREPARED_H_
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -30,6 +31,8 @@ struct CanonicalDescriptor {
   std::vector<std::string> arg_ops;     // size = args_count
   std::vector<sqlast::ColumnDefinition::Type> arg_types;
   std::optional<std::string> view_name;  // If from a view.
+  // Parsed statement with placeholders for ? (see ParseCanonical).
+  std::unique_ptr<sqlast::AbstractStatement> statement;
 };
 
 // Contains information about a connection-specific prepared statement
@@ -61,6 +64,16 @@ bool NeedsFlow(const CanonicalQuery &query);
 sqlast::SQLCommand PopulateStatement(const PreparedStatementDescriptor &stmt,
                                      const std::vector<std::string> &args);
 
+// Parse the canonical statement once with placeholders in place of ?, so that
+// executions bind their arguments into it instead of re-parsing. Leaves
+// statement empty if the canonical statement cannot be parsed this way.
+void ParseCanonical(CanonicalDescriptor *stmt);
+
+// Bind concrete values into a copy of the parsed canonical statement.
+std::unique_ptr<sqlast::AbstractStatement> BindStatement(
+    const PreparedStatementDescriptor &stmt,
+    const std::vector<std::string> &args);
+
 // Extract type information about ? arguments from flow.
 void FromFlow(const std::string &flow_name,
               const dataflow::DataFlowGraph &graph, CanonicalDescriptor *stmt);
@@ -0,0 +1,168 @@
+#include "k9db/prepared.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/dataflow/schema.h"
+#include "k9db/dataflow/state.h"
+#include "k9db/sqlast/ast.h"
+#include "k9db/sqlast/command.h"
+#include "k9db/sqlast/parser.h"
+
+namespace k9db {
+namespace prepared {
+
+using CType = sqlast::ColumnDefinition::Type;
+
+namespace {
+
+dataflow::SchemaRef MakeSchema() {
+  std::vector<std::string> names = {"id", "name", "age"};
+  std::vector<CType> types = {CType::INT, CType::TEXT, CType::INT};
+  std::vector<dataflow::ColumnID> keys = {0};
+  return dataflow::SchemaFactory::Create(names, types, keys);
+}
+
+std::string Stringify(const sqlast::AbstractStatement &stmt) {
+  sqlast::Stringifier stringifier;
+  return stmt.Visit(&stringifier);
+}
+
+// Prepares query the same way k9db::prepare does for SELECT/UPDATE/DELETE.
+std::unique_ptr<CanonicalDescriptor> Prepare(
+    const std::string &query, std::vector<size_t> *arg_value_count) {
+  auto pair = Canonicalize(query);
+  *arg_value_count = std::move(pair.second);
+  auto canonical = std::make_unique<CanonicalDescriptor>();
+  *canonical = MakeCanonical(pair.first);
+  ParseCanonical(canonical.get());
+  return canonical;
+}
+
+// Binding the parsed canonical statement must give the same statement as
+// populating the canonical query and parsing it, and contain expected.
+void BindEqualsParse(const std::string &query,
+                     const CanonicalDescriptor *canonical,
+                     std::vector<size_t> &&arg_value_count,
+                     const std::vector<std::string> &args,
+                     const std::string &expected) {
+  PreparedStatementDescriptor stmt =
+      MakeStmt(query, canonical, std::move(arg_value_count));
+  ASSERT_EQ(stmt.total_count, args.size());
+
+  sqlast::SQLParser parser;
+  auto parsed = parser.Parse(PopulateStatement(stmt, args));
+  ASSERT_TRUE(parsed.ok()) << parsed.status();
+  std::unique_ptr<sqlast::AbstractStatement> bound = BindStatement(stmt, args);
+  ASSERT_NE(bound, nullptr);
+
+  std::string str = Stringify(*bound);
+  EXPECT_EQ(str, Stringify(*parsed.value()));
+  EXPECT_NE(str.find(expected), std::string::npos) << str;
+}
+
+}  // namespace
+
+TEST(PreparedTest, BindInsert) {
+  dataflow::DataFlowState dstate(1, true);
+  dstate.AddTableSchema("users", MakeSchema());
+
+  std::string query = "INSERT INTO users VALUES (?, ?, 20);";
+  auto result = MakeInsertCanonical(query, dstate);
+  ASSERT_TRUE(result.ok()) << result.status();
+  CanonicalDescriptor canonical = std::move(result.value());
+  ParseCanonical(&canonical);
+  // Placeholders survive the hacky parser.
+  ASSERT_NE(canonical.statement, nullptr);
+
+  BindEqualsParse(query, &canonical, {}, {"1", "'alice'"},
+                  "INSERT INTO users VALUES (1, 'alice', 20)");
+  dstate.Shutdown();
+}
+
+TEST(PreparedTest, BindSelect) {
+  std::string query = "SELECT * FROM users WHERE id = ? AND name = ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  ASSERT_NE(canonical->statement, nullptr);
+
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"5", "'bob'"}, "WHERE id = 5 AND name = 'bob'");
+}
+
+TEST(PreparedTest, BindSelectIn) {
+  std::string query = "SELECT * FROM users WHERE id IN (?, ?, ?) AND age > ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  EXPECT_EQ(arg_value_count, (std::vector<size_t>{3, 1}));
+  ASSERT_NE(canonical->statement, nullptr);
+
+  // id = ? is bound to 3 values and is rewritten to id IN (...).
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"1", "2", "3", "18"}, "WHERE id IN (1, 2, 3) AND age > 18");
+
+  // The same canonical statement can be bound with a single value.
+  query = "SELECT * FROM users WHERE id IN (?) AND age > ?";
+  arg_value_count = Canonicalize(query).second;
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"1", "18"}, "WHERE id = 1 AND age > 18");
+}
+
+TEST(PreparedTest, BindUpdate) {
+  std::string query = "UPDATE users SET name = ? WHERE id = ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  ASSERT_NE(canonical->statement, nullptr);
+
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"'eve'", "7"}, "UPDATE users SET name = 'eve' WHERE id = 7");
+}
+
+TEST(PreparedTest, BindUpdatePlus) {
+  // The hacky parser rejects <column> + ?, this uses the fallback parser.
+  std::string query = "UPDATE users SET age = age + ? WHERE id IN (?, ?)";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  EXPECT_EQ(canonical->args_count, 2u);
+  EXPECT_EQ(canonical->arg_names.front(), "age");
+  ASSERT_NE(canonical->statement, nullptr);
+
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"1", "7", "8"},
+                  "UPDATE users SET age = age + 1 WHERE id IN (7, 8)");
+}
+
+TEST(PreparedTest, BindDelete) {
+  // The hacky parser does not handle DELETE, this uses the fallback parser.
+  std::string query = "DELETE FROM users WHERE id IN (?, ?) AND name = ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  ASSERT_NE(canonical->statement, nullptr);
+
+  BindEqualsParse(query, canonical.get(), std::move(arg_value_count),
+                  {"1", "2", "'bob'"},
+                  "DELETE FROM users WHERE id IN (1, 2) AND name = 'bob'");
+}
+
+TEST(PreparedTest, UnboundPlaceholderFallsBack) {
+  // The first ? is inside a string: the regex counts it, but the parser does
+  // not, so bound() != args_count and the statement must be re-parsed.
+  std::string query = "SELECT * FROM users WHERE name = 'x = ?' AND id = ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  EXPECT_EQ(canonical->args_count, 2u);
+  EXPECT_EQ(canonical->statement, nullptr);
+}
+
+TEST(PreparedTest, UnparsableFallsBack) {
+  std::string query = "SELECT * FROM WHERE id = ?";
+  std::vector<size_t> arg_value_count;
+  auto canonical = Prepare(query, &arg_value_count);
+  EXPECT_EQ(canonical->statement, nullptr);
+}
+
+}  // namespace prepared
+}  // namespace k9db
@@ -4,6 +4,7 @@
 #include <memory>
 #include <utility>
 
+#include "gflags/gflags.h"
 #include "k9db/shards/sqlengine/create.h"
 #include "k9db/shards/sqlengine/delete.h"
 #include "k9db/shards/sqlengine/explain.h"
@@ -20,29 +21,55 @@
 #include "k9db/util/status.h"
 #include "k9db/util/upgradable_lock.h"
 
+DEFINE_uint32(conflict_retries, 10,
+              "Times a write statement is retried when it conflicts with a "
+              "concurrent one");
+
 namespace k9db {
 namespace shards {
 namespace sqlengine {
 
+namespace {
+
+// With optimistic transactions, write statements that conflict with concurrent
+// ones are rolled back (and return an aborted status), and are retried here.
+template <typename C, typename S, typename L>
+absl::StatusOr<sql::SqlResult> ExecWrite(const S &stmt, Connection *connection,
+                                         L *lock) {
+  for (uint32_t i = 0;; i++) {
+    C context(stmt, connection, lock);
+    absl::StatusOr<sql::SqlResult> result = context.Exec();
+    if (!absl::IsAborted(result.status()) || i >= FLAGS_conflict_retries) {
+      return result;
+    }
+  }
+}
+
+}  // namespace
+
 absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
                                      Connection *connection) {
-  dataflow::DataFlowState &dstate = connection->state->DataflowState();
-
   // Parse with ANTLR into our AST.
   sqlast::SQLParser parser;
   // parse the statement, move result of parsing sql string to newly created
   // <sqlast::AbstractStatement> statement.
   MOVE_OR_RETURN(std::unique_ptr<sqlast::AbstractStatement> statement,
                  parser.Parse(sql));
+  return Shard(*statement, connection);
+}
+
+absl::StatusOr<sql::SqlResult> Shard(const sqlast::AbstractStatement &statement,
+                                     Connection *connection) {
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
 
   // Get type of sql statement, initialize stmt (statement) as the associated
   // type custom defined in k9db via the sqlast class. Then call Shard in the
   // appropriate file. Eg if CreateTable we call create::Shard() from
   // sqlengine/create.cc
-  switch (statement->type()) {
+  switch (statement.type()) {
     // Case 1: CREATE TABLE statement.
     case sqlast::AbstractStatement::Type::CREATE_TABLE: {
-      auto *stmt = static_cast<sqlast::CreateTable *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::CreateTable *>(&statement);
       util::UniqueLock lock = connection->state->WriterLock();
       CreateContext context(*stmt, connection, &lock);
       return context.Exec();
@@ -50,30 +77,27 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
 
     // Case 2: INSERT or REPLACE statement.
     case sqlast::AbstractStatement::Type::INSERT: {
-      auto *stmt = static_cast<sqlast::Insert *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::Insert *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
-      InsertContext context(*stmt, connection, &lock);
-      return context.Exec();
+      return ExecWrite<InsertContext>(*stmt, connection, &lock);
     }
     case sqlast::AbstractStatement::Type::REPLACE: {
-      auto *stmt = static_cast<sqlast::Replace *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::Replace *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
-      ReplaceContext context(*stmt, connection, &lock);
-      return context.Exec();
+      return ExecWrite<ReplaceContext>(*stmt, connection, &lock);
     }
 
     // Case 3: UPDATE statement.
     case sqlast::AbstractStatement::Type::UPDATE: {
-      auto *stmt = static_cast<sqlast::Update *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::Update *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
-      UpdateContext context(*stmt, connection, &lock);
-      return context.Exec();
+      return ExecWrite<UpdateContext>(*stmt, connection, &lock);
     }
 
     // Case 4: SELECT statement.
     // Might be a select from a matview or a table.
     case sqlast::AbstractStatement::Type::SELECT: {
-      auto *stmt = static_cast<sqlast::Select *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::Select *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
       if (dstate.HasFlow(stmt->table_name())) {
         return view::SelectView(*stmt, connection, &lock);
@@ -86,17 +110,16 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
 
     // Case 5: DELETE statement.
     case sqlast::AbstractStatement::Type::DELETE: {
-      auto *stmt = static_cast<sqlast::Delete *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::Delete *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
-      DeleteContext context(*stmt, connection, &lock);
-      return context.Exec();
+      return ExecWrite<DeleteContext>(*stmt, connection, &lock);
     }
 
     // Case 6: CREATE VIEW statement (e.g. dataflow).
     case sqlast::AbstractStatement::Type::CREATE_VIEW: {
-      auto *stmt = static_cast<sqlast::CreateView *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::CreateView *>(&statement);
       util::UniqueLock lock = connection->state->WriterLock();
-      CHECK_STATUS(view::CreateView(*stmt, connection, &lock));
+      CHECK_STATUS(view::CreateView(*stmt, connection, &lock, true));
       // Persist explicit views, not prepared statements.
       bool ok = true;
       if (stmt->view_name()[0] != '_') {
@@ -107,7 +130,7 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
 
     // Case 7: CREATE INDEX statement.
     case sqlast::AbstractStatement::Type::CREATE_INDEX: {
-      auto *stmt = static_cast<sqlast::CreateIndex *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::CreateIndex *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
       auto db = connection->state->Database();
       return sql::SqlResult(db->ExecuteCreateIndex(*stmt));
@@ -115,7 +138,7 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
 
     // Case 8: GDPR (GET | FORGET) statements.
     case sqlast::AbstractStatement::Type::GDPR: {
-      auto *stmt = static_cast<sqlast::GDPRStatement *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::GDPRStatement *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
       switch (stmt->operation()) {
         case sqlast::GDPRStatement::Operation::GET: {
@@ -123,15 +146,14 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
           return context.Exec();
         }
         case sqlast::GDPRStatement::Operation::FORGET: {
-          GDPRForgetContext context(*stmt, connection, &lock);
-          return context.Exec();
+          return ExecWrite<GDPRForgetContext>(*stmt, connection, &lock);
         }
       }
     }
 
     // Case 9: EXPLAIN <query> statements.
     case sqlast::AbstractStatement::Type::EXPLAIN_QUERY: {
-      auto *stmt = static_cast<sqlast::ExplainQuery *>(statement.get());
+      const auto *stmt = static_cast<const sqlast::ExplainQuery *>(&statement);
       util::SharedLock lock = connection->state->ReaderLock();
       ExplainContext context(*stmt, connection, &lock);
       return context.Exec();
@@ -143,6 +165,12 @@ absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
   }
 }
 
+absl::StatusOr<sql::SqlResult> CheckpointViews(Connection *connection) {
+  // Exclude writes, so that views are consistent with the log watermark.
+  util::UniqueLock lock = connection->state->WriterLock();
+  return view::CheckpointViews(connection, &lock);
+}
+
 }  // namespace sqlengine
 }  // namespace shards
 }  // namespace k9db
@@ -21,6 +21,7 @@
 #include "k9db/dataflow/state.h"
 #include "k9db/shards/state.h"
 #include "k9db/sql/result.h"
+#include "k9db/sqlast/ast.h"
 #include "k9db/sqlast/command.h"
 
 namespace k9db {
@@ -29,6 +30,14 @@ namespace sqlengine {
 
 absl::StatusOr<sql::SqlResult> Shard(const sqlast::SQLCommand &sql,
                                      Connection *connection);
+
+// Execute an already parsed statement (e.g. a bound prepared statement).
+absl::StatusOr<sql::SqlResult> Shard(const sqlast::AbstractStatement &statement,
+                                     Connection *connection);
+
+// Persist the state of views, so that they are not recomputed on restart.
+absl::StatusOr<sql::SqlResult> CheckpointViews(Connection *connection);
+
 }  // namespace sqlengine
 }  // namespace shards
 }  // namespace k9db
@@ -5,6 +5,8 @@
 // clang-format on
 
 #include <memory>
+#include <string>
+#include <unordered_set>
 #include <utility>
 
 #include "glog/logging.h"
@@ -220,16 +222,41 @@ absl::StatusOr<sql::SqlResult> GDPRForgetContext::Exec() {
   // Anonymize data in other user shards.
   CHECK_STATUS(this->AnonymizeRecords());
 
+  // Log updates to dataflow, so views can catch up with them from a checkpoint
+  // or a backfill.
+  for (const auto &[table_name, records] : this->records_) {
+    if (this->dstate_.LogsWritesTo(table_name)) {
+      this->db_->LogRecords(table_name, records);
+    }
+  }
+
   // Commit transaction.
-  this->db_->CommitTransaction();
+  if (!this->db_->CommitTransaction()) {
+    CHECK_STATUS(this->conn_->ctx->RollbackCheckpoint());
+    return absl::AbortedError("Conflict with a concurrent transaction");
+  }
   CHECK_STATUS(this->conn_->ctx->CommitCheckpoint());
 
   // Decrement users.
   this->sstate_.DecrementUsers(this->shard_kind_, 1);
 
+  // Checkpoints of affected views and the archived log may hold the forgotten
+  // data: drop them, the views are recomputed from the tables on restart.
+  sql::Connection *db = this->conn_->state->Database();
+  std::unordered_set<std::string> flows;
+  for (const auto &[table_name, _] : this->records_) {
+    for (const std::string &flow : this->dstate_.GetFlowsAffectBy(table_name)) {
+      if (flows.insert(flow).second) {
+        db->DeleteCheckpoint(flow);
+      }
+    }
+  }
+  db->PurgeLog();
+
   // Update dataflow.
   for (auto &[table_name, records] : this->records_) {
-    this->dstate_.ProcessRecords(table_name, std::move(records));
+    this->dstate_.ProcessRecords(table_name, std::move(records),
+                                 &this->conn_->last_write);
   }
 
   return sql::SqlResult(this->status_);
@@ -162,6 +162,10 @@ absl::StatusOr<IndexDescriptor> Create(const std::string &table_name,
                  view::CreateView(create_stmt, connection, lock));
   ASSERT_RET(result.Success(), Internal, "Error VD index");
 
+  // Indices decide data ownership, they must reflect every write (even by
+  // other connections) that was acknowledged, also with async writes.
+  connection->state->DataflowState().MarkSynchronous(index_name);
+
   // Return index descriptor.
   return IndexDescriptor{index_name, table_name, shard_kind, column_name};
 }
@@ -174,6 +178,7 @@ std::vector<dataflow::Record> LookupIndex(const IndexDescriptor &index,
                                           Connection *connection,
                                           util::SharedLock *lock) {
   const dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  // Indices are synchronous flows: they reflect all acknowledged writes.
   const dataflow::DataFlowGraph &flow = dstate.GetFlow(index.index_name);
   // Lookup by given value as key.
   dataflow::Key key(1);
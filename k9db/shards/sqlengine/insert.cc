@@ -321,12 +321,22 @@ absl::StatusOr<sql::SqlResult> InsertContext::Exec() {
     }
   }
 
+  // Log updates to dataflow, so views can catch up with them from a checkpoint
+  // or a backfill.
+  if (this->dstate_.LogsWritesTo(this->table_name_)) {
+    this->db_->LogRecords(this->table_name_, this->records_);
+  }
+
   // Commit transaction.
-  this->db_->CommitTransaction();
+  if (!this->db_->CommitTransaction()) {
+    CHECK_STATUS(this->conn_->ctx->RollbackCheckpoint());
+    return absl::AbortedError("Conflict with a concurrent transaction");
+  }
   CHECK_STATUS(this->conn_->ctx->CommitCheckpoint());
 
   // Process updates to dataflows.
-  this->dstate_.ProcessRecords(this->table_name_, std::move(this->records_));
+  this->dstate_.ProcessRecords(this->table_name_, std::move(this->records_),
+                               &this->conn_->last_write);
 
   // Increment number of users in the system if we inserted a new user!
   if (this->new_users_ > 0) {
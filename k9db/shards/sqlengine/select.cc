@@ -114,6 +114,7 @@ absl::StatusOr<sql::SqlResult> SelectContext::ExecWithinTransaction() {
   if (this->stmt_.HasWhereClause()) {
     value_mapper.VisitBinaryExpression(*this->stmt_.GetWhereClause());
   }
+  CHECK_STATUS(value_mapper.status());
   std::optional<std::vector<sql::KeyPair>> direct_keys =
       this->FindDirectKeys(&value_mapper);
   if (direct_keys.has_value()) {
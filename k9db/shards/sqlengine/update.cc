@@ -7,6 +7,7 @@
 #include <unordered_set>
 
 #include "k9db/shards/sqlengine/util.h"
+#include "k9db/sqlast/value_mapper.h"
 #include "k9db/util/iterator.h"
 #include "k9db/util/status.h"
 
@@ -507,12 +508,22 @@ absl::StatusOr<sql::SqlResult> UpdateContext::Exec() {
     return sql::SqlResult(result.first);
   }
 
+  // Log updates to dataflow, so views can catch up with them from a checkpoint
+  // or a backfill.
+  if (this->dstate_.LogsWritesTo(this->table_name_)) {
+    this->db_->LogRecords(this->table_name_, result.second);
+  }
+
   // Commit transaction.
-  this->db_->CommitTransaction();
+  if (!this->db_->CommitTransaction()) {
+    CHECK_STATUS(this->conn_->ctx->RollbackCheckpoint());
+    return absl::AbortedError("Conflict with a concurrent transaction");
+  }
   CHECK_STATUS(this->conn_->ctx->CommitCheckpoint());
 
   // Update dataflow.
-  this->dstate_.ProcessRecords(this->table_name_, std::move(result.second));
+  this->dstate_.ProcessRecords(this->table_name_, std::move(result.second),
+                               &this->conn_->last_write);
 
   // Return number of copies inserted.
   return sql::SqlResult(result.first);
@@ -521,6 +532,13 @@ absl::StatusOr<sql::SqlResult> UpdateContext::Exec() {
 absl::StatusOr<UpdateContext::Result> UpdateContext::ExecWithinTransaction() {
   Result result;
 
+  // Reject where conditions that cannot be evaluated.
+  if (this->stmt_.HasWhereClause()) {
+    sqlast::ValueMapper value_mapper(this->schema_);
+    value_mapper.VisitBinaryExpression(*this->stmt_.GetWhereClause());
+    CHECK_STATUS(value_mapper.status());
+  }
+
   // Check if this statement affects the ownership of records in the updated
   // table.
   std::vector<UpdateInfo> cascades;
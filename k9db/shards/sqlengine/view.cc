@@ -1,14 +1,19 @@
 // Creation and management of dataflows.
 #include "k9db/shards/sqlengine/view.h"
 
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
+#include "k9db/dataflow/checkpoint.h"
 #include "k9db/dataflow/future.h"
 #include "k9db/dataflow/graph.h"
 #include "k9db/dataflow/graph_partition.h"
@@ -23,6 +28,11 @@
 #include "k9db/sql/connection.h"
 #include "k9db/util/status.h"
 
+DEFINE_uint64(view_memory_budget, 0,
+              "Memory budget (bytes) of partial views, 0 for full views");
+DEFINE_uint64(view_backfill_chunk, 4096,
+              "Number of records read at a time when populating a new view");
+
 namespace k9db {
 namespace shards {
 namespace sqlengine {
@@ -32,9 +42,148 @@ namespace view {
  * View creation.
  */
 
+namespace {
+
+// Feed everything in the input tables of a flow to it, one chunk at a time.
+// The dataflow workers process a chunk while the next one is read.
+void StreamTables(const std::string &flow_name, Connection *connection,
+                  dataflow::Future *future) {
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  for (const auto &table_name : dstate.GetFlow(flow_name).Inputs()) {
+    connection->session->StreamAll(
+        table_name, FLAGS_view_backfill_chunk,
+        [&](std::vector<dataflow::Record> &&records) {
+          dstate.ProcessRecordsByFlowName(flow_name, table_name,
+                                          std::move(records),
+                                          future->GetPromise());
+        });
+  }
+}
+
+// Feed logged writes to a flow, in order.
+void Replay(const std::string &flow_name, Connection *connection,
+            std::vector<sql::LogEntry> &&log) {
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  dataflow::Future future(true);
+  for (auto &[table_name, records] : log) {
+    dstate.ProcessRecordsByFlowName(flow_name, table_name, std::move(records),
+                                    future.GetPromise());
+  }
+  future.Wait();
+}
+
+// Read the writes to the inputs of a flow logged after watermark, and advance
+// the watermark past them. Returns nothing if the log is no longer available.
+std::optional<std::vector<sql::LogEntry>> ReadLog(const std::string &flow_name,
+                                                  Connection *connection,
+                                                  uint64_t *watermark) {
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  const std::vector<std::string> &inputs = dstate.GetFlow(flow_name).Inputs();
+  std::unordered_set<std::string> tables(inputs.begin(), inputs.end());
+  return connection->state->Database()->ReadLog(watermark, tables);
+}
+
+// Feed the writes logged after watermark to a flow, and advance the watermark
+// past them. Returns false if the log is no longer available.
+bool CatchUp(const std::string &flow_name, Connection *connection,
+             uint64_t *watermark) {
+  std::optional<std::vector<sql::LogEntry>> log =
+      ReadLog(flow_name, connection, watermark);
+  if (!log.has_value()) {
+    return false;
+  }
+  Replay(flow_name, connection, std::move(*log));
+  return true;
+}
+
+// Restore the state of a new flow from its checkpoint, and catch up with the
+// writes logged after the checkpoint was taken. Returns false if there is no
+// usable checkpoint, and the flow must be populated from the tables instead.
+bool RestoreCheckpoint(const std::string &flow_name, Connection *connection) {
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  const dataflow::DataFlowGraph &flow = dstate.GetFlow(flow_name);
+  if (!flow.SupportsCheckpoint()) {
+    return false;
+  }
+
+  // Writes were not logged if checkpoints were disabled at any point since the
+  // checkpoint was taken (e.g. now): it cannot be caught up.
+  sql::Connection *db = connection->state->Database();
+  if (!dstate.checkpoints()) {
+    db->DeleteCheckpoint(flow_name);
+    return false;
+  }
+
+  std::optional<dataflow::FlowCheckpoint> checkpoint = db->LoadCheckpoint(
+      flow_name, flow.Signature(),
+      [&](dataflow::PartitionIndex, dataflow::NodeIndex n, uint32_t b) {
+        return flow.CheckpointSchemas(n).at(b);
+      });
+  if (!checkpoint.has_value()) {
+    return false;
+  }
+
+  uint64_t watermark = checkpoint->watermark;
+  std::optional<std::vector<sql::LogEntry>> log =
+      ReadLog(flow_name, connection, &watermark);
+  if (!log.has_value()) {
+    LOG(WARNING) << "Recomputing view " << flow_name << " from tables";
+    return false;
+  }
+
+  // Restore the state and replay the log.
+  flow.Restore(std::move(checkpoint->batches));
+  Replay(flow_name, connection, std::move(*log));
+  return true;
+}
+
+// Backfill a flow over tables from a snapshot of them, without excluding
+// writes for the duration. Writes made after the snapshot are logged, and the
+// flow catches up with them before it is fed writes directly.
+// If the log was discarded before the flow caught up with it (e.g. a long
+// backfill outlived the WAL archive), the flow is populated again from the
+// tables while writes are excluded.
+void Backfill(const sqlast::CreateView &stmt, Connection *connection,
+              util::UniqueLock *lock) {
+  const std::string &flow_name = stmt.view_name();
+  dataflow::DataFlowState &dstate = connection->state->DataflowState();
+
+  // Take the snapshot while writes are still excluded.
+  connection->session->BeginTransaction(false);
+  uint64_t watermark = connection->session->SnapshotSequenceNumber();
+
+  // Stream the snapshot.
+  lock->unlock();
+  dataflow::Future future(true);
+  StreamTables(flow_name, connection, &future);
+  future.Wait();
+  connection->session->RollbackTransaction();
+
+  // Catch up with most concurrent writes first, and only exclude writes for
+  // the remaining few.
+  bool caught_up = CatchUp(flow_name, connection, &watermark);
+  lock->lock();
+  caught_up = caught_up && CatchUp(flow_name, connection, &watermark);
+  if (!caught_up) {
+    LOG(WARNING) << "Log to backfill " << flow_name << " was discarded, "
+                 << "populating it again from tables";
+    dstate.RestartBackfill(flow_name,
+                           planner::PlanGraph(&dstate, stmt.query()));
+    connection->session->BeginTransaction(false);
+    dataflow::Future future(true);
+    StreamTables(flow_name, connection, &future);
+    future.Wait();
+    connection->session->RollbackTransaction();
+  }
+  dstate.FinishBackfill(flow_name);
+}
+
+}  // namespace
+
 absl::StatusOr<sql::SqlResult> CreateView(const sqlast::CreateView &stmt,
                                           Connection *connection,
-                                          util::UniqueLock *lock) {
+                                          util::UniqueLock *lock,
+                                          bool concurrent) {
   std::string flow_name = stmt.view_name();
 
   // Make sure a table or a view with the same name does not exist.
@@ -49,32 +198,48 @@ absl::StatusOr<sql::SqlResult> CreateView(const sqlast::CreateView &stmt,
   std::unique_ptr<dataflow::DataFlowGraphPartition> graph =
       planner::PlanGraph(&dataflow_state, stmt.query());
 
+  // Views over partial views cannot be populated.
+  for (auto *forward : graph->forwards()) {
+    const std::string &parent = forward->parent_flow();
+    ASSERT_RET(!dataflow_state.GetFlow(parent).partial(), InvalidArgument,
+               "Cannot create a view over a partial view!");
+    ASSERT_RET(!dataflow_state.IsBackfilling(parent), InvalidArgument,
+               "Cannot create a view over a view that is being populated!");
+  }
+
+  // Views over views are populated from their parents, which requires
+  // excluding writes throughout.
+  concurrent = concurrent && graph->forwards().empty();
+  if (!graph->forwards().empty()) {
+    dataflow_state.WaitForWrites();
+  }
+
   // Add The flow to state so that data is fed into it on INSERT/UPDATE/DELETE.
-  dataflow_state.AddFlow(flow_name, std::move(graph));
+  dataflow_state.AddFlow(flow_name, std::move(graph), FLAGS_view_memory_budget,
+                         concurrent);
+
+  // Partial views start out empty, keys are filled when read.
+  // Views that were checkpointed (e.g. on shutdown) need not be recomputed.
+  if (dataflow_state.GetFlow(flow_name).partial() ||
+      RestoreCheckpoint(flow_name, connection)) {
+    if (concurrent) {
+      dataflow_state.FinishBackfill(flow_name);
+    }
+    return sql::SqlResult(true);
+  }
 
   // Update new View with existing data in tables.
-  std::vector<std::pair<std::string, std::vector<dataflow::Record>>> data;
+  if (concurrent) {
+    Backfill(stmt, connection, lock);
+    return sql::SqlResult(true);
+  }
 
   // Begin transaction (for reading tables content).
   connection->session->BeginTransaction(false);
 
   // Iterate through each table in the new View's flow.
   dataflow::Future future(true);
-  for (const auto &table_name : dataflow_state.GetFlow(flow_name).Inputs()) {
-    // Generate and execute select * query for current table
-    sql::SqlResultSet result = connection->session->GetAll(table_name);
-
-    // Vectorize and store records.
-    std::vector<k9db::dataflow::Record> records = std::move(result.Vec());
-
-    // Records will be negative here, need to turn them to positive records.
-    for (auto &record : records) {
-      record.SetPositive(true);
-    }
-
-    dataflow_state.ProcessRecordsByFlowName(
-        flow_name, table_name, std::move(records), future.GetPromise());
-  }
+  StreamTables(flow_name, connection, &future);
 
   // Populate nested view upon creation.
   for (size_t p = 0; p < dataflow_state.workers(); p++) {
@@ -96,6 +261,31 @@ absl::StatusOr<sql::SqlResult> CreateView(const sqlast::CreateView &stmt,
   return sql::SqlResult(true);
 }
 
+/*
+ * View checkpointing.
+ */
+
+absl::StatusOr<sql::SqlResult> CheckpointViews(Connection *connection,
+                                               util::UniqueLock *lock) {
+  const dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  // Writes are only logged, and checkpoints only restored, with checkpoints
+  // enabled, which requires consistency.
+  ASSERT_RET(dstate.checkpoints(), InvalidArgument,
+             "Checkpoints are disabled, see --checkpoint_views!");
+  dstate.WaitForWrites();
+
+  int count = 0;
+  sql::Connection *db = connection->state->Database();
+  for (const std::string &flow_name : dstate.GetFlows()) {
+    const dataflow::DataFlowGraph &flow = dstate.GetFlow(flow_name);
+    if (flow.SupportsCheckpoint() && !dstate.IsBackfilling(flow_name)) {
+      db->PersistCheckpoint(flow_name, flow.Signature(), flow.Checkpoint());
+      count++;
+    }
+  }
+  return sql::SqlResult(count);
+}
+
 /*
  * View querying.
  */
@@ -153,6 +343,51 @@ std::vector<dataflow::Record> LookupRecords(const dataflow::DataFlowGraph &flow,
   return flow.All(limit, offset);
 }
 
+// Upquery: fill the missing keys of a partial view from the base tables.
+void FillMisses(const dataflow::DataFlowGraph &flow,
+                const std::vector<dataflow::Key> &misses,
+                Connection *connection) {
+  const dataflow::DataFlowState &dstate = connection->state->DataflowState();
+  connection->session->BeginTransaction(false);
+  for (const dataflow::Key &key : misses) {
+    std::unordered_map<std::string, std::vector<dataflow::Record>> inputs;
+    for (const std::string &table_name : flow.Inputs()) {
+      // SELECT * FROM <table> WHERE <partition key> = <key>;
+      dataflow::SchemaRef schema = dstate.GetTableSchema(table_name);
+      const dataflow::PartitionKey &cols = flow.input_partition_key(table_name);
+      sqlast::Select select{table_name};
+      select.AddColumn(sqlast::Select::ResultColumn("*"));
+      std::unique_ptr<sqlast::BinaryExpression> where;
+      for (size_t i = 0; i < cols.size(); i++) {
+        auto eq = std::make_unique<sqlast::BinaryExpression>(
+            sqlast::Expression::Type::EQ);
+        eq->SetLeft(
+            std::make_unique<sqlast::ColumnExpression>(schema.NameOf(cols[i])));
+        eq->SetRight(std::make_unique<sqlast::LiteralExpression>(key.value(i)));
+        if (where == nullptr) {
+          where = std::move(eq);
+        } else {
+          auto conj = std::make_unique<sqlast::BinaryExpression>(
+              sqlast::Expression::Type::AND);
+          conj->SetLeft(std::move(where));
+          conj->SetRight(std::move(eq));
+          where = std::move(conj);
+        }
+      }
+      select.SetWhereClause(std::move(where));
+      std::vector<dataflow::Record> records =
+          connection->session->ExecuteSelect(select).Vec();
+      for (auto &record : records) {
+        record.SetPositive(true);
+      }
+      inputs.emplace(table_name, std::move(records));
+    }
+    flow.Fill(key, std::move(inputs));
+  }
+  // Nothing to commit.
+  connection->session->RollbackTransaction();
+}
+
 // Constructing a comparator record from values.
 dataflow::Record MakeRecord(Constraint *constraint,
                             const dataflow::SchemaRef &schema) {
@@ -349,10 +584,33 @@ absl::StatusOr<sql::SqlResult> SelectView(const sqlast::Select &stmt,
   // Get the corresponding flow.
   const std::string &view_name = stmt.table_name();
   const dataflow::DataFlowGraph &flow = dstate.GetFlow(view_name);
+  ASSERT_RET(!dstate.IsBackfilling(view_name), InvalidArgument,
+             "View is being populated!");
+
+  // Read your own writes.
+  dstate.WaitForWrite(connection->last_write);
 
   // Transform WHERE statement to conditions on matview keys.
   LookupCondition condition = ConstraintKeys(flow, stmt.GetWhereClause());
 
+  // Partial views: fill any missing keys before reading. Filling excludes
+  // writers (and other readers), so that no update to these keys is missed.
+  std::optional<util::UniqueLock> upgraded;
+  if (flow.partial()) {
+    ASSERT_RET(condition.equality_keys.has_value(), InvalidArgument,
+               "Partial views can only be read by key!");
+    const std::vector<dataflow::Key> &keys = *condition.equality_keys;
+    auto &&[upgrade, _] =
+        lock->UpgradeIf([&]() { return flow.Misses(keys).size() > 0; });
+    if (upgrade.has_value()) {
+      upgraded = std::move(upgrade);
+      // Filled keys are read from the database, which already has any
+      // pending writes to them.
+      dstate.WaitForWrites();
+      FillMisses(flow, flow.Misses(keys), connection);
+    }
+  }
+
   // Read from view.
   std::vector<dataflow::Record> records =
       LookupRecords(flow, condition, stmt.limit(), stmt.offset());
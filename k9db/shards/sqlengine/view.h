@@ -13,9 +13,17 @@ namespace shards {
 namespace sqlengine {
 namespace view {
 
+// If concurrent, writes are only excluded at the start and the end of
+// populating the view from the tables, and lock is released in between.
 absl::StatusOr<sql::SqlResult> CreateView(const sqlast::CreateView &stmt,
                                           Connection *connection,
-                                          util::UniqueLock *lock);
+                                          util::UniqueLock *lock,
+                                          bool concurrent = false);
+
+// Persist the state of all (full) views, so that they are restored rather than
+// recomputed on restart.
+absl::StatusOr<sql::SqlResult> CheckpointViews(Connection *connection,
+                                               util::UniqueLock *lock);
 
 absl::StatusOr<sql::SqlResult> SelectView(const sqlast::Select &stmt,
                                           Connection *connection,
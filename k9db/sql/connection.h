@@ -3,6 +3,7 @@
 #define K9DB_SQL_CONNECTION_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -10,6 +11,7 @@
 #include <utility>
 #include <vector>
 
+#include "k9db/dataflow/checkpoint.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/sql/result.h"
 #include "k9db/sqlast/ast.h"
@@ -23,17 +25,26 @@ namespace sql {
 using RecordAndStatus = std::pair<std::optional<dataflow::Record>, int>;
 using ResultSetAndStatus = std::pair<SqlResultSet, int>;
 using KeyPair = std::pair<util::ShardName, sqlast::Value>;
+using LogEntry = std::pair<std::string, std::vector<dataflow::Record>>;
 
 class Session {
  public:
   Session() = default;
   virtual ~Session() = default;
 
-  // Commit and rollback.
+  // Commit and rollback. Commit returns false if the transaction conflicted
+  // with a concurrent one and was rolled back instead, the statement may then
+  // be retried.
   virtual void BeginTransaction(bool write) = 0;
-  virtual void CommitTransaction() = 0;
+  virtual bool CommitTransaction() = 0;
   virtual void RollbackTransaction() = 0;
 
+  // Log the updates to the given table that the current (write) transaction
+  // feeds to dataflow, so that views can be caught up from a checkpoint.
+  // The log is committed or rolled back with the transaction.
+  virtual void LogRecords(const std::string &table_name,
+                          const std::vector<dataflow::Record> &records) = 0;
+
   // Insert related API.
   virtual bool Exists(const std::string &table_name,
                       const sqlast::Value &pk) const = 0;
@@ -58,6 +69,14 @@ class Session {
 
   // Everything in a table.
   virtual SqlResultSet GetAll(const std::string &table_name) const = 0;
+  // Everything in a table, handed to callback in chunks of up to chunk_size
+  // records as they are read, so the table is never in memory all at once.
+  virtual void StreamAll(const std::string &table_name, size_t chunk_size,
+                         const std::function<void(std::vector<dataflow::Record>
+                                                      &&)> &callback) const = 0;
+  // The sequence number of the snapshot read by the current read transaction.
+  // Writes logged after it (see Connection::ReadLog()) are not visible to it.
+  virtual uint64_t SnapshotSequenceNumber() const = 0;
 
   // GDPR operations
   virtual SqlResultSet GetShard(const std::string &table_name,
@@ -102,8 +121,12 @@ class Connection {
   virtual ~Connection() = default;
 
   // Opening a connection.
+  // With archive_log, the log of writes (see Session::LogRecords()) is kept
+  // after it is no longer needed for recovery, so that views can catch up
+  // from their checkpoints.
   virtual std::vector<std::string> Open(const std::string &db_name,
-                                        const std::string &db_path) = 0;
+                                        const std::string &db_path,
+                                        bool archive_log = false) = 0;
   virtual void Close() = 0;
 
   // Schema statements.
@@ -116,10 +139,35 @@ class Connection {
   // Opening a session.
   virtual std::unique_ptr<Session> OpenSession() = 0;
 
+  // View checkpoints (see k9db/dataflow/checkpoint.h).
+  // Persist a checkpoint of a view, replacing any previous one, with the
+  // latest write as its watermark. No writes may be concurrently in progress.
+  virtual void PersistCheckpoint(
+      const std::string &view_name, const std::string &signature,
+      std::vector<dataflow::CheckpointBatch> &&batches) = 0;
+  // Load the checkpoint of a view, if one exists with the given signature.
+  virtual std::optional<dataflow::FlowCheckpoint> LoadCheckpoint(
+      const std::string &view_name, const std::string &signature,
+      const dataflow::CheckpointSchemas &schemas) const = 0;
+  virtual void DeleteCheckpoint(const std::string &view_name) = 0;
+  // The records logged to the given tables (see Session::LogRecords()) after
+  // the watermark, in order, and advances the watermark past them. Returns
+  // nothing if that part of the log is no longer available.
+  virtual std::optional<std::vector<LogEntry>> ReadLog(
+      uint64_t *watermark,
+      const std::unordered_set<std::string> &tables) const = 0;
+  // Discard the archived part of the log, e.g. after data is forgotten.
+  // Checkpoints that need it are then recomputed instead of caught up.
+  virtual void PurgeLog() = 0;
+
   // Index information for explain.
   virtual std::vector<std::string> GetIndices(const std::string &tbl) const = 0;
   virtual std::string GetIndex(const std::string &tbl,
                                const sqlast::BinaryExpression *const) const = 0;
+
+  // Storage settings as (name, value) pairs, for tuning.
+  virtual std::vector<std::pair<std::string, std::string>> GetSettings()
+      const = 0;
 };
 
 }  // namespace sql
@@ -2,6 +2,7 @@
 #ifndef K9DB_SQL_ROCKSDB_DEDUP_H_
 #define K9DB_SQL_ROCKSDB_DEDUP_H_
 
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -48,6 +49,13 @@ using DedupIndexSet =
     std::unordered_set<RocksdbIndexRecord, RocksdbIndexRecord::DedupHash,
                        RocksdbIndexRecord::DedupEqual>;
 
+// Deduplicated like DedupIndexSet, and maps each record to the value stored
+// in its index entry.
+using CoveringIndexMap =
+    std::unordered_map<RocksdbIndexRecord, std::string,
+                       RocksdbIndexRecord::DedupHash,
+                       RocksdbIndexRecord::DedupEqual>;
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
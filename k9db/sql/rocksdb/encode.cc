@@ -1,11 +1,19 @@
 #include "k9db/sql/rocksdb/encode.h"
 
 // NOLINTNEXTLINE
+#include <algorithm>
 #include <charconv>
 #include <memory>
 
 #include "glog/logging.h"
 
+// Binary rows (see RocksdbRow in encode.h).
+#define ROW_FORMAT_VERSION static_cast<char>(1)
+#define ROW_HEADER_SIZE 4
+#define ROW_COUNT_SIZE 2
+#define ROW_OFFSET_SIZE 4
+#define ROW_INT_SIZE 8
+
 namespace k9db {
 namespace sql {
 namespace rocks {
@@ -68,6 +76,154 @@ std::string EncodeValue(const sqlast::Value &val) {
   }
 }
 
+// Decodes a value encoded as in RocksdbSequence into the record.
+void DecodeEncodedValue(const rocksdb::Slice &v, size_t idx,
+                        dataflow::Record *record) {
+  if (v.size() == 1 && *v.data() == __ROCKSNULL) {
+    record->SetNull(true, idx);
+    return;
+  }
+  switch (record->schema().TypeOf(idx)) {
+    case sqlast::ColumnDefinition::Type::UINT: {
+      uint64_t num;
+      auto result = std::from_chars(v.data(), v.data() + v.size(), num);
+      CHECK(result.ec == std::errc{});
+      record->SetUInt(num, idx);
+      break;
+    }
+    case sqlast::ColumnDefinition::Type::INT: {
+      int64_t num;
+      auto result = std::from_chars(v.data(), v.data() + v.size(), num);
+      CHECK(result.ec == std::errc{});
+      record->SetInt(num, idx);
+      break;
+    }
+    case sqlast::ColumnDefinition::Type::TEXT: {
+      record->SetString(std::make_unique<std::string>(v.data(), v.size()),
+                        idx);
+      break;
+    }
+    case sqlast::ColumnDefinition::Type::DATETIME: {
+      record->SetDateTime(std::make_unique<std::string>(v.data(), v.size()),
+                          idx);
+      break;
+    }
+    default:
+      LOG(FATAL) << "UNREACHABLE";
+  }
+}
+
+// Fixed-width little endian numbers.
+void PutFixed(char *ptr, uint64_t v, size_t width) {
+  for (size_t i = 0; i < width; i++) {
+    ptr[i] = static_cast<char>(v >> (8 * i));
+  }
+}
+uint64_t GetFixed(const char *ptr, size_t width) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < width; i++) {
+    v |= static_cast<uint64_t>(static_cast<unsigned char>(ptr[i])) << (8 * i);
+  }
+  return v;
+}
+
+// Decodes a non-null value encoded as in RocksdbRow into the record.
+void DecodeBinaryValue(const rocksdb::Slice &v, size_t idx,
+                       dataflow::Record *record) {
+  switch (record->schema().TypeOf(idx)) {
+    case sqlast::ColumnDefinition::Type::UINT:
+      record->SetUInt(GetFixed(v.data(), ROW_INT_SIZE), idx);
+      break;
+    case sqlast::ColumnDefinition::Type::INT:
+      record->SetInt(static_cast<int64_t>(GetFixed(v.data(), ROW_INT_SIZE)),
+                     idx);
+      break;
+    case sqlast::ColumnDefinition::Type::TEXT:
+      record->SetString(std::make_unique<std::string>(v.data(), v.size()),
+                        idx);
+      break;
+    case sqlast::ColumnDefinition::Type::DATETIME:
+      record->SetDateTime(std::make_unique<std::string>(v.data(), v.size()),
+                          idx);
+      break;
+    default:
+      LOG(FATAL) << "UNREACHABLE";
+  }
+}
+
+// Layout of the header of a binary row with the given number of columns.
+size_t BitmapSize(size_t columns) { return (columns + 7) / 8; }
+size_t OffsetsStart(size_t columns) {
+  return ROW_HEADER_SIZE + BitmapSize(columns);
+}
+size_t DataStart(size_t columns) {
+  return OffsetsStart(columns) + ROW_OFFSET_SIZE * columns;
+}
+
+// Writes a binary row column by column.
+class RowWriter {
+ public:
+  explicit RowWriter(size_t columns) : columns_(columns), col_(0) {
+    CHECK_LT(columns, 1u << (8 * ROW_COUNT_SIZE)) << "Too many columns";
+    this->data_.resize(DataStart(columns), 0);
+    this->data_[0] = __ROCKSNULL;
+    this->data_[1] = ROW_FORMAT_VERSION;
+    PutFixed(&this->data_[2], columns, ROW_COUNT_SIZE);
+  }
+
+  void AppendNull() {
+    this->data_[ROW_HEADER_SIZE + this->col_ / 8] |= 1 << (this->col_ % 8);
+    this->EndColumn();
+  }
+  void Append(const sqlast::Value &val) {
+    switch (val.type()) {
+      case sqlast::Value::Type::_NULL:
+        this->AppendNull();
+        return;
+      case sqlast::Value::Type::INT:
+        this->AppendInt(static_cast<uint64_t>(val.GetInt()));
+        return;
+      case sqlast::Value::Type::UINT:
+        this->AppendInt(val.GetUInt());
+        return;
+      case sqlast::Value::Type::TEXT:
+        this->AppendRaw(val.GetString());
+        return;
+      default:
+        LOG(FATAL) << "UNREACHABLE";
+    }
+  }
+  // The column as it is in another binary row.
+  void AppendRaw(const rocksdb::Slice &raw) {
+    this->data_.append(raw.data(), raw.size());
+    this->EndColumn();
+  }
+
+  RocksdbRow Finish() {
+    CHECK_EQ(this->col_, this->columns_) << "Row is missing columns";
+    return RocksdbRow(std::move(this->data_));
+  }
+
+ private:
+  void AppendInt(uint64_t v) {
+    size_t pos = this->data_.size();
+    this->data_.resize(pos + ROW_INT_SIZE);
+    PutFixed(&this->data_[pos], v, ROW_INT_SIZE);
+    this->EndColumn();
+  }
+  void EndColumn() {
+    CHECK_LT(this->col_, this->columns_) << "Row has too many columns";
+    size_t end = this->data_.size() - DataStart(this->columns_);
+    size_t pos = OffsetsStart(this->columns_) + ROW_OFFSET_SIZE * this->col_;
+    PutFixed(&this->data_[pos], end, ROW_OFFSET_SIZE);
+    this->col_++;
+  }
+
+  size_t columns_;
+  size_t col_;
+  std::string data_;
+};
+
 }  // namespace
 
 /*
@@ -144,38 +300,7 @@ dataflow::Record RocksdbSequence::DecodeRecord(
   dataflow::Record record{schema, positive};
   size_t idx = 0;
   for (rocksdb::Slice v : *this) {
-    if (v.size() == 1 && *v.data() == __ROCKSNULL) {
-      record.SetNull(true, idx++);
-      continue;
-    }
-    switch (schema.TypeOf(idx)) {
-      case sqlast::ColumnDefinition::Type::UINT: {
-        uint64_t num;
-        auto result = std::from_chars(v.data(), v.data() + v.size(), num);
-        CHECK(result.ec == std::errc{});
-        record.SetUInt(num, idx++);
-        break;
-      }
-      case sqlast::ColumnDefinition::Type::INT: {
-        int64_t num;
-        auto result = std::from_chars(v.data(), v.data() + v.size(), num);
-        CHECK(result.ec == std::errc{});
-        record.SetInt(num, idx++);
-        break;
-      }
-      case sqlast::ColumnDefinition::Type::TEXT: {
-        record.SetString(std::make_unique<std::string>(v.data(), v.size()),
-                         idx++);
-        break;
-      }
-      case sqlast::ColumnDefinition::Type::DATETIME: {
-        record.SetDateTime(std::make_unique<std::string>(v.data(), v.size()),
-                           idx++);
-        break;
-      }
-      default:
-        LOG(FATAL) << "UNREACHABLE";
-    }
+    DecodeEncodedValue(v, idx++, &record);
   }
   return record;
 }
@@ -234,6 +359,177 @@ rocksdb::Slice RocksdbSequence::Iterator::operator*() const {
   return rocksdb::Slice(this->ptr_, this->next_);
 }
 
+/*
+ * RocksdbRow
+ */
+// From a record.
+RocksdbRow RocksdbRow::FromRecord(const dataflow::Record &record) {
+  RowWriter writer(record.schema().size());
+  for (size_t i = 0; i < record.schema().size(); i++) {
+    writer.Append(record.GetValue(i));
+  }
+  return writer.Finish();
+}
+
+// Format.
+bool RocksdbRow::IsLegacy() const {
+  return this->data_.size() < ROW_HEADER_SIZE ||
+         this->data_[0] != __ROCKSNULL || this->data_[1] != ROW_FORMAT_VERSION;
+}
+
+// Getting from the row.
+size_t RocksdbRow::Size() const {
+  if (this->IsLegacy()) {
+    return std::count(this->data_.begin(), this->data_.end(), __ROCKSSEP);
+  }
+  return GetFixed(&this->data_[2], ROW_COUNT_SIZE);
+}
+bool RocksdbRow::IsNull(size_t col) const {
+  if (this->IsLegacy()) {
+    rocksdb::Slice v = ExtractColumn(this->data_, col);
+    return v.size() == 1 && *v.data() == __ROCKSNULL;
+  }
+  CHECK_LT(col, this->Size()) << "Column out of bounds";
+  return (this->data_[ROW_HEADER_SIZE + col / 8] >> (col % 8)) & 1;
+}
+rocksdb::Slice RocksdbRow::Column(size_t col) const {
+  size_t columns = this->Size();
+  CHECK_LT(col, columns) << "Column out of bounds";
+  const char *offsets = this->data_.data() + OffsetsStart(columns);
+  size_t start = 0;
+  if (col > 0) {
+    start = GetFixed(offsets + ROW_OFFSET_SIZE * (col - 1), ROW_OFFSET_SIZE);
+  }
+  size_t end = GetFixed(offsets + ROW_OFFSET_SIZE * col, ROW_OFFSET_SIZE);
+  return rocksdb::Slice(this->data_.data() + DataStart(columns) + start,
+                        end - start);
+}
+
+sqlast::Value RocksdbRow::ValueAt(size_t col,
+                                  sqlast::ColumnDefinition::Type type) const {
+  if (this->IsNull(col)) {
+    return sqlast::Value();
+  }
+  if (this->IsLegacy()) {
+    rocksdb::Slice v = ExtractColumn(this->data_, col);
+    switch (type) {
+      case sqlast::ColumnDefinition::Type::UINT: {
+        uint64_t num;
+        auto result = std::from_chars(v.data(), v.data() + v.size(), num);
+        CHECK(result.ec == std::errc{});
+        return sqlast::Value(num);
+      }
+      case sqlast::ColumnDefinition::Type::INT: {
+        int64_t num;
+        auto result = std::from_chars(v.data(), v.data() + v.size(), num);
+        CHECK(result.ec == std::errc{});
+        return sqlast::Value(num);
+      }
+      case sqlast::ColumnDefinition::Type::TEXT:
+      case sqlast::ColumnDefinition::Type::DATETIME:
+        return sqlast::Value(v.ToString());
+      default:
+        LOG(FATAL) << "UNREACHABLE";
+    }
+  }
+  rocksdb::Slice v = this->Column(col);
+  switch (type) {
+    case sqlast::ColumnDefinition::Type::UINT:
+      return sqlast::Value(GetFixed(v.data(), ROW_INT_SIZE));
+    case sqlast::ColumnDefinition::Type::INT:
+      return sqlast::Value(
+          static_cast<int64_t>(GetFixed(v.data(), ROW_INT_SIZE)));
+    case sqlast::ColumnDefinition::Type::TEXT:
+    case sqlast::ColumnDefinition::Type::DATETIME:
+      return sqlast::Value(v.ToString());
+    default:
+      LOG(FATAL) << "UNREACHABLE";
+  }
+}
+
+std::string RocksdbRow::EncodedAt(size_t col,
+                                  sqlast::ColumnDefinition::Type type) const {
+  if (this->IsLegacy()) {
+    return ExtractColumn(this->data_, col).ToString();
+  }
+  if (this->IsNull(col)) {
+    return std::string(1, __ROCKSNULL);
+  }
+  rocksdb::Slice v = this->Column(col);
+  switch (type) {
+    case sqlast::ColumnDefinition::Type::UINT:
+      return std::to_string(GetFixed(v.data(), ROW_INT_SIZE));
+    case sqlast::ColumnDefinition::Type::INT:
+      return std::to_string(
+          static_cast<int64_t>(GetFixed(v.data(), ROW_INT_SIZE)));
+    case sqlast::ColumnDefinition::Type::TEXT:
+    case sqlast::ColumnDefinition::Type::DATETIME:
+      return v.ToString();
+    default:
+      LOG(FATAL) << "UNREACHABLE";
+  }
+}
+
+// Masking columns out.
+RocksdbRow RocksdbRow::Mask(const dataflow::SchemaRef &schema,
+                            const std::vector<bool> &keep) const {
+  bool legacy = this->IsLegacy();
+  RowWriter writer(schema.size());
+  for (size_t col = 0; col < schema.size(); col++) {
+    if (!keep.at(col) || this->IsNull(col)) {
+      writer.AppendNull();
+    } else if (legacy) {
+      writer.Append(this->ValueAt(col, schema.TypeOf(col)));
+    } else {
+      writer.AppendRaw(this->Column(col));
+    }
+  }
+  return writer.Finish();
+}
+
+// For reading/decoding.
+void RocksdbRow::DecodeColumn(size_t col, size_t idx,
+                              dataflow::Record *record) const {
+  if (this->IsLegacy()) {
+    DecodeEncodedValue(ExtractColumn(this->data_, col), idx, record);
+  } else if (this->IsNull(col)) {
+    record->SetNull(true, idx);
+  } else {
+    DecodeBinaryValue(this->Column(col), idx, record);
+  }
+}
+
+dataflow::Record RocksdbRow::DecodeRecord(const dataflow::SchemaRef &schema,
+                                          bool positive) const {
+  if (this->IsLegacy()) {
+    dataflow::Record record{schema, positive};
+    size_t idx = 0;
+    for (rocksdb::Slice v : RocksdbSequence(this->Data())) {
+      DecodeEncodedValue(v, idx++, &record);
+    }
+    return record;
+  }
+
+  size_t columns = this->Size();
+  CHECK_EQ(columns, schema.size()) << "Row does not match schema";
+  dataflow::Record record{schema, positive};
+  const char *bitmap = this->data_.data() + ROW_HEADER_SIZE;
+  const char *offsets = this->data_.data() + OffsetsStart(columns);
+  const char *data = this->data_.data() + DataStart(columns);
+  size_t start = 0;
+  for (size_t col = 0; col < columns; col++) {
+    size_t end = GetFixed(offsets + ROW_OFFSET_SIZE * col, ROW_OFFSET_SIZE);
+    if ((bitmap[col / 8] >> (col % 8)) & 1) {
+      record.SetNull(true, col);
+      start = end;
+      continue;
+    }
+    DecodeBinaryValue(rocksdb::Slice(data + start, end - start), col, &record);
+    start = end;
+  }
+  return record;
+}
+
 /*
  * RocksdbRecord
  */
@@ -257,14 +553,14 @@ RocksdbRecord RocksdbRecord::FromInsert(const sqlast::Insert &stmt,
   key.Append(pk_value);
 
   // Encode value.
-  RocksdbSequence value;
+  RowWriter value(schema.size());
   for (size_t i = 0; i < schema.size(); i++) {
     const sqlast::Value &val = stmt.GetValue(schema.NameOf(i), i);
     CHECK(val.TypeCompatible(schema.TypeOf(i)));
     value.Append(val);
   }
 
-  return RocksdbRecord(std::move(key), std::move(value));
+  return RocksdbRecord(std::move(key), value.Finish());
 }
 
 /*
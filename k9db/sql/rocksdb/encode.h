@@ -109,11 +109,74 @@ class RocksdbSequence {
   // For reading/decoding into dataflow.
   dataflow::Record DecodeRecord(const dataflow::SchemaRef &schema,
                                 bool positive) const;
+  // Decodes only the given column of the row into column idx of the record,
+  // with the type that column has in the record's schema.
+  void DecodeColumn(size_t col, size_t idx, dataflow::Record *record) const;
 
  private:
   std::string data_;
 };
 
+// The rows stored as values of tables (and covering indices), in a binary
+// format with O(1) access to columns:
+//   <__ROCKSNULL><version: 1 byte><column count: 2 bytes>
+//   <null bitmap: 1 bit per column><end offset of every column: 4 bytes each>
+//   <column data>
+// Integers are fixed-width (8 bytes), strings take the bytes between their
+// offsets, and NULLs take none. All numbers are little endian.
+// Rows written by older versions are RocksdbSequences, which never start
+// with the header (a leading NULL is followed by __ROCKSSEP), these are still
+// read, and are written back in the binary format when next updated.
+class RocksdbRow {
+ public:
+  // Constructing a row while reading from db.
+  explicit RocksdbRow(const rocksdb::Slice &slice)
+      : data_(slice.data(), slice.size()) {}
+  explicit RocksdbRow(std::string &&str) : data_(std::move(str)) {}
+
+  RocksdbRow() = default;
+
+  // From a given record.
+  static RocksdbRow FromRecord(const dataflow::Record &record);
+
+  // Access underlying data.
+  std::string &&Release() { return std::move(this->data_); }
+  rocksdb::Slice Data() const { return rocksdb::Slice(this->data_); }
+
+  // Whether the row was written in the older separator-based format.
+  bool IsLegacy() const;
+
+  // Getting from the row.
+  size_t Size() const;
+  bool IsNull(size_t col) const;
+  sqlast::Value ValueAt(size_t col,
+                        sqlast::ColumnDefinition::Type type) const;
+  // The value encoded as in RocksdbSequence (and thus in index keys).
+  std::string EncodedAt(size_t col,
+                        sqlast::ColumnDefinition::Type type) const;
+
+  // A copy of this row where the columns that are not kept are NULL.
+  RocksdbRow Mask(const dataflow::SchemaRef &schema,
+                  const std::vector<bool> &keep) const;
+
+  // Equality is over underlying data.
+  bool operator==(const RocksdbRow &o) const { return this->data_ == o.data_; }
+  bool operator!=(const RocksdbRow &o) const { return this->data_ != o.data_; }
+
+  // For reading/decoding into dataflow.
+  dataflow::Record DecodeRecord(const dataflow::SchemaRef &schema,
+                                bool positive) const;
+  // Decodes only the given column of the row into column idx of the record,
+  // with the type that column has in the record's schema.
+  void DecodeColumn(size_t col, size_t idx, dataflow::Record *record) const;
+
+ private:
+  // The bytes of the column (must be binary).
+  rocksdb::Slice Column(size_t col) const;
+
+  std::string data_;
+};
+
 class RocksdbRecord {
  public:
   // Construct a record when reading from rocksdb.
@@ -123,7 +186,7 @@ class RocksdbRecord {
   RocksdbRecord(std::string &&key, std::string &&value)
       : key_(std::move(key)), value_(std::move(value)) {}
 
-  RocksdbRecord(RocksdbSequence &&key, RocksdbSequence &&value)
+  RocksdbRecord(RocksdbSequence &&key, RocksdbRow &&value)
       : key_(std::move(key)), value_(std::move(value)) {}
 
   // Construct a record when handling SQL statements.
@@ -133,9 +196,9 @@ class RocksdbRecord {
 
   // For writing/encoding.
   RocksdbSequence &Key() { return this->key_; }
-  RocksdbSequence &Value() { return this->value_; }
+  RocksdbRow &Value() { return this->value_; }
   const RocksdbSequence &Key() const { return this->key_; }
-  const RocksdbSequence &Value() const { return this->value_; }
+  const RocksdbRow &Value() const { return this->value_; }
 
   // For reading/decoding.
   rocksdb::Slice GetShard() const { return this->key_.At(0); }
@@ -143,7 +206,7 @@ class RocksdbRecord {
 
  private:
   RocksdbSequence key_;
-  RocksdbSequence value_;
+  RocksdbRow value_;
 };
 
 // The output/lookup records returned by both RocksdbIndex and RocksdbPKIndex.
@@ -92,8 +92,14 @@ TEST(RocksdbEncodeTest, RocksdbRecord) {
   EXPECT_EQ(record.GetPK(), "0");
 
   // Test value.
-  EXPECT_EQ(record.Value().Data(), "0" + SEP + "user" + SEP + "-20" + SEP +
-                                       NUL + SEP + "2022-09-01 00:00:00" + SEP);
+  dataflow::Record value = record.Value().DecodeRecord(schema, true);
+  EXPECT_FALSE(record.Value().IsLegacy());
+  EXPECT_EQ(value.GetUInt(0), 0_u);
+  EXPECT_EQ(value.GetString(1), "user");
+  EXPECT_EQ(value.GetInt(2), -20_s);
+  EXPECT_TRUE(value.IsNull(3));
+  EXPECT_EQ(value.GetDateTime(4), "2022-09-01 00:00:00");
+  std::string data = record.Value().Data().ToString();
 
   // Test other constructor.
   RocksdbRecord read(record.Key().Release(), record.Value().Release());
@@ -104,8 +110,85 @@ TEST(RocksdbEncodeTest, RocksdbRecord) {
   EXPECT_EQ(read.GetPK(), "0");
 
   // Test value.
-  EXPECT_EQ(read.Value().Data(), "0" + SEP + "user" + SEP + "-20" + SEP + NUL +
-                                     SEP + "2022-09-01 00:00:00" + SEP);
+  EXPECT_EQ(read.Value().Data(), data);
+}
+
+// RocksdbRow
+TEST(RocksdbEncodeTest, RocksdbRow) {
+  dataflow::Record record{
+      schema,     true, 0_u, std::make_unique<std::string>("kinan"),
+      -10_s,      dataflow::NullValue(),
+      std::make_unique<std::string>("2022-09-01 00:00:00")};
+  RocksdbRow row = RocksdbRow::FromRecord(record);
+  EXPECT_FALSE(row.IsLegacy());
+  EXPECT_EQ(row.Size(), 5u);
+
+  // Header, bitmap, offsets, then two ints and two strings.
+  EXPECT_EQ(row.Data().size(), 4u + 1u + 5u * 4u + 8u + 5u + 8u + 19u);
+
+  // Test getters.
+  EXPECT_FALSE(row.IsNull(0));
+  EXPECT_TRUE(row.IsNull(3));
+  EXPECT_EQ(row.ValueAt(0, CType::UINT), sqlast::Value(0_u));
+  EXPECT_EQ(row.ValueAt(1, CType::TEXT), sqlast::Value("kinan"));
+  EXPECT_EQ(row.ValueAt(2, CType::INT), sqlast::Value(-10_s));
+  EXPECT_EQ(row.ValueAt(3, CType::TEXT), sqlast::Value());
+  EXPECT_EQ(row.EncodedAt(0, CType::UINT), "0");
+  EXPECT_EQ(row.EncodedAt(1, CType::TEXT), "kinan");
+  EXPECT_EQ(row.EncodedAt(2, CType::INT), "-10");
+  EXPECT_EQ(row.EncodedAt(3, CType::TEXT), NUL);
+  EXPECT_EQ(row.EncodedAt(4, CType::DATETIME), "2022-09-01 00:00:00");
+
+  // Test release / constructor and record decoding.
+  RocksdbRow read = RocksdbRow(row.Release());
+  EXPECT_EQ(read.DecodeRecord(schema, true), record);
+
+  // Test masking.
+  dataflow::Record masked = read.Mask(schema, {true, false, true, true, false})
+                                .DecodeRecord(schema, true);
+  EXPECT_EQ(masked.GetUInt(0), 0_u);
+  EXPECT_TRUE(masked.IsNull(1));
+  EXPECT_EQ(masked.GetInt(2), -10_s);
+  EXPECT_TRUE(masked.IsNull(3));
+  EXPECT_TRUE(masked.IsNull(4));
+}
+
+// Rows written by older versions are still read.
+TEST(RocksdbEncodeTest, RocksdbRowLegacy) {
+  RocksdbSequence sequence;
+  sequence.Append(sqlast::Value());  // NULL.
+  sequence.Append(sqlast::Value("kinan"));
+  sequence.Append(sqlast::Value(-10_s));
+  sequence.Append(sqlast::Value("mail"));
+  sequence.Append(sqlast::Value("2022-09-01 00:00:00"));
+  RocksdbRow row(sequence.Release());
+  EXPECT_TRUE(row.IsLegacy());
+  EXPECT_EQ(row.Size(), 5u);
+
+  // Test getters.
+  EXPECT_TRUE(row.IsNull(0));
+  EXPECT_FALSE(row.IsNull(1));
+  EXPECT_EQ(row.ValueAt(1, CType::TEXT), sqlast::Value("kinan"));
+  EXPECT_EQ(row.ValueAt(2, CType::INT), sqlast::Value(-10_s));
+  EXPECT_EQ(row.EncodedAt(0, CType::UINT), NUL);
+  EXPECT_EQ(row.EncodedAt(2, CType::INT), "-10");
+
+  // Test record decoding, and migrating to the binary format.
+  dataflow::Record record = row.DecodeRecord(schema, true);
+  EXPECT_TRUE(record.IsNull(0));
+  EXPECT_EQ(record.GetString(1), "kinan");
+  EXPECT_EQ(record.GetInt(2), -10_s);
+  EXPECT_EQ(record.GetString(3), "mail");
+  EXPECT_EQ(record.GetDateTime(4), "2022-09-01 00:00:00");
+  RocksdbRow migrated = RocksdbRow::FromRecord(record);
+  EXPECT_FALSE(migrated.IsLegacy());
+  EXPECT_EQ(migrated.DecodeRecord(schema, true), record);
+
+  // Masking migrates too.
+  RocksdbRow masked = row.Mask(schema, {true, true, false, true, true});
+  EXPECT_FALSE(masked.IsLegacy());
+  EXPECT_TRUE(masked.IsNull(2));
+  EXPECT_EQ(masked.ValueAt(3, CType::TEXT), sqlast::Value("mail"));
 }
 
 // RocksdbIndexInternalRecord
@@ -1,16 +1,15 @@
 #ifndef K9DB_SQL_ROCKSDB_ENCRYPTION_H_
 #define K9DB_SQL_ROCKSDB_ENCRYPTION_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <utility>
 
 #include "k9db/sql/rocksdb/encode.h"
 #include "k9db/sql/rocksdb/metadata.h"
 #include "k9db/util/shard_name.h"
-#include "k9db/util/upgradable_lock.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
@@ -96,23 +95,36 @@ class EncryptedKey {
 using EncryptedValue = Cipher;
 using EncryptedPrefix = Cipher;
 
+// A key along with its expanded AES-GCM state, which is computed once when the
+// key is created or loaded rather than for every row (defined in the .cc).
+struct EncryptionKey;
+
+// A shard of the map of user keys, with its own lock (defined in the .cc).
+struct UserKeyShard;
+
 // Encryption manager is responsible for encrypting / decrypting.
 // The functions of encryption manager basically become noops if encryption
 // is turned off.
 class EncryptionManager {
  public:
   EncryptionManager();
+  ~EncryptionManager();
   void Initialize(RocksdbMetadata *metadata);
 
   // Encryption of keys and values of records.
   EncryptedKey EncryptKey(RocksdbSequence &&k) const;
-  EncryptedValue EncryptValue(const std::string &shard_name,
-                              RocksdbSequence &&v);
+  EncryptedValue EncryptValue(const rocksdb::Slice &shard_name,
+                              RocksdbRow &&v);
 
   // Decryption of records.
   RocksdbSequence DecryptKey(EncryptedKey &&k) const;
-  RocksdbSequence DecryptValue(const std::string &shard_name,
-                               EncryptedValue &&v) const;
+  RocksdbRow DecryptValue(const rocksdb::Slice &shard_name,
+                          EncryptedValue &&v) const;
+
+  // Encryption of data that belongs to no user (view checkpoints) with the
+  // global key.
+  EncryptedValue EncryptGlobal(RocksdbSequence &&v) const;
+  RocksdbSequence DecryptGlobal(EncryptedValue &&v) const;
 
   // Encrypts a key for use with rocksdb Seek.
   // Given our K9dbPrefixTransform, the seek prefix is the shard name.
@@ -120,16 +132,19 @@ class EncryptionManager {
   EncryptedPrefix EncryptSeek(util::ShardName &&seek_key) const;
 
  private:
-  std::unique_ptr<unsigned char[]> global_key_;
+  std::unique_ptr<EncryptionKey> global_key_;
   std::unique_ptr<unsigned char[]> global_nonce_;
-  std::unordered_map<std::string, std::unique_ptr<unsigned char[]>> keys_;
-  mutable util::UpgradableMutex mtx_;
+  // User keys are split into shards by the hash of the shard name, each with
+  // its own lock. Keys are never removed, so threads cache pointers to the keys
+  // they recently used, tagged with id_ to tell managers apart.
+  std::unique_ptr<UserKeyShard[]> user_keys_;
+  uint64_t id_;
   RocksdbMetadata *metadata_;
 
   // Get the key of the given user, create the key for that user if it does not
   // exist.
-  const unsigned char *GetOrCreateUserKey(const std::string &shard_name);
-  const unsigned char *GetUserKey(const std::string &shard_name) const;
+  const EncryptionKey *GetOrCreateUserKey(const rocksdb::Slice &shard_name);
+  const EncryptionKey *GetUserKey(const rocksdb::Slice &shard_name) const;
 };
 
 // Extract the shard prefix from keys according to our rocksdb key format.
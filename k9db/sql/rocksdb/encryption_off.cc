@@ -30,7 +30,10 @@ EncryptedKey::Offset EncryptedKey::ShardSize(const rocksdb::Slice &slice) {
  */
 
 // Construct encryption manager.
+struct EncryptionKey {};
+struct UserKeyShard {};
 EncryptionManager::EncryptionManager() = default;
+EncryptionManager::~EncryptionManager() = default;
 void EncryptionManager::Initialize(RocksdbMetadata *metadata) {}
 
 // Encryption of keys and values of records.
@@ -38,8 +41,8 @@ EncryptedKey EncryptionManager::EncryptKey(RocksdbSequence &&k) const {
   return EncryptedKey(k.Release());
 }
 
-EncryptedValue EncryptionManager::EncryptValue(const std::string &shard_name,
-                                               RocksdbSequence &&v) {
+EncryptedValue EncryptionManager::EncryptValue(
+    const rocksdb::Slice &shard_name, RocksdbRow &&v) {
   return EncryptedValue(v.Release());
 }
 
@@ -48,8 +51,16 @@ RocksdbSequence EncryptionManager::DecryptKey(EncryptedKey &&k) const {
   return RocksdbSequence(k.Release());
 }
 
-RocksdbSequence EncryptionManager::DecryptValue(const std::string &shard_name,
-                                                EncryptedValue &&v) const {
+RocksdbRow EncryptionManager::DecryptValue(
+    const rocksdb::Slice &shard_name, EncryptedValue &&v) const {
+  return RocksdbRow(v.Release());
+}
+
+// Encryption with the global key.
+EncryptedValue EncryptionManager::EncryptGlobal(RocksdbSequence &&v) const {
+  return EncryptedValue(v.Release());
+}
+RocksdbSequence EncryptionManager::DecryptGlobal(EncryptedValue &&v) const {
   return RocksdbSequence(v.Release());
 }
 
@@ -61,13 +72,13 @@ EncryptedPrefix EncryptionManager::EncryptSeek(util::ShardName &&seek) const {
 }
 
 // Helpers are unused.
-const unsigned char *EncryptionManager::GetOrCreateUserKey(
-    const std::string &shard_name) {
+const EncryptionKey *EncryptionManager::GetOrCreateUserKey(
+    const rocksdb::Slice &shard_name) {
   LOG(FATAL) << "ENCRYPTION OFF!";
   return nullptr;
 }
-const unsigned char *EncryptionManager::GetUserKey(
-    const std::string &shard_name) const {
+const EncryptionKey *EncryptionManager::GetUserKey(
+    const rocksdb::Slice &shard_name) const {
   LOG(FATAL) << "ENCRYPTION OFF!";
   return nullptr;
 }
@@ -3,9 +3,17 @@
 #include "k9db/sql/rocksdb/encryption.h"
 // clang-format on
 
-#include <cassert>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+// NOLINTNEXTLINE
+#include <string_view>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "glog/logging.h"
+#include "k9db/util/upgradable_lock.h"
 // NOLINTNEXTLINE
 #include "sodium.h"
 
@@ -16,36 +24,78 @@ namespace rocks {
 #define KEY_SIZE crypto_aead_aes256gcm_KEYBYTES
 #define NONCE_SIZE crypto_aead_aes256gcm_NPUBBYTES
 #define CIPHER_OVERHEAD crypto_aead_aes256gcm_ABYTES
-#define PLAIN_MAX_LEN 10000
 
-#define ENCRYPT(dst, dsz, src, sz, nonce, key) \
-  crypto_aead_aes256gcm_encrypt(dst, dsz, src, sz, nullptr, 0, NULL, nonce, key)
-#define DECRYPT(dst, dsz, src, sz, nonce, key) \
-  crypto_aead_aes256gcm_decrypt(dst, dsz, NULL, src, sz, nullptr, 0, nonce, key)
+// Number of shards in the map of user keys.
+#define USER_KEY_SHARDS 64
+// Number of user keys every thread caches.
+#define USER_KEY_CACHE 16
+
+#define ENCRYPT(dst, dsz, src, sz, nonce, state)                             \
+  crypto_aead_aes256gcm_encrypt_afternm(dst, dsz, src, sz, nullptr, 0, NULL, \
+                                        nonce, state)
+#define DECRYPT(dst, dsz, src, sz, nonce, state)                             \
+  crypto_aead_aes256gcm_decrypt_afternm(dst, dsz, NULL, src, sz, nullptr, 0, \
+                                        nonce, state)
+
+// The state is 16-byte aligned, which std::make_unique respects.
+struct EncryptionKey {
+  unsigned char key[KEY_SIZE];
+  crypto_aead_aes256gcm_state state;
+
+  // Expand the key, must be called after key is set.
+  void Expand() { crypto_aead_aes256gcm_beforenm(&this->state, this->key); }
+};
+
+// Keys are looked up by string view without building a string.
+struct UserKeyShard {
+  util::UpgradableMutex mtx;
+  absl::flat_hash_map<std::string, std::unique_ptr<EncryptionKey>> keys;
+};
 
 namespace {
 
-std::string Encrypt(rocksdb::Slice input, const unsigned char *nonce,
-                    const unsigned char *key) {
+// Every thread caches the user keys it used last, direct-mapped by the hash of
+// the shard name. Entries of different managers are told apart by their id.
+struct CachedKey {
+  uint64_t manager = 0;
+  size_t hash = 0;
+  std::string shard_name;
+  const EncryptionKey *key = nullptr;
+};
+thread_local CachedKey key_cache[USER_KEY_CACHE];
+
+// Ids of managers, 0 marks empty cache entries.
+std::atomic<uint64_t> manager_ids = 1;
+
+// Same as util::ShardName::Hash.
+size_t HashShardName(absl::string_view shard_name) {
+  return std::hash<std::string_view>()(
+      std::string_view(shard_name.data(), shard_name.size()));
+}
+
+// Encrypt/decrypt input and append the result to dst, so that data is
+// encrypted/decrypted straight into its destination without intermediate
+// buffers or bounds on its size.
+void Encrypt(std::string *dst, const rocksdb::Slice &input,
+             const unsigned char *nonce, const EncryptionKey &key) {
   const unsigned char *input_buf =
       reinterpret_cast<const unsigned char *>(input.data());
 
-  // Allocate memory.
-  size_t capacity = input.size() + CIPHER_OVERHEAD;
-  std::unique_ptr<unsigned char[]> dst =
-      std::make_unique<unsigned char[]>(capacity);
+  size_t offset = dst->size();
+  dst->resize(offset + input.size() + CIPHER_OVERHEAD);
+  unsigned char *dst_buf = reinterpret_cast<unsigned char *>(&(*dst)[offset]);
 
   // NOLINTNEXTLINE
   unsigned long long size;
-  if (ENCRYPT(dst.get(), &size, input_buf, input.size(), nonce, key) != 0) {
+  if (ENCRYPT(dst_buf, &size, input_buf, input.size(), nonce, &key.state) !=
+      0) {
     LOG(FATAL) << "Cannot encrypt!";
   }
-
-  return std::string(reinterpret_cast<const char *>(dst.get()), size);
+  dst->resize(offset + size);
 }
 
-std::string Decrypt(rocksdb::Slice input, const unsigned char *nonce,
-                    const unsigned char *key) {
+void Decrypt(std::string *dst, const rocksdb::Slice &input,
+             const unsigned char *nonce, const EncryptionKey &key) {
   if (input.size() < CIPHER_OVERHEAD) {
     LOG(FATAL) << "Cipher too short to decrypt!";
   }
@@ -53,26 +103,65 @@ std::string Decrypt(rocksdb::Slice input, const unsigned char *nonce,
   const unsigned char *input_buf =
       reinterpret_cast<const unsigned char *>(input.data());
 
-  // Allocate memory for plaintext.
-  std::unique_ptr<unsigned char[]> dst =
-      std::make_unique<unsigned char[]>(PLAIN_MAX_LEN);
+  size_t offset = dst->size();
+  dst->resize(offset + input.size() - CIPHER_OVERHEAD);
+  unsigned char *dst_buf = reinterpret_cast<unsigned char *>(&(*dst)[offset]);
 
   // NOLINTNEXTLINE
   unsigned long long size;
-  if (DECRYPT(dst.get(), &size, input_buf, input.size(), nonce, key) != 0) {
+  if (DECRYPT(dst_buf, &size, input_buf, input.size(), nonce, &key.state) !=
+      0) {
     LOG(FATAL) << "Cannot decrypt!";
   }
+  dst->resize(offset + size);
+}
+
+// Encrypt v with a fresh random nonce, stored in front of the cipher.
+std::string EncryptWithNonce(const rocksdb::Slice &v,
+                             const EncryptionKey &key) {
+  std::string cipher;
+  cipher.reserve(NONCE_SIZE + v.size() + CIPHER_OVERHEAD);
+  cipher.resize(NONCE_SIZE);
+  randombytes_buf(cipher.data(), NONCE_SIZE);
+  const unsigned char *nonce =
+      reinterpret_cast<const unsigned char *>(cipher.data());
+  Encrypt(&cipher, v, nonce, key);
+  return cipher;
+}
+std::string DecryptWithNonce(const std::string &cipher,
+                             const EncryptionKey &key) {
+  if (cipher.size() < NONCE_SIZE) {
+    LOG(FATAL) << "Cipher too short to decrypt!";
+  }
+  const unsigned char *nonce =
+      reinterpret_cast<const unsigned char *>(cipher.data());
+  rocksdb::Slice data(cipher.data() + NONCE_SIZE, cipher.size() - NONCE_SIZE);
+  std::string plain;
+  Decrypt(&plain, data, nonce, key);
+  return plain;
+}
+
+std::unique_ptr<EncryptionKey> GenerateKey() {
+  std::unique_ptr<EncryptionKey> key = std::make_unique<EncryptionKey>();
+  crypto_aead_aes256gcm_keygen(key->key);
+  key->Expand();
+  return key;
+}
 
-  return std::string(reinterpret_cast<const char *>(dst.get()), size);
+std::unique_ptr<EncryptionKey> DeserializeKey(const std::string &str) {
+  CHECK_EQ(str.size(), KEY_SIZE);
+  std::unique_ptr<EncryptionKey> key = std::make_unique<EncryptionKey>();
+  std::memcpy(key->key, str.data(), KEY_SIZE);
+  key->Expand();
+  return key;
 }
 
-std::unique_ptr<unsigned char[]> DeserializeKey(const std::string &str,
-                                                size_t size) {
-  CHECK_EQ(str.size(), size);
-  std::unique_ptr<char[]> ptr = std::make_unique<char[]>(size);
-  std::memcpy(ptr.get(), str.data(), size);
-  return std::unique_ptr<unsigned char[]>(
-      reinterpret_cast<unsigned char *>(ptr.release()));
+std::unique_ptr<unsigned char[]> DeserializeNonce(const std::string &str) {
+  CHECK_EQ(str.size(), NONCE_SIZE);
+  std::unique_ptr<unsigned char[]> ptr =
+      std::make_unique<unsigned char[]>(NONCE_SIZE);
+  std::memcpy(ptr.get(), str.data(), NONCE_SIZE);
+  return ptr;
 }
 
 std::string SerializeKey(const unsigned char *key, size_t size) {
@@ -118,19 +207,23 @@ EncryptedKey::Offset EncryptedKey::ShardSize(const rocksdb::Slice &slice) {
 
 // Construct encryption manager.
 EncryptionManager::EncryptionManager()
-    : global_key_(std::make_unique<unsigned char[]>(KEY_SIZE)),
+    : global_key_(),
       global_nonce_(std::make_unique<unsigned char[]>(NONCE_SIZE)),
-      keys_(),
-      mtx_(),
+      user_keys_(std::make_unique<UserKeyShard[]>(USER_KEY_SHARDS)),
+      id_(manager_ids++),
       metadata_(nullptr) {
-  // Initialize libsodium.
-  assert(sodium_init() >= 0);
+  // Initialize libsodium (before expanding any keys).
+  if (sodium_init() < 0) {
+    LOG(FATAL) << "Cannot initialize libsodium!";
+  }
 
   // Generate random global key and nonce.
-  crypto_aead_aes256gcm_keygen(this->global_key_.get());
+  this->global_key_ = GenerateKey();
   randombytes_buf(this->global_nonce_.get(), NONCE_SIZE);
 }
 
+EncryptionManager::~EncryptionManager() = default;
+
 // Initialization: load any previously created keys from persistent storage.
 void EncryptionManager::Initialize(RocksdbMetadata *metadata) {
   this->metadata_ = metadata;
@@ -139,95 +232,152 @@ void EncryptionManager::Initialize(RocksdbMetadata *metadata) {
   std::optional<std::string> key = metadata->LoadGlobalKey();
   std::optional<std::string> nonce = metadata->LoadGlobalNonce();
   if (key.has_value()) {
-    this->global_key_ = DeserializeKey(key.value(), KEY_SIZE);
-    this->global_nonce_ = DeserializeKey(nonce.value(), NONCE_SIZE);
+    this->global_key_ = DeserializeKey(key.value());
+    this->global_nonce_ = DeserializeNonce(nonce.value());
   } else {
-    metadata->PersistGlobalKey(SerializeKey(this->global_key_.get(), KEY_SIZE));
+    metadata->PersistGlobalKey(SerializeKey(this->global_key_->key, KEY_SIZE));
     metadata->PersistGlobalNonce(
         SerializeKey(this->global_nonce_.get(), NONCE_SIZE));
   }
 
   // Load user keys.
   for (const auto &[user, key] : metadata->LoadUserKeys()) {
-    this->keys_.emplace(user, DeserializeKey(key, KEY_SIZE));
+    size_t hash = HashShardName(user);
+    UserKeyShard &shard = this->user_keys_[hash % USER_KEY_SHARDS];
+    shard.keys.emplace(user, DeserializeKey(key));
   }
 }
 
 // Get the key of the given user.
-const unsigned char *EncryptionManager::GetUserKey(
-    const std::string &shard_name) const {
-  util::SharedLock lock(&this->mtx_);
-  return this->keys_.at(shard_name).get();
+const EncryptionKey *EncryptionManager::GetUserKey(
+    const rocksdb::Slice &shard_name) const {
+  absl::string_view view(shard_name.data(), shard_name.size());
+  size_t hash = HashShardName(view);
+  CachedKey &cached = key_cache[hash % USER_KEY_CACHE];
+  if (cached.manager == this->id_ && cached.hash == hash &&
+      cached.shard_name == view) {
+    return cached.key;
+  }
+
+  // Not cached, find in map.
+  UserKeyShard &shard = this->user_keys_[hash % USER_KEY_SHARDS];
+  const EncryptionKey *key;
+  {
+    util::SharedLock lock(&shard.mtx);
+    auto it = shard.keys.find(view);
+    CHECK(it != shard.keys.end()) << "No key for user " << view;
+    key = it->second.get();
+  }
+  cached.manager = this->id_;
+  cached.hash = hash;
+  cached.shard_name.assign(view.data(), view.size());
+  cached.key = key;
+  return key;
 }
 
 // Get the key of the given user.
 // Create the key if that user does not yet have one.
-const unsigned char *EncryptionManager::GetOrCreateUserKey(
-    const std::string &shard_name) {
-  util::SharedLock lock(&this->mtx_);
-  auto &&[upgraded, condition] =
-      lock.UpgradeIf([&]() { return this->keys_.count(shard_name) == 0; });
-  if (condition) {
-    std::unique_ptr<unsigned char[]> key =
-        std::make_unique<unsigned char[]>(KEY_SIZE);
-    crypto_aead_aes256gcm_keygen(key.get());
-    auto [eit, _] = this->keys_.emplace(shard_name, std::move(key));
-    const unsigned char *ptr = eit->second.get();
-    // Unlock mutex before writing to persistent storage.
-    upgraded->unlock();
-    // Persist key.
-    if (this->metadata_ != nullptr) {
-      this->metadata_->PersistUserKey(shard_name, SerializeKey(ptr, KEY_SIZE));
+const EncryptionKey *EncryptionManager::GetOrCreateUserKey(
+    const rocksdb::Slice &shard_name) {
+  absl::string_view view(shard_name.data(), shard_name.size());
+  size_t hash = HashShardName(view);
+  CachedKey &cached = key_cache[hash % USER_KEY_CACHE];
+  if (cached.manager == this->id_ && cached.hash == hash &&
+      cached.shard_name == view) {
+    return cached.key;
+  }
+
+  // Not cached, find in map or create.
+  UserKeyShard &shard = this->user_keys_[hash % USER_KEY_SHARDS];
+  const EncryptionKey *key;
+  {
+    util::SharedLock lock(&shard.mtx);
+    auto &&[upgraded, condition] =
+        lock.UpgradeIf([&]() { return shard.keys.count(view) == 0; });
+    if (condition) {
+      auto [eit, _] = shard.keys.emplace(std::string(view), GenerateKey());
+      key = eit->second.get();
+      // Unlock mutex before writing to persistent storage.
+      upgraded->unlock();
+      // Persist key.
+      if (this->metadata_ != nullptr) {
+        this->metadata_->PersistUserKey(std::string(view),
+                                        SerializeKey(key->key, KEY_SIZE));
+      } else {
+        LOG(WARNING) << "User keys are not persisted!";
+      }
     } else {
-      LOG(WARNING) << "User keys are not persisted!";
+      key = shard.keys.find(view)->second.get();
     }
-    return ptr;
   }
-  return this->keys_.at(shard_name).get();
+  cached.manager = this->id_;
+  cached.hash = hash;
+  cached.shard_name.assign(view.data(), view.size());
+  cached.key = key;
+  return key;
 }
 
 // Encryption of keys and values of records.
+// The key is encrypted piece-wise directly into its final layout:
+// <shard cipher><pk cipher><size of shard cipher: 2 bytes>.
 EncryptedKey EncryptionManager::EncryptKey(RocksdbSequence &&k) const {
   const unsigned char *nonce = this->global_nonce_.get();
-  const unsigned char *key = this->global_key_.get();
-  return EncryptedKey(Cipher(Encrypt(k.At(0), nonce, key)),
-                      Cipher(Encrypt(k.At(1), nonce, key)));
+  const EncryptionKey &key = *this->global_key_;
+  rocksdb::Slice shard = k.At(0);
+  rocksdb::Slice pk = k.At(1);
+
+  std::string data;
+  data.reserve(shard.size() + pk.size() + 2 * CIPHER_OVERHEAD +
+               sizeof(EncryptedKey::Offset));
+  Encrypt(&data, shard, nonce, key);
+  EncryptedKey::Offset size = data.size();
+  Encrypt(&data, pk, nonce, key);
+  const char *ptr = reinterpret_cast<char *>(&size);
+  data.push_back(ptr[0]);
+  data.push_back(ptr[1]);
+  return EncryptedKey(std::move(data));
 }
-EncryptedValue EncryptionManager::EncryptValue(const std::string &shard_name,
-                                               RocksdbSequence &&v) {
-  unsigned char *nonce = new unsigned char[NONCE_SIZE];
-  randombytes_buf(nonce, NONCE_SIZE);
-  const unsigned char *key = this->GetOrCreateUserKey(shard_name);
-  std::string nonce_str(reinterpret_cast<char *>(nonce), NONCE_SIZE);
-  std::string cipher_str = Encrypt(v.Data(), nonce, key);
-  return Cipher(nonce_str + cipher_str);
+EncryptedValue EncryptionManager::EncryptValue(
+    const rocksdb::Slice &shard_name, RocksdbRow &&v) {
+  const EncryptionKey *key = this->GetOrCreateUserKey(shard_name);
+  return Cipher(EncryptWithNonce(v.Data(), *key));
 }
 
 // Decryption of records.
 RocksdbSequence EncryptionManager::DecryptKey(EncryptedKey &&k) const {
   const unsigned char *nonce = this->global_nonce_.get();
-  const unsigned char *key = this->global_key_.get();
+  const EncryptionKey &key = *this->global_key_;
+  rocksdb::Slice shard = k.GetShard();
+  rocksdb::Slice pk = k.GetPK();
+
+  // Decrypt into an encoded sequence of two values.
+  std::string data;
+  data.reserve(shard.size() + pk.size());
+  Decrypt(&data, shard, nonce, key);
+  data.push_back(__ROCKSSEP);
+  Decrypt(&data, pk, nonce, key);
+  data.push_back(__ROCKSSEP);
+  return RocksdbSequence(std::move(data));
+}
+RocksdbRow EncryptionManager::DecryptValue(
+    const rocksdb::Slice &shard_name, EncryptedValue &&v) const {
+  const EncryptionKey *key = this->GetUserKey(shard_name);
+  return RocksdbRow(DecryptWithNonce(v.Release(), *key));
+}
 
-  RocksdbSequence result;
-  result.AppendEncoded(Decrypt(k.GetShard(), nonce, key));
-  result.AppendEncoded(Decrypt(k.GetPK(), nonce, key));
-  return result;
+// Encryption with the global key.
+EncryptedValue EncryptionManager::EncryptGlobal(RocksdbSequence &&v) const {
+  return Cipher(EncryptWithNonce(v.Data(), *this->global_key_));
 }
-RocksdbSequence EncryptionManager::DecryptValue(const std::string &shard_name,
-                                                EncryptedValue &&v) const {
-  std::string str = v.Release();
-  const char *ptr = str.data();
-  const unsigned char *nonce = reinterpret_cast<const unsigned char *>(ptr);
-  const unsigned char *key = this->GetUserKey(shard_name);
-  rocksdb::Slice cipher(ptr + NONCE_SIZE, str.size() - NONCE_SIZE);
-  return RocksdbSequence(Decrypt(cipher, nonce, key));
+RocksdbSequence EncryptionManager::DecryptGlobal(EncryptedValue &&v) const {
+  return RocksdbSequence(DecryptWithNonce(v.Release(), *this->global_key_));
 }
 
 // Encrypts a key for use with rocksdb Seek.
 EncryptedPrefix EncryptionManager::EncryptSeek(util::ShardName &&seek) const {
   const unsigned char *nonce = this->global_nonce_.get();
-  const unsigned char *key = this->global_key_.get();
-  std::string cipher = Encrypt(seek.AsSlice(), nonce, key);
+  std::string cipher;
+  Encrypt(&cipher, seek.AsSlice(), nonce, *this->global_key_);
   EncryptedKey::Offset size = cipher.size();
   const char *ptr = reinterpret_cast<char *>(&size);
   cipher.push_back(ptr[0]);
@@ -11,10 +11,41 @@ namespace k9db {
 namespace sql {
 namespace rocks {
 
-bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
-                    const dataflow::Record &record) {
+namespace {
+
+// Compare a non-null record value to a range bound: negative if value is
+// smaller, positive if it is larger.
+int CompareToBound(const sqlast::Value &value, const sqlast::Value &bound) {
+  if (value.type() == sqlast::Value::Type::TEXT) {
+    CHECK_EQ(bound.type(), sqlast::Value::Type::TEXT) << "Bad comparison";
+    return value.GetString().compare(bound.GetString());
+  }
+  CHECK_NE(bound.type(), sqlast::Value::Type::TEXT) << "Bad comparison";
+  // Integers of different signedness compare by value.
+  bool vneg = value.type() == sqlast::Value::Type::INT && value.GetInt() < 0;
+  bool bneg = bound.type() == sqlast::Value::Type::INT && bound.GetInt() < 0;
+  if (vneg != bneg) {
+    return vneg ? -1 : 1;
+  }
+  if (vneg) {
+    int64_t v = value.GetInt();
+    int64_t b = bound.GetInt();
+    return v < b ? -1 : (v > b ? 1 : 0);
+  }
+  uint64_t v = value.type() == sqlast::Value::Type::INT
+                   ? static_cast<uint64_t>(value.GetInt())
+                   : value.GetUInt();
+  uint64_t b = bound.type() == sqlast::Value::Type::INT
+                   ? static_cast<uint64_t>(bound.GetInt())
+                   : bound.GetUInt();
+  return v < b ? -1 : (v > b ? 1 : 0);
+}
+
+// Filter using the given function to get the values of columns.
+template <typename F>
+bool Filter(const sqlast::ValueMapper &value_mapper, F &&get) {
   for (const auto &[i, vals] : value_mapper.Values()) {
-    sqlast::Value value = record.GetValue(i);
+    sqlast::Value value = get(i);
     if (value.type() == sqlast::Value::Type::UINT) {
       value = sqlast::Value(static_cast<int64_t>(value.GetUInt()));
     }
@@ -22,9 +53,36 @@ bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
       return false;
     }
   }
+  for (const auto &[i, range] : value_mapper.Ranges()) {
+    sqlast::Value value = get(i);
+    if (value.IsNull()) {
+      return false;
+    }
+    if (range.lower.has_value() &&
+        CompareToBound(value, range.lower.value()) <= 0) {
+      return false;
+    }
+    if (range.upper.has_value() &&
+        CompareToBound(value, range.upper.value()) >= 0) {
+      return false;
+    }
+  }
   return true;
 }
 
+}  // namespace
+
+bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
+                    const dataflow::Record &record) {
+  return Filter(value_mapper, [&](size_t i) { return record.GetValue(i); });
+}
+
+bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
+                    const RocksdbRow &row, const dataflow::SchemaRef &schema) {
+  return Filter(value_mapper,
+                [&](size_t i) { return row.ValueAt(i, schema.TypeOf(i)); });
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
@@ -3,6 +3,7 @@
 
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/encode.h"
 #include "k9db/sqlast/value_mapper.h"
 
 namespace k9db {
@@ -12,6 +13,10 @@ namespace rocks {
 bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
                     const dataflow::Record &record);
 
+// Filters an encoded row, decoding only the columns the filter reads.
+bool InMemoryFilter(const sqlast::ValueMapper &value_mapper,
+                    const RocksdbRow &row, const dataflow::SchemaRef &schema);
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
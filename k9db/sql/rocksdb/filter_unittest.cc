@@ -2,11 +2,13 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/encode.h"
 #include "k9db/sqlast/value_mapper.h"
 #include "k9db/util/ints.h"
 
@@ -184,6 +186,124 @@ TEST(FilterTest, Combined) {
   EXPECT_FALSE(InMemoryFilter(cond, r5));
 }
 
+// Range filters, bounds are exclusive.
+TEST(FilterTest, RangeFilters) {
+  sqlast::ValueMapper cond(schema);
+  cond.AddRange(2, {sqlast::Value(0_s), {}});
+  EXPECT_TRUE(InMemoryFilter(cond, r1));
+  EXPECT_FALSE(InMemoryFilter(cond, r2));
+  EXPECT_TRUE(InMemoryFilter(cond, r3));
+  EXPECT_TRUE(InMemoryFilter(cond, r4));
+  EXPECT_FALSE(InMemoryFilter(cond, r5));
+
+  cond = sqlast::ValueMapper(schema);
+  cond.AddRange(0, {sqlast::Value(-1_s), sqlast::Value(2_s)});
+  EXPECT_TRUE(InMemoryFilter(cond, r1));
+  EXPECT_TRUE(InMemoryFilter(cond, r2));
+  EXPECT_FALSE(InMemoryFilter(cond, r3));
+  EXPECT_FALSE(InMemoryFilter(cond, r4));
+  EXPECT_FALSE(InMemoryFilter(cond, r5));
+
+  cond = sqlast::ValueMapper(schema);
+  cond.AddRange(1, {{}, sqlast::Value("user4")});
+  ADD_CONDITION(cond, 2, "20");
+  EXPECT_TRUE(InMemoryFilter(cond, r1));
+  EXPECT_FALSE(InMemoryFilter(cond, r2));
+  EXPECT_TRUE(InMemoryFilter(cond, r3));
+  EXPECT_FALSE(InMemoryFilter(cond, r4));
+  EXPECT_FALSE(InMemoryFilter(cond, r5));
+}
+
+// Filters over encoded rows agree with filters over records.
+TEST(FilterTest, RowFilters) {
+  std::vector<const dataflow::Record *> records = {&r1, &r2, &r3, &r4, &r5};
+  sqlast::ValueMapper cond(schema);
+  ADD_CONDITION(cond, 1, "'user2'");
+  ADD_CONDITION(cond, 1, "NULL");
+  ADD_CONDITION(cond, 2, "0");
+  ADD_CONDITION(cond, 2, "NULL");
+  for (const dataflow::Record *record : records) {
+    RocksdbRow row = RocksdbRow::FromRecord(*record);
+    EXPECT_EQ(InMemoryFilter(cond, row, schema),
+              InMemoryFilter(cond, *record));
+  }
+
+  cond = sqlast::ValueMapper(schema);
+  cond.AddRange(0, {sqlast::Value(-1_s), sqlast::Value(2_s)});
+  cond.AddRange(2, {{}, sqlast::Value(25_s)});
+  for (const dataflow::Record *record : records) {
+    RocksdbRow row = RocksdbRow::FromRecord(*record);
+    EXPECT_EQ(InMemoryFilter(cond, row, schema),
+              InMemoryFilter(cond, *record));
+  }
+}
+
+// Several bounds on a column are intersected.
+TEST(FilterTest, IntersectRanges) {
+  using Type = sqlast::Expression::Type;
+  auto gt = [](std::unique_ptr<sqlast::Expression> &&l,
+               std::unique_ptr<sqlast::Expression> &&r) {
+    auto expr = std::make_unique<sqlast::BinaryExpression>(Type::GREATER_THAN);
+    expr->SetLeft(std::move(l));
+    expr->SetRight(std::move(r));
+    return expr;
+  };
+  auto col = []() { return std::make_unique<sqlast::ColumnExpression>("age"); };
+  auto val = [](int64_t v) {
+    return std::make_unique<sqlast::LiteralExpression>(sqlast::Value(v));
+  };
+
+  // age > 1 AND age > 5 AND 30 > age AND 25 > age.
+  auto left = std::make_unique<sqlast::BinaryExpression>(Type::AND);
+  left->SetLeft(gt(col(), val(1)));
+  left->SetRight(gt(col(), val(5)));
+  auto right = std::make_unique<sqlast::BinaryExpression>(Type::AND);
+  right->SetLeft(gt(val(30), col()));
+  right->SetRight(gt(val(25), col()));
+  sqlast::BinaryExpression where(Type::AND);
+  where.SetLeft(std::move(left));
+  where.SetRight(std::move(right));
+
+  sqlast::ValueMapper cond(schema);
+  cond.VisitBinaryExpression(where);
+  EXPECT_TRUE(cond.status().ok());
+  sqlast::ValueMapper::Range range = cond.ReleaseRange(2);
+  EXPECT_EQ(range.lower, sqlast::Value(5_s));
+  EXPECT_EQ(range.upper, sqlast::Value(25_s));
+
+  // Integer literals of different signedness are compared by value, e.g. in
+  // age > -1 AND age > 5 the literal 5 is parsed as unsigned.
+  auto uval = [](uint64_t v) {
+    return std::make_unique<sqlast::LiteralExpression>(sqlast::Value(v));
+  };
+  sqlast::BinaryExpression mixed(Type::AND);
+  mixed.SetLeft(gt(col(), val(-1)));
+  mixed.SetRight(gt(col(), uval(5)));
+  sqlast::ValueMapper mixed_cond(schema);
+  mixed_cond.VisitBinaryExpression(mixed);
+  EXPECT_TRUE(mixed_cond.status().ok());
+  range = mixed_cond.ReleaseRange(2);
+  EXPECT_EQ(range.lower, sqlast::Value(5_s));
+
+  // Text and integer bounds on the same column cannot be compared.
+  sqlast::BinaryExpression text(Type::AND);
+  text.SetLeft(gt(col(), val(1)));
+  text.SetRight(gt(col(), std::make_unique<sqlast::LiteralExpression>(
+                              sqlast::Value(std::string("a")))));
+  sqlast::ValueMapper text_cond(schema);
+  text_cond.VisitBinaryExpression(text);
+  EXPECT_FALSE(text_cond.status().ok());
+
+  // Comparisons between columns or with NULL are errors, not crashes.
+  sqlast::ValueMapper bad(schema);
+  bad.VisitBinaryExpression(*gt(col(), col()));
+  EXPECT_FALSE(bad.status().ok());
+  sqlast::ValueMapper null(schema);
+  null.VisitBinaryExpression(
+      *gt(col(), std::make_unique<sqlast::LiteralExpression>(sqlast::Value())));
+  EXPECT_FALSE(null.status().ok());
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
@@ -0,0 +1,58 @@
+#include "k9db/sql/rocksdb/group_commit.h"
+
+// NOLINTNEXTLINE
+#include <thread>
+
+#include "glog/logging.h"
+#include "k9db/util/status.h"
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+GroupCommit::GroupCommit(rocksdb::DB *db, std::chrono::microseconds window)
+    : db_(db),
+      window_(window),
+      requested_(0),
+      synced_(0),
+      syncs_(0),
+      syncing_(false) {}
+
+void GroupCommit::Sync() {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  uint64_t ticket = ++this->requested_;
+  while (this->synced_ < ticket) {
+    if (this->syncing_) {
+      this->cv_.wait(lock);
+      continue;
+    }
+
+    // Lead the next sync: let others join during the window, everyone who
+    // asked by then committed before the sync starts, and is covered by it.
+    this->syncing_ = true;
+    lock.unlock();
+    std::this_thread::sleep_for(this->window_);
+    lock.lock();
+    uint64_t target = this->requested_;
+    lock.unlock();
+    PANIC(this->db_->FlushWAL(true));
+    lock.lock();
+    this->synced_ = target;
+    this->syncs_++;
+    this->syncing_ = false;
+    this->cv_.notify_all();
+  }
+}
+
+uint64_t GroupCommit::Commits() const {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  return this->synced_;
+}
+uint64_t GroupCommit::Syncs() const {
+  std::unique_lock<std::mutex> lock(this->mtx_);
+  return this->syncs_;
+}
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
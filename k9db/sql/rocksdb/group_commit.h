@@ -0,0 +1,54 @@
+// Group commit: coalescing the WAL syncs of concurrent write transactions.
+#ifndef K9DB_SQL_ROCKSDB_GROUP_COMMIT_H_
+#define K9DB_SQL_ROCKSDB_GROUP_COMMIT_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+// NOLINTNEXTLINE
+#include <mutex>
+
+#include "rocksdb/db.h"
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+// Transactions commit to the WAL without syncing it, and then wait in Sync()
+// until a sync that covers their commit is done. The first waiter leads: it
+// waits for the window so that concurrent commits can join, and then syncs
+// the WAL once on behalf of all of them. The others wait for the leader, or
+// lead the next sync if theirs came too late for the current one.
+class GroupCommit {
+ public:
+  GroupCommit(rocksdb::DB *db, std::chrono::microseconds window);
+
+  // Cannot copy or move, sessions point to the group commit.
+  GroupCommit(const GroupCommit &) = delete;
+  GroupCommit &operator=(const GroupCommit &) = delete;
+
+  // Returns once everything written to the WAL before the call is synced.
+  void Sync();
+
+  // Statistics.
+  uint64_t Commits() const;
+  uint64_t Syncs() const;
+
+ private:
+  rocksdb::DB *db_;
+  std::chrono::microseconds window_;
+  mutable std::mutex mtx_;
+  std::condition_variable cv_;
+  // Calls to Sync() so far, and how many of them are covered by a done sync.
+  uint64_t requested_;
+  uint64_t synced_;
+  uint64_t syncs_;
+  // Whether some thread is leading a sync.
+  bool syncing_;
+};
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
+
+#endif  // K9DB_SQL_ROCKSDB_GROUP_COMMIT_H_
@@ -0,0 +1,73 @@
+#include "k9db/sql/rocksdb/group_commit.h"
+
+// NOLINTNEXTLINE
+#include <filesystem>
+#include <memory>
+#include <string>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "k9db/util/status.h"
+#include "rocksdb/options.h"
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+#define DB_PATH "/tmp/k9db_group_commit_test"
+
+namespace {
+
+std::unique_ptr<rocksdb::DB> InitializeDatabase() {
+  std::filesystem::remove_all(DB_PATH);
+  rocksdb::Options opts;
+  opts.create_if_missing = true;
+  opts.error_if_exists = true;
+  opts.manual_wal_flush = true;
+  rocksdb::DB *db;
+  PANIC(rocksdb::DB::Open(opts, DB_PATH, &db));
+  return std::unique_ptr<rocksdb::DB>(db);
+}
+
+}  // namespace
+
+TEST(GroupCommitTest, SingleCommit) {
+  std::unique_ptr<rocksdb::DB> db = InitializeDatabase();
+  GroupCommit group(db.get(), std::chrono::microseconds(100));
+  rocksdb::WriteOptions opts;
+  PANIC(db->Put(opts, "a", "1"));
+  group.Sync();
+  EXPECT_EQ(group.Commits(), 1);
+  EXPECT_EQ(group.Syncs(), 1);
+}
+
+TEST(GroupCommitTest, ConcurrentCommitsShareSyncs) {
+  std::unique_ptr<rocksdb::DB> db = InitializeDatabase();
+  GroupCommit group(db.get(), std::chrono::microseconds(2000));
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      rocksdb::WriteOptions opts;
+      for (size_t i = 0; i < 20; i++) {
+        std::string key = std::to_string(t) + "_" + std::to_string(i);
+        PANIC(db->Put(opts, key, key));
+        group.Sync();
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Everyone is synced, with fewer syncs than commits.
+  EXPECT_EQ(group.Commits(), 8 * 20);
+  EXPECT_GE(group.Syncs(), 20);
+  EXPECT_LT(group.Syncs(), 8 * 20);
+}
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
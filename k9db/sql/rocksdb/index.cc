@@ -1,13 +1,24 @@
 #include "k9db/sql/rocksdb/index.h"
 
 #include <algorithm>
+#include <limits>
 #include <optional>
+#include <type_traits>
 #include <utility>
 
+#include "k9db/sql/rocksdb/options.h"
 #include "k9db/sqlast/ast.h"
 #include "k9db/util/iterator.h"
 #include "k9db/util/status.h"
 
+// Number of digits integers are padded to inside indices (2^64 has 20).
+#define ORDERED_INT_WIDTH 20
+
+// Format version of index entries, persisted with every index.
+// 1: values are stored as encoded in rows.
+// 2: integers are stored in an order preserving encoding.
+#define INDEX_FORMAT_VERSION 2
+
 namespace k9db {
 namespace sql {
 namespace rocks {
@@ -32,6 +43,18 @@ class IndexPrefixTransform : public rocksdb::SliceTransform {
   }
 };
 
+// Add an index entry to the result of a lookup, covering lookups also keep
+// the value stored in the entry.
+template <typename T>
+void AddEntry(T *result, RocksdbIndexRecord &&key,
+              const rocksdb::Iterator *it) {
+  if constexpr (std::is_same<T, CoveringIndexMap>::value) {
+    result->emplace(std::move(key), it->value().ToString());
+  } else {
+    result->emplace(std::move(key));
+  }
+}
+
 // Helper: avoids writing the Get code twice for regular and dedup lookups.
 template <typename T, typename R, bool shards_specified = false>
 T GetHelper(rocksdb::DB *db, const RocksdbInterface *txn,
@@ -72,16 +95,109 @@ T GetHelper(rocksdb::DB *db, const RocksdbInterface *txn,
       R record(it->key());
       if constexpr (shards_specified) {
         if (record.GetShard() == shards.at(i)) {
-          result.emplace(record.TargetKey());
+          AddEntry(&result, record.TargetKey(), it.get());
         }
       } else {
-        result.emplace(record.TargetKey());
+        AddEntry(&result, record.TargetKey(), it.get());
+      }
+    }
+  }
+  return result;
+}
+
+// Helper: avoids writing the range code twice for regular and dedup lookups.
+template <typename T, typename R>
+T RangeHelper(const RocksdbInterface *txn, rocksdb::ColumnFamilyHandle *handle,
+              std::vector<std::string> &&prefixes,
+              const std::optional<std::string> &lower,
+              const std::optional<std::string> &upper, int limit) {
+  // The range may span many values of the first column, so we cannot limit
+  // the iterator to the prefix of the seek key.
+  std::unique_ptr<rocksdb::Iterator> it = txn->Iterate(handle, false);
+  std::sort(prefixes.begin(), prefixes.end());
+
+  // Holds the result.
+  T result;
+
+  // Go through prefixes in order, from the lower bound to the upper bound.
+  for (const std::string &prefix : prefixes) {
+    std::string start = prefix;
+    if (lower.has_value()) {
+      start.append(lower.value());
+    }
+    for (it->Seek(start); it->Valid(); it->Next()) {
+      rocksdb::Slice key = it->key();
+      if (!key.starts_with(prefix)) {
+        break;
+      }
+
+      // Find the value of the range column.
+      const char *data = key.data() + prefix.size();
+      size_t size = 0;
+      while (prefix.size() + size < key.size() && data[size] != __ROCKSCOMP &&
+             data[size] != __ROCKSSEP) {
+        size++;
+      }
+      rocksdb::Slice value(data, size);
+      if (size == 1 && *data == __ROCKSNULL) {
+        continue;
+      }
+      if (lower.has_value() && value == rocksdb::Slice(lower.value())) {
+        continue;
+      }
+      if (upper.has_value() && value.compare(upper.value()) >= 0) {
+        break;
+      }
+
+      if (limit != -1 && result.size() == static_cast<size_t>(limit)) {
+        return result;
       }
+      AddEntry(&result, R(key).TargetKey(), it.get());
     }
   }
   return result;
 }
 
+// Integers are stored as fixed width decimals, so that their bytewise order is
+// their numeric order. Signed integers are offset by 2^63 first.
+std::string EncodeOrderedInt(uint64_t v) {
+  std::string digits = std::to_string(v);
+  return std::string(ORDERED_INT_WIDTH - digits.size(), '0') + digits;
+}
+uint64_t OffsetInt(int64_t v) {
+  return static_cast<uint64_t>(v) ^ (static_cast<uint64_t>(1) << 63);
+}
+
+// Encode a range bound over an integer column. Bounds outside of the values
+// of the column type are either always satisfied (returns nullopt), or never
+// satisfied (also sets *empty).
+std::optional<std::string> EncodeOrderedBound(
+    sqlast::ColumnDefinition::Type type, const sqlast::Value &bound,
+    bool lower, bool *empty) {
+  using CType = sqlast::ColumnDefinition::Type;
+  CHECK(bound.type() == sqlast::Value::Type::INT ||
+        bound.type() == sqlast::Value::Type::UINT)
+      << "Bad comparison";
+  if (type == CType::UINT) {
+    if (bound.type() == sqlast::Value::Type::UINT) {
+      return EncodeOrderedInt(bound.GetUInt());
+    }
+    if (bound.GetInt() >= 0) {
+      return EncodeOrderedInt(static_cast<uint64_t>(bound.GetInt()));
+    }
+    *empty = !lower;
+    return {};
+  }
+  if (bound.type() == sqlast::Value::Type::INT) {
+    return EncodeOrderedInt(OffsetInt(bound.GetInt()));
+  }
+  if (bound.GetUInt() <= std::numeric_limits<int64_t>::max()) {
+    return EncodeOrderedInt(OffsetInt(static_cast<int64_t>(bound.GetUInt())));
+  }
+  *empty = lower;
+  return {};
+}
+
 }  // namespace
 
 /*
@@ -93,19 +209,44 @@ rocksdb::ColumnFamilyOptions RocksdbIndex::ColumnFamilyOptions() {
   rocksdb::ColumnFamilyOptions options;
   options.prefix_extractor.reset(new IndexPrefixTransform());
   options.comparator = rocksdb::BytewiseComparator();
+  ConfigureColumnFamily(ColumnFamilyKind::INDEX, &options);
   return options;
 }
 
 // Constructor.
-RocksdbIndex::RocksdbIndex(rocksdb::DB *db, const std::string &table_name,
-                           const std::vector<size_t> &columns,
-                           RocksdbMetadata *metadata)
-    : db_(db), handle_(), columns_(columns), cf_name_() {
+RocksdbIndex::RocksdbIndex(
+    rocksdb::DB *db, const std::string &table_name,
+    const std::vector<size_t> &columns,
+    const std::vector<sqlast::ColumnDefinition::Type> &types,
+    const std::vector<size_t> &included, RocksdbMetadata *metadata)
+    : db_(db),
+      handle_(),
+      columns_(columns),
+      types_(types),
+      included_(included),
+      ordered_(false),
+      stale_(false),
+      cf_name_(),
+      metadata_(metadata) {
+  CHECK(types.empty() || types.size() == columns.size()) << "Bad index types";
+  for (sqlast::ColumnDefinition::Type type : this->types_) {
+    if (type == sqlast::ColumnDefinition::Type::INT ||
+        type == sqlast::ColumnDefinition::Type::UINT) {
+      this->ordered_ = true;
+    }
+  }
+
   // Create a name for the index.
   std::string name = table_name;
   for (size_t c : this->columns_) {
     name += "_" + std::to_string(c);
   }
+  if (this->included_.size() > 0) {
+    name += "_include";
+    for (size_t c : this->included_) {
+      name += "_" + std::to_string(c);
+    }
+  }
   name += ColumnFamilySuffix();
 
   // Has this index been created before and we are reloading as part of
@@ -115,27 +256,56 @@ RocksdbIndex::RocksdbIndex(rocksdb::DB *db, const std::string &table_name,
     handle = metadata->Find(name);
   }
 
+  // Store the name used for this column family.
+  this->cf_name_ = std::move(name);
+
   if (!handle.has_value()) {
     // Create a column family for this index.
     rocksdb::ColumnFamilyHandle *handle;
-    PANIC(this->db_->CreateColumnFamily(ColumnFamilyOptions(), name, &handle));
+    PANIC(this->db_->CreateColumnFamily(ColumnFamilyOptions(), this->cf_name_,
+                                        &handle));
     this->handle_ = std::unique_ptr<rocksdb::ColumnFamilyHandle>(handle);
+    this->MarkCurrent();
   } else {
     // It was already created, point to it!
     this->handle_ = std::move(handle.value());
+
+    // Indices persisted before versioning are in version 1. Only the encoding
+    // of integers changed since, other indices can be used as they are.
+    int version = metadata->LoadIndexVersion(this->cf_name_).value_or(1);
+    if (version < INDEX_FORMAT_VERSION) {
+      if (this->ordered_) {
+        this->stale_ = true;
+      } else {
+        this->MarkCurrent();
+      }
+    }
   }
+}
 
-  // Store the name used for this column family.
-  this->cf_name_ = std::move(name);
+// The key of the entry of the given record.
+RocksdbIndexInternalRecord RocksdbIndex::Entry(
+    const std::vector<rocksdb::Slice> &values, const rocksdb::Slice &shard_name,
+    const rocksdb::Slice &pk) const {
+  if (this->ordered_) {
+    std::vector<std::string> ordered;
+    std::vector<rocksdb::Slice> slices;
+    for (size_t i = 0; i < values.size(); i++) {
+      ordered.push_back(this->Ordered(values.at(i), i));
+    }
+    slices.insert(slices.end(), ordered.begin(), ordered.end());
+    return IRecord(slices, shard_name, pk);
+  }
+  return IRecord(values, shard_name, pk);
 }
 
 // Adding things to index.
 void RocksdbIndex::Add(const std::vector<rocksdb::Slice> &values,
                        const rocksdb::Slice &shard_name,
-                       const rocksdb::Slice &pk, RocksdbWriteTransaction *txn) {
-  rocksdb::ColumnFamilyHandle *handle = this->handle_.get();
-  IRecord e(values, shard_name, pk);
-  txn->Put(handle, e.Data(), "");
+                       const rocksdb::Slice &pk, RocksdbWriteTransaction *txn,
+                       const rocksdb::Slice &value) {
+  IRecord e = this->Entry(values, shard_name, pk);
+  txn->Put(this->handle_.get(), e.Data(), value);
 }
 
 // Deleting things from index.
@@ -143,9 +313,37 @@ void RocksdbIndex::Delete(const std::vector<rocksdb::Slice> &values,
                           const rocksdb::Slice &shard_name,
                           const rocksdb::Slice &pk,
                           RocksdbWriteTransaction *txn) {
+  IRecord e = this->Entry(values, shard_name, pk);
+  txn->Delete(this->handle_.get(), e.Data());
+}
+
+// Rebuilding stale indices.
+void RocksdbIndex::Clear() {
   rocksdb::ColumnFamilyHandle *handle = this->handle_.get();
-  IRecord e(values, shard_name, pk);
-  txn->Delete(handle, e.Data());
+  rocksdb::ReadOptions opts;
+  opts.total_order_seek = true;
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(opts, handle));
+  rocksdb::WriteBatch batch;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    batch.Delete(handle, it->key());
+  }
+  PANIC(it->status());
+  rocksdb::WriteOptions wopts;
+  wopts.sync = true;
+  PANIC(this->db_->Write(wopts, &batch));
+}
+void RocksdbIndex::Add(const std::vector<rocksdb::Slice> &values,
+                       const rocksdb::Slice &shard_name,
+                       const rocksdb::Slice &pk, const rocksdb::Slice &value,
+                       rocksdb::WriteBatch *batch) {
+  IRecord e = this->Entry(values, shard_name, pk);
+  PANIC(batch->Put(this->handle_.get(), e.Data(), value));
+}
+void RocksdbIndex::MarkCurrent() {
+  if (this->metadata_ != nullptr) {
+    this->metadata_->PersistIndexVersion(this->cf_name_, INDEX_FORMAT_VERSION);
+  }
+  this->stale_ = false;
 }
 
 // Use to encode condition values for composite index.
@@ -180,15 +378,58 @@ std::vector<std::string> RocksdbIndex::EncodeComposite(
   return result;
 }
 
+// Translate encoded values to how they are stored in the index.
+std::string RocksdbIndex::Ordered(const rocksdb::Slice &value,
+                                  size_t position) const {
+  if (position >= this->types_.size() || value.empty() ||
+      (value.size() == 1 && value[0] == __ROCKSNULL)) {
+    return value.ToString();
+  }
+  switch (this->types_.at(position)) {
+    case sqlast::ColumnDefinition::Type::INT:
+      return EncodeOrderedInt(OffsetInt(std::stoll(value.ToString())));
+    case sqlast::ColumnDefinition::Type::UINT:
+      return EncodeOrderedInt(std::stoull(value.ToString()));
+    default:
+      return value.ToString();
+  }
+}
+std::string RocksdbIndex::OrderedComposite(const std::string &values) const {
+  std::string result;
+  size_t position = 0;
+  size_t start = 0;
+  for (size_t i = 0; i <= values.size(); i++) {
+    if (i == values.size() || values.at(i) == __ROCKSCOMP) {
+      rocksdb::Slice value(values.data() + start, i - start);
+      result.append(this->Ordered(value, position++));
+      if (i < values.size()) {
+        result.push_back(__ROCKSCOMP);
+      }
+      start = i + 1;
+    }
+  }
+  return result;
+}
+
 // Get by value.
 IndexSet RocksdbIndex::Get(std::vector<std::string> &&v,
                            const RocksdbInterface *txn, int limit) const {
+  if (this->ordered_) {
+    for (std::string &str : v) {
+      str = this->OrderedComposite(str);
+    }
+  }
   return GetHelper<IndexSet, IRecord>(this->db_, txn, this->handle_.get(),
                                       std::move(v), {}, limit);
 }
 DedupIndexSet RocksdbIndex::GetDedup(std::vector<std::string> &&v,
                                      const RocksdbInterface *txn,
                                      int limit) const {
+  if (this->ordered_) {
+    for (std::string &str : v) {
+      str = this->OrderedComposite(str);
+    }
+  }
   return GetHelper<DedupIndexSet, IRecord>(this->db_, txn, this->handle_.get(),
                                            std::move(v), {}, limit);
 }
@@ -196,11 +437,122 @@ DedupIndexSet RocksdbIndex::GetDedup(std::vector<std::string> &&v,
 IndexSet RocksdbIndex::GetWithShards(std::vector<std::string> &&shards,
                                      std::vector<std::string> &&values,
                                      const RocksdbInterface *txn) const {
+  if (this->ordered_) {
+    for (std::string &str : values) {
+      str = this->OrderedComposite(str);
+    }
+  }
   return GetHelper<IndexSet, IRecord, true>(this->db_, txn, this->handle_.get(),
                                             std::move(values),
                                             std::move(shards));
 }
 
+// Get by range.
+bool RocksdbIndex::EncodeRange(std::vector<std::string> *values,
+                               size_t position,
+                               const sqlast::ValueMapper::Range &range,
+                               std::optional<std::string> *lower,
+                               std::optional<std::string> *upper) const {
+  CHECK_LT(position, this->columns_.size()) << "Range over no column";
+  // Values of the preceding columns are followed by __ROCKSCOMP.
+  if (position == 0) {
+    CHECK(values->empty()) << "Range prefix has values";
+    values->emplace_back();
+  } else if (this->ordered_) {
+    for (std::string &str : *values) {
+      str = this->OrderedComposite(str);
+    }
+  }
+
+  // Integer bounds are encoded like integer values, other bounds are as is.
+  bool empty = false;
+  bool integer = false;
+  if (position < this->types_.size()) {
+    sqlast::ColumnDefinition::Type type = this->types_.at(position);
+    integer = type == sqlast::ColumnDefinition::Type::INT ||
+              type == sqlast::ColumnDefinition::Type::UINT;
+    if (integer && range.lower.has_value()) {
+      *lower = EncodeOrderedBound(type, range.lower.value(), true, &empty);
+    }
+    if (integer && range.upper.has_value()) {
+      *upper = EncodeOrderedBound(type, range.upper.value(), false, &empty);
+    }
+  }
+  if (!integer) {
+    if (range.lower.has_value()) {
+      CHECK_EQ(range.lower->type(), sqlast::Value::Type::TEXT)
+          << "Bad comparison";
+      *lower = range.lower->GetString();
+    }
+    if (range.upper.has_value()) {
+      CHECK_EQ(range.upper->type(), sqlast::Value::Type::TEXT)
+          << "Bad comparison";
+      *upper = range.upper->GetString();
+    }
+  }
+  if (lower->has_value() && upper->has_value() &&
+      lower->value() >= upper->value()) {
+    empty = true;
+  }
+  return !empty;
+}
+IndexSet RocksdbIndex::GetRange(std::vector<std::string> &&v, size_t position,
+                                const sqlast::ValueMapper::Range &range,
+                                const RocksdbInterface *txn, int limit) const {
+  std::optional<std::string> lower;
+  std::optional<std::string> upper;
+  if (!this->EncodeRange(&v, position, range, &lower, &upper)) {
+    return IndexSet();
+  }
+  return RangeHelper<IndexSet, IRecord>(txn, this->handle_.get(), std::move(v),
+                                        lower, upper, limit);
+}
+DedupIndexSet RocksdbIndex::GetRangeDedup(
+    std::vector<std::string> &&v, size_t position,
+    const sqlast::ValueMapper::Range &range, const RocksdbInterface *txn,
+    int limit) const {
+  std::optional<std::string> lower;
+  std::optional<std::string> upper;
+  if (!this->EncodeRange(&v, position, range, &lower, &upper)) {
+    return DedupIndexSet();
+  }
+  return RangeHelper<DedupIndexSet, IRecord>(txn, this->handle_.get(),
+                                             std::move(v), lower, upper, limit);
+}
+
+// Get by value or range, with the values stored in the entries.
+CoveringIndexMap RocksdbIndex::GetCovering(std::vector<std::string> &&v,
+                                           const RocksdbInterface *txn,
+                                           int limit) const {
+  if (this->ordered_) {
+    for (std::string &str : v) {
+      str = this->OrderedComposite(str);
+    }
+  }
+  return GetHelper<CoveringIndexMap, IRecord>(
+      this->db_, txn, this->handle_.get(), std::move(v), {}, limit);
+}
+CoveringIndexMap RocksdbIndex::GetRangeCovering(
+    std::vector<std::string> &&v, size_t position,
+    const sqlast::ValueMapper::Range &range, const RocksdbInterface *txn,
+    int limit) const {
+  std::optional<std::string> lower;
+  std::optional<std::string> upper;
+  if (!this->EncodeRange(&v, position, range, &lower, &upper)) {
+    return CoveringIndexMap();
+  }
+  return RangeHelper<CoveringIndexMap, IRecord>(
+      txn, this->handle_.get(), std::move(v), lower, upper, limit);
+}
+
+// Whether the given column is indexed or included.
+bool RocksdbIndex::Covers(size_t column) const {
+  return std::find(this->columns_.begin(), this->columns_.end(), column) !=
+             this->columns_.end() ||
+         std::find(this->included_.begin(), this->included_.end(), column) !=
+             this->included_.end();
+}
+
 /*
  * RocksdbPKIndex
  */
@@ -211,6 +563,7 @@ rocksdb::ColumnFamilyOptions RocksdbPKIndex::ColumnFamilyOptions() {
   rocksdb::ColumnFamilyOptions options;
   options.prefix_extractor.reset(new IndexPrefixTransform());
   options.comparator = rocksdb::BytewiseComparator();
+  ConfigureColumnFamily(ColumnFamilyKind::INDEX, &options);
   return options;
 }
 
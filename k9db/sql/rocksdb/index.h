@@ -2,6 +2,7 @@
 #define K9DB_SQL_ROCKSDB_INDEX_H__
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -11,10 +12,12 @@
 #include "k9db/sql/rocksdb/encode.h"
 #include "k9db/sql/rocksdb/metadata.h"
 #include "k9db/sql/rocksdb/transaction.h"
+#include "k9db/sqlast/ast.h"
 #include "k9db/sqlast/value_mapper.h"
 #include "rocksdb/db.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/write_batch.h"
 
 namespace k9db {
 namespace sql {
@@ -27,8 +30,15 @@ class RocksdbIndex {
   static std::string ColumnFamilySuffix();
 
   // Constructor.
+  // types are the types of the indexed columns. Integer values are stored in
+  // an order preserving encoding, so that the index supports range lookups
+  // over them. If types are not given, values are stored as is.
+  // included are columns that are not indexed, but whose values are stored
+  // in the index entries, so that lookups can read them without the table.
   RocksdbIndex(rocksdb::DB *db, const std::string &table_name,
                const std::vector<size_t> &columns,
+               const std::vector<sqlast::ColumnDefinition::Type> &types = {},
+               const std::vector<size_t> &included = {},
                RocksdbMetadata *metadata = nullptr);
 
   // Get the name used for the rocksdb column family corresponding to this
@@ -39,13 +49,27 @@ class RocksdbIndex {
   // shard_name is the shard_name specialized with the user_id.
   // index_value is the value of 'name'.
   // key is the value of 'id' (the PK) without a shard prefix.
+  // value is stored in the entry, covering indices store the (encrypted)
+  // values of their columns in it.
   void Add(const std::vector<rocksdb::Slice> &index_values,
            const rocksdb::Slice &shard_name, const rocksdb::Slice &pk,
-           RocksdbWriteTransaction *txn);
+           RocksdbWriteTransaction *txn,
+           const rocksdb::Slice &value = rocksdb::Slice());
   void Delete(const std::vector<rocksdb::Slice> &index_values,
               const rocksdb::Slice &shard_name, const rocksdb::Slice &pk,
               RocksdbWriteTransaction *txn);
 
+  // Indices over integer columns persisted by versions that stored integers
+  // as is are stale after a restart, and must be rebuilt from their table:
+  // Clear() them, Add() the entries of every row of the table in batches, and
+  // then MarkCurrent().
+  bool Stale() const { return this->stale_; }
+  void Clear();
+  void Add(const std::vector<rocksdb::Slice> &index_values,
+           const rocksdb::Slice &shard_name, const rocksdb::Slice &pk,
+           const rocksdb::Slice &value, rocksdb::WriteBatch *batch);
+  void MarkCurrent();
+
   // Use to encode condition values for composite index.
   std::vector<std::string> EncodeComposite(
       sqlast::ValueMapper *vm, const dataflow::SchemaRef &schema) const;
@@ -60,14 +84,62 @@ class RocksdbIndex {
                          std::vector<std::string> &&values,
                          const RocksdbInterface *txn) const;
 
+  // Get the shard and pk of matching records for given values of the first
+  // position columns (as encoded by EncodeComposite), and for a range over
+  // the column at position.
+  IndexSet GetRange(std::vector<std::string> &&values, size_t position,
+                    const sqlast::ValueMapper::Range &range,
+                    const RocksdbInterface *txn, int limit = -1) const;
+  DedupIndexSet GetRangeDedup(std::vector<std::string> &&values,
+                              size_t position,
+                              const sqlast::ValueMapper::Range &range,
+                              const RocksdbInterface *txn,
+                              int limit = -1) const;
+
+  // Like GetDedup and GetRangeDedup, but also read the values stored in the
+  // entries.
+  CoveringIndexMap GetCovering(std::vector<std::string> &&values,
+                               const RocksdbInterface *txn,
+                               int limit = -1) const;
+  CoveringIndexMap GetRangeCovering(std::vector<std::string> &&values,
+                                    size_t position,
+                                    const sqlast::ValueMapper::Range &range,
+                                    const RocksdbInterface *txn,
+                                    int limit = -1) const;
+
   // Get the columns over which this index is defined.
   const std::vector<size_t> &GetColumns() const { return this->columns_; }
+  const std::vector<size_t> &GetIncluded() const { return this->included_; }
+
+  // Whether the given column is indexed or included.
+  bool Covers(size_t column) const;
 
  private:
   rocksdb::DB *db_;
   std::unique_ptr<rocksdb::ColumnFamilyHandle> handle_;
   std::vector<size_t> columns_;
+  std::vector<sqlast::ColumnDefinition::Type> types_;
+  std::vector<size_t> included_;
+  bool ordered_;  // Some column has an order preserving encoding.
+  bool stale_;    // Entries are in an older format.
   std::string cf_name_;
+  RocksdbMetadata *metadata_;
+
+  // The key of the entry of the given record.
+  RocksdbIndexInternalRecord Entry(const std::vector<rocksdb::Slice> &values,
+                                   const rocksdb::Slice &shard_name,
+                                   const rocksdb::Slice &pk) const;
+
+  // Translate encoded values to how they are stored in the index.
+  std::string Ordered(const rocksdb::Slice &value, size_t position) const;
+  std::string OrderedComposite(const std::string &values) const;
+
+  // Translate values and range for a range lookup, returns false if no value
+  // can be in the range.
+  bool EncodeRange(std::vector<std::string> *values, size_t position,
+                   const sqlast::ValueMapper::Range &range,
+                   std::optional<std::string> *lower,
+                   std::optional<std::string> *upper) const;
 
   using IRecord = RocksdbIndexInternalRecord;
 };
@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -343,6 +344,133 @@ TEST(RocksdbIndexTest, CompositeIndex) {
   txn.Rollback();
 }
 
+TEST(RocksdbIndexTest, RangeIndex) {
+  using CType = sqlast::ColumnDefinition::Type;
+  using Range = sqlast::ValueMapper::Range;
+  dataflow::SchemaRef schema = dataflow::SchemaFactory::Create(
+      {"", ""}, {CType::TEXT, CType::INT}, {});
+
+  std::unique_ptr<rocksdb::TransactionDB> db = InitializeDatabase();
+  RocksdbWriteTransaction txn(db.get());
+
+  // Decimal strings of integers are not in numeric order.
+  rocksdb::Slice m5("-5");
+  rocksdb::Slice m10("-10");
+  std::string null(1, __ROCKSNULL);
+  RocksdbIndex index(db.get(), "range", {0, 1}, {CType::TEXT, CType::INT});
+  index.Add({z, m10}, shard10, pk1, &txn);
+  index.Add({z, m5}, shard10, pk2, &txn);
+  index.Add({z, z}, shard100, pk3, &txn);
+  index.Add({z, t}, shard1, pk4, &txn);
+  index.Add({z, oz}, shard1, pk5, &txn);
+  index.Add({z, null}, shard2, pk6, &txn);
+  index.Add({o, t}, shard2, pk1, &txn);
+
+  // Equality still works.
+  EXPECT_REQ(index.Get(V({{z, t}, {o, t}}), &txn),
+             {{shard1, pk4}, {shard2, pk1}});
+
+  // Range over the second column.
+  sqlast::ValueMapper vm(schema);
+  vm.AddValues(0, {sqlast::Value("0")});
+  EXPECT_REQ(index.GetRange(index.EncodeComposite(&vm, schema), 1,
+                            Range{sqlast::Value(-6_s), sqlast::Value(2_s)},
+                            &txn),
+             {{shard10, pk2}, {shard100, pk3}});
+
+  vm.AddValues(0, {sqlast::Value("0")});
+  EXPECT_REQ(index.GetRange(index.EncodeComposite(&vm, schema), 1,
+                            Range{sqlast::Value(0_s), {}}, &txn),
+             {{shard1, pk4}, {shard1, pk5}});
+
+  // NULL is not in any range.
+  vm.AddValues(0, {sqlast::Value("0")});
+  EXPECT_REQ(index.GetRange(index.EncodeComposite(&vm, schema), 1,
+                            Range{{}, sqlast::Value(0_s)}, &txn),
+             {{shard10, pk1}, {shard10, pk2}});
+
+  // Bounds outside of the column type.
+  uint64_t max = std::numeric_limits<uint64_t>::max();
+  vm.AddValues(0, {sqlast::Value("0"), sqlast::Value("1")});
+  EXPECT_REQ(index.GetRange(index.EncodeComposite(&vm, schema), 1,
+                            Range{sqlast::Value(max), {}}, &txn),
+             {});
+  vm.AddValues(0, {sqlast::Value("0"), sqlast::Value("1")});
+  EXPECT_DEQ(index.GetRangeDedup(index.EncodeComposite(&vm, schema), 1,
+                                 Range{sqlast::Value(1_s), sqlast::Value(max)},
+                                 &txn),
+             {{{shard1}, pk4}, {{shard1}, pk5}, {{shard2}, pk1}});
+
+  // Range over the first column.
+  EXPECT_REQ(index.GetRange({}, 0, Range{sqlast::Value("0"), {}}, &txn),
+             {{shard2, pk1}});
+  EXPECT_REQ(index.GetRange({}, 0, Range{{}, sqlast::Value("1")}, &txn, 3),
+             {{shard2, pk6}, {shard10, pk1}, {shard10, pk2}});
+
+  txn.Rollback();
+}
+
+TEST(RocksdbIndexTest, Rebuild) {
+  using CType = sqlast::ColumnDefinition::Type;
+  std::unique_ptr<rocksdb::TransactionDB> db = InitializeDatabase();
+
+  // New indices are in the current format.
+  RocksdbIndex index(db.get(), "rebuild", {0}, {CType::INT});
+  EXPECT_FALSE(index.Stale());
+
+  RocksdbWriteTransaction txn(db.get());
+  index.Add({z}, shard1, pk1, &txn);
+  index.Add({o}, shard2, pk2, &txn);
+  EXPECT_TRUE(txn.Commit());
+
+  // Clear removes all entries.
+  index.Clear();
+  RocksdbReadSnapshot snapshot(db.get());
+  EXPECT_REQ(index.Get(V({z, o}), &snapshot), {});
+
+  // Entries written in a batch are found like other entries.
+  rocksdb::WriteBatch batch;
+  index.Add({o}, shard1, pk3, rocksdb::Slice(), &batch);
+  index.Add({oz}, shard2, pk4, rocksdb::Slice(), &batch);
+  PANIC(db->Write(rocksdb::WriteOptions(), &batch));
+  index.MarkCurrent();
+
+  RocksdbReadSnapshot updated(db.get());
+  EXPECT_REQ(index.Get(V({o, oz}), &updated), {{shard1, pk3}, {shard2, pk4}});
+}
+
+TEST(RocksdbIndexTest, CoveringIndex) {
+  std::unique_ptr<rocksdb::TransactionDB> db = InitializeDatabase();
+  RocksdbWriteTransaction txn(db.get());
+
+  RocksdbIndex index(db.get(), "covering", {0}, {}, {2});
+  EXPECT_TRUE(index.Covers(0));
+  EXPECT_FALSE(index.Covers(1));
+  EXPECT_TRUE(index.Covers(2));
+  index.Add({z}, shard1, pk1, &txn, rocksdb::Slice("v1"));
+  index.Add({z}, shard2, pk1, &txn, rocksdb::Slice("v1"));
+  index.Add({z}, shard2, pk2, &txn, rocksdb::Slice("v2"));
+  index.Add({o}, shard1, pk3, &txn, rocksdb::Slice("v3"));
+
+  // Values are read along with the (deduplicated) keys.
+  CoveringIndexMap result = index.GetCovering(V({z}), &txn);
+  ASSERT_EQ(result.size(), 2);
+  for (const auto &[record, value] : result) {
+    if (record.GetPK() == pk1) {
+      EXPECT_EQ(value, "v1");
+    } else {
+      EXPECT_EQ(record.GetPK(), pk2);
+      EXPECT_EQ(value, "v2");
+    }
+  }
+
+  // Deleted entries are gone.
+  index.Delete({o}, shard1, pk3, &txn);
+  EXPECT_EQ(index.GetCovering(V({o}), &txn).size(), 0);
+
+  txn.Rollback();
+}
+
 // For PK indices.
 TEST(RocksdbPKIndex, GetAfterDelete) {
   std::unique_ptr<rocksdb::TransactionDB> db = InitializeDatabase();
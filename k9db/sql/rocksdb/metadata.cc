@@ -4,7 +4,9 @@
 // interface to persist the description of what is created to disk, so that
 // when k9db is restarted, it can read that description and reload the table,
 // index, or view properly.
-// This class is also responsible for storing the required encryption keys.
+// This class is also responsible for storing the required encryption keys and
+// the format versions of indices, and owns the column family where view
+// checkpoints are stored.
 
 #include "k9db/sql/rocksdb/metadata.h"
 
@@ -59,6 +61,12 @@ std::vector<std::string> RocksdbMetadata::Initialize(
     } else if (name == StatementsColumnFamily()) {
       this->statements_cf_ =
           std::unique_ptr<rocksdb::ColumnFamilyHandle>(handles.at(i));
+    } else if (name == IndexVersionsColumnFamily()) {
+      this->index_versions_cf_ =
+          std::unique_ptr<rocksdb::ColumnFamilyHandle>(handles.at(i));
+    } else if (name == CheckpointsColumnFamily()) {
+      this->checkpoints_cf_ =
+          std::unique_ptr<rocksdb::ColumnFamilyHandle>(handles.at(i));
     } else {
       this->cf_map_.emplace(name, handles.at(i));
       this->persisted_cfs_.insert(name);
@@ -66,7 +74,7 @@ std::vector<std::string> RocksdbMetadata::Initialize(
   }
 
   // In case k9db is just being started for the first time, we need to create
-  // the column families for statements and keys.
+  // the column families for statements, keys, index versions, and checkpoints.
   if (this->keys_cf_ == nullptr) {
     std::string cf_name = KeysColumnFamily();
     rocksdb::ColumnFamilyHandle *handle;
@@ -81,6 +89,22 @@ std::vector<std::string> RocksdbMetadata::Initialize(
     PANIC(this->db_->CreateColumnFamily(options, cf_name, &handle));
     this->statements_cf_ = std::unique_ptr<rocksdb::ColumnFamilyHandle>(handle);
   }
+  if (this->index_versions_cf_ == nullptr) {
+    std::string cf_name = IndexVersionsColumnFamily();
+    rocksdb::ColumnFamilyHandle *handle;
+    rocksdb::ColumnFamilyOptions options = IndexVersionsColumnFamilyOptions();
+    PANIC(this->db_->CreateColumnFamily(options, cf_name, &handle));
+    this->index_versions_cf_ =
+        std::unique_ptr<rocksdb::ColumnFamilyHandle>(handle);
+  }
+  if (this->checkpoints_cf_ == nullptr) {
+    std::string cf_name = CheckpointsColumnFamily();
+    rocksdb::ColumnFamilyHandle *handle;
+    rocksdb::ColumnFamilyOptions options = CheckpointsColumnFamilyOptions();
+    PANIC(this->db_->CreateColumnFamily(options, cf_name, &handle));
+    this->checkpoints_cf_ =
+        std::unique_ptr<rocksdb::ColumnFamilyHandle>(handle);
+  }
 
   // Read all persisted statements and find views.
   rocksdb::ReadOptions opts;
@@ -229,6 +253,31 @@ void RocksdbMetadata::PersistUserKey(const std::string &user_id,
   PANIC(this->db_->Put(opts, this->keys_cf_.get(), user_id, key));
 }
 
+// Index format versions are keyed by the name of the index column family.
+std::optional<int> RocksdbMetadata::LoadIndexVersion(
+    const std::string &cf_name) {
+  rocksdb::ReadOptions opts;
+  opts.total_order_seek = true;
+  opts.verify_checksums = false;
+
+  std::string result;
+  rocksdb::Status status =
+      this->db_->Get(opts, this->index_versions_cf_.get(), cf_name, &result);
+  if (status.ok()) {
+    return std::stoi(result);
+  } else if (!status.IsNotFound()) {
+    PANIC(status);
+  }
+  return {};
+}
+void RocksdbMetadata::PersistIndexVersion(const std::string &cf_name,
+                                          int version) {
+  rocksdb::WriteOptions opts;
+  opts.sync = true;
+  std::string value = std::to_string(version);
+  PANIC(this->db_->Put(opts, this->index_versions_cf_.get(), cf_name, value));
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
@@ -7,7 +7,9 @@
 // interface to persist the description of what is created to disk, so that
 // when k9db is restarted, it can read that description and reload the table,
 // index, or view properly.
-// This class is also responsible for storing the required encryption keys.
+// This class is also responsible for storing the required encryption keys and
+// the format versions of indices, and owns the column family where view
+// checkpoints are stored.
 
 #include <atomic>
 #include <memory>
@@ -17,6 +19,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "k9db/sql/rocksdb/options.h"
 #include "k9db/sqlast/ast.h"
 #include "rocksdb/db.h"
 #include "rocksdb/utilities/transaction_db.h"
@@ -27,16 +30,26 @@ namespace rocks {
 
 class RocksdbMetadata {
  public:
-  // Column family options for the families used to store keys and persisted
-  // statements.
+  // Column family options for the families used to store keys, persisted
+  // statements, index format versions, and view checkpoints.
   static rocksdb::ColumnFamilyOptions KeysColumnFamilyOptions() {
-    return rocksdb::ColumnFamilyOptions();
+    return MetadataColumnFamilyOptions();
   }
   static rocksdb::ColumnFamilyOptions StatementsColumnFamilyOptions() {
-    return rocksdb::ColumnFamilyOptions();
+    return MetadataColumnFamilyOptions();
+  }
+  static rocksdb::ColumnFamilyOptions IndexVersionsColumnFamilyOptions() {
+    return MetadataColumnFamilyOptions();
+  }
+  static rocksdb::ColumnFamilyOptions CheckpointsColumnFamilyOptions() {
+    return MetadataColumnFamilyOptions();
   }
   static std::string KeysColumnFamily() { return "__keys__"; }
   static std::string StatementsColumnFamily() { return "__statements__"; }
+  static std::string IndexVersionsColumnFamily() {
+    return "__index_versions__";
+  }
+  static std::string CheckpointsColumnFamily() { return "__checkpoints__"; }
 
   // Constructor.
   RocksdbMetadata() = default;
@@ -45,6 +58,8 @@ class RocksdbMetadata {
   void Clear() {
     this->statements_cf_ = nullptr;
     this->keys_cf_ = nullptr;
+    this->index_versions_cf_ = nullptr;
+    this->checkpoints_cf_ = nullptr;
     this->cf_map_.clear();
   }
 
@@ -76,10 +91,28 @@ class RocksdbMetadata {
   void PersistGlobalNonce(const std::string &nonce);
   void PersistUserKey(const std::string &user_id, const std::string &key);
 
+  // Load and persist the format version of the entries of an index column
+  // family. Indices persisted before versioning have no version.
+  std::optional<int> LoadIndexVersion(const std::string &cf_name);
+  void PersistIndexVersion(const std::string &cf_name, int version);
+
+  // View checkpoints are written and read by RocksdbConnection.
+  rocksdb::ColumnFamilyHandle *CheckpointsHandle() const {
+    return this->checkpoints_cf_.get();
+  }
+
  private:
+  static rocksdb::ColumnFamilyOptions MetadataColumnFamilyOptions() {
+    rocksdb::ColumnFamilyOptions options;
+    ConfigureColumnFamily(ColumnFamilyKind::METADATA, &options);
+    return options;
+  }
+
   rocksdb::TransactionDB *db_;
   std::unique_ptr<rocksdb::ColumnFamilyHandle> statements_cf_;
   std::unique_ptr<rocksdb::ColumnFamilyHandle> keys_cf_;
+  std::unique_ptr<rocksdb::ColumnFamilyHandle> index_versions_cf_;
+  std::unique_ptr<rocksdb::ColumnFamilyHandle> checkpoints_cf_;
   std::unordered_map<std::string, std::unique_ptr<rocksdb::ColumnFamilyHandle>>
       cf_map_;
 
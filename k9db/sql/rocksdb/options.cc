@@ -0,0 +1,188 @@
+#include "k9db/sql/rocksdb/options.h"
+
+#include <memory>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/table.h"
+#include "rocksdb/version.h"
+
+// Entries in the hyper clock cache are mostly data blocks.
+#define HYPER_CLOCK_ENTRY_CHARGE 4096
+// Fraction of the memtable used by its prefix bloom filter.
+#define MEMTABLE_PREFIX_BLOOM_RATIO 0.1
+
+DEFINE_uint64(rocksdb_block_cache_mb, 512,
+              "Size (MB) of the block cache shared by all column families");
+DEFINE_string(rocksdb_block_cache, "lru",
+              "Block cache implementation: lru or hyperclock");
+DEFINE_int32(rocksdb_block_cache_shard_bits, -1,
+             "Block cache is sharded 2^bits ways, -1 to pick automatically");
+DEFINE_int32(rocksdb_bloom_bits_per_key, 10,
+             "Bits per key of table and index prefix bloom filters, 0 for "
+             "none");
+DEFINE_bool(rocksdb_partitioned_filters, false,
+            "Partition index and filter blocks, and keep them in block cache");
+DEFINE_string(rocksdb_table_compression, "default",
+              "Compression of tables: default, none, snappy, zlib, bz2, lz4 "
+              "or zstd");
+DEFINE_string(rocksdb_index_compression, "default",
+              "Compression of indices: default, none, snappy, zlib, bz2, lz4 "
+              "or zstd");
+DEFINE_int32(rocksdb_background_threads, 16,
+             "Number of threads used by rocksdb for flushes and compactions");
+DEFINE_uint64(rocksdb_group_commit_us, 0,
+              "Window (microseconds) in which concurrent commits share one WAL "
+              "sync, 0 to sync the WAL on every commit");
+DEFINE_bool(rocksdb_manual_wal_flush, false,
+            "Buffer WAL writes in memory until the group commit syncs them");
+DEFINE_bool(rocksdb_optimistic, false,
+            "Validate the reads of write transactions on commit instead of "
+            "locking them");
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+namespace {
+
+std::shared_ptr<rocksdb::Cache> MakeBlockCache() {
+  size_t capacity = FLAGS_rocksdb_block_cache_mb << 20;
+  int shard_bits = FLAGS_rocksdb_block_cache_shard_bits;
+  if (FLAGS_rocksdb_block_cache == "lru") {
+    return rocksdb::NewLRUCache(capacity, shard_bits);
+  }
+  if (FLAGS_rocksdb_block_cache == "hyperclock") {
+#if ROCKSDB_MAJOR > 7 || (ROCKSDB_MAJOR == 7 && ROCKSDB_MINOR >= 7)
+    rocksdb::HyperClockCacheOptions opts(capacity, HYPER_CLOCK_ENTRY_CHARGE,
+                                         shard_bits);
+    return opts.MakeSharedCache();
+#else
+    LOG(FATAL) << "Hyper clock cache needs rocksdb 7.7 or later";
+#endif
+  }
+  LOG(FATAL) << "Unknown block cache " << FLAGS_rocksdb_block_cache;
+}
+
+// Created on first use, i.e. after flags are parsed.
+const std::shared_ptr<rocksdb::Cache> &SharedBlockCache() {
+  static std::shared_ptr<rocksdb::Cache> cache = MakeBlockCache();
+  return cache;
+}
+
+void SetCompression(const std::string &name,
+                    rocksdb::ColumnFamilyOptions *options) {
+  rocksdb::CompressionType type;
+  if (name == "default") {
+    return;
+  } else if (name == "none") {
+    type = rocksdb::kNoCompression;
+  } else if (name == "snappy") {
+    type = rocksdb::kSnappyCompression;
+  } else if (name == "zlib") {
+    type = rocksdb::kZlibCompression;
+  } else if (name == "bz2") {
+    type = rocksdb::kBZip2Compression;
+  } else if (name == "lz4") {
+    type = rocksdb::kLZ4Compression;
+  } else if (name == "zstd") {
+    type = rocksdb::kZSTD;
+  } else {
+    LOG(FATAL) << "Unknown compression " << name;
+  }
+  // Overrides the per level compression set by OptimizeLevelStyleCompaction().
+  options->compression_per_level.clear();
+  options->compression = type;
+}
+
+}  // namespace
+
+void ConfigureDBOptions(rocksdb::DBOptions *options) {
+  options->IncreaseParallelism(FLAGS_rocksdb_background_threads);
+  if (FLAGS_rocksdb_manual_wal_flush) {
+    CHECK_GT(FLAGS_rocksdb_group_commit_us, 0u)
+        << "Manual WAL flush requires group commit";
+    options->manual_wal_flush = true;
+  }
+}
+
+std::chrono::microseconds GroupCommitWindow() {
+  return std::chrono::microseconds(FLAGS_rocksdb_group_commit_us);
+}
+
+bool OptimisticTransactions() { return FLAGS_rocksdb_optimistic; }
+
+void ConfigureColumnFamily(ColumnFamilyKind kind,
+                           rocksdb::ColumnFamilyOptions *options) {
+  rocksdb::BlockBasedTableOptions table_options;
+  table_options.block_cache = SharedBlockCache();
+
+  // Prefix bloom filters. Tables are also read by full key (<shard, pk>),
+  // indices are only ever read by prefix.
+  bool prefixed = options->prefix_extractor != nullptr;
+  bool bloom = prefixed && FLAGS_rocksdb_bloom_bits_per_key > 0;
+  if (bloom) {
+    table_options.filter_policy.reset(
+        rocksdb::NewBloomFilterPolicy(FLAGS_rocksdb_bloom_bits_per_key));
+    table_options.whole_key_filtering = kind == ColumnFamilyKind::TABLE;
+    options->memtable_prefix_bloom_size_ratio = MEMTABLE_PREFIX_BLOOM_RATIO;
+  }
+
+  // Partitioned index and filter blocks are cached and evicted piecewise,
+  // only their top level is pinned.
+  if (FLAGS_rocksdb_partitioned_filters) {
+    table_options.index_type =
+        rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+    table_options.partition_filters = bloom;
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.cache_index_and_filter_blocks_with_high_priority = true;
+    table_options.pin_top_level_index_and_filter = true;
+  }
+  options->table_factory.reset(
+      rocksdb::NewBlockBasedTableFactory(table_options));
+
+  switch (kind) {
+    case ColumnFamilyKind::TABLE:
+      SetCompression(FLAGS_rocksdb_table_compression, options);
+      break;
+    case ColumnFamilyKind::INDEX:
+      SetCompression(FLAGS_rocksdb_index_compression, options);
+      break;
+    case ColumnFamilyKind::METADATA:
+      break;
+  }
+}
+
+std::vector<std::pair<std::string, std::string>> DescribeOptions() {
+  const std::shared_ptr<rocksdb::Cache> &cache = SharedBlockCache();
+  std::vector<std::pair<std::string, std::string>> result;
+  result.emplace_back("block_cache", FLAGS_rocksdb_block_cache);
+  result.emplace_back("block_cache_capacity",
+                      std::to_string(cache->GetCapacity()));
+  result.emplace_back("block_cache_usage", std::to_string(cache->GetUsage()));
+  result.emplace_back("block_cache_pinned_usage",
+                      std::to_string(cache->GetPinnedUsage()));
+  result.emplace_back("block_cache_shard_bits",
+                      std::to_string(FLAGS_rocksdb_block_cache_shard_bits));
+  result.emplace_back("bloom_bits_per_key",
+                      std::to_string(FLAGS_rocksdb_bloom_bits_per_key));
+  result.emplace_back("partitioned_filters",
+                      FLAGS_rocksdb_partitioned_filters ? "true" : "false");
+  result.emplace_back("table_compression", FLAGS_rocksdb_table_compression);
+  result.emplace_back("index_compression", FLAGS_rocksdb_index_compression);
+  result.emplace_back("background_threads",
+                      std::to_string(FLAGS_rocksdb_background_threads));
+  result.emplace_back("group_commit_us",
+                      std::to_string(FLAGS_rocksdb_group_commit_us));
+  result.emplace_back("manual_wal_flush",
+                      FLAGS_rocksdb_manual_wal_flush ? "true" : "false");
+  result.emplace_back("optimistic",
+                      FLAGS_rocksdb_optimistic ? "true" : "false");
+  return result;
+}
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
@@ -0,0 +1,44 @@
+#ifndef K9DB_SQL_ROCKSDB_OPTIONS_H__
+#define K9DB_SQL_ROCKSDB_OPTIONS_H__
+
+// Tunable rocksdb options, configured by command line flags (or a --flagfile).
+// All column families share one block cache. Tables and indices get bloom
+// filters over their prefixes (<shard> and <first indexed value>), and their
+// own compression.
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/options.h"
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+enum class ColumnFamilyKind { TABLE, INDEX, METADATA };
+
+// Database wide options, e.g. background threads.
+void ConfigureDBOptions(rocksdb::DBOptions *options);
+
+// Window in which concurrent commits share one WAL sync (see group_commit.h),
+// zero if every commit syncs the WAL on its own.
+std::chrono::microseconds GroupCommitWindow();
+
+// Whether write transactions are optimistic (see transaction.h).
+bool OptimisticTransactions();
+
+// Options for the column families of the given kind, must be called after
+// the column family's prefix extractor is set.
+void ConfigureColumnFamily(ColumnFamilyKind kind,
+                           rocksdb::ColumnFamilyOptions *options);
+
+// The current settings (and block cache usage) as (name, value) pairs.
+std::vector<std::pair<std::string, std::string>> DescribeOptions();
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
+
+#endif  // K9DB_SQL_ROCKSDB_OPTIONS_H__
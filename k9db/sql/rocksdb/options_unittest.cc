@@ -0,0 +1,80 @@
+#include "k9db/sql/rocksdb/options.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "rocksdb/slice_transform.h"
+#include "rocksdb/table.h"
+
+DECLARE_string(rocksdb_table_compression);
+DECLARE_string(rocksdb_index_compression);
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+TEST(RocksdbOptionsTest, Compression) {
+  FLAGS_rocksdb_table_compression = "none";
+  FLAGS_rocksdb_index_compression = "default";
+
+  // Tables override the per level compression.
+  rocksdb::ColumnFamilyOptions table;
+  table.OptimizeLevelStyleCompaction();
+  ConfigureColumnFamily(ColumnFamilyKind::TABLE, &table);
+  EXPECT_TRUE(table.compression_per_level.empty());
+  EXPECT_EQ(table.compression, rocksdb::kNoCompression);
+
+  // Indices keep it.
+  rocksdb::ColumnFamilyOptions index;
+  index.OptimizeLevelStyleCompaction();
+  ConfigureColumnFamily(ColumnFamilyKind::INDEX, &index);
+  EXPECT_FALSE(index.compression_per_level.empty());
+
+  FLAGS_rocksdb_table_compression = "default";
+}
+
+TEST(RocksdbOptionsTest, PrefixBloomFilters) {
+  // Only column families with a prefix extractor get filters.
+  rocksdb::ColumnFamilyOptions metadata;
+  ConfigureColumnFamily(ColumnFamilyKind::METADATA, &metadata);
+  const auto *options =
+      metadata.table_factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+  ASSERT_NE(options, nullptr);
+  EXPECT_EQ(options->filter_policy, nullptr);
+  EXPECT_NE(options->block_cache, nullptr);
+
+  rocksdb::ColumnFamilyOptions index;
+  index.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(1));
+  ConfigureColumnFamily(ColumnFamilyKind::INDEX, &index);
+  options = index.table_factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+  ASSERT_NE(options, nullptr);
+  EXPECT_NE(options->filter_policy, nullptr);
+  EXPECT_FALSE(options->whole_key_filtering);
+
+  // All column families share the block cache.
+  rocksdb::ColumnFamilyOptions table;
+  table.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(1));
+  ConfigureColumnFamily(ColumnFamilyKind::TABLE, &table);
+  const auto *table_options =
+      table.table_factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+  ASSERT_NE(table_options, nullptr);
+  EXPECT_TRUE(table_options->whole_key_filtering);
+  EXPECT_EQ(table_options->block_cache, options->block_cache);
+}
+
+TEST(RocksdbOptionsTest, Describe) {
+  std::vector<std::pair<std::string, std::string>> settings =
+      DescribeOptions();
+  ASSERT_FALSE(settings.empty());
+  EXPECT_EQ(settings.at(0), std::make_pair(std::string("block_cache"),
+                                           std::string("lru")));
+  EXPECT_EQ(settings.at(1).first, "block_cache_capacity");
+  EXPECT_EQ(settings.at(1).second, std::to_string(512 << 20));
+}
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
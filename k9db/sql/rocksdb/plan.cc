@@ -1,5 +1,7 @@
 #include "k9db/sql/rocksdb/plan.h"
 
+#include <algorithm>
+
 namespace k9db {
 namespace sql {
 namespace rocks {
@@ -42,6 +44,10 @@ std::string RocksdbPlan::ToString(
       result += " [TOTAL]";
       break;
     }
+    case IndexChoiceType::RANGE: {
+      result += " [RANGE]";
+      break;
+    }
     default: {
       LOG(FATAL) << "Unsupported";
     }
@@ -52,11 +58,22 @@ std::string RocksdbPlan::ToString(
   for (size_t index_col : this->cols_) {
     remaining_clauses.erase(index_col);
   }
-  if (!remaining_clauses.empty()) {
+  std::vector<size_t> remaining_ranges;
+  for (const auto &[column, _] : value_mapper.Ranges()) {
+    if (remaining_clauses.count(column) == 0 &&
+        std::find(this->cols_.begin(), this->cols_.end(), column) ==
+            this->cols_.end()) {
+      remaining_ranges.push_back(column);
+    }
+  }
+  if (!remaining_clauses.empty() || !remaining_ranges.empty()) {
     result += " WITH FILTERS (";
     for (const auto &[column, _] : remaining_clauses) {
       result += this->table_schema_.NameOf(column) + ", ";
     }
+    for (size_t column : remaining_ranges) {
+      result += this->table_schema_.NameOf(column) + ", ";
+    }
     result.pop_back();
     result.pop_back();
     result += ") [INMEMORY]";
@@ -15,7 +15,7 @@ namespace rocks {
 // Plan describing how to handle looking up a where condition.
 class RocksdbPlan {
  public:
-  enum IndexChoiceType { PK, UNIQUE, REGULAR, SCAN };
+  enum IndexChoiceType { PK, UNIQUE, REGULAR, RANGE, SCAN };
 
   // Constructor.
   RocksdbPlan(const std::string &table_name,
@@ -41,6 +41,13 @@ class RocksdbPlan {
       this->type_ = IndexChoiceType::REGULAR;
     }
   }
+  // cols are a prefix of the index columns: all but the last have values,
+  // the last has a range.
+  void MakeRange(const std::vector<size_t> &cols, size_t idx) {
+    this->type_ = IndexChoiceType::RANGE;
+    this->cols_ = cols;
+    this->idx_ = idx;
+  }
 
   // Accessors.
   IndexChoiceType type() const { return this->type_; }
@@ -10,6 +10,26 @@ namespace k9db {
 namespace sql {
 namespace rocks {
 
+namespace {
+
+void ProjectLiteral(const sqlast::Value &l, size_t i,
+                    dataflow::Record *output) {
+  switch (l.type()) {
+    case sqlast::Value::INT: {
+      output->SetInt(l.GetInt(), i);
+      break;
+    }
+    case sqlast::Value::TEXT: {
+      output->SetString(std::make_unique<std::string>(l.GetString()), i);
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unsupported literal projection type";
+  }
+}
+
+}  // namespace
+
 Projection ProjectionSchema(
     const dataflow::SchemaRef &table_schema,
     const std::vector<sqlast::Select::ResultColumn> &columns) {
@@ -56,19 +76,22 @@ dataflow::Record Project(const Projection &project,
       output.SetValue(record.GetValue(idx), i);
     } else {
       // Project literal.
-      const sqlast::Value &l = std::get<sqlast::Value>(v);
-      switch (l.type()) {
-        case sqlast::Value::INT: {
-          output.SetInt(l.GetInt(), i);
-          break;
-        }
-        case sqlast::Value::TEXT: {
-          output.SetString(std::make_unique<std::string>(l.GetString()), i);
-          break;
-        }
-        default:
-          LOG(FATAL) << "Unsupported literal projection type";
-      }
+      ProjectLiteral(std::get<sqlast::Value>(v), i, &output);
+    }
+  }
+  return output;
+}
+
+dataflow::Record Project(const Projection &project, const RocksdbRow &row) {
+  dataflow::Record output{project.schema, false};
+  for (size_t i = 0; i < project.schema.size(); i++) {
+    const std::variant<uint32_t, sqlast::Value> &v = project.projections.at(i);
+    if (v.index() == 0) {
+      // Project column.
+      row.DecodeColumn(std::get<uint32_t>(v), i, &output);
+    } else {
+      // Project literal.
+      ProjectLiteral(std::get<sqlast::Value>(v), i, &output);
     }
   }
   return output;
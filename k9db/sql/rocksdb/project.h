@@ -8,6 +8,7 @@
 
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/encode.h"
 
 namespace k9db {
 namespace sql {
@@ -25,6 +26,9 @@ Projection ProjectionSchema(
 dataflow::Record Project(const Projection &project,
                          const dataflow::Record &record);
 
+// Projects straight from an encoded row, decoding only the projected columns.
+dataflow::Record Project(const Projection &project, const RocksdbRow &row);
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
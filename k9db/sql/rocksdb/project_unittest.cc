@@ -7,6 +7,7 @@
 #include "gtest/gtest.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/encode.h"
 #include "k9db/util/ints.h"
 
 #define STR(s) std::make_unique<std::string>(s)
@@ -122,6 +123,21 @@ TEST(ProjectTest, CombinedProject) {
   EXPECT_EQ(result.GetString(4), "kinan");
 }
 
+// Projecting straight from an encoded row.
+TEST(ProjectTest, RowProject) {
+  Projection projection = ProjectionSchema(
+      schema,
+      {COL("email"), SQL("10"), COL("name"), COL("age"), SQL("'kinan'")});
+
+  RocksdbRow row = RocksdbRow::FromRecord(record);
+  dataflow::Record result = Project(projection, row);
+  EXPECT_EQ(result, Project(projection, record));
+
+  // Rows written by older versions.
+  RocksdbRow legacy(RocksdbSequence::FromRecord(record).Release());
+  EXPECT_EQ(Project(projection, legacy), Project(projection, record));
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
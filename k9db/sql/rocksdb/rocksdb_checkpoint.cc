@@ -0,0 +1,372 @@
+// clang-format off
+// NOLINTNEXTLINE
+#include "k9db/sql/rocksdb/rocksdb_connection.h"
+// clang-format on
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "k9db/util/status.h"
+#include "rocksdb/transaction_log.h"
+#include "rocksdb/write_batch.h"
+
+// Number of checkpoint entries written to rocksdb at once.
+#define CHECKPOINT_WRITE_BATCH 4096
+
+// Version of the format of checkpoints, stored in their header. Checkpoints
+// in another format are discarded.
+#define CHECKPOINT_FORMAT_VERSION "1"
+
+namespace k9db {
+namespace sql {
+namespace rocks {
+
+/*
+ * Checkpoints are stored in their own column family, one entry per record.
+ * The entries of a view are prefixed by <view name>\0, and ordered by
+ * (partition, node, batch, index) in big endian, so that records of the same
+ * batch are contiguous. The entry with key <view name>\0 is the header: it
+ * holds the watermark, the signature of the view, and the format version, and
+ * is written last.
+ *
+ * Writes are logged as LogData blobs in the WAL, one blob per record:
+ * <size of key: 4 bytes><key><value>. The key is <shard>, <table>, encrypted
+ * like the keys of rows, where shard is a shard that holds the record. The
+ * value is <1 if positive, 0 otherwise>, then the values of the record,
+ * encrypted with the key of the user that owns that shard, like rows.
+ */
+
+namespace {
+
+std::string CheckpointPrefix(const std::string &view_name) {
+  std::string prefix = view_name;
+  prefix.push_back('\0');
+  return prefix;
+}
+
+void AppendBigEndian(std::string *str, uint64_t v, size_t bytes) {
+  for (size_t i = bytes; i > 0; i--) {
+    str->push_back(static_cast<char>((v >> (8 * (i - 1))) & 0xFF));
+  }
+}
+uint64_t ReadBigEndian(const char *ptr, size_t bytes) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    v = (v << 8) | static_cast<unsigned char>(ptr[i]);
+  }
+  return v;
+}
+
+bool StartsWith(const rocksdb::Slice &slice, const std::string &prefix) {
+  return slice.size() >= prefix.size() &&
+         std::equal(prefix.begin(), prefix.end(), slice.data());
+}
+
+// Collects the logged records of the given tables from WAL write batches.
+class LogReader : public rocksdb::WriteBatch::Handler {
+ public:
+  LogReader(const EncryptionManager &encryption,
+            const std::unordered_map<std::string, RocksdbTable> &schemas,
+            const std::unordered_set<std::string> &tables,
+            std::vector<LogEntry> *output)
+      : encryption_(encryption),
+        schemas_(schemas),
+        tables_(tables),
+        output_(output) {}
+
+  void LogData(const rocksdb::Slice &blob) override {
+    size_t size = ReadBigEndian(blob.data(), 4);
+    RocksdbSequence key = this->encryption_.DecryptKey(
+        EncryptedKey(rocksdb::Slice(blob.data() + 4, size)));
+    std::string table_name = key.At(1).ToString();
+    if (this->tables_.count(table_name) == 0) {
+      return;
+    }
+    std::string value(blob.data() + 4 + size, blob.size() - 4 - size);
+    RocksdbRow row = this->encryption_.DecryptValue(
+        key.At(0), EncryptedValue::FromDB(std::move(value)));
+    RocksdbSequence data(row.Release());
+    std::vector<rocksdb::Slice> values = data.Split();
+    bool positive = values.at(0) == rocksdb::Slice("1");
+    RocksdbSequence encoded(data.Slice(1, values.size() - 1));
+    const dataflow::SchemaRef &schema =
+        this->schemas_.at(table_name).Schema();
+    if (this->output_->empty() || this->output_->back().first != table_name) {
+      this->output_->emplace_back(table_name, std::vector<dataflow::Record>());
+    }
+    this->output_->back().second.push_back(
+        encoded.DecodeRecord(schema, positive));
+  }
+
+  // Writes to column families are not part of the log.
+  rocksdb::Status PutCF(uint32_t, const rocksdb::Slice &,
+                        const rocksdb::Slice &) override {
+    return rocksdb::Status::OK();
+  }
+  rocksdb::Status DeleteCF(uint32_t, const rocksdb::Slice &) override {
+    return rocksdb::Status::OK();
+  }
+  rocksdb::Status SingleDeleteCF(uint32_t, const rocksdb::Slice &) override {
+    return rocksdb::Status::OK();
+  }
+  rocksdb::Status DeleteRangeCF(uint32_t, const rocksdb::Slice &,
+                                const rocksdb::Slice &) override {
+    return rocksdb::Status::OK();
+  }
+  rocksdb::Status MergeCF(uint32_t, const rocksdb::Slice &,
+                          const rocksdb::Slice &) override {
+    return rocksdb::Status::OK();
+  }
+
+ private:
+  const EncryptionManager &encryption_;
+  const std::unordered_map<std::string, RocksdbTable> &schemas_;
+  const std::unordered_set<std::string> &tables_;
+  std::vector<LogEntry> *output_;
+};
+
+}  // namespace
+
+/*
+ * Logging writes.
+ */
+
+void RocksdbSession::LogRecords(const std::string &table_name,
+                                const std::vector<dataflow::Record> &records) {
+  CHECK(this->write_txn_) << "Logging records outside a write transaction";
+  RocksdbWriteTransaction *txn =
+      reinterpret_cast<RocksdbWriteTransaction *>(this->txn_.get());
+  const RocksdbTable &table = this->conn_->tables_.at(table_name);
+  size_t pk_column = table.PKColumn();
+  sqlast::ColumnDefinition::Type pk_type = table.Schema().TypeOf(pk_column);
+
+  // Positive records are in the shards that hold them after this transaction,
+  // negative records in the shards that held them before it.
+  RocksdbReadSnapshot before(this->conn_->db_.get());
+  for (const dataflow::Record &record : records) {
+    std::string pk = EncodeValue(pk_type, record.GetValue(pk_column));
+    const RocksdbInterface *state = txn;
+    if (!record.IsPositive()) {
+      state = &before;
+    }
+    std::optional<std::string> owner;
+    for (const RocksdbIndexRecord &entry :
+         table.GetPKIndex().Get({std::move(pk)}, state)) {
+      std::string shard = entry.GetShard().ToString();
+      if (!owner.has_value() || shard < owner.value()) {
+        owner = std::move(shard);
+      }
+    }
+    if (!owner.has_value()) {
+      owner = util::ShardName(DEFAULT_SHARD, DEFAULT_SHARD).ByMove();
+    }
+    const std::string &shard = owner.value();
+
+    // Encrypt the record like a row in that shard.
+    RocksdbSequence key;
+    key.Append(sqlast::Value(shard));
+    key.Append(sqlast::Value(table_name));
+    RocksdbSequence value;
+    value.Append(sqlast::Value(static_cast<uint64_t>(record.IsPositive())));
+    std::string data = value.Release();
+    data.append(RocksdbSequence::FromRecord(record).Release());
+    EncryptedKey enkey = this->conn_->encryption_.EncryptKey(std::move(key));
+    EncryptedValue envalue = this->conn_->encryption_.EncryptValue(
+        shard, RocksdbRow(std::move(data)));
+
+    std::string blob;
+    AppendBigEndian(&blob, enkey.Data().size(), 4);
+    blob.append(enkey.Data().data(), enkey.Data().size());
+    blob.append(envalue.Data().data(), envalue.Data().size());
+    txn->PutLogData(blob);
+  }
+}
+
+std::optional<std::vector<LogEntry>> RocksdbConnection::ReadLog(
+    uint64_t *watermark, const std::unordered_set<std::string> &tables) const {
+  std::vector<LogEntry> result;
+  uint64_t start = *watermark;
+  if (start >= this->db_->GetLatestSequenceNumber()) {
+    return result;
+  }
+
+  std::unique_ptr<rocksdb::TransactionLogIterator> it;
+  rocksdb::Status status = this->db_->GetUpdatesSince(start + 1, &it);
+  if (!status.ok()) {
+    LOG(WARNING) << "Cannot read log since " << start << ": "
+                 << status.ToString();
+    return {};
+  }
+
+  LogReader reader(this->encryption_, this->tables_, tables, &result);
+  for (bool first = true; it->Valid(); it->Next(), first = false) {
+    rocksdb::BatchResult batch = it->GetBatch();
+    if (first && batch.sequence > start + 1) {
+      LOG(WARNING) << "Log since " << start << " was discarded";
+      return {};
+    }
+    if (batch.sequence > start) {
+      PANIC(batch.writeBatchPtr->Iterate(&reader));
+      // A batch spans one sequence number per write in it.
+      int count = batch.writeBatchPtr->Count();
+      *watermark = batch.sequence + (count > 0 ? count - 1 : 0);
+    }
+  }
+  if (!it->status().ok()) {
+    LOG(WARNING) << "Cannot read log since " << start << ": "
+                 << it->status().ToString();
+    return {};
+  }
+  return result;
+}
+
+// Archived WAL files can be deleted through the DB, the live ones are deleted
+// by rocksdb once their writes are flushed.
+void RocksdbConnection::PurgeLog() {
+  rocksdb::VectorLogPtr files;
+  PANIC(this->db_->GetSortedWalFiles(files));
+  for (const std::unique_ptr<rocksdb::LogFile> &file : files) {
+    if (file->Type() == rocksdb::WalFileType::kArchivedLogFile) {
+      PANIC(this->db_->DeleteFile(file->PathName()));
+    }
+  }
+}
+
+/*
+ * View checkpoints.
+ */
+
+void RocksdbConnection::PersistCheckpoint(
+    const std::string &view_name, const std::string &signature,
+    std::vector<dataflow::CheckpointBatch> &&batches) {
+  rocksdb::ColumnFamilyHandle *cf = this->metadata_.CheckpointsHandle();
+  uint64_t watermark = this->db_->GetLatestSequenceNumber();
+
+  // Delete the previous checkpoint (header first).
+  this->DeleteCheckpoint(view_name);
+
+  // Write the records.
+  std::string prefix = CheckpointPrefix(view_name);
+  rocksdb::WriteOptions opts;
+  rocksdb::WriteBatch batch;
+  for (dataflow::CheckpointBatch &checkpoint : batches) {
+    for (size_t i = 0; i < checkpoint.records.size(); i++) {
+      std::string key = prefix;
+      AppendBigEndian(&key, checkpoint.partition, 4);
+      AppendBigEndian(&key, checkpoint.node, 4);
+      AppendBigEndian(&key, checkpoint.batch, 4);
+      AppendBigEndian(&key, i, 8);
+      EncryptedValue value = this->encryption_.EncryptGlobal(
+          RocksdbSequence::FromRecord(checkpoint.records.at(i)));
+      PANIC(batch.Put(cf, key, value.Data()));
+      if (batch.Count() >= CHECKPOINT_WRITE_BATCH) {
+        PANIC(this->db_->Write(opts, &batch));
+        batch.Clear();
+      }
+    }
+    checkpoint.records.clear();
+  }
+
+  // Write the header last, and make everything durable.
+  RocksdbSequence header;
+  header.Append(sqlast::Value(watermark));
+  header.Append(sqlast::Value(signature));
+  header.Append(sqlast::Value(CHECKPOINT_FORMAT_VERSION));
+  EncryptedValue value = this->encryption_.EncryptGlobal(std::move(header));
+  PANIC(batch.Put(cf, prefix, value.Data()));
+  opts.sync = true;
+  PANIC(this->db_->Write(opts, &batch));
+}
+
+std::optional<dataflow::FlowCheckpoint> RocksdbConnection::LoadCheckpoint(
+    const std::string &view_name, const std::string &signature,
+    const dataflow::CheckpointSchemas &schemas) const {
+  rocksdb::ColumnFamilyHandle *cf = this->metadata_.CheckpointsHandle();
+  std::string prefix = CheckpointPrefix(view_name);
+
+  rocksdb::ReadOptions opts;
+  opts.total_order_seek = true;
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(opts, cf));
+  it->Seek(prefix);
+  if (!it->Valid() || it->key() != rocksdb::Slice(prefix)) {
+    return {};
+  }
+
+  // Read the header.
+  dataflow::FlowCheckpoint checkpoint;
+  RocksdbSequence header = this->encryption_.DecryptGlobal(
+      EncryptedValue::FromDB(it->value().ToString()));
+  size_t fields = 0;
+  for (auto field = header.begin(); field != header.end(); ++field) {
+    fields++;
+  }
+  if (fields != 3 ||
+      header.At(2) != rocksdb::Slice(CHECKPOINT_FORMAT_VERSION)) {
+    LOG(WARNING) << "Discarding checkpoint of view " << view_name
+                 << " in an older format";
+    return {};
+  }
+  if (header.At(1) != rocksdb::Slice(signature)) {
+    LOG(WARNING) << "Discarding checkpoint of view " << view_name
+                 << " with a different signature";
+    return {};
+  }
+  checkpoint.watermark = std::stoull(header.At(0).ToString());
+
+  // Read the records, contiguous ones with the same (partition, node, batch)
+  // belong to the same batch.
+  dataflow::SchemaRef schema;
+  for (it->Next(); it->Valid() && StartsWith(it->key(), prefix); it->Next()) {
+    rocksdb::Slice key = it->key();
+    CHECK_EQ(key.size(), prefix.size() + 20) << "Bad checkpoint key";
+    const char *ptr = key.data() + prefix.size();
+    dataflow::PartitionIndex partition = ReadBigEndian(ptr, 4);
+    dataflow::NodeIndex node = ReadBigEndian(ptr + 4, 4);
+    uint32_t index = ReadBigEndian(ptr + 8, 4);
+    std::vector<dataflow::CheckpointBatch> &batches = checkpoint.batches;
+    if (batches.empty() || batches.back().partition != partition ||
+        batches.back().node != node || batches.back().batch != index) {
+      batches.push_back({partition, node, index, {}});
+      schema = schemas(partition, node, index);
+    }
+    RocksdbSequence value = this->encryption_.DecryptGlobal(
+        EncryptedValue::FromDB(it->value().ToString()));
+    batches.back().records.push_back(value.DecodeRecord(schema, true));
+  }
+  PANIC(it->status());
+  return checkpoint;
+}
+
+void RocksdbConnection::DeleteCheckpoint(const std::string &view_name) {
+  rocksdb::ColumnFamilyHandle *cf = this->metadata_.CheckpointsHandle();
+  std::string prefix = CheckpointPrefix(view_name);
+
+  rocksdb::ReadOptions ropts;
+  ropts.total_order_seek = true;
+  std::unique_ptr<rocksdb::Iterator> it(this->db_->NewIterator(ropts, cf));
+
+  rocksdb::WriteOptions wopts;
+  rocksdb::WriteBatch batch;
+  for (it->Seek(prefix); it->Valid() && StartsWith(it->key(), prefix);
+       it->Next()) {
+    PANIC(batch.Delete(cf, it->key()));
+    if (batch.Count() >= CHECKPOINT_WRITE_BATCH) {
+      PANIC(this->db_->Write(wopts, &batch));
+      batch.Clear();
+    }
+  }
+  PANIC(it->status());
+  wopts.sync = true;
+  PANIC(this->db_->Write(wopts, &batch));
+}
+
+}  // namespace rocks
+}  // namespace sql
+}  // namespace k9db
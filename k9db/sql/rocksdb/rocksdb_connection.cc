@@ -1,10 +1,12 @@
 #include "k9db/sql/rocksdb/rocksdb_connection.h"
 
 #include "glog/logging.h"
+#include "k9db/sql/rocksdb/options.h"
 #include "k9db/util/status.h"
 #include "rocksdb/options.h"
 
 #define DEFAULT_K9DB_DB_PATH "/tmp/k9db_"
+#define K9DB_WAL_ARCHIVE_MB 4096
 
 namespace k9db {
 namespace sql {
@@ -24,7 +26,8 @@ inline bool EndsWith(const std::string &str, const std::string &suffix) {
  */
 
 std::vector<std::string> RocksdbConnection::Open(const std::string &db_name,
-                                                 const std::string &db_path) {
+                                                 const std::string &db_path,
+                                                 bool archive_log) {
   // Make path for database.
   std::string path = DEFAULT_K9DB_DB_PATH;
   if (db_path.size() > 0) {
@@ -38,8 +41,14 @@ std::vector<std::string> RocksdbConnection::Open(const std::string &db_name,
   // Options.
   rocksdb::Options opts;
   opts.create_if_missing = true;
-  opts.IncreaseParallelism();
   opts.OptimizeLevelStyleCompaction();
+  ConfigureDBOptions(&opts);
+  // Archive the WAL instead of deleting it, so that views can be caught up
+  // from their checkpoints by reading the writes logged since (see ReadLog()).
+  // Backfills only read the recent log, which is not archived otherwise.
+  if (archive_log) {
+    opts.WAL_size_limit_MB = K9DB_WAL_ARCHIVE_MB;
+  }
 
   // Transaction options.
   rocksdb::TransactionDBOptions txn_opts;
@@ -80,6 +89,14 @@ std::vector<std::string> RocksdbConnection::Open(const std::string &db_name,
       // Statements persistent column family.
       descriptors.emplace_back(
           name, RocksdbMetadata::StatementsColumnFamilyOptions());
+    } else if (name == RocksdbMetadata::IndexVersionsColumnFamily()) {
+      // Index format versions column family.
+      descriptors.emplace_back(
+          name, RocksdbMetadata::IndexVersionsColumnFamilyOptions());
+    } else if (name == RocksdbMetadata::CheckpointsColumnFamily()) {
+      // View checkpoints column family.
+      descriptors.emplace_back(
+          name, RocksdbMetadata::CheckpointsColumnFamilyOptions());
     } else {
       // Column family corresponds to a regular table.
       descriptors.emplace_back(name, RocksdbTable::ColumnFamilyOptions());
@@ -95,6 +112,10 @@ std::vector<std::string> RocksdbConnection::Open(const std::string &db_name,
                                        &handles, &db));
   }
   this->db_ = std::unique_ptr<rocksdb::TransactionDB>(db);
+  if (GroupCommitWindow().count() > 0) {
+    this->group_commit_ =
+        std::make_unique<GroupCommit>(this->db_.get(), GroupCommitWindow());
+  }
 
   // Figure out what to do with any opened pre-existing column families.
   std::vector<std::string> result = this->metadata_.Initialize(
@@ -105,10 +126,17 @@ std::vector<std::string> RocksdbConnection::Open(const std::string &db_name,
   return result;
 }
 
+// Rocksdb settings (see options.h).
+std::vector<std::pair<std::string, std::string>>
+RocksdbConnection::GetSettings() const {
+  return DescribeOptions();
+}
+
 // Close database connection (on k9db shutdown).
 void RocksdbConnection::Close() {
   this->tables_.clear();
   this->metadata_.Clear();
+  this->group_commit_ = nullptr;
   this->db_ = nullptr;
 }
 
@@ -2,18 +2,23 @@
 #ifndef K9DB_SQL_ROCKSDB_ROCKSDB_CONNECTION_H_
 #define K9DB_SQL_ROCKSDB_ROCKSDB_CONNECTION_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "k9db/dataflow/checkpoint.h"
 #include "k9db/dataflow/record.h"
 #include "k9db/sql/connection.h"
 #include "k9db/sql/result.h"
 #include "k9db/sql/rocksdb/encryption.h"
 #include "k9db/sql/rocksdb/metadata.h"
+#include "k9db/sql/rocksdb/project.h"
 #include "k9db/sql/rocksdb/table.h"
 #include "k9db/sql/rocksdb/transaction.h"
 #include "k9db/sqlast/ast.h"
@@ -38,7 +43,8 @@ class RocksdbConnection : public Connection {
 
   // Open/close connection.
   std::vector<std::string> Open(const std::string &db_name,
-                                const std::string &db_path) override;
+                                const std::string &db_path,
+                                bool archive_log = false) override;
   void Close() override;
 
   // Schema statements.
@@ -51,13 +57,32 @@ class RocksdbConnection : public Connection {
   // Opening a session.
   std::unique_ptr<Session> OpenSession() override;
 
+  // View checkpoints.
+  void PersistCheckpoint(
+      const std::string &view_name, const std::string &signature,
+      std::vector<dataflow::CheckpointBatch> &&batches) override;
+  std::optional<dataflow::FlowCheckpoint> LoadCheckpoint(
+      const std::string &view_name, const std::string &signature,
+      const dataflow::CheckpointSchemas &schemas) const override;
+  void DeleteCheckpoint(const std::string &view_name) override;
+  std::optional<std::vector<LogEntry>> ReadLog(
+      uint64_t *watermark,
+      const std::unordered_set<std::string> &tables) const override;
+  void PurgeLog() override;
+
   // Index information for explain.
   std::vector<std::string> GetIndices(const std::string &tbl) const override;
   std::string GetIndex(const std::string &tbl,
                        const sqlast::BinaryExpression *const) const override;
 
+  // Storage settings.
+  std::vector<std::pair<std::string, std::string>> GetSettings()
+      const override;
+
  private:
   std::unique_ptr<rocksdb::TransactionDB> db_;
+  // Only if group commit is enabled (see options.h).
+  std::unique_ptr<GroupCommit> group_commit_;
   std::unordered_map<std::string, RocksdbTable> tables_;
   EncryptionManager encryption_;
   RocksdbMetadata metadata_;
@@ -77,9 +102,13 @@ class RocksdbSession : public Session {
 
   // Commit or rollback.
   void BeginTransaction(bool write) override;
-  void CommitTransaction() override;
+  bool CommitTransaction() override;
   void RollbackTransaction() override;
 
+  // Logging updates for checkpointed views.
+  void LogRecords(const std::string &table_name,
+                  const std::vector<dataflow::Record> &records) override;
+
   // Insert.
   bool Exists(const std::string &table_name,
               const sqlast::Value &pk) const override;
@@ -104,6 +133,10 @@ class RocksdbSession : public Session {
 
   // Everything in a table.
   SqlResultSet GetAll(const std::string &table_name) const override;
+  void StreamAll(const std::string &table_name, size_t chunk_size,
+                 const std::function<void(std::vector<dataflow::Record> &&)>
+                     &callback) const override;
+  uint64_t SnapshotSequenceNumber() const override;
 
   // Shard-based operations for GDPR GET/FORGET.
   SqlResultSet DeleteShard(const std::string &table_name,
@@ -149,18 +182,30 @@ class RocksdbSession : public Session {
   struct DeleteRecord {
     std::string shard;
     EncryptedKey key;
-    RocksdbSequence value;
+    RocksdbRow value;
     dataflow::Record record;
     // Move constructor only.
-    DeleteRecord(std::string &&s, EncryptedKey &&k, RocksdbSequence &&v,
+    DeleteRecord(std::string &&s, EncryptedKey &&k, RocksdbRow &&v,
                  dataflow::Record &&r);
   };
 
-  // Get records matching where condition.
+  // Get records matching where condition. Rows are filtered before they are
+  // decoded, and only the projected columns are decoded if a projection is
+  // given (SelectRecord only).
   template <typename T, bool DEDUP>
   std::vector<T> GetRecords(const std::string &table_name,
                             const sqlast::BinaryExpression *const where,
-                            int limit = -1) const;
+                            int limit = -1,
+                            const Projection *projection = nullptr) const;
+
+  // Get records matching where condition from a covering index, if the index
+  // covers the given columns. The other columns of the records are NULL,
+  // unless they are projected away by the given projection.
+  std::optional<std::vector<dataflow::Record>> GetCoveredRecords(
+      const std::string &table_name,
+      const sqlast::BinaryExpression *const where,
+      const std::vector<size_t> &columns, int limit = -1,
+      const Projection *projection = nullptr) const;
 };
 
 }  // namespace rocks
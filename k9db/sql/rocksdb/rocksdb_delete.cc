@@ -14,7 +14,7 @@ namespace rocks {
 
 // Move constructor for DeleteRecord.
 RocksdbSession::DeleteRecord::DeleteRecord(std::string &&s, EncryptedKey &&k,
-                                           RocksdbSequence &&v,
+                                           RocksdbRow &&v,
                                            dataflow::Record &&r)
     : shard(std::move(s)),
       key(std::move(k)),
@@ -52,7 +52,8 @@ SqlDeleteSet RocksdbSession::ExecuteDelete(const sqlast::Delete &sql) {
     table.Delete(element.key, txn);
 
     // Append record to result.
-    if (!dedup_keys.Exists(element.value.At(pk_col).ToString())) {
+    if (!dedup_keys.Exists(
+            element.value.EncodedAt(pk_col, schema.TypeOf(pk_col)))) {
       dedup_keys.Assign(result.AddRecord(std::move(element.record)));
     }
     result.AssignToShard(dedup_keys.Value(), std::move(element.shard));
@@ -3,9 +3,12 @@
 #include "k9db/sql/rocksdb/rocksdb_connection.h"
 // clang-format on
 
+#include <optional>
 #include <utility>
+#include <vector>
 
 #include "k9db/dataflow/schema.h"
+#include "k9db/util/thread_pool.h"
 
 namespace k9db {
 namespace sql {
@@ -26,14 +29,28 @@ SqlResultSet RocksdbSession::GetShard(const std::string &table_name,
   EncryptedPrefix seek =
       this->conn_->encryption_.EncryptSeek(std::move(shard_name));
 
-  // Get all content of shard.
+  // Get all content of shard, decrypt it in parallel chunks.
+  util::ThreadPool *pool = util::ThreadPool::Shared();
   RocksdbStream stream = table.GetShard(seek, this->txn_.get());
-  for (auto [enkey, envalue] : stream) {
-    RocksdbSequence key = this->conn_->encryption_.DecryptKey(std::move(enkey));
-    std::string shard = key.At(0).ToString();
-    RocksdbSequence value =
-        this->conn_->encryption_.DecryptValue(shard, std::move(envalue));
-    records.push_back(value.DecodeRecord(schema, true));
+  RocksdbStream::Iterator it = stream.begin();
+  RocksdbStream::Iterator end = stream.end();
+  while (it != end) {
+    std::vector<std::pair<EncryptedKey, EncryptedValue>> chunk;
+    for (; it != end && chunk.size() < DECRYPT_CHUNK_SIZE; ++it) {
+      chunk.push_back(*it);
+    }
+    std::vector<std::optional<dataflow::Record>> decoded(chunk.size());
+    pool->ParallelFor(chunk.size(), DECRYPT_GRAIN_SIZE, [&](size_t i) {
+      auto &[enkey, envalue] = chunk.at(i);
+      RocksdbSequence key =
+          this->conn_->encryption_.DecryptKey(std::move(enkey));
+      RocksdbRow value =
+          this->conn_->encryption_.DecryptValue(key.At(0), std::move(envalue));
+      decoded.at(i).emplace(value.DecodeRecord(schema, true));
+    });
+    for (std::optional<dataflow::Record> &record : decoded) {
+      records.push_back(std::move(*record));
+    }
   }
 
   return SqlResultSet(table_name, schema, std::move(records));
@@ -64,7 +81,7 @@ SqlResultSet RocksdbSession::DeleteShard(const std::string &table_name,
     // Decrypt and add to result set.
     RocksdbSequence key = this->conn_->encryption_.DecryptKey(std::move(enkey));
     std::string shard = key.At(0).ToString();
-    RocksdbSequence value =
+    RocksdbRow value =
         this->conn_->encryption_.DecryptValue(shard, std::move(envalue));
     records.push_back(value.DecodeRecord(schema, false));
 
@@ -1,9 +1,17 @@
+#include <optional>
 #include <type_traits>
 
 #include "glog/logging.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/sql/rocksdb/dedup.h"
 #include "k9db/sql/rocksdb/filter.h"
+#include "k9db/util/thread_pool.h"
+
+// Scans read this many rows before decrypting them together.
+#define DECRYPT_CHUNK_SIZE 1024
+// Every thread decrypts and decodes at least this many rows at a time, smaller
+// batches are decrypted by the calling thread alone.
+#define DECRYPT_GRAIN_SIZE 64
 
 namespace k9db {
 namespace sql {
@@ -15,13 +23,14 @@ namespace rocks {
 template <typename T, bool DEDUP>
 std::vector<T> RocksdbSession::GetRecords(
     const std::string &table_name, const sqlast::BinaryExpression *const where,
-    int limit) const {
+    int limit, const Projection *projection) const {
   using SET = std::conditional<DEDUP, DedupIndexSet, IndexSet>::type;
 
   // T must be one of {SelectRecord, DeleteRecord}.
   constexpr bool Tselect = std::is_same<T, SelectRecord>::value;
   constexpr bool Tdelete = std::is_same<T, DeleteRecord>::value;
   static_assert(Tselect || Tdelete);
+  CHECK(Tselect || projection == nullptr) << "Cannot project deleted records";
 
   const RocksdbTable &table = this->conn_->tables_.at(table_name);
   const dataflow::SchemaRef &schema = table.Schema();
@@ -35,6 +44,18 @@ std::vector<T> RocksdbSession::GetRecords(
   // Hold resulting records.
   std::vector<T> records;
 
+  // Filter a decrypted row and decode the ones that pass, only reading the
+  // columns needed by the filter and projection.
+  auto decode = [&](const RocksdbRow &row, std::optional<dataflow::Record> *o) {
+    if (value_mapper.Empty() || InMemoryFilter(value_mapper, row, schema)) {
+      if (projection != nullptr) {
+        o->emplace(Project(*projection, row));
+      } else {
+        o->emplace(row.DecodeRecord(schema, Tselect));
+      }
+    }
+  };
+
   // Look up existing indices.
   std::optional<SET> lookup;
   if constexpr (DEDUP) {
@@ -62,20 +83,28 @@ std::vector<T> RocksdbSession::GetRecords(
     std::vector<std::optional<EncryptedValue>> envalues =
         table.MultiGet(keys, this->txn_.get());
 
-    // Decrypt all values.
-    for (size_t i = 0; i < envalues.size(); i++) {
-      std::optional<EncryptedValue> &opt = envalues.at(i);
-      if (opt.has_value()) {
-        std::string &shard = shards.at(i);
-        RocksdbSequence value =
-            this->conn_->encryption_.DecryptValue(shard, std::move(*opt));
-
-        dataflow::Record record = value.DecodeRecord(schema, Tselect);
+    // Decrypt all values in parallel.
+    std::vector<RocksdbRow> values(envalues.size());
+    std::vector<std::optional<dataflow::Record>> decoded(envalues.size());
+    util::ThreadPool::Shared()->ParallelFor(
+        envalues.size(), DECRYPT_GRAIN_SIZE, [&](size_t i) {
+          std::optional<EncryptedValue> &opt = envalues.at(i);
+          if (opt.has_value()) {
+            values.at(i) = this->conn_->encryption_.DecryptValue(
+                shards.at(i), std::move(*opt));
+            decode(values.at(i), &decoded.at(i));
+          }
+        });
+
+    // Add to result in order.
+    for (size_t i = 0; i < decoded.size(); i++) {
+      if (decoded.at(i).has_value()) {
         if constexpr (Tselect) {
-          records.push_back(std::move(record));
+          records.push_back(std::move(*decoded.at(i)));
         } else if constexpr (Tdelete) {
-          records.emplace_back(std::move(shard), std::move(keys.at(i)),
-                               std::move(value), std::move(record));
+          records.emplace_back(std::move(shards.at(i)), std::move(keys.at(i)),
+                               std::move(values.at(i)),
+                               std::move(*decoded.at(i)));
         }
       }
     }
@@ -86,56 +115,81 @@ std::vector<T> RocksdbSession::GetRecords(
     }
 
     // Iterate over everything while deduplicating by PK.
+    // Rows are read in chunks, and the keys then the values of a chunk are
+    // decrypted in parallel. Deduplication and limit are applied in between,
+    // in the order rows are read.
+    util::ThreadPool *pool = util::ThreadPool::Shared();
     RocksdbStream all = table.GetAll(this->txn_.get());
     DedupSet<std::string> dup_keys;
-    for (auto [enkey, enval] : all) {
-      EncryptedKey enkey_copy = enkey;
-      if (limit != -1 && records.size() == static_cast<size_t>(limit)) {
-        break;
+    RocksdbStream::Iterator it = all.begin();
+    RocksdbStream::Iterator end = all.end();
+    while (it != end &&
+           (limit == -1 || records.size() < static_cast<size_t>(limit))) {
+      // Read a chunk.
+      std::vector<EncryptedKey> enkeys;
+      std::vector<EncryptedValue> envals;
+      for (; it != end && enkeys.size() < DECRYPT_CHUNK_SIZE; ++it) {
+        auto [enkey, enval] = *it;
+        enkeys.push_back(std::move(enkey));
+        envals.push_back(std::move(enval));
       }
 
-      // Decrypt key.
-      RocksdbSequence key =
-          this->conn_->encryption_.DecryptKey(std::move(enkey));
-
-      // Use shard from decrypted key to decrypt value.
-      if (!DEDUP || !dup_keys.Duplicate(key.At(1).ToString())) {
-        // Decrypt record.
-        std::string shard = key.At(0).ToString();
-        RocksdbSequence value =
-            this->conn_->encryption_.DecryptValue(shard, std::move(enval));
-        dataflow::Record record = value.DecodeRecord(schema, Tselect);
-
+      // Decrypt keys.
+      std::vector<RocksdbSequence> keys(enkeys.size());
+      pool->ParallelFor(enkeys.size(), DECRYPT_GRAIN_SIZE, [&](size_t i) {
         if constexpr (Tselect) {
-          records.push_back(std::move(record));
+          keys.at(i) =
+              this->conn_->encryption_.DecryptKey(std::move(enkeys.at(i)));
         } else if constexpr (Tdelete) {
-          records.emplace_back(std::move(shard), std::move(enkey_copy),
-                               std::move(value), std::move(record));
+          // Encrypted key is needed for deleting.
+          EncryptedKey enkey = enkeys.at(i);
+          keys.at(i) = this->conn_->encryption_.DecryptKey(std::move(enkey));
+        }
+      });
+
+      // Find the rows to decrypt. Rows may be filtered out after decryption,
+      // so the limit can only be used to stop early without filters.
+      std::vector<size_t> rows;
+      for (size_t i = 0; i < keys.size(); i++) {
+        if (limit != -1 && value_mapper.Empty() &&
+            records.size() + rows.size() == static_cast<size_t>(limit)) {
+          break;
+        }
+        if (!DEDUP || !dup_keys.Duplicate(keys.at(i).At(1).ToString())) {
+          rows.push_back(i);
         }
-      }
-    }
-  }
-
-  // Apply remaining filters (if any).
-  if (!value_mapper.Empty()) {
-    std::vector<T> filtered;
-    for (size_t i = 0; i < records.size(); i++) {
-      T &record = records.at(i);
-
-      // Perform filter on record.
-      bool filter;
-      if constexpr (Tselect) {
-        filter = InMemoryFilter(value_mapper, record);
-      } else if constexpr (Tdelete) {
-        filter = InMemoryFilter(value_mapper, record.record);
       }
 
-      // Move record into result if filtered.
-      if (filter) {
-        filtered.push_back(std::move(record));
+      // Use shard from decrypted key to decrypt value.
+      std::vector<std::string> shards(rows.size());
+      std::vector<RocksdbRow> values(rows.size());
+      std::vector<std::optional<dataflow::Record>> decoded(rows.size());
+      pool->ParallelFor(rows.size(), DECRYPT_GRAIN_SIZE, [&](size_t j) {
+        size_t i = rows.at(j);
+        shards.at(j) = keys.at(i).At(0).ToString();
+        values.at(j) = this->conn_->encryption_.DecryptValue(
+            shards.at(j), std::move(envals.at(i)));
+        decode(values.at(j), &decoded.at(j));
+      });
+
+      // Add to result in order.
+      for (size_t j = 0; j < rows.size(); j++) {
+        if (!decoded.at(j).has_value()) {
+          continue;
+        }
+        if (limit != -1 && records.size() == static_cast<size_t>(limit)) {
+          break;
+        }
+        if constexpr (Tselect) {
+          records.push_back(std::move(*decoded.at(j)));
+        } else if constexpr (Tdelete) {
+          records.emplace_back(std::move(shards.at(j)),
+                               std::move(enkeys.at(rows.at(j))),
+                               std::move(values.at(j)),
+                               std::move(*decoded.at(j)));
+        }
       }
     }
-    records = std::move(filtered);
   }
 
   return records;
@@ -80,7 +80,7 @@ int RocksdbSession::ExecuteInsert(const sqlast::Insert &stmt,
   EncryptedKey key =
       this->conn_->encryption_.EncryptKey(std::move(record.Key()));
   EncryptedValue value = this->conn_->encryption_.EncryptValue(
-      shard_name.ByRef(), std::move(record.Value()));
+      shard_name.AsSlice(), std::move(record.Value()));
 
   // Write to DB.
   table.Put(key, value, txn);
@@ -137,7 +137,7 @@ RecordAndStatus RocksdbSession::ExecuteReplace(
     if (opt.has_value()) {
       // Decrypt record.
       std::string &shard = shards.at(i);
-      RocksdbSequence value =
+      RocksdbRow value =
           this->conn_->encryption_.DecryptValue(shard, std::move(*opt));
       if (!result.has_value()) {
         result = value.DecodeRecord(schema, false);
@@ -170,7 +170,7 @@ RecordAndStatus RocksdbSession::ExecuteReplace(
           ? enkeys.at(same_shard_index)
           : this->conn_->encryption_.EncryptKey(std::move(record.Key()));
   EncryptedValue value = this->conn_->encryption_.EncryptValue(
-      shard_name.ByRef(), std::move(record.Value()));
+      shard_name.AsSlice(), std::move(record.Value()));
 
   // Write to DB.
   table.Put(key, value, txn);
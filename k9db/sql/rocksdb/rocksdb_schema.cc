@@ -28,7 +28,8 @@ bool RocksdbConnection::ExecuteCreateTable(const sqlast::CreateTable &stmt) {
   // Create table.
   auto [it, flag] = this->tables_.emplace(
       std::piecewise_construct, std::make_tuple(table_name),
-      std::make_tuple(this->db_.get(), table_name, schema, &this->metadata_));
+      std::make_tuple(this->db_.get(), table_name, schema, &this->metadata_,
+                      &this->encryption_));
   CHECK(flag);
 
   // Create indices for table.
@@ -63,7 +64,8 @@ bool RocksdbConnection::ExecuteCreateTable(const sqlast::CreateTable &stmt) {
 bool RocksdbConnection::ExecuteCreateIndex(const sqlast::CreateIndex &stmt) {
   const std::string &table_name = stmt.table_name();
   RocksdbTable &table = this->tables_.at(table_name);
-  std::string cf_name = table.CreateIndex(stmt.column_names());
+  std::string cf_name =
+      table.CreateIndex(stmt.column_names(), stmt.included_column_names());
 
   // After index creation succeeds. Persist the statement so that it can be
   // reloaded on restart.
@@ -105,7 +107,7 @@ int64_t RocksdbConnection::GetMaximumValue(
     if (!dup_keys.Duplicate(key.At(1).ToString())) {
       // Decrypt record.
       std::string shard = key.At(0).ToString();
-      RocksdbSequence value =
+      RocksdbRow value =
           this->encryption_.DecryptValue(shard, std::move(enval));
 
       // Track max.
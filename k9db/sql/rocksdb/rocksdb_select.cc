@@ -3,8 +3,19 @@
 #include "k9db/sql/rocksdb/rocksdb_connection.h"
 // clang-format on
 
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+// NOLINTNEXTLINE
+#include <variant>
+#include <vector>
+
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/dedup.h"
+#include "k9db/sql/rocksdb/filter.h"
 #include "k9db/sql/rocksdb/project.h"
+#include "k9db/util/thread_pool.h"
 
 namespace k9db {
 namespace sql {
@@ -21,23 +32,101 @@ SqlResultSet RocksdbSession::ExecuteSelect(const sqlast::Select &sql) const {
   const RocksdbTable &table = this->conn_->tables_.at(table_name);
   const dataflow::SchemaRef &schema = table.Schema();
 
-  // Filter by where clause.
-  std::vector<dataflow::Record> records =
-      this->GetRecords<SelectRecord, true>(table_name, where, sql.limit());
-
-  // Apply projection, if any.
+  // Columns read by the projection.
   Projection projection = ProjectionSchema(schema, sql.GetColumns());
-  if (projection.schema != schema) {
-    std::vector<dataflow::Record> projected;
-    for (const dataflow::Record &record : records) {
-      projected.push_back(Project(projection, record));
+  std::vector<size_t> columns;
+  if (projection.schema == schema) {
+    for (size_t i = 0; i < schema.size(); i++) {
+      columns.push_back(i);
+    }
+  }
+  for (const auto &v : projection.projections) {
+    if (v.index() == 0) {
+      columns.push_back(std::get<uint32_t>(v));
     }
-    records = std::move(projected);
+  }
+
+  // Filter by where clause, from a covering index if possible. The projection,
+  // if any, is applied while decoding.
+  const Projection *project = nullptr;
+  if (projection.schema != schema) {
+    project = &projection;
+  }
+  std::optional<std::vector<dataflow::Record>> covered =
+      this->GetCoveredRecords(table_name, where, columns, sql.limit(), project);
+  std::vector<dataflow::Record> records;
+  if (covered.has_value()) {
+    records = std::move(*covered);
+  } else {
+    records = this->GetRecords<SelectRecord, true>(table_name, where,
+                                                   sql.limit(), project);
   }
 
   return SqlResultSet(table_name, projection.schema, std::move(records));
 }
 
+// Reading covering indices instead of the table.
+std::optional<std::vector<dataflow::Record>> RocksdbSession::GetCoveredRecords(
+    const std::string &table_name, const sqlast::BinaryExpression *const where,
+    const std::vector<size_t> &columns, int limit,
+    const Projection *projection) const {
+  const RocksdbTable &table = this->conn_->tables_.at(table_name);
+  const dataflow::SchemaRef &schema = table.Schema();
+  if (where == nullptr) {
+    return {};
+  }
+
+  // Turn where condition into a value mapper, the remaining filters must also
+  // be covered.
+  sqlast::ValueMapper value_mapper(schema);
+  value_mapper.VisitBinaryExpression(*where);
+  std::vector<size_t> read = columns;
+  for (const auto &[col, _] : value_mapper.Values()) {
+    read.push_back(col);
+  }
+  for (const auto &[col, _] : value_mapper.Ranges()) {
+    read.push_back(col);
+  }
+
+  std::optional<CoveringIndexMap> lookup =
+      table.CoveringLookup(&value_mapper, read, this->txn_.get(), limit);
+  if (!lookup.has_value()) {
+    return {};
+  }
+
+  // Decrypt all the covered values in parallel.
+  std::vector<std::string> shards;
+  std::vector<std::string> envalues;
+  for (auto it = lookup->begin(); it != lookup->end();) {
+    auto node = lookup->extract(it++);
+    shards.push_back(node.key().GetShard().ToString());
+    envalues.push_back(std::move(node.mapped()));
+  }
+  // Remaining filters (if any) are applied before decoding.
+  std::vector<std::optional<dataflow::Record>> decoded(envalues.size());
+  util::ThreadPool::Shared()->ParallelFor(
+      envalues.size(), DECRYPT_GRAIN_SIZE, [&](size_t i) {
+        RocksdbRow value = this->conn_->encryption_.DecryptValue(
+            shards.at(i), EncryptedValue::FromDB(std::move(envalues.at(i))));
+        if (value_mapper.Empty() ||
+            InMemoryFilter(value_mapper, value, schema)) {
+          if (projection != nullptr) {
+            decoded.at(i).emplace(Project(*projection, value));
+          } else {
+            decoded.at(i).emplace(value.DecodeRecord(schema, true));
+          }
+        }
+      });
+
+  std::vector<dataflow::Record> records;
+  for (std::optional<dataflow::Record> &record : decoded) {
+    if (record.has_value()) {
+      records.push_back(std::move(*record));
+    }
+  }
+  return records;
+}
+
 // Everything in a table.
 SqlResultSet RocksdbSession::GetAll(const std::string &table_name) const {
   const RocksdbTable &table = this->conn_->tables_.at(table_name);
@@ -50,6 +139,66 @@ SqlResultSet RocksdbSession::GetAll(const std::string &table_name) const {
   return SqlResultSet(table_name, schema, std::move(records));
 }
 
+// Everything in a table, one chunk at a time.
+void RocksdbSession::StreamAll(
+    const std::string &table_name, size_t chunk_size,
+    const std::function<void(std::vector<dataflow::Record> &&)> &callback)
+    const {
+  const RocksdbTable &table = this->conn_->tables_.at(table_name);
+  const dataflow::SchemaRef &schema = table.Schema();
+
+  // Iterate over everything while deduplicating by PK, rows are decrypted in
+  // parallel chunks.
+  util::ThreadPool *pool = util::ThreadPool::Shared();
+  RocksdbStream all = table.GetAll(this->txn_.get());
+  RocksdbStream::Iterator it = all.begin();
+  RocksdbStream::Iterator end = all.end();
+  DedupSet<std::string> dup_keys;
+  std::vector<dataflow::Record> chunk;
+  chunk.reserve(chunk_size);
+  while (it != end) {
+    // Read and decrypt keys.
+    std::vector<std::pair<EncryptedKey, EncryptedValue>> rows;
+    for (; it != end && rows.size() < DECRYPT_CHUNK_SIZE; ++it) {
+      rows.push_back(*it);
+    }
+    std::vector<RocksdbSequence> keys(rows.size());
+    pool->ParallelFor(rows.size(), DECRYPT_GRAIN_SIZE, [&](size_t i) {
+      keys.at(i) =
+          this->conn_->encryption_.DecryptKey(std::move(rows.at(i).first));
+    });
+
+    // Deduplicate in order.
+    std::vector<size_t> unique;
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (!dup_keys.Duplicate(keys.at(i).At(1).ToString())) {
+        unique.push_back(i);
+      }
+    }
+
+    // Use shard from decrypted key to decrypt value.
+    std::vector<std::optional<dataflow::Record>> decoded(unique.size());
+    pool->ParallelFor(unique.size(), DECRYPT_GRAIN_SIZE, [&](size_t j) {
+      size_t i = unique.at(j);
+      RocksdbRow value = this->conn_->encryption_.DecryptValue(
+          keys.at(i).At(0), std::move(rows.at(i).second));
+      decoded.at(j).emplace(value.DecodeRecord(schema, true));
+    });
+
+    for (std::optional<dataflow::Record> &record : decoded) {
+      chunk.push_back(std::move(*record));
+      if (chunk.size() == chunk_size) {
+        callback(std::move(chunk));
+        chunk = std::vector<dataflow::Record>();
+        chunk.reserve(chunk_size);
+      }
+    }
+  }
+  if (chunk.size() > 0) {
+    callback(std::move(chunk));
+  }
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
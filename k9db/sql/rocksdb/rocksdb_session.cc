@@ -3,6 +3,9 @@
 #include "k9db/sql/rocksdb/rocksdb_connection.h"
 // clang-format on
 
+#include "glog/logging.h"
+#include "k9db/sql/rocksdb/options.h"
+
 namespace k9db {
 namespace sql {
 namespace rocks {
@@ -20,17 +23,21 @@ void RocksdbSession::BeginTransaction(bool write) {
   if (this->txn_ == nullptr) {
     rocksdb::TransactionDB *db = this->conn_->db_.get();
     if (write) {
-      this->txn_ = std::make_unique<RocksdbWriteTransaction>(db);
+      this->txn_ = std::make_unique<RocksdbWriteTransaction>(
+          db, this->conn_->group_commit_.get(), OptimisticTransactions());
     } else {
       this->txn_ = std::make_unique<RocksdbReadSnapshot>(db);
     }
   }
 }
-void RocksdbSession::CommitTransaction() {
+bool RocksdbSession::CommitTransaction() {
+  bool committed = true;
   if (this->write_txn_) {
-    reinterpret_cast<RocksdbWriteTransaction *>(this->txn_.get())->Commit();
+    committed =
+        reinterpret_cast<RocksdbWriteTransaction *>(this->txn_.get())->Commit();
   }
   this->txn_ = nullptr;
+  return committed;
 }
 void RocksdbSession::RollbackTransaction() {
   if (this->write_txn_) {
@@ -39,6 +46,12 @@ void RocksdbSession::RollbackTransaction() {
   this->txn_ = nullptr;
 }
 
+uint64_t RocksdbSession::SnapshotSequenceNumber() const {
+  CHECK(this->txn_ != nullptr && !this->write_txn_) << "Not a read snapshot";
+  return reinterpret_cast<RocksdbReadSnapshot *>(this->txn_.get())
+      ->SequenceNumber();
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
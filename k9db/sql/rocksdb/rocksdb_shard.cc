@@ -79,9 +79,10 @@ std::vector<dataflow::Record> RocksdbSession::GetDirect(
     std::optional<EncryptedValue> &en_row = en_rows.at(i);
     if (en_row.has_value()) {
       const std::string &shard = by_pk ? keys.at(i).first.ByRef() : decr.at(i);
-      RocksdbSequence row =
+      RocksdbRow row =
           this->conn_->encryption_.DecryptValue(shard, std::move(*en_row));
-      if (!dedup.Duplicate(row.At(table.PKColumn()).ToString())) {
+      size_t pk = table.PKColumn();
+      if (!dedup.Duplicate(row.EncodedAt(pk, schema.TypeOf(pk)))) {
         result.push_back(row.DecodeRecord(schema, true));
       }
     }
@@ -188,7 +189,7 @@ ResultSetAndStatus RocksdbSession::AssignToShards(
     }
 
     // Need to decrypt row.
-    RocksdbSequence row =
+    RocksdbRow row =
         this->conn_->encryption_.DecryptValue(data.shard, std::move(*enrow));
 
     // Need to delete row.
@@ -204,14 +205,16 @@ ResultSetAndStatus RocksdbSession::AssignToShards(
         // Create the new target key and encrypt it.
         RocksdbSequence target_key;
         target_key.Append(target);
-        target_key.AppendEncoded(row.At(schema.keys().front()));
+        size_t pk = schema.keys().front();
+        target_key.AppendEncoded(row.EncodedAt(pk, schema.TypeOf(pk)));
         EncryptedKey target_enkey =
             this->conn_->encryption_.EncryptKey(std::move(target_key));
 
         // Encrypt the row.
-        RocksdbSequence r(row);
+        RocksdbRow r(row);
         EncryptedValue target_envalue =
-            this->conn_->encryption_.EncryptValue(target.ByRef(), std::move(r));
+            this->conn_->encryption_.EncryptValue(target.AsSlice(),
+                                                  std::move(r));
 
         // Add to table.
         table.IndexAdd(target.AsSlice(), row, txn);
@@ -257,13 +260,13 @@ int RocksdbSession::DeleteFromShard(
 
   // Construct and encrypt key.
   std::vector<EncryptedKey> en_keys;
-  std::vector<RocksdbSequence> rows;
+  std::vector<RocksdbRow> rows;
   for (const dataflow::Record &record : records) {
     RocksdbSequence key;
     key.Append(shard_name);
     key.Append(record.GetValue(pk_index));
     en_keys.push_back(this->conn_->encryption_.EncryptKey(std::move(key)));
-    rows.push_back(RocksdbSequence::FromRecord(record));
+    rows.push_back(RocksdbRow::FromRecord(record));
   }
 
   // Delete all keys.
@@ -284,7 +287,7 @@ int RocksdbSession::DeleteFromShard(
 
       // Add to table with default shard.
       table.Put(this->conn_->encryption_.EncryptKey(std::move(key)),
-                this->conn_->encryption_.EncryptValue(default_shard.ByRef(),
+                this->conn_->encryption_.EncryptValue(default_shard.AsSlice(),
                                                       std::move(rows.at(i))),
                 txn);
       count++;
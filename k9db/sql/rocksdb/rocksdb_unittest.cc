@@ -557,6 +557,25 @@ TEST_F(RocksdbConnectionTest, GetAllDeleteAll) {
   EXPECT_EQ(session->GetAll("test_table"), GetRecords({}));
 }
 
+/*
+ * Stream all data in chunks.
+ */
+TEST_F(RocksdbConnectionTest, StreamAllChunks) {
+  // Shared record appears only once, chunks are never larger than asked.
+  std::vector<dataflow::Record> records;
+  size_t chunks = 0;
+  session->StreamAll("test_table", 3, [&](std::vector<dataflow::Record> &&v) {
+    EXPECT_LE(v.size(), 3);
+    records.insert(records.end(), std::make_move_iterator(v.begin()),
+                   std::make_move_iterator(v.end()));
+    chunks++;
+  });
+  EXPECT_EQ(chunks, 2);
+  std::vector<dataflow::Record> expected = GetRecords({0, 1, 2, 3});
+  EXPECT_TRUE(std::is_permutation(records.begin(), records.end(),
+                                  expected.begin(), expected.end()));
+}
+
 /*
  * Test CountShards(...).
  */
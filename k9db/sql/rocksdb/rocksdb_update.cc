@@ -46,10 +46,11 @@ SqlUpdateSet RocksdbSession::ExecuteUpdate(const sqlast::Update &sql) {
   for (DeleteRecord &element : records) {
     // Update record.
     dataflow::Record urecord = element.record.Update(updates);
-    RocksdbSequence updated = RocksdbSequence::FromRecord(urecord);
+    RocksdbRow updated = RocksdbRow::FromRecord(urecord);
 
     // Append record to result.
-    if (!dedup_keys.Exists(element.value.At(pk_col).ToString())) {
+    if (!dedup_keys.Exists(
+            element.value.EncodedAt(pk_col, schema.TypeOf(pk_col)))) {
       dedup_keys.Assign(
           result.AddRecord(std::move(element.record), std::move(urecord)));
     }
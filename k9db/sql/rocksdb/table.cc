@@ -3,9 +3,14 @@
 #include <utility>
 
 #include "glog/logging.h"
+#include "k9db/sql/rocksdb/options.h"
 #include "k9db/util/status.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table.h"
+#include "rocksdb/write_batch.h"
+
+// Number of entries written at a time when rebuilding an index.
+#define REBUILD_BATCH_SIZE 10000
 
 namespace k9db {
 namespace sql {
@@ -32,17 +37,20 @@ rocksdb::ColumnFamilyOptions RocksdbTable::ColumnFamilyOptions() {
   options.OptimizeLevelStyleCompaction();
   options.prefix_extractor.reset(new K9dbPrefixTransform());
   options.comparator = K9dbComparator();
+  ConfigureColumnFamily(ColumnFamilyKind::TABLE, &options);
   return options;
 }
 
 // Constructor.
 RocksdbTable::RocksdbTable(rocksdb::DB *db, const std::string &table_name,
                            const dataflow::SchemaRef &schema,
-                           RocksdbMetadata *metadata)
+                           RocksdbMetadata *metadata,
+                           EncryptionManager *encryption)
     : db_(db),
       table_name_(table_name),
       schema_(schema),
       metadata_(metadata),
+      encryption_(encryption),
       pk_column_(),
       unique_columns_(),
       handle_(),
@@ -72,8 +80,12 @@ RocksdbTable::RocksdbTable(rocksdb::DB *db, const std::string &table_name,
 }
 
 // Create an index.
-std::string RocksdbTable::CreateIndex(const std::vector<size_t> &cols) {
+std::string RocksdbTable::CreateIndex(const std::vector<size_t> &cols,
+                                      const std::vector<size_t> &included) {
   CHECK_GT(cols.size(), 0u) << "Index has no columns";
+  if (included.size() > 0) {
+    CHECK(this->encryption_ != nullptr) << "Covering index without encryption";
+  }
   if (std::find(cols.begin(), cols.end(), this->pk_column_) != cols.end()) {
     LOG(FATAL) << "Index includes PK";
   }
@@ -85,7 +97,7 @@ std::string RocksdbTable::CreateIndex(const std::vector<size_t> &cols) {
     }
   }
   for (const RocksdbIndex &index : this->indices_) {
-    if (index.GetColumns() == cols) {
+    if (index.GetColumns() == cols && index.GetIncluded() == included) {
       return index.name();
     }
     if (IsPrefix(cols, index.GetColumns())) {
@@ -95,16 +107,94 @@ std::string RocksdbTable::CreateIndex(const std::vector<size_t> &cols) {
       LOG(WARNING) << "An existing index is a prefix of index being created";
     }
   }
-  this->indices_.emplace_back(this->db_, this->table_name_, cols,
-                              this->metadata_);
+  std::vector<sqlast::ColumnDefinition::Type> types;
+  for (size_t col : cols) {
+    types.push_back(this->schema_.TypeOf(col));
+  }
+  this->indices_.emplace_back(this->db_, this->table_name_, cols, types,
+                              included, this->metadata_);
+  if (this->indices_.back().Stale()) {
+    this->RebuildIndex(&this->indices_.back());
+  }
   return this->indices_.back().name();
 }
 
+// Rebuild an index whose entries are in an older format from the rows.
+// Happens once, when an index persisted by an older version is reloaded.
+void RocksdbTable::RebuildIndex(RocksdbIndex *index) {
+  LOG(WARNING) << "Rebuilding index " << index->name() << " of "
+               << this->table_name_;
+  index->Clear();
+
+  rocksdb::ReadOptions opts;
+  opts.total_order_seek = true;
+  std::unique_ptr<rocksdb::Iterator> it(
+      this->db_->NewIterator(opts, this->handle_.get()));
+  it->SeekToFirst();
+
+  rocksdb::WriteOptions wopts;
+  wopts.sync = true;
+  rocksdb::WriteBatch batch;
+  for (auto [enkey, enval] : RocksdbStream(std::move(it))) {
+    RocksdbSequence key = this->encryption_->DecryptKey(std::move(enkey));
+    rocksdb::Slice shard = key.At(0);
+    RocksdbRow row = this->encryption_->DecryptValue(shard, std::move(enval));
+    std::vector<std::string> split = this->EncodeColumns(row);
+    std::vector<rocksdb::Slice> index_values;
+    index_values.reserve(index->GetColumns().size());
+    for (size_t col : index->GetColumns()) {
+      index_values.push_back(split.at(col));
+    }
+    index->Add(index_values, shard, split.at(this->pk_column_),
+               this->IndexValue(*index, shard, row), &batch);
+    if (batch.Count() >= REBUILD_BATCH_SIZE) {
+      PANIC(this->db_->Write(wopts, &batch));
+      batch.Clear();
+    }
+  }
+  PANIC(this->db_->Write(wopts, &batch));
+  index->MarkCurrent();
+}
+
+// Index keys hold values encoded as in RocksdbSequence, whatever the format of
+// the row.
+std::vector<std::string> RocksdbTable::EncodeColumns(
+    const RocksdbRow &row) const {
+  std::vector<std::string> result;
+  result.reserve(this->schema_.size());
+  if (row.IsLegacy()) {
+    for (rocksdb::Slice v : RocksdbSequence(row.Data())) {
+      result.push_back(v.ToString());
+    }
+    return result;
+  }
+  for (size_t col = 0; col < this->schema_.size(); col++) {
+    result.push_back(row.EncodedAt(col, this->schema_.TypeOf(col)));
+  }
+  return result;
+}
+
+// Covering indices store the row with the columns they do not cover replaced
+// by NULL, encrypted like the row. Other indices store nothing.
+std::string RocksdbTable::IndexValue(const RocksdbIndex &index,
+                                     const rocksdb::Slice &shard,
+                                     const RocksdbRow &row) {
+  if (index.GetIncluded().empty()) {
+    return "";
+  }
+  std::vector<bool> keep(this->schema_.size());
+  for (size_t col = 0; col < keep.size(); col++) {
+    keep[col] = col == this->pk_column_ || index.Covers(col);
+  }
+  RocksdbRow covered = row.Mask(this->schema_, keep);
+  return this->encryption_->EncryptValue(shard, std::move(covered)).Release();
+}
+
 // Index updating.
 void RocksdbTable::IndexAdd(const rocksdb::Slice &shard,
-                            const RocksdbSequence &row,
+                            const RocksdbRow &row,
                             RocksdbWriteTransaction *txn, bool update_pk) {
-  std::vector<rocksdb::Slice> split = row.Split();
+  std::vector<std::string> split = this->EncodeColumns(row);
   rocksdb::Slice pk = split.at(this->pk_column_);
 
   // Update PK index.
@@ -119,13 +209,14 @@ void RocksdbTable::IndexAdd(const rocksdb::Slice &shard,
     for (size_t col : index.GetColumns()) {
       index_values.push_back(split.at(col));
     }
-    index.Add(index_values, shard, pk, txn);
+    index.Add(index_values, shard, pk, txn,
+              this->IndexValue(index, shard, row));
   }
 }
 void RocksdbTable::IndexDelete(const rocksdb::Slice &shard,
-                               const RocksdbSequence &row,
+                               const RocksdbRow &row,
                                RocksdbWriteTransaction *txn, bool update_pk) {
-  std::vector<rocksdb::Slice> split = row.Split();
+  std::vector<std::string> split = this->EncodeColumns(row);
   rocksdb::Slice pk = split.at(this->pk_column_);
 
   // Update PK index.
@@ -144,11 +235,11 @@ void RocksdbTable::IndexDelete(const rocksdb::Slice &shard,
   }
 }
 void RocksdbTable::IndexUpdate(const rocksdb::Slice &shard,
-                               const RocksdbSequence &old,
-                               const RocksdbSequence &updated,
+                               const RocksdbRow &old,
+                               const RocksdbRow &updated,
                                RocksdbWriteTransaction *txn) {
-  std::vector<rocksdb::Slice> osplit = old.Split();
-  std::vector<rocksdb::Slice> usplit = updated.Split();
+  std::vector<std::string> osplit = this->EncodeColumns(old);
+  std::vector<std::string> usplit = this->EncodeColumns(updated);
   rocksdb::Slice pk = osplit.at(this->pk_column_);
   CHECK(pk == usplit.at(this->pk_column_)) << "Update cannot change PK";
 
@@ -163,9 +254,17 @@ void RocksdbTable::IndexUpdate(const rocksdb::Slice &shard,
       uvalues.push_back(usplit.at(col));
       changed = changed || osplit.at(col) != usplit.at(col);
     }
+    // Covering entries are rewritten if any included column changes.
+    bool included_changed = false;
+    for (size_t col : index.GetIncluded()) {
+      included_changed = included_changed || osplit.at(col) != usplit.at(col);
+    }
     if (changed) {
       index.Delete(ovalues, shard, pk, txn);
-      index.Add(uvalues, shard, pk, txn);
+    }
+    if (changed || included_changed) {
+      index.Add(uvalues, shard, pk, txn,
+                this->IndexValue(index, shard, updated));
     }
   }
 }
@@ -206,6 +305,28 @@ RocksdbPlan RocksdbTable::ChooseIndex(
     plan.MakeIndex(false, this->indices_.at(argmax).GetColumns(), argmax);
     return plan;
   }
+  // Otherwise, we try an index whose leading columns have values followed by
+  // a column with a range, with as many columns matched as possible.
+  for (size_t i = 0; i < this->indices_.size(); i++) {
+    const std::vector<size_t> &index_cols = this->indices_.at(i).GetColumns();
+    for (size_t k = 0; k < index_cols.size(); k++) {
+      size_t col = index_cols.at(k);
+      if (value_mapper->HasValues(col)) {
+        continue;
+      }
+      if (value_mapper->HasRange(col) && k + 1 > max) {
+        max = k + 1;
+        argmax = i;
+      }
+      break;
+    }
+  }
+  if (max > 0) {
+    const std::vector<size_t> &index_cols =
+        this->indices_.at(argmax).GetColumns();
+    plan.MakeRange({index_cols.begin(), index_cols.begin() + max}, argmax);
+    return plan;
+  }
   plan.MakeScan();
   return plan;
 }
@@ -237,6 +358,16 @@ std::optional<IndexSet> RocksdbTable::IndexLookup(
       return index.Get(index.EncodeComposite(value_mapper, this->schema_), txn,
                        limit);
     }
+    // By a range over an index.
+    case RocksdbPlan::IndexChoiceType::RANGE: {
+      const RocksdbIndex &index = this->indices_.at(plan.idx());
+      std::vector<std::string> encoded =
+          index.EncodeComposite(value_mapper, this->schema_);
+      sqlast::ValueMapper::Range range =
+          value_mapper->ReleaseRange(plan.cols().back());
+      return index.GetRange(std::move(encoded), plan.cols().size() - 1, range,
+                            txn, limit);
+    }
     // By scan.
     case RocksdbPlan::IndexChoiceType::SCAN:
       return {};
@@ -264,6 +395,16 @@ std::optional<DedupIndexSet> RocksdbTable::IndexLookupDedup(
       return index.GetDedup(index.EncodeComposite(value_mapper, this->schema_),
                             txn, limit);
     }
+    // By a range over an index.
+    case RocksdbPlan::IndexChoiceType::RANGE: {
+      const RocksdbIndex &index = this->indices_.at(plan.idx());
+      std::vector<std::string> encoded =
+          index.EncodeComposite(value_mapper, this->schema_);
+      sqlast::ValueMapper::Range range =
+          value_mapper->ReleaseRange(plan.cols().back());
+      return index.GetRangeDedup(std::move(encoded), plan.cols().size() - 1,
+                                 range, txn, limit);
+    }
     // By scan.
     case RocksdbPlan::IndexChoiceType::SCAN:
       return {};
@@ -272,6 +413,37 @@ std::optional<DedupIndexSet> RocksdbTable::IndexLookupDedup(
   }
 }
 
+// Covering index lookup.
+std::optional<CoveringIndexMap> RocksdbTable::CoveringLookup(
+    sqlast::ValueMapper *value_mapper, const std::vector<size_t> &columns,
+    const RocksdbInterface *txn, int limit) const {
+  RocksdbPlan plan = this->ChooseIndex(value_mapper);
+  if (plan.type() != RocksdbPlan::IndexChoiceType::UNIQUE &&
+      plan.type() != RocksdbPlan::IndexChoiceType::REGULAR &&
+      plan.type() != RocksdbPlan::IndexChoiceType::RANGE) {
+    return {};
+  }
+  const RocksdbIndex &index = this->indices_.at(plan.idx());
+  if (index.GetIncluded().empty()) {
+    return {};
+  }
+  for (size_t col : columns) {
+    if (col != this->pk_column_ && !index.Covers(col)) {
+      return {};
+    }
+  }
+
+  std::vector<std::string> encoded =
+      index.EncodeComposite(value_mapper, this->schema_);
+  if (plan.type() == RocksdbPlan::IndexChoiceType::RANGE) {
+    sqlast::ValueMapper::Range range =
+        value_mapper->ReleaseRange(plan.cols().back());
+    return index.GetRangeCovering(std::move(encoded), plan.cols().size() - 1,
+                                  range, txn, limit);
+  }
+  return index.GetCovering(std::move(encoded), txn, limit);
+}
+
 // Check if a record with given PK exists.
 bool RocksdbTable::Exists(const rocksdb::Slice &pk_value,
                           const RocksdbWriteTransaction *txn) const {
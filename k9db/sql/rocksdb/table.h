@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "k9db/dataflow/schema.h"
+#include "k9db/sql/rocksdb/dedup.h"
 #include "k9db/sql/rocksdb/encode.h"
 #include "k9db/sql/rocksdb/encryption.h"
 #include "k9db/sql/rocksdb/index.h"
@@ -71,9 +72,11 @@ class RocksdbTable {
   // Rocksdb Options for table column families.
   static rocksdb::ColumnFamilyOptions ColumnFamilyOptions();
 
+  // encryption is used to encrypt the values stored in covering indices.
   RocksdbTable(rocksdb::DB *db, const std::string &table_name,
                const dataflow::SchemaRef &schema,
-               RocksdbMetadata *metadata = nullptr);
+               RocksdbMetadata *metadata = nullptr,
+               EncryptionManager *encryption = nullptr);
 
   void AddUniqueColumn(size_t column) {
     this->unique_columns_.push_back(column);
@@ -84,23 +87,28 @@ class RocksdbTable {
   size_t PKColumn() const { return this->pk_column_; }
 
   // Index creation.
-  std::string CreateIndex(const std::vector<size_t> &columns);
-  std::string CreateIndex(const std::vector<std::string> &column_names) {
+  std::string CreateIndex(const std::vector<size_t> &columns,
+                          const std::vector<size_t> &included = {});
+  std::string CreateIndex(const std::vector<std::string> &column_names,
+                          const std::vector<std::string> &included_names = {}) {
     std::vector<size_t> columns;
     for (const std::string &column_name : column_names) {
       columns.push_back(this->schema_.IndexOf(column_name));
     }
-    return this->CreateIndex(columns);
+    std::vector<size_t> included;
+    for (const std::string &column_name : included_names) {
+      included.push_back(this->schema_.IndexOf(column_name));
+    }
+    return this->CreateIndex(columns, included);
   }
 
   // Index updating.
-  void IndexAdd(const rocksdb::Slice &shard, const RocksdbSequence &row,
+  void IndexAdd(const rocksdb::Slice &shard, const RocksdbRow &row,
                 RocksdbWriteTransaction *txn, bool update_pk = true);
-  void IndexDelete(const rocksdb::Slice &shard, const RocksdbSequence &row,
+  void IndexDelete(const rocksdb::Slice &shard, const RocksdbRow &row,
                    RocksdbWriteTransaction *txn, bool update_pk = true);
-  void IndexUpdate(const rocksdb::Slice &shard, const RocksdbSequence &old,
-                   const RocksdbSequence &updated,
-                   RocksdbWriteTransaction *txn);
+  void IndexUpdate(const rocksdb::Slice &shard, const RocksdbRow &old,
+                   const RocksdbRow &updated, RocksdbWriteTransaction *txn);
 
   // Query planning (selecting index).
   RocksdbPlan ChooseIndex(const sqlast::ValueMapper *vm) const;
@@ -114,6 +122,13 @@ class RocksdbTable {
                                                 const RocksdbInterface *txn,
                                                 int limit = -1) const;
 
+  // Look up the values stored in a covering index, rather than the keys of
+  // the records. Returns nothing unless the index chosen for vm covers all the
+  // given columns.
+  std::optional<CoveringIndexMap> CoveringLookup(
+      sqlast::ValueMapper *vm, const std::vector<size_t> &columns,
+      const RocksdbInterface *txn, int limit = -1) const;
+
   // Get an index.
   const RocksdbPKIndex &GetPKIndex() const { return this->pk_index_; }
   const RocksdbIndex &GetTableIndex(size_t index) const {
@@ -166,6 +181,7 @@ class RocksdbTable {
   std::string table_name_;
   dataflow::SchemaRef schema_;
   RocksdbMetadata *metadata_;
+  EncryptionManager *encryption_;
   // The index of the PK column.
   size_t pk_column_;
   std::vector<size_t> unique_columns_;
@@ -176,6 +192,16 @@ class RocksdbTable {
   // Indices.
   RocksdbPKIndex pk_index_;
   std::vector<RocksdbIndex> indices_;
+
+  // The values of the row encoded as in index keys.
+  std::vector<std::string> EncodeColumns(const RocksdbRow &row) const;
+
+  // The value to store in the entry of the given index for the given row.
+  std::string IndexValue(const RocksdbIndex &index, const rocksdb::Slice &shard,
+                         const RocksdbRow &row);
+
+  // Rebuild an index whose entries are in an older format from the rows.
+  void RebuildIndex(RocksdbIndex *index);
 };
 
 }  // namespace rocks
@@ -63,10 +63,19 @@ RocksdbSequence FromVector(const std::vector<std::string> &vec) {
   return sequence;
 }
 
-std::vector<RocksdbSequence> DecryptStream(const EncryptionManager &enc,
-                                           RocksdbStream &&s) {
+// Rows in the binary format, and in the format of older versions.
+RocksdbRow Row(const std::vector<std::string> &vec) {
+  RocksdbRow legacy(FromVector(vec).Release());
+  return RocksdbRow::FromRecord(legacy.DecodeRecord(schema, true));
+}
+RocksdbRow LegacyRow(const std::vector<std::string> &vec) {
+  return RocksdbRow(FromVector(vec).Release());
+}
+
+std::vector<RocksdbRow> DecryptStream(const EncryptionManager &enc,
+                                      RocksdbStream &&s) {
   std::vector<std::pair<EncryptedKey, EncryptedValue>> all(s.begin(), s.end());
-  std::vector<RocksdbSequence> rows;
+  std::vector<RocksdbRow> rows;
   for (auto &&[enkey, envalue] : all) {
     RocksdbSequence key = enc.DecryptKey(std::move(enkey));
     std::string shard = key.At(0).ToString();
@@ -93,10 +102,10 @@ TEST(TableTest, PutExistsGetDelete) {
   RocksdbSequence k2 = FromVector({"usr1", "10"});
   RocksdbSequence k3 = FromVector({"usr2", "30"});
   RocksdbSequence k4 = FromVector({"usr0", "20"});
-  RocksdbSequence v1 = FromVector({"10", "user0", "-10", "mail", "2012-11-11"});
-  RocksdbSequence v2 = FromVector({"10", "user1", "5", "mail", "1992-02-19"});
-  RocksdbSequence v3 = FromVector({"30", "user2", NUL, "mail", "2002-01-09"});
-  RocksdbSequence v4 = FromVector({"20", "user0", "0", NUL, "2022-11-09"});
+  RocksdbRow v1 = Row({"10", "user0", "-10", "mail", "2012-11-11"});
+  RocksdbRow v2 = Row({"10", "user1", "5", "mail", "1992-02-19"});
+  RocksdbRow v3 = Row({"30", "user2", NUL, "mail", "2002-01-09"});
+  RocksdbRow v4 = LegacyRow({"20", "user0", "0", NUL, "2022-11-09"});
 
   // First update indices.
   tbl.IndexAdd("usr0", v1, txn.get());
@@ -131,10 +140,10 @@ TEST(TableTest, PutExistsGetDelete) {
   EXPECT_FALSE(tbl.Exists("50", txn.get()));
 
   // Read.
-  RocksdbSequence r1 = enc.DecryptValue("usr0", *tbl.Get(e1, txn.get()));
-  RocksdbSequence r2 = enc.DecryptValue("usr1", *tbl.Get(e2, txn.get()));
-  RocksdbSequence r3 = enc.DecryptValue("usr2", *tbl.Get(e3, txn.get()));
-  RocksdbSequence r4 = enc.DecryptValue("usr0", *tbl.Get(e4, txn.get()));
+  RocksdbRow r1 = enc.DecryptValue("usr0", *tbl.Get(e1, txn.get()));
+  RocksdbRow r2 = enc.DecryptValue("usr1", *tbl.Get(e2, txn.get()));
+  RocksdbRow r3 = enc.DecryptValue("usr2", *tbl.Get(e3, txn.get()));
+  RocksdbRow r4 = enc.DecryptValue("usr0", *tbl.Get(e4, txn.get()));
 
   // Check correctness.
   EXPECT_EQ(v1.Data(), r1.Data());
@@ -145,7 +154,7 @@ TEST(TableTest, PutExistsGetDelete) {
   EXPECT_FALSE(tbl.Get(e6, txn.get()).has_value());
 
   // Check that stream gives us correct data.
-  std::vector<RocksdbSequence> rows = DecryptStream(enc, tbl.GetAll(txn.get()));
+  std::vector<RocksdbRow> rows = DecryptStream(enc, tbl.GetAll(txn.get()));
   EXPECT_NE(std::find(rows.begin(), rows.end(), v1), rows.end());
   EXPECT_NE(std::find(rows.begin(), rows.end(), v2), rows.end());
   EXPECT_NE(std::find(rows.begin(), rows.end(), v3), rows.end());
@@ -170,8 +179,8 @@ TEST(TableTest, PutExistsGetDelete) {
   EXPECT_FALSE(tbl.Exists("50", txn.get()));
 
   // Read.
-  RocksdbSequence d1 = enc.DecryptValue("usr0", *tbl.Get(e1, txn.get()));
-  RocksdbSequence d4 = enc.DecryptValue("usr0", *tbl.Get(e4, txn.get()));
+  RocksdbRow d1 = enc.DecryptValue("usr0", *tbl.Get(e1, txn.get()));
+  RocksdbRow d4 = enc.DecryptValue("usr0", *tbl.Get(e4, txn.get()));
 
   // Check correctness.
   EXPECT_EQ(v1.Data(), d1.Data());
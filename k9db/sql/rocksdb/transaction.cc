@@ -15,16 +15,27 @@ namespace rocks {
 namespace {
 
 // Options for transaction.
-rocksdb::WriteOptions WriteOpts() {
+rocksdb::WriteOptions WriteOpts(bool sync) {
   rocksdb::WriteOptions opts;
-  opts.sync = true;
+  opts.sync = sync;
   return opts;
 }
-rocksdb::TransactionOptions TxnOpts() {
+rocksdb::TransactionOptions TxnOpts(bool optimistic) {
   rocksdb::TransactionOptions opts;
+  // Writes are validated against the snapshot. Optimistic transactions only
+  // lock their read set on commit, possibly after other transactions locked
+  // parts of it for writing, so we detect deadlocks instead of waiting them
+  // out.
+  opts.set_snapshot = optimistic;
+  opts.deadlock_detect = optimistic;
   return opts;
 }
 
+// Statuses that indicate a conflict with a concurrent transaction.
+bool IsConflict(const rocksdb::Status &status) {
+  return status.IsBusy() || status.IsTryAgain() || status.IsTimedOut();
+}
+
 // While the usual rocksdb::Iterator, used for reading data from the database,
 // respects the parameters passed to it in the associated rocksdb::Options, the
 // specific child class of Iterator that rocksdb::WriteBatchWithIndex uses
@@ -89,11 +100,15 @@ class PrefixRespectingIterator : public rocksdb::Iterator {
 // prefix, the first row outside that prefix will be eventually read, which
 // is when iteration ends, this last key is not locked).
 // Locking occurs on Next().
+// For optimistic transactions, rows are added to the read set instead.
 class LockingIterator : public rocksdb::Iterator {
  public:
+  using ReadSet =
+      std::vector<std::pair<rocksdb::ColumnFamilyHandle *, std::string>>;
+
   LockingIterator(rocksdb::Iterator *it, rocksdb::Transaction *txn,
-                  rocksdb::ColumnFamilyHandle *cf)
-      : it_(it), txn_(txn), cf_(cf) {}
+                  rocksdb::ColumnFamilyHandle *cf, ReadSet *read_set)
+      : it_(it), txn_(txn), cf_(cf), read_set_(read_set) {}
 
   // We lock when moving to a new row.
   void Next() {
@@ -123,9 +138,14 @@ class LockingIterator : public rocksdb::Iterator {
   std::unique_ptr<rocksdb::Iterator> it_;
   rocksdb::Transaction *txn_;
   rocksdb::ColumnFamilyHandle *cf_;
+  ReadSet *read_set_;
 
   // Lock current key.
   void Lock() {
+    if (this->read_set_ != nullptr) {
+      this->read_set_->emplace_back(this->cf_, this->key().ToString());
+      return;
+    }
     // Options.
     rocksdb::ReadOptions opts;
     opts.total_order_seek = true;
@@ -146,10 +166,17 @@ class LockingIterator : public rocksdb::Iterator {
  */
 
 // A write transaction starts as soon as it is created!
-RocksdbWriteTransaction::RocksdbWriteTransaction(rocksdb::TransactionDB *db)
+RocksdbWriteTransaction::RocksdbWriteTransaction(rocksdb::TransactionDB *db,
+                                                 GroupCommit *group_commit,
+                                                 bool optimistic)
     : db_(db),
-      txn_(db_->BeginTransaction(WriteOpts(), TxnOpts())),
-      finalized_(false) {
+      group_commit_(group_commit),
+      optimistic_(optimistic),
+      txn_(db_->BeginTransaction(WriteOpts(group_commit == nullptr),
+                                 TxnOpts(optimistic))),
+      finalized_(false),
+      read_set_(),
+      conflict_(false) {
   // TODO(babman): can we get higher isolation using snapshots like the next
   //               line?
   // SetSnapshot on the next operation call.
@@ -169,20 +196,63 @@ void RocksdbWriteTransaction::Rollback() {
   this->finalized_ = true;
   PANIC(this->txn_->Rollback());
 }
-void RocksdbWriteTransaction::Commit() {
+bool RocksdbWriteTransaction::Commit() {
   this->finalized_ = true;
+  if (this->optimistic_ && !this->Validate()) {
+    PANIC(this->txn_->Rollback());
+    return false;
+  }
   PANIC(this->txn_->Commit());
+  if (this->group_commit_ != nullptr) {
+    this->group_commit_->Sync();
+  }
+  return true;
+}
+
+// Lock the read set, and check that it was not written to since the snapshot.
+// Writes were already checked when they were made.
+bool RocksdbWriteTransaction::Validate() {
+  if (this->conflict_) {
+    return false;
+  }
+  rocksdb::ReadOptions opts;
+  opts.total_order_seek = true;
+  opts.verify_checksums = false;
+  std::string _;
+  for (const auto &[cf, key] : this->read_set_) {
+    rocksdb::Status status = this->txn_->GetForUpdate(opts, cf, key, &_);
+    if (IsConflict(status)) {
+      return false;
+    }
+    if (!status.ok() && !status.IsNotFound()) {
+      PANIC(status);
+    }
+  }
+  return true;
 }
 
 // Writes.
 void RocksdbWriteTransaction::Put(rocksdb::ColumnFamilyHandle *cf,
                                   const rocksdb::Slice &key,
                                   const rocksdb::Slice &value) {
-  PANIC(this->txn_->Put(cf, key, value));
+  rocksdb::Status status = this->txn_->Put(cf, key, value);
+  if (this->optimistic_ && IsConflict(status)) {
+    this->conflict_ = true;
+    return;
+  }
+  PANIC(status);
 }
 void RocksdbWriteTransaction::Delete(rocksdb::ColumnFamilyHandle *cf,
                                      const rocksdb::Slice &key) {
-  PANIC(this->txn_->Delete(cf, key));
+  rocksdb::Status status = this->txn_->Delete(cf, key);
+  if (this->optimistic_ && IsConflict(status)) {
+    this->conflict_ = true;
+    return;
+  }
+  PANIC(status);
+}
+void RocksdbWriteTransaction::PutLogData(const rocksdb::Slice &blob) {
+  this->txn_->PutLogData(blob);
 }
 
 // Locking reads.
@@ -193,7 +263,14 @@ std::optional<std::string> RocksdbWriteTransaction::Get(
   opts.verify_checksums = false;
 
   std::string result;
-  rocksdb::Status status = this->txn_->GetForUpdate(opts, cf, key, &result);
+  rocksdb::Status status;
+  if (this->optimistic_) {
+    opts.snapshot = this->txn_->GetSnapshot();
+    this->read_set_.emplace_back(cf, key.ToString());
+    status = this->txn_->Get(opts, cf, key, &result);
+  } else {
+    status = this->txn_->GetForUpdate(opts, cf, key, &result);
+  }
   if (status.ok()) {
     return result;
   } else if (status.IsNotFound()) {
@@ -215,8 +292,16 @@ std::vector<std::optional<std::string>> RocksdbWriteTransaction::MultiGet(
   opts.verify_checksums = false;
 
   // Read.
-  std::vector<rocksdb::Status> statuses =
-      this->txn_->MultiGetForUpdate(opts, handles, keys, &pins);
+  std::vector<rocksdb::Status> statuses;
+  if (this->optimistic_) {
+    opts.snapshot = this->txn_->GetSnapshot();
+    for (const rocksdb::Slice &key : keys) {
+      this->read_set_.emplace_back(cf, key.ToString());
+    }
+    statuses = this->txn_->MultiGet(opts, handles, keys, &pins);
+  } else {
+    statuses = this->txn_->MultiGetForUpdate(opts, handles, keys, &pins);
+  }
 
   // Move results into vector.
   std::vector<std::optional<std::string>> results;
@@ -243,9 +328,15 @@ std::unique_ptr<rocksdb::Iterator> RocksdbWriteTransaction::Iterate(
 
   // Get an iterator from both the underlying DB and
   // the current uncommitted write set of the transaction.
-  // This iterator locks the read and used row (using GetForUpdate()).
+  // This iterator locks the read and used row (using GetForUpdate()), or adds
+  // it to the read set.
+  LockingIterator::ReadSet *read_set = nullptr;
+  if (this->optimistic_) {
+    opts.snapshot = this->txn_->GetSnapshot();
+    read_set = &this->read_set_;
+  }
   std::unique_ptr<rocksdb::Iterator> it = std::make_unique<LockingIterator>(
-      this->txn_->GetIterator(opts, cf), this->txn_.get(), cf);
+      this->txn_->GetIterator(opts, cf), this->txn_.get(), cf, read_set);
   if (same_prefix) {
     // Wrap around a prefix respecting iterator.
     rocksdb::ColumnFamilyDescriptor descriptor;
@@ -281,6 +372,11 @@ void RocksdbReadSnapshot::InitializeSnapshot() const {
   }
 }
 
+uint64_t RocksdbReadSnapshot::SequenceNumber() const {
+  this->InitializeSnapshot();
+  return this->snapshot_->GetSequenceNumber();
+}
+
 // Non-locking reads from snapshot.
 std::optional<std::string> RocksdbReadSnapshot::Get(
     rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &key) const {
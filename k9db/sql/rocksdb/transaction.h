@@ -2,11 +2,14 @@
 #ifndef K9DB_SQL_ROCKSDB_TRANSACTION_H_
 #define K9DB_SQL_ROCKSDB_TRANSACTION_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "k9db/sql/rocksdb/group_commit.h"
 #include "rocksdb/db.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/utilities/transaction_db.h"
@@ -44,13 +47,21 @@ class RocksdbInterface {
 // Further, we use the SetSnapshot() API in rocksdb to ensure that the
 // transaction won't commit if concurrent changes were made to the read set
 // after the first read.
+// Commits are durable once Commit() returns: the WAL is synced either by the
+// commit itself, or by the given group commit.
+// Optimistic transactions do not lock what they read. Instead, they read from
+// a snapshot taken when they start, and on commit, validate that what they
+// read and wrote was not modified since by a concurrent transaction.
 class RocksdbWriteTransaction : public RocksdbInterface {
  public:
-  explicit RocksdbWriteTransaction(rocksdb::TransactionDB *db);
+  explicit RocksdbWriteTransaction(rocksdb::TransactionDB *db,
+                                   GroupCommit *group_commit = nullptr,
+                                   bool optimistic = false);
   ~RocksdbWriteTransaction();
 
-  // Commit / Rollback.
-  void Commit();
+  // Commit / Rollback. Commit returns false if the transaction conflicts with
+  // a concurrent one (only if optimistic), in which case it is rolled back.
+  bool Commit();
   void Rollback();
 
   // Only defined in RocksdbWriteTransaction.
@@ -59,6 +70,9 @@ class RocksdbWriteTransaction : public RocksdbInterface {
   void Put(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &key,
            const rocksdb::Slice &value);
   void Delete(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &key);
+  // Attach a blob to the transaction that is written to the WAL on commit, but
+  // not to any column family.
+  void PutLogData(const rocksdb::Slice &blob);
 
   // Read current (i.e. latest comitted data), acquire write lock for the read
   // data.
@@ -74,8 +88,18 @@ class RocksdbWriteTransaction : public RocksdbInterface {
 
  private:
   rocksdb::TransactionDB *db_;
+  GroupCommit *group_commit_;
+  bool optimistic_;
   std::unique_ptr<rocksdb::Transaction> txn_;
   bool finalized_;
+  // Optimistic transactions only: keys read so far, and whether a write
+  // already conflicted.
+  mutable std::vector<std::pair<rocksdb::ColumnFamilyHandle *, std::string>>
+      read_set_;
+  bool conflict_;
+
+  // Validate the read set of an optimistic transaction.
+  bool Validate();
 };
 
 class RocksdbReadSnapshot : public RocksdbInterface {
@@ -94,6 +118,10 @@ class RocksdbReadSnapshot : public RocksdbInterface {
   std::unique_ptr<rocksdb::Iterator> Iterate(rocksdb::ColumnFamilyHandle *cf,
                                              bool same_prefix) const override;
 
+  // The sequence number of the snapshot (taking the snapshot if it was not
+  // taken already).
+  uint64_t SequenceNumber() const;
+
  private:
   rocksdb::TransactionDB *db_;
   mutable const rocksdb::Snapshot *snapshot_;
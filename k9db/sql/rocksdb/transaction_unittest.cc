@@ -258,6 +258,43 @@ TEST(TransactionTest, MixedTest) {
   EXPECT_EQ(GetAll(db.get(), cf.get()), (VV{"v1", "v22", "v3", "v5"}));
 }
 
+// Optimistic transactions fail to commit if what they read or write was
+// modified after they started.
+TEST(TransactionTest, OptimisticTest) {
+  // Create DB.
+  std::unique_ptr<rocksdb::TransactionDB> db = InitializeDatabase();
+  std::unique_ptr<rocksdb::ColumnFamilyHandle> cf = InitializeTable(db.get());
+  rocksdb::WriteOptions opts;
+  opts.sync = true;
+  PANIC(db->Put(opts, cf.get(), "k1", "v1"));
+
+  // Read is not locked, so the concurrent write goes through.
+  RocksdbWriteTransaction txn1(db.get(), nullptr, true);
+  EXPECT_EQ(txn1.Get(cf.get(), "k1"), "v1");
+  RocksdbWriteTransaction txn2(db.get());
+  txn2.Put(cf.get(), "k1", "v2");
+  EXPECT_TRUE(txn2.Commit());
+  txn1.Put(cf.get(), "k2", "v2");
+  EXPECT_FALSE(txn1.Commit());
+  EXPECT_TRUE(!Get(db.get(), cf.get(), "k2"));
+
+  // Retrying it succeeds.
+  RocksdbWriteTransaction txn3(db.get(), nullptr, true);
+  EXPECT_EQ(txn3.Get(cf.get(), "k1"), "v2");
+  txn3.Put(cf.get(), "k2", "v2");
+  EXPECT_TRUE(txn3.Commit());
+  EXPECT_EQ(Get(db.get(), cf.get(), "k2"), "v2");
+
+  // Writes to keys that were written after the snapshot conflict.
+  RocksdbWriteTransaction txn4(db.get(), nullptr, true);
+  RocksdbWriteTransaction txn5(db.get(), nullptr, true);
+  txn5.Put(cf.get(), "k3", "v3");
+  EXPECT_TRUE(txn5.Commit());
+  txn4.Put(cf.get(), "k3", "v4");
+  EXPECT_FALSE(txn4.Commit());
+  EXPECT_EQ(Get(db.get(), cf.get(), "k3"), "v3");
+}
+
 }  // namespace rocks
 }  // namespace sql
 }  // namespace k9db
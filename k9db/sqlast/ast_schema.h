@@ -259,12 +259,18 @@ class CreateIndex : public AbstractStatement {
       : AbstractStatement(AbstractStatement::Type::CREATE_INDEX),
         index_name_(index_name),
         table_name_(table_name),
-        column_names_() {}
+        column_names_(),
+        included_column_names_() {}
 
   // Add columns.
   void AddColumn(const std::string &column_name) {
     this->column_names_.push_back(column_name);
   }
+  // Add columns that are not indexed, but whose values are stored in the
+  // index (INCLUDE (...)).
+  void AddIncludedColumn(const std::string &column_name) {
+    this->included_column_names_.push_back(column_name);
+  }
 
   // Accessors.
   const std::string &table_name() const { return this->table_name_; }
@@ -272,6 +278,9 @@ class CreateIndex : public AbstractStatement {
   const std::vector<std::string> &column_names() const {
     return this->column_names_;
   }
+  const std::vector<std::string> &included_column_names() const {
+    return this->included_column_names_;
+  }
 
   // Visitor pattern.
   template <class T>
@@ -297,6 +306,7 @@ class CreateIndex : public AbstractStatement {
   std::string index_name_;
   std::string table_name_;
   std::vector<std::string> column_names_;
+  std::vector<std::string> included_column_names_;
 };
 
 class CreateView : public AbstractStatement {
@@ -127,6 +127,15 @@ std::string Stringifier::VisitCreateIndex(const CreateIndex &ast) {
   str.pop_back();
   str.pop_back();
   str.push_back(')');
+  if (ast.included_column_names().size() > 0) {
+    str += " INCLUDE (";
+    for (const std::string &column_name : ast.included_column_names()) {
+      str += column_name + ", ";
+    }
+    str.pop_back();
+    str.pop_back();
+    str.push_back(')');
+  }
   return str;
 }
 
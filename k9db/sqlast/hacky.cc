@@ -2,7 +2,9 @@
 // which we want to parse quickly without ANTLR.
 #include "k9db/sqlast/hacky.h"
 
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "k9db/sqlast/hacky_util.h"
 #include "k9db/util/status.h"
@@ -311,6 +313,93 @@ absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyGDPR(
   return std::make_unique<GDPRStatement>(operation, shard_kind, user_id);
 }
 
+namespace {
+
+// Helper for parsing a list of column names: (<col>, <col>, ...).
+bool HackyColumnList(const char **str, size_t *size,
+                     std::vector<std::string> *columns) {
+  if (!StartsWith(str, size, "(", 1)) {
+    return false;
+  }
+  do {
+    ConsumeWhiteSpace(str, size);
+    std::string column = ExtractIdentifier(str, size);
+    if (column.size() == 0) {
+      return false;
+    }
+    columns->push_back(std::move(column));
+    ConsumeWhiteSpace(str, size);
+  } while (StartsWith(str, size, ",", 1));
+  return StartsWith(str, size, ")", 1);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyCreateIndex(
+    const char *str, size_t size) {
+  // CREATE INDEX <name> ON <tablename>(<col>, ...) [INCLUDE (<col>, ...)]
+  // INCLUDE is not part of the sqlite grammar, so we must parse it here.
+  // CREATE INDEX.
+  if (!StartsWith(&str, &size, "CREATE", 6)) {
+    return absl::InvalidArgumentError("Hacky create index: CREATE");
+  }
+  ConsumeWhiteSpace(&str, &size);
+  if (!StartsWith(&str, &size, "INDEX", 5)) {
+    return absl::InvalidArgumentError("Hacky create index: INDEX");
+  }
+  ConsumeWhiteSpace(&str, &size);
+
+  // <name>.
+  std::string index_name = ExtractIdentifier(&str, &size);
+  if (index_name.size() == 0) {
+    return absl::InvalidArgumentError("Hacky create index: index name");
+  }
+  ConsumeWhiteSpace(&str, &size);
+
+  // ON <tablename>.
+  if (!StartsWith(&str, &size, "ON", 2)) {
+    return absl::InvalidArgumentError("Hacky create index: ON");
+  }
+  ConsumeWhiteSpace(&str, &size);
+  std::string table_name = ExtractIdentifier(&str, &size);
+  if (table_name.size() == 0) {
+    return absl::InvalidArgumentError("Hacky create index: table name");
+  }
+  ConsumeWhiteSpace(&str, &size);
+
+  // (<col>, ...).
+  std::vector<std::string> columns;
+  if (!HackyColumnList(&str, &size, &columns)) {
+    return absl::InvalidArgumentError("Hacky create index: columns");
+  }
+  ConsumeWhiteSpace(&str, &size);
+
+  // INCLUDE (<col>, ...).
+  std::vector<std::string> included;
+  if (StartsWith(&str, &size, "INCLUDE", 7)) {
+    ConsumeWhiteSpace(&str, &size);
+    if (!HackyColumnList(&str, &size, &included)) {
+      return absl::InvalidArgumentError("Hacky create index: INCLUDE");
+    }
+    ConsumeWhiteSpace(&str, &size);
+  }
+
+  // End of statement.
+  if (size != 0 && !StartsWith(&str, &size, ";", 1)) {
+    return absl::InvalidArgumentError("Hacky create index: ;");
+  }
+
+  std::unique_ptr<CreateIndex> stmt =
+      std::make_unique<CreateIndex>(index_name, table_name);
+  for (const std::string &column : columns) {
+    stmt->AddColumn(column);
+  }
+  for (const std::string &column : included) {
+    stmt->AddIncludedColumn(column);
+  }
+  return stmt;
+}
+
 absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyParse(
     const SQLCommand &sql) {
   size_t size = sql.query().size();
@@ -329,6 +418,9 @@ absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyParse(
   if (str[0] == 'U' || str[0] == 'u') {
     return HackyUpdate(str, size, args);
   }
+  if (str[0] == 'C' || str[0] == 'c') {
+    return HackyCreateIndex(str, size);
+  }
 
   return absl::InvalidArgumentError("Cannot hacky parse");
 }
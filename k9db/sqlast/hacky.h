@@ -33,6 +33,9 @@ absl::StatusOr<std::unique_ptr<AbstractStatement>> HackySelect(
 absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyUpdate(
     const char *str, size_t size, const std::vector<std::string> &args);
 
+absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyCreateIndex(
+    const char *str, size_t size);
+
 absl::StatusOr<std::unique_ptr<AbstractStatement>> HackyParse(
     const SQLCommand &sql);
 
@@ -594,8 +594,9 @@ antlrcpp::Any AstTransformer::visitExpr(
 
   if ((ctx->literal_value() == nullptr && ctx->ASSIGN() == nullptr &&
        ctx->column_name() == nullptr && ctx->AND() == nullptr &&
-       ctx->GT() == nullptr && ctx->IN() == nullptr && ctx->IS() == nullptr &&
-       ctx->PLUS() == nullptr && ctx->MINUS() == nullptr) ||
+       ctx->GT() == nullptr && ctx->LT() == nullptr && ctx->IN() == nullptr &&
+       ctx->IS() == nullptr && ctx->PLUS() == nullptr &&
+       ctx->MINUS() == nullptr) ||
       ctx->expr().size() > 2) {
     return absl::InvalidArgumentError("Unsupported expression");
   }
@@ -662,7 +663,7 @@ antlrcpp::Any AstTransformer::visitExpr(
   if (ctx->AND() != nullptr) {
     result = std::make_unique<BinaryExpression>(Expression::Type::AND);
   }
-  if (ctx->GT() != nullptr) {
+  if (ctx->GT() != nullptr || ctx->LT() != nullptr) {
     result = std::make_unique<BinaryExpression>(Expression::Type::GREATER_THAN);
   }
   if (ctx->PLUS() != nullptr) {
@@ -674,6 +675,10 @@ antlrcpp::Any AstTransformer::visitExpr(
 
   CAST_REF(std::unique_ptr<Expression>, expr0, ctx->expr(0)->accept(this));
   CAST_REF(std::unique_ptr<Expression>, expr1, ctx->expr(1)->accept(this));
+  // a < b is b > a.
+  if (ctx->LT() != nullptr) {
+    std::swap(expr0, expr1);
+  }
   result->SetLeft(std::move(expr0));
   result->SetRight(std::move(expr1));
   return static_cast<std::unique_ptr<Expression>>(std::move(result));
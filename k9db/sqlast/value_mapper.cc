@@ -1,5 +1,10 @@
 #include "k9db/sqlast/value_mapper.h"
 
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "absl/status/status.h"
 #include "glog/logging.h"
 
 namespace k9db {
@@ -13,6 +18,41 @@ namespace sqlast {
 #define TO_LIST(expr) reinterpret_cast<const LiteralListExpression *>(expr)
 #define TO_BINARY(expr) reinterpret_cast<const BinaryExpression *>(expr)
 
+namespace {
+
+bool IsInteger(const Value &v) {
+  return v.type() == Value::Type::INT || v.type() == Value::Type::UINT;
+}
+
+// Integer bounds are converted to the type of their column when they fit in
+// it. Bounds that do not fit are kept as is, the index handles them when
+// encoding (see EncodeOrderedBound in sql/rocksdb/index.cc).
+Value NormalizeBound(const Value &v, ColumnDefinition::Type type) {
+  if (v.type() == Value::Type::INT && type == ColumnDefinition::Type::UINT &&
+      v.GetInt() >= 0) {
+    return Value(static_cast<uint64_t>(v.GetInt()));
+  }
+  if (v.type() == Value::Type::UINT && type == ColumnDefinition::Type::INT &&
+      v.GetUInt() <= std::numeric_limits<int64_t>::max()) {
+    return Value(static_cast<int64_t>(v.GetUInt()));
+  }
+  return v;
+}
+
+// Bounds are comparable if they have the same type or are both integers,
+// integers of different signedness compare by value.
+bool BoundLess(const Value &l, const Value &r) {
+  if (l.type() == r.type()) {
+    return l < r;
+  }
+  if (l.type() == Value::Type::INT) {
+    return l.GetInt() < 0 || static_cast<uint64_t>(l.GetInt()) < r.GetUInt();
+  }
+  return r.GetInt() >= 0 && l.GetUInt() < static_cast<uint64_t>(r.GetInt());
+}
+
+}  // namespace
+
 // These are unsupported.
 void ValueMapper::VisitCreateTable(const CreateTable &ast) {
   LOG(FATAL) << "UNSUPPORTED";
@@ -109,16 +149,61 @@ void ValueMapper::VisitBinaryExpression(const BinaryExpression &ast) {
       this->values_.emplace(col_idx, list->values());
       break;
     }
+    case Expression::Type::GREATER_THAN: {
+      if (!(IS_COLUMN(ast.GetLeft()) && IS_LITERAL(ast.GetRight())) &&
+          !(IS_LITERAL(ast.GetLeft()) && IS_COLUMN(ast.GetRight()))) {
+        this->Fail("Comparisons must be between a column and a value");
+        break;
+      }
+
+      // col > val is a lower bound, val > col is an upper bound.
+      const ColumnExpression *col;
+      const LiteralExpression *val;
+      bool lower = IS_COLUMN(ast.GetLeft());
+      if (lower) {
+        col = TO_COLUMN(ast.GetLeft());
+        val = TO_LITERAL(ast.GetRight());
+      } else {
+        col = TO_COLUMN(ast.GetRight());
+        val = TO_LITERAL(ast.GetLeft());
+      }
+      if (val->value().IsNull()) {
+        this->Fail("Comparison with NULL on " + col->column());
+        break;
+      }
+
+      // Several bounds on the same side are intersected: keep the tighter.
+      size_t col_idx = this->schema_.IndexOf(col->column());
+      Value value = NormalizeBound(val->value(), this->schema_.TypeOf(col_idx));
+      Range &range = this->ranges_[col_idx];
+      std::optional<Value> &bound = lower ? range.lower : range.upper;
+      if (!bound.has_value()) {
+        bound = std::move(value);
+      } else if (bound->type() != value.type() &&
+                 !(IsInteger(*bound) && IsInteger(value))) {
+        this->Fail("Comparisons of different types on " + col->column());
+      } else if (lower ? BoundLess(*bound, value) : BoundLess(value, *bound)) {
+        bound = std::move(value);
+      }
+      break;
+    }
     case Expression::Type::AND: {
       this->VisitBinaryExpression(*TO_BINARY(ast.GetLeft()));
       this->VisitBinaryExpression(*TO_BINARY(ast.GetRight()));
       break;
     }
-    default:  // >, LITERAL, COLUMN, LIST, PLUS, MINUS.
+    default:  // LITERAL, COLUMN, LIST, PLUS, MINUS.
       LOG(FATAL) << "Bad expression";
   }
 }
 
+// Only the first error is kept.
+void ValueMapper::Fail(const std::string &error) {
+  if (this->status_.ok()) {
+    this->status_ = absl::InvalidArgumentError(error);
+  }
+}
+
 // These will never be invoked.
 void ValueMapper::VisitColumnExpression(const ColumnExpression &ast) {
   LOG(FATAL) << "UNREACHABLE";
@@ -1,11 +1,13 @@
 #ifndef K9DB_SQLAST_VALUE_MAPPER_H_
 #define K9DB_SQLAST_VALUE_MAPPER_H_
 
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "k9db/dataflow/schema.h"
 #include "k9db/sqlast/ast.h"
 
@@ -16,10 +18,16 @@ namespace sqlast {
 // std::string -> std::vector<std::string>
 // values inside std::vector are basically an OR.
 // TODO(babman): values of strings can be slices.
+// Strict comparisons (col > value, value > col) are captured separately as
+// ranges with exclusive bounds. Comparisons that cannot be captured (between
+// two columns, or with NULL) are ignored and reported by status().
 class ValueMapper : public AbstractVisitor<void> {
  public:
   explicit ValueMapper(const dataflow::SchemaRef &schema)
-      : AbstractVisitor(), schema_(schema) {}
+      : AbstractVisitor(), schema_(schema), status_() {}
+
+  // Ok unless the visited where clause has unsupported comparisons.
+  const absl::Status &status() const { return this->status_; }
 
   // Get the value(s) of a column.
   bool HasValues(size_t col_idx) const {
@@ -41,7 +49,26 @@ class ValueMapper : public AbstractVisitor<void> {
   const std::unordered_map<size_t, std::vector<Value>> &Values() const {
     return this->values_;
   }
-  bool Empty() const { return this->values_.size() == 0; }
+  bool Empty() const {
+    return this->values_.size() == 0 && this->ranges_.size() == 0;
+  }
+
+  // Get the range a column is constrained to.
+  struct Range {
+    std::optional<Value> lower;  // Exclusive.
+    std::optional<Value> upper;  // Exclusive.
+  };
+  bool HasRange(size_t col_idx) const {
+    return this->ranges_.count(col_idx) == 1;
+  }
+  Range ReleaseRange(size_t col_idx) {
+    auto node = this->ranges_.extract(col_idx);
+    Range res = std::move(node.mapped());
+    return res;
+  }
+  const std::unordered_map<size_t, Range> &Ranges() const {
+    return this->ranges_;
+  }
 
   // Add values manually (without visiting some ast).
   void AddValue(size_t i, const Value &value) {
@@ -50,6 +77,9 @@ class ValueMapper : public AbstractVisitor<void> {
   void AddValues(size_t i, std::vector<Value> &&values) {
     this->values_[i] = std::move(values);
   }
+  void AddRange(size_t i, Range &&range) {
+    this->ranges_[i] = std::move(range);
+  }
 
   // Visitors.
   // These are unsupported.
@@ -77,8 +107,12 @@ class ValueMapper : public AbstractVisitor<void> {
   void VisitLiteralListExpression(const LiteralListExpression &ast) override;
 
  private:
+  void Fail(const std::string &error);
+
   dataflow::SchemaRef schema_;
   std::unordered_map<size_t, std::vector<Value>> values_;
+  std::unordered_map<size_t, Range> ranges_;
+  absl::Status status_;
 };
 
 }  // namespace sqlast
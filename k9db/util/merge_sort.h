@@ -38,7 +38,7 @@ std::vector<T> KMerge(std::vector<const std::multiset<T, C> *> &&V,
     queue.pop();
     if (i >= offset) {
       if (limit == -1 || count < offset + static_cast<size_t>(limit)) {
-        result.push_back(j->Copy());
+        result.push_back(j->Share());
       } else {
         break;
       }
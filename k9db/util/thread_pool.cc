@@ -0,0 +1,116 @@
+// A fixed pool of threads for running data-parallel loops, e.g. decrypting
+// and decoding many rows at once.
+#include "k9db/util/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace k9db {
+namespace util {
+
+namespace {
+
+// State of one ParallelFor. Shared with the tasks, since a task may only start
+// after the loop is done and ParallelFor has returned. Such a task finds no
+// indices left, and never touches fn.
+struct Loop {
+  Loop(size_t n, size_t grain, const std::function<void(size_t)> *fn)
+      : n(n), grain(grain), fn(fn), next(0), done(0) {}
+
+  size_t n;
+  size_t grain;
+  const std::function<void(size_t)> *fn;
+  std::atomic<size_t> next;
+  std::atomic<size_t> done;
+  std::mutex mtx;
+  std::condition_variable cv;
+
+  // Run blocks of indices until there are none left.
+  void Run() {
+    size_t start;
+    while ((start = this->next.fetch_add(this->grain)) < this->n) {
+      size_t end = std::min(start + this->grain, this->n);
+      for (size_t i = start; i < end; i++) {
+        (*this->fn)(i);
+      }
+      if (this->done.fetch_add(end - start) + (end - start) == this->n) {
+        std::unique_lock<std::mutex> lock(this->mtx);
+        this->cv.notify_all();
+      }
+    }
+  }
+};
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads) : threads_(), tasks_(), stop_(false) {
+  for (size_t i = 0; i < threads; i++) {
+    this->threads_.emplace_back(&ThreadPool::Run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(this->mtx_);
+    this->stop_ = true;
+  }
+  this->cv_.notify_all();
+  for (std::thread &thread : this->threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(this->mtx_);
+      this->cv_.wait(lock,
+                     [this]() { return this->stop_ || !this->tasks_.empty(); });
+      if (this->tasks_.empty()) {
+        return;
+      }
+      task = std::move(this->tasks_.front());
+      this->tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t n, size_t grain,
+                             const std::function<void(size_t)> &fn) {
+  grain = std::max(grain, static_cast<size_t>(1));
+  size_t blocks = (n + grain - 1) / grain;
+  size_t helpers = std::min(blocks, this->Parallelism()) - 1;
+  if (n == 0 || helpers == 0) {
+    for (size_t i = 0; i < n; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  // Hand out blocks to helpers, and work on blocks ourselves.
+  auto loop = std::make_shared<Loop>(n, grain, &fn);
+  {
+    std::unique_lock<std::mutex> lock(this->mtx_);
+    for (size_t i = 0; i < helpers; i++) {
+      this->tasks_.emplace_back([loop]() { loop->Run(); });
+    }
+  }
+  this->cv_.notify_all();
+  loop->Run();
+
+  // Wait for blocks taken by helpers.
+  std::unique_lock<std::mutex> lock(loop->mtx);
+  loop->cv.wait(lock, [&]() { return loop->done.load() == n; });
+}
+
+ThreadPool *ThreadPool::Shared() {
+  static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+  return &pool;
+}
+
+}  // namespace util
+}  // namespace k9db
@@ -0,0 +1,57 @@
+// A fixed pool of threads for running data-parallel loops, e.g. decrypting
+// and decoding many rows at once.
+#ifndef K9DB_UTIL_THREAD_POOL_H_
+#define K9DB_UTIL_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+// NOLINTNEXTLINE
+#include <mutex>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+namespace k9db {
+namespace util {
+
+class ThreadPool {
+ public:
+  // Spawns the given number of threads, the threads calling ParallelFor also
+  // participate in running it.
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  // Cannot copy or move a pool.
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of threads that can work on one loop, including the caller.
+  size_t Parallelism() const { return this->threads_.size() + 1; }
+
+  // Calls fn(i) for every i in [0, n), and returns once all calls are done.
+  // Indices are handed out in blocks of grain to the pool and the calling
+  // thread, loops of at most grain indices run entirely on the calling thread.
+  // fn must be safe to call concurrently for different indices.
+  void ParallelFor(size_t n, size_t grain,
+                   const std::function<void(size_t)> &fn);
+
+  // A pool shared by the whole process, with one thread per core.
+  static ThreadPool *Shared();
+
+ private:
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool stop_;
+
+  // Pool threads run tasks until the pool is destructed.
+  void Run();
+};
+
+}  // namespace util
+}  // namespace k9db
+
+#endif  // K9DB_UTIL_THREAD_POOL_H_
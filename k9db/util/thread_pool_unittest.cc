@@ -0,0 +1,46 @@
+#include "k9db/util/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace k9db {
+namespace util {
+
+TEST(ThreadPoolTest, EveryIndexOnce) {
+  ThreadPool pool(3);
+  EXPECT_EQ(pool.Parallelism(), 4);
+  for (size_t n : {0, 1, 7, 64, 1000}) {
+    std::vector<int> counts(n, 0);
+    pool.ParallelFor(n, 5, [&](size_t i) { counts.at(i)++; });
+    EXPECT_EQ(counts, std::vector<int>(n, 1));
+  }
+}
+
+TEST(ThreadPoolTest, ConcurrentLoops) {
+  ThreadPool pool(2);
+  std::atomic<size_t> sum = 0;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (size_t j = 0; j < 50; j++) {
+        pool.ParallelFor(100, 3, [&](size_t i) { sum += i; });
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(sum.load(), 4 * 50 * (99 * 100 / 2));
+}
+
+TEST(ThreadPoolTest, NoThreads) {
+  ThreadPool pool(0);
+  std::vector<int> counts(10, 0);
+  pool.ParallelFor(10, 1, [&](size_t i) { counts.at(i)++; });
+  EXPECT_EQ(counts, std::vector<int>(10, 1));
+}
+
+}  // namespace util
+}  // namespace k9db